@@ -14,6 +14,7 @@ See the Mulan PSL v2 for more details. */
 #include <benchmark/benchmark.h>
 #include <inttypes.h>
 
+#include "common/lang/lower_bound.h"
 #include "common/lang/stdexcept.h"
 #include "common/log/log.h"
 #include "common/math/integer_generator.h"
@@ -57,7 +58,8 @@ public:
       return;
     }
 
-    bpm_.init(make_unique<VacuousDoubleWriteBuffer>());
+    bpm_ = make_unique<BufferPoolManager>(BufferPoolMemorySize(), FrameShardNum(state));
+    bpm_->init(make_unique<VacuousDoubleWriteBuffer>());
 
     string log_name       = this->Name() + ".log";
     string btree_filename = this->Name() + ".btree";
@@ -71,7 +73,7 @@ public:
     const char *filename = btree_filename.c_str();
 
     RC rc = handler_.create(
-        log_handler_, bpm_, filename, AttrType::INTS, sizeof(int32_t) /*attr_len*/, internal_max_size, leaf_max_size);
+        log_handler_, *bpm_, filename, AttrType::INTS, sizeof(int32_t) /*attr_len*/, internal_max_size, leaf_max_size);
     if (rc != RC::SUCCESS) {
       throw runtime_error("failed to create btree handler");
     }
@@ -103,6 +105,11 @@ public:
     }
   }
 
+  /// 页帧管理器的分片个数，默认不分片
+  virtual int FrameShardNum(const State &state) const { return 1; }
+
+  virtual int BufferPoolMemorySize() const { return 512; }
+
   uint32_t GetRangeMax(const State &state) const
   {
     uint32_t max = static_cast<uint32_t>(state.range(0) * 3);
@@ -150,6 +157,21 @@ public:
     }
   }
 
+  void Lookup(uint32_t value, Stat &stat)
+  {
+    const char *key = reinterpret_cast<const char *>(&value);
+
+    list<RID> rids;
+    RC        rc = handler_.get_entry(key, sizeof(value), rids);
+    if (rc != RC::SUCCESS) {
+      stat.scan_open_failed_count++;
+    } else if (rids.size() != 1) {
+      stat.mismatch_count++;
+    } else {
+      stat.scan_success_count++;
+    }
+  }
+
   void Scan(uint32_t begin, uint32_t end, Stat &stat)
   {
     const char *begin_key = reinterpret_cast<const char *>(&begin);
@@ -181,9 +203,9 @@ public:
   }
 
 protected:
-  BufferPoolManager bpm_{512};
-  BplusTreeHandler  handler_;
-  VacuousLogHandler log_handler_;
+  unique_ptr<BufferPoolManager> bpm_;
+  BplusTreeHandler              handler_;
+  VacuousLogHandler             log_handler_;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -294,6 +316,57 @@ BENCHMARK_REGISTER_F(ScanBenchmark, Scan)->Threads(10)->Arg(4 * 10000);
 
 ////////////////////////////////////////////////////////////////////////////////
 
+/**
+ * @brief 点查询，用来观察页帧管理器分片之后随线程数增加的扩展性
+ * @details 第一个参数是数据量，第二个参数是页帧管理器分片的个数。
+ * 缓冲池不能放下所有的页面，因此查询时会同时有命中和淘汰。
+ */
+class LookupBenchmark : public BenchmarkBase
+{
+public:
+  string Name() const override { return "lookup"; }
+
+  int FrameShardNum(const State &state) const override { return static_cast<int>(state.range(1)); }
+
+  int BufferPoolMemorySize() const override { return 8 * DEFAULT_ITEM_NUM_PER_POOL * BP_PAGE_SIZE; }
+
+  void SetUp(const State &state) override
+  {
+    if (0 != state.thread_index()) {
+      return;
+    }
+
+    BenchmarkBase::SetUp(state);
+
+    uint32_t max = GetRangeMax(state);
+    ASSERT(max > 0, "invalid argument count. %ld", state.range(0));
+    FillUp(0, max);
+  }
+};
+
+BENCHMARK_DEFINE_F(LookupBenchmark, Lookup)(State &state)
+{
+  uint32_t         max = GetRangeMax(state);
+  IntegerGenerator generator(0, max - 1);
+  Stat             stat;
+
+  for (auto _ : state) {
+    uint32_t value = static_cast<uint32_t>(generator.next());
+    Lookup(value, stat);
+  }
+
+  state.counters["success"]  = Counter(stat.scan_success_count, Counter::kIsRate);
+  state.counters["failed"]   = Counter(stat.scan_open_failed_count, Counter::kIsRate);
+  state.counters["mismatch"] = Counter(stat.mismatch_count, Counter::kIsRate);
+}
+
+BENCHMARK_REGISTER_F(LookupBenchmark, Lookup)
+    ->ThreadRange(1, 32)
+    ->ArgsProduct({{4 * 10000}, {1, 8}})
+    ->ArgNames({"keys", "shards"});
+
+////////////////////////////////////////////////////////////////////////////////
+
 struct MixtureBenchmark : public BenchmarkBase
 {
   string Name() const override { return "mixture"; }
@@ -348,4 +421,85 @@ BENCHMARK_REGISTER_F(MixtureBenchmark, Mixture)->Threads(10)->Arg(4 * 10000);
 
 ////////////////////////////////////////////////////////////////////////////////
 
+/**
+ * @brief 节点内二分查找，对比构造 Value 比较与按照类型特化比较的开销
+ * @details 第一个参数是键值类型，第二个参数为 0 时使用构造 Value 的比较方式(原来的实现)，为 1 时使用特化的比较器。
+ * 键值个数与一个叶子节点差不多。
+ */
+static void KeyComparatorLookup(State &state)
+{
+  const AttrType type        = static_cast<AttrType>(state.range(0));
+  const bool     specialized = state.range(1) != 0;
+  const int      attr_length = (type == AttrType::CHARS) ? 16 : 4;
+  const int      key_length  = attr_length + static_cast<int>(sizeof(RID));
+  const int      key_num     = 400;
+
+  // 按照顺序生成键值，字符串的前缀相同，比较时需要看到后面的字符
+  vector<char> keys(key_num * key_length, 0);
+  for (int i = 0; i < key_num; i++) {
+    char *key = keys.data() + i * key_length;
+    if (type == AttrType::INTS) {
+      memcpy(key, &i, sizeof(i));
+    } else if (type == AttrType::FLOATS) {
+      float value = static_cast<float>(i);
+      memcpy(key, &value, sizeof(value));
+    } else {
+      snprintf(key, attr_length, "key-prefix-%04d", i);
+    }
+    RID rid(i, i);
+    memcpy(key + attr_length, &rid, sizeof(rid));
+  }
+
+  KeyComparator comparator;
+  comparator.init(type, attr_length);
+
+  auto value_compare = [type, attr_length](const char *v1, const char *v2) {
+    Value left;
+    left.set_type(type);
+    left.set_data(v1, attr_length);
+    Value right;
+    right.set_type(type);
+    right.set_data(v2, attr_length);
+    int result = DataType::type_instance(type)->compare(left, right);
+    if (result != 0) {
+      return result;
+    }
+    return RID::compare((const RID *)(v1 + attr_length), (const RID *)(v2 + attr_length));
+  };
+
+  BinaryIterator<char> iter_begin(key_length, keys.data());
+  BinaryIterator<char> iter_end(key_length, keys.data() + key_num * key_length);
+
+  // 提前生成查找的键值，避免随机数生成的开销影响结果
+  IntegerGenerator generator(0, key_num - 1);
+  vector<int>      probes(4096);
+  for (int &probe : probes) {
+    probe = static_cast<int>(generator.next());
+  }
+
+  int64_t found_count = 0;
+  size_t  probe_index = 0;
+  for (auto _ : state) {
+    const char *key   = keys.data() + probes[probe_index++ % probes.size()] * key_length;
+    bool        found = false;
+    if (specialized) {
+      comparator.visit([&](const auto &typed_comparator) {
+        return common::lower_bound(iter_begin, iter_end, key, typed_comparator, &found);
+      });
+    } else {
+      common::lower_bound(iter_begin, iter_end, key, value_compare, &found);
+    }
+    found_count += found ? 1 : 0;
+  }
+
+  state.counters["found"] = Counter(found_count, Counter::kIsRate);
+}
+
+BENCHMARK(KeyComparatorLookup)
+    ->ArgsProduct({{static_cast<int>(AttrType::INTS), static_cast<int>(AttrType::FLOATS), static_cast<int>(AttrType::CHARS)},
+        {0, 1}})
+    ->ArgNames({"type", "specialized"});
+
+////////////////////////////////////////////////////////////////////////////////
+
 BENCHMARK_MAIN();
@@ -0,0 +1,196 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <benchmark/benchmark.h>
+#include <inttypes.h>
+
+#include "common/lang/array.h"
+#include "common/lang/atomic.h"
+#include "common/lang/chrono.h"
+#include "common/lang/filesystem.h"
+#include "common/lang/stdexcept.h"
+#include "common/lang/thread.h"
+#include "common/log/log.h"
+#include "storage/clog/disk_log_handler.h"
+#include "storage/clog/log_replayer.h"
+
+using namespace std;
+using namespace common;
+using namespace benchmark;
+
+/**
+ * @brief 提交延迟的直方图
+ * @details 第i个桶记录延迟在 [2^(i-1), 2^i) 微秒之间的提交次数，多个线程可以同时记录
+ */
+class LatencyHistogram
+{
+public:
+  static constexpr int BUCKET_NUM = 32;
+
+  void reset()
+  {
+    for (auto &bucket : buckets_) {
+      bucket.store(0);
+    }
+  }
+
+  void record(int64_t us)
+  {
+    int index = 0;
+    while (us > 0 && index < BUCKET_NUM - 1) {
+      us >>= 1;
+      index++;
+    }
+    buckets_[index].fetch_add(1, memory_order_relaxed);
+  }
+
+  int64_t count() const
+  {
+    int64_t total = 0;
+    for (const auto &bucket : buckets_) {
+      total += bucket.load();
+    }
+    return total;
+  }
+
+  /// 返回百分位所在桶的上界，单位微秒
+  int64_t percentile(double percent) const
+  {
+    const int64_t target  = static_cast<int64_t>(count() * percent / 100);
+    int64_t       current = 0;
+    for (int i = 0; i < BUCKET_NUM; i++) {
+      current += buckets_[i].load();
+      if (current > target) {
+        return upper_bound(i);
+      }
+    }
+    return upper_bound(BUCKET_NUM - 1);
+  }
+
+  void print(const string &title) const
+  {
+    const int64_t total = count();
+    printf("commit latency histogram. %s, commits=%" PRId64 "\n", title.c_str(), total);
+    for (int i = 0; i < BUCKET_NUM; i++) {
+      const int64_t num = buckets_[i].load();
+      if (num == 0) {
+        continue;
+      }
+      printf("  < %8" PRId64 " us: %10" PRId64 " %6.2f%%\n", upper_bound(i), num, num * 100.0 / total);
+    }
+  }
+
+private:
+  static int64_t upper_bound(int index) { return 1L << index; }
+
+private:
+  array<atomic<int64_t>, BUCKET_NUM> buckets_;
+};
+
+class NoopLogReplayer : public LogReplayer
+{
+public:
+  RC replay(const LogEntry &) override { return RC::SUCCESS; }
+};
+
+/**
+ * @brief 测试并发提交时的延迟
+ * @details 每次迭代写入一条日志，并等待它刷盘，相当于提交一个只有一条日志的事务。
+ * 线程越多，每次刷盘可以带上的日志就越多
+ */
+class GroupCommitBenchmark : public Fixture
+{
+public:
+  string log_path() const { return "group_commit_clog"; }
+
+  void SetUp(const State &state) override
+  {
+    if (0 != state.thread_index()) {
+      while (!setup_done_) {
+        this_thread::sleep_for(chrono::milliseconds(10));
+      }
+      return;
+    }
+
+    LoggerFactory::init_default("group_commit.log", LOG_LEVEL_INFO);
+
+    filesystem::remove_all(log_path());
+    log_handler_ = make_unique<DiskLogHandler>();
+    NoopLogReplayer replayer;
+    if (OB_FAIL(log_handler_->init(log_path().c_str())) || OB_FAIL(log_handler_->replay(replayer, 0)) ||
+        OB_FAIL(log_handler_->start())) {
+      throw runtime_error("failed to start log handler");
+    }
+
+    histogram_.reset();
+    setup_done_ = true;
+  }
+
+  void TearDown(const State &state) override
+  {
+    if (0 != state.thread_index()) {
+      return;
+    }
+
+    log_handler_->stop();
+    log_handler_->await_termination();
+    log_handler_.reset();
+    filesystem::remove_all(log_path());
+    setup_done_ = false;
+  }
+
+  void Commit(int payload_size)
+  {
+    auto start = chrono::steady_clock::now();
+
+    LSN          lsn = 0;
+    vector<char> data(payload_size);
+    RC           rc = log_handler_->append(lsn, LogModule::Id::TRANSACTION, std::move(data));
+    if (OB_SUCC(rc)) {
+      rc = log_handler_->wait_lsn(lsn);
+    }
+    ASSERT(OB_SUCC(rc), "failed to commit. rc=%s", strrc(rc));
+
+    auto end = chrono::steady_clock::now();
+    histogram_.record(chrono::duration_cast<chrono::microseconds>(end - start).count());
+  }
+
+protected:
+  unique_ptr<DiskLogHandler> log_handler_;
+  LatencyHistogram           histogram_;
+  atomic<bool>               setup_done_{false};
+};
+
+BENCHMARK_DEFINE_F(GroupCommitBenchmark, Commit)(State &state)
+{
+  const int payload_size = static_cast<int>(state.range(0));
+  for (auto _ : state) {
+    Commit(payload_size);
+  }
+
+  // 所有线程都结束迭代之后才会走到这里，由第一个线程汇总
+  if (0 == state.thread_index()) {
+    state.counters["p50_us"] = histogram_.percentile(50);
+    state.counters["p90_us"] = histogram_.percentile(90);
+    state.counters["p99_us"] = histogram_.percentile(99);
+    histogram_.print("threads=" + to_string(state.threads()));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(GroupCommitBenchmark, Commit)
+    ->Arg(100)
+    ->Threads(1)
+    ->Threads(4)
+    ->Threads(16)
+    ->Threads(64)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
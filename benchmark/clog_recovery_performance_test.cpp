@@ -0,0 +1,199 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <benchmark/benchmark.h>
+
+#include "common/lang/filesystem.h"
+#include "common/lang/stdexcept.h"
+#include "common/lang/string.h"
+#include "common/lang/vector.h"
+#include "common/log/log.h"
+#include "storage/buffer/disk_buffer_pool.h"
+#include "storage/buffer/double_write_buffer.h"
+#include "storage/clog/disk_log_handler.h"
+#include "storage/clog/integrated_log_replayer.h"
+#include "storage/clog/parallel_log_replayer.h"
+#include "storage/index/bplus_tree.h"
+#include "storage/record/record_manager.h"
+
+using namespace std;
+using namespace common;
+using namespace benchmark;
+
+/**
+ * @brief 测试崩溃恢复时回放日志的耗时
+ * @details 先构造一个崩溃现场：若干张表，每张表一个数据文件和一个索引文件，插入数据后不刷脏页直接复制文件。
+ * 每次迭代把崩溃现场复制一份，只统计回放日志的时间。参数是回放线程数，1表示使用 IntegratedLogReplayer 串行回放。
+ */
+class RecoveryBenchmark : public Fixture
+{
+public:
+  static constexpr int TABLE_NUM  = 4;
+  static constexpr int RECORD_NUM = 50000;  ///< 每张表插入的记录数
+  static constexpr int RECORD_SIZE = 64;
+
+  filesystem::path crash_directory() const { return "clog_recovery_crash"; }
+  filesystem::path work_directory() const { return "clog_recovery_work"; }
+
+  static string record_filename(int table) { return "record_" + to_string(table) + ".bp"; }
+  static string index_filename(int table) { return "index_" + to_string(table) + ".bp"; }
+
+  void SetUp(const State &state) override
+  {
+    if (prepared_) {
+      return;
+    }
+
+    LoggerFactory::init_default("clog_recovery.log", LOG_LEVEL_WARN);
+    filesystem::remove_all(crash_directory());
+    if (OB_FAIL(prepare())) {
+      throw runtime_error("failed to prepare crash files");
+    }
+    prepared_ = true;
+  }
+
+  void TearDown(const State &state) override { filesystem::remove_all(work_directory()); }
+
+  /// 构造崩溃现场，保存到 crash_directory 中
+  RC prepare()
+  {
+    const filesystem::path directory = "clog_recovery_prepare";
+    filesystem::remove_all(directory);
+    filesystem::create_directories(directory);
+
+    auto bpm = make_unique<BufferPoolManager>();
+    RC   rc  = bpm->init(make_unique<VacuousDoubleWriteBuffer>());
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+
+    auto                  log_handler = make_unique<DiskLogHandler>();
+    IntegratedLogReplayer log_replayer(*bpm);
+    if (OB_FAIL(rc = log_handler->init((directory / "clog").c_str())) ||
+        OB_FAIL(rc = log_handler->replay(log_replayer, 0)) || OB_FAIL(rc = log_handler->start())) {
+      return rc;
+    }
+
+    vector<unique_ptr<RecordFileHandler>> record_handlers;
+    vector<unique_ptr<BplusTreeHandler>>  tree_handlers;
+    for (int table = 0; table < TABLE_NUM; table++) {
+      DiskBufferPool *record_buffer_pool = nullptr;
+      DiskBufferPool *index_buffer_pool  = nullptr;
+      const string    record_file        = (directory / record_filename(table)).string();
+      const string    index_file         = (directory / index_filename(table)).string();
+      if (OB_FAIL(rc = bpm->create_file(record_file.c_str())) ||
+          OB_FAIL(rc = bpm->open_file(*log_handler, record_file.c_str(), record_buffer_pool)) ||
+          OB_FAIL(rc = bpm->create_file(index_file.c_str())) ||
+          OB_FAIL(rc = bpm->open_file(*log_handler, index_file.c_str(), index_buffer_pool))) {
+        return rc;
+      }
+
+      record_handlers.push_back(make_unique<RecordFileHandler>(StorageFormat::ROW_FORMAT));
+      tree_handlers.push_back(make_unique<BplusTreeHandler>());
+      if (OB_FAIL(rc = record_handlers.back()->init(*record_buffer_pool, *log_handler, nullptr, nullptr)) ||
+          OB_FAIL(rc = tree_handlers.back()->create(*log_handler, *index_buffer_pool, AttrType::INTS, sizeof(int)))) {
+        return rc;
+      }
+    }
+
+    char record_data[RECORD_SIZE] = {0};
+    for (int i = 0; i < RECORD_NUM; i++) {
+      for (int table = 0; table < TABLE_NUM; table++) {
+        RID rid;
+        memcpy(record_data, &i, sizeof(i));
+        if (OB_FAIL(rc = record_handlers[table]->insert_record(record_data, RECORD_SIZE, &rid)) ||
+            OB_FAIL(rc = tree_handlers[table]->insert_entry(reinterpret_cast<const char *>(&i), &rid))) {
+          return rc;
+        }
+      }
+    }
+
+    // 日志都写入磁盘之后直接复制文件，相当于进程崩溃
+    if (OB_FAIL(rc = log_handler->stop()) || OB_FAIL(rc = log_handler->await_termination())) {
+      return rc;
+    }
+    filesystem::copy(directory, crash_directory(), filesystem::copy_options::recursive);
+
+    tree_handlers.clear();
+    record_handlers.clear();
+    bpm.reset();
+    log_handler.reset();
+    filesystem::remove_all(directory);
+    return RC::SUCCESS;
+  }
+
+  /// 从崩溃现场恢复一次
+  RC recover(State &state, int thread_num)
+  {
+    state.PauseTiming();
+    filesystem::remove_all(work_directory());
+    filesystem::copy(crash_directory(), work_directory(), filesystem::copy_options::recursive);
+
+    auto bpm = make_unique<BufferPoolManager>();
+    RC   rc  = bpm->init(make_unique<VacuousDoubleWriteBuffer>());
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+    auto log_handler = make_unique<DiskLogHandler>();
+    for (int table = 0; table < TABLE_NUM; table++) {
+      DiskBufferPool *buffer_pool = nullptr;
+      const string    record_file = (work_directory() / record_filename(table)).string();
+      const string    index_file  = (work_directory() / index_filename(table)).string();
+      if (OB_FAIL(rc = bpm->open_file(*log_handler, record_file.c_str(), buffer_pool)) ||
+          OB_FAIL(rc = bpm->open_file(*log_handler, index_file.c_str(), buffer_pool))) {
+        return rc;
+      }
+    }
+    if (OB_FAIL(rc = log_handler->init((work_directory() / "clog").c_str()))) {
+      return rc;
+    }
+    state.ResumeTiming();
+
+    if (thread_num <= 1) {
+      IntegratedLogReplayer log_replayer(*bpm);
+      rc = log_handler->replay(log_replayer, 0);
+    } else {
+      ParallelLogReplayer log_replayer(*bpm, nullptr, thread_num);
+      if (OB_SUCC(rc = log_replayer.start()) && OB_SUCC(rc = log_handler->replay(log_replayer, 0))) {
+        rc = log_replayer.on_done();
+      }
+    }
+
+    state.PauseTiming();
+    bpm.reset();
+    log_handler.reset();
+    state.ResumeTiming();
+    return rc;
+  }
+
+protected:
+  static inline bool prepared_ = false;
+};
+
+BENCHMARK_DEFINE_F(RecoveryBenchmark, Replay)(State &state)
+{
+  const int thread_num = static_cast<int>(state.range(0));
+  for (auto _ : state) {
+    RC rc = recover(state, thread_num);
+    ASSERT(OB_SUCC(rc), "failed to recover. rc=%s", strrc(rc));
+  }
+  state.SetItemsProcessed(state.iterations() * TABLE_NUM * RECORD_NUM);
+}
+
+BENCHMARK_REGISTER_F(RecoveryBenchmark, Replay)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+    ->Iterations(3)
+    ->Unit(kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
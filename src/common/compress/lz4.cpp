@@ -0,0 +1,238 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "common/compress/lz4.h"
+
+namespace common {
+
+namespace {
+
+constexpr int MIN_MATCH     = 4;
+constexpr int LAST_LITERALS = 5;   ///< 最后5个字节必须是字面量
+constexpr int MF_LIMIT      = 12;  ///< 最后一个匹配必须在距离结尾12个字节之前开始
+constexpr int MAX_DISTANCE  = 65535;
+constexpr int HASH_LOG      = 12;
+constexpr int SKIP_TRIGGER  = 6;  ///< 连续找不到匹配时加快跳过的速度，不可压缩的数据不会太慢
+
+inline uint32_t read32(const unsigned char *p)
+{
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+inline uint32_t hash(uint32_t sequence) { return (sequence * 2654435761U) >> (32 - HASH_LOG); }
+
+/// 写入长度的扩展部分，返回写入之后的位置，空间不够时返回 nullptr
+inline unsigned char *write_length(unsigned char *op, const unsigned char *oend, int length)
+{
+  for (; length >= 255; length -= 255) {
+    if (op >= oend) {
+      return nullptr;
+    }
+    *op++ = 255;
+  }
+  if (op >= oend) {
+    return nullptr;
+  }
+  *op++ = static_cast<unsigned char>(length);
+  return op;
+}
+
+/// 读取长度的扩展部分，数据不完整时返回 false
+inline bool read_length(const unsigned char *&ip, const unsigned char *iend, int &length)
+{
+  unsigned char byte = 0;
+  do {
+    if (ip >= iend || length > INT32_MAX - 255) {
+      return false;
+    }
+    byte = *ip++;
+    length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+/// 写一个序列：字面量加上一个匹配，match_length 小于0表示最后一个只有字面量的序列
+unsigned char *write_sequence(unsigned char *op, const unsigned char *oend, const unsigned char *literals,
+    int literal_length, int offset, int match_length)
+{
+  if (op >= oend) {
+    return nullptr;
+  }
+
+  unsigned char *token = op++;
+  *token               = 0;
+  if (literal_length >= 15) {
+    *token = 15 << 4;
+    if ((op = write_length(op, oend, literal_length - 15)) == nullptr) {
+      return nullptr;
+    }
+  } else {
+    *token = static_cast<unsigned char>(literal_length << 4);
+  }
+
+  if (oend - op < literal_length) {
+    return nullptr;
+  }
+  memcpy(op, literals, literal_length);
+  op += literal_length;
+
+  if (match_length < 0) {
+    return op;
+  }
+
+  if (oend - op < 2) {
+    return nullptr;
+  }
+  *op++ = static_cast<unsigned char>(offset & 0xff);
+  *op++ = static_cast<unsigned char>(offset >> 8);
+
+  const int length = match_length - MIN_MATCH;
+  if (length >= 15) {
+    *token |= 15;
+    op = write_length(op, oend, length - 15);
+  } else {
+    *token |= static_cast<unsigned char>(length);
+  }
+  return op;
+}
+
+}  // namespace
+
+int Lz4::compress(const char *src, int src_size, char *dst, int dst_capacity)
+{
+  const unsigned char *const base   = reinterpret_cast<const unsigned char *>(src);
+  const unsigned char *const iend   = base + src_size;
+  const unsigned char       *ip     = base;
+  const unsigned char       *anchor = base;
+  unsigned char *const       ostart = reinterpret_cast<unsigned char *>(dst);
+  const unsigned char *const oend   = ostart + dst_capacity;
+  unsigned char             *op     = ostart;
+
+  if (src_size >= MF_LIMIT + 1) {
+    const unsigned char *const mflimit    = iend - MF_LIMIT;
+    const unsigned char *const matchlimit = iend - LAST_LITERALS;
+
+    int32_t table[1 << HASH_LOG];
+    memset(table, 0xff, sizeof(table));
+
+    int search_count = 1 << SKIP_TRIGGER;
+    while (ip < mflimit) {
+      const uint32_t sequence = read32(ip);
+      const uint32_t h        = hash(sequence);
+      const int32_t  ref      = table[h];
+      table[h]                = static_cast<int32_t>(ip - base);
+
+      if (ref < 0 || ip - base - ref > MAX_DISTANCE || read32(base + ref) != sequence) {
+        ip += search_count++ >> SKIP_TRIGGER;
+        continue;
+      }
+      search_count = 1 << SKIP_TRIGGER;
+
+      // 向前和向后扩展匹配
+      const unsigned char *match = base + ref;
+      while (ip > anchor && match > base && ip[-1] == match[-1]) {
+        ip--;
+        match--;
+      }
+      const unsigned char *match_end = ip + MIN_MATCH;
+      const unsigned char *ref_end   = match + MIN_MATCH;
+      while (match_end < matchlimit && *match_end == *ref_end) {
+        match_end++;
+        ref_end++;
+      }
+
+      op = write_sequence(op,
+          oend,
+          anchor,
+          static_cast<int>(ip - anchor),
+          static_cast<int>(ip - match),
+          static_cast<int>(match_end - ip));
+      if (op == nullptr) {
+        return 0;
+      }
+
+      ip     = match_end;
+      anchor = ip;
+    }
+  }
+
+  op = write_sequence(op, oend, anchor, static_cast<int>(iend - anchor), 0, -1);
+  if (op == nullptr) {
+    return 0;
+  }
+  return static_cast<int>(op - ostart);
+}
+
+int Lz4::decompress(const char *src, int src_size, char *dst, int dst_capacity)
+{
+  const unsigned char       *ip     = reinterpret_cast<const unsigned char *>(src);
+  const unsigned char *const iend   = ip + src_size;
+  unsigned char *const       ostart = reinterpret_cast<unsigned char *>(dst);
+  unsigned char *const       oend   = ostart + dst_capacity;
+  unsigned char             *op     = ostart;
+
+  while (ip < iend) {
+    const unsigned char token = *ip++;
+
+    int literal_length = token >> 4;
+    if (literal_length == 15 && !read_length(ip, iend, literal_length)) {
+      return -1;
+    }
+    if (iend - ip < literal_length || oend - op < literal_length) {
+      return -1;
+    }
+    memcpy(op, ip, literal_length);
+    ip += literal_length;
+    op += literal_length;
+
+    // 最后一个序列只有字面量
+    if (ip == iend) {
+      break;
+    }
+
+    if (iend - ip < 2) {
+      return -1;
+    }
+    const int offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    if (offset == 0 || offset > op - ostart) {
+      return -1;
+    }
+
+    int match_length = token & 15;
+    if (match_length == 15 && !read_length(ip, iend, match_length)) {
+      return -1;
+    }
+    match_length += MIN_MATCH;
+    if (oend - op < match_length) {
+      return -1;
+    }
+
+    // 匹配可能和输出重叠，比如连续的相同字节，这时只能逐个字节复制
+    const unsigned char *match = op - offset;
+    if (offset >= match_length) {
+      memcpy(op, match, match_length);
+      op += match_length;
+    } else {
+      for (int i = 0; i < match_length; i++) {
+        *op++ = *match++;
+      }
+    }
+  }
+
+  return static_cast<int>(op - ostart);
+}
+
+}  // namespace common
@@ -0,0 +1,42 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+namespace common {
+
+/**
+ * @brief LZ4 block 格式的压缩和解压
+ * @details 只实现了最基本的贪心匹配，压缩率比不上官方实现，但是格式相同。
+ * 没有帧格式，调用者需要自己记录压缩前后的大小。
+ */
+class Lz4
+{
+public:
+  /**
+   * @brief 最坏情况下压缩后的大小
+   */
+  static int compress_bound(int src_size) { return src_size + src_size / 255 + 16; }
+
+  /**
+   * @brief 压缩数据
+   * @return 压缩后的大小，dst 空间不够时返回0
+   */
+  static int compress(const char *src, int src_size, char *dst, int dst_capacity);
+
+  /**
+   * @brief 解压数据
+   * @details 会检查输入数据是否合法，不会越界读写
+   * @return 解压后的大小，数据不合法或者 dst 空间不够时返回-1
+   */
+  static int decompress(const char *src, int src_size, char *dst, int dst_capacity);
+};
+
+}  // namespace common
@@ -14,4 +14,5 @@ See the Mulan PSL v2 for more details. */
 
 #include "common/lang/exception.h"
 
+using std::align_val_t;
 using std::nothrow;
\ No newline at end of file
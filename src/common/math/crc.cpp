@@ -12,6 +12,14 @@ See the Mulan PSL v2 for more details. */
 // Created by Wenbin on 2024/3/25.
 //
 
+#include <string.h>
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+#include "common/math/crc.h"
+
 unsigned int crc_table[] = {0x00000000,
     0x77073096,
     0xEE0E612C,
@@ -276,4 +284,74 @@ unsigned int crc32(const char *buffer, unsigned int size)
     crc = crc_table[(crc ^ buffer[i]) & 0xff] ^ (crc >> 8);
   }
   return crc;
-}
\ No newline at end of file
+}
+namespace {
+
+/// CRC32C 多项式 0x1EDC6F41 按位反转之后的值
+constexpr uint32_t CRC32C_POLY = 0x82F63B78;
+
+/**
+ * @brief slicing-by-8 使用的表
+ * @details table[0] 是普通的按字节查询的表，table[k][i] 是 i 后面再跟 k 个0字节时的crc
+ */
+struct Crc32cTable
+{
+  uint32_t table[8][256];
+
+  Crc32cTable()
+  {
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t crc = i;
+      for (int j = 0; j < 8; j++) {
+        crc = (crc >> 1) ^ ((crc & 1) ? CRC32C_POLY : 0);
+      }
+      table[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; i++) {
+      for (int k = 1; k < 8; k++) {
+        table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xff];
+      }
+    }
+  }
+};
+
+const Crc32cTable &crc32c_table()
+{
+  static const Crc32cTable table;
+  return table;
+}
+
+}  // namespace
+
+uint32_t crc32c(uint32_t crc, const char *buffer, size_t size)
+{
+  const unsigned char *p = reinterpret_cast<const unsigned char *>(buffer);
+  crc                    = ~crc;
+
+#if defined(__SSE4_2__)
+  uint64_t crc64 = crc;
+  for (; size >= 8; size -= 8, p += 8) {
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    crc64 = _mm_crc32_u64(crc64, value);
+  }
+  crc = static_cast<uint32_t>(crc64);
+  for (; size > 0; size--, p++) {
+    crc = _mm_crc32_u8(crc, *p);
+  }
+#else
+  const auto &t = crc32c_table().table;
+  // 每次处理8个字节，按照小端读取
+  for (; size >= 8; size -= 8, p += 8) {
+    uint32_t low  = crc ^ (p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24));
+    uint32_t high = p[4] | (p[5] << 8) | (p[6] << 16) | (static_cast<uint32_t>(p[7]) << 24);
+    crc           = t[7][low & 0xff] ^ t[6][(low >> 8) & 0xff] ^ t[5][(low >> 16) & 0xff] ^ t[4][low >> 24] ^
+          t[3][high & 0xff] ^ t[2][(high >> 8) & 0xff] ^ t[1][(high >> 16) & 0xff] ^ t[0][high >> 24];
+  }
+  for (; size > 0; size--, p++) {
+    crc = (crc >> 8) ^ t[0][(crc ^ *p) & 0xff];
+  }
+#endif
+
+  return ~crc;
+}
@@ -14,5 +14,15 @@ See the Mulan PSL v2 for more details. */
 
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
+
 /// 计算buffer的crc校验码
 unsigned int crc32(const char *buffer, unsigned int size);
+
+/**
+ * @brief 计算 CRC32C(Castagnoli) 校验码
+ * @details 可以分段计算，把上一段的结果作为下一段的 crc 参数传入，第一段传 0。
+ * 编译时开启了 SSE4.2 就使用 crc32 指令，否则查表计算。
+ */
+uint32_t crc32c(uint32_t crc, const char *buffer, size_t size);
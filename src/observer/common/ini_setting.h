@@ -25,3 +25,38 @@ See the Mulan PSL v2 for more details. */
 #define SOCKET_BUFFER_SIZE 8192
 
 #define SESSION_STAGE_NAME "SessionStage"
+
+//! storage section
+#define STORAGE "STORAGE"
+#define BUFFER_POOL_FRAME_SHARD_NUM "BUFFER_POOL_FRAME_SHARD_NUM"
+#define BUFFER_POOL_FRAME_SHARD_NUM_DEFAULT 1
+#define BUFFER_POOL_FRAME_REPLACER "BUFFER_POOL_FRAME_REPLACER"
+#define BUFFER_POOL_FRAME_REPLACER_DEFAULT "lru"
+#define BUFFER_POOL_READ_AHEAD_WINDOW "BUFFER_POOL_READ_AHEAD_WINDOW"
+#define BUFFER_POOL_READ_AHEAD_WINDOW_DEFAULT 0
+#define BUFFER_POOL_IO_ENGINE "BUFFER_POOL_IO_ENGINE"
+#define BUFFER_POOL_IO_ENGINE_DEFAULT "sync"
+#define BUFFER_POOL_DIRECT_IO "BUFFER_POOL_DIRECT_IO"
+#define BUFFER_POOL_DIRECT_IO_DEFAULT 0
+#define BUFFER_POOL_EXTENT_PAGE_NUM "BUFFER_POOL_EXTENT_PAGE_NUM"
+#define BUFFER_POOL_EXTENT_PAGE_NUM_DEFAULT 64
+#define PAX_TABLE_PAGE_SIZE "PAX_TABLE_PAGE_SIZE"
+#define PAX_TABLE_PAGE_SIZE_DEFAULT 8192
+#define BUFFER_POOL_CLEAN_PERCENT "BUFFER_POOL_CLEAN_PERCENT"
+#define BUFFER_POOL_CLEAN_PERCENT_DEFAULT 0
+#define BUFFER_POOL_IO_CAPACITY "BUFFER_POOL_IO_CAPACITY"
+#define BUFFER_POOL_IO_CAPACITY_DEFAULT 200
+#define CHECKPOINT_INTERVAL_MS "CHECKPOINT_INTERVAL_MS"
+#define CHECKPOINT_INTERVAL_MS_DEFAULT 0
+#define RECOVERY_THREAD_NUM "RECOVERY_THREAD_NUM"
+#define RECOVERY_THREAD_NUM_DEFAULT 0
+#define CLOG_FILE_SIZE "CLOG_FILE_SIZE"
+#define CLOG_FILE_SIZE_DEFAULT (16 * 1024 * 1024)
+#define CLOG_RECYCLED_FILE_NUM "CLOG_RECYCLED_FILE_NUM"
+#define CLOG_RECYCLED_FILE_NUM_DEFAULT 4
+#define CLOG_COMPRESSION "CLOG_COMPRESSION"
+#define CLOG_COMPRESSION_DEFAULT "none"
+#define INDEX_BUILD_SORT_BUFFER_SIZE "INDEX_BUILD_SORT_BUFFER_SIZE"
+#define INDEX_BUILD_SORT_BUFFER_SIZE_DEFAULT (64 * 1024 * 1024)
+#define INDEX_BUILD_FILL_PERCENT "INDEX_BUILD_FILL_PERCENT"
+#define INDEX_BUILD_FILL_PERCENT_DEFAULT 90
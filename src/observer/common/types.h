@@ -42,13 +42,15 @@ enum class ReadWriteMode
 
 /**
  * @brief 存储格式，仅支持 Heap 存储引擎设置。
- * @details 当前仅支持行存格式（ROW_FORMAT）以及 PAX 存储格式(PAX_FORMAT)。
+ * @details 当前支持行存格式（ROW_FORMAT）、PAX 存储格式(PAX_FORMAT)以及变长行存格式(VAR_ROW_FORMAT)。
+ * 变长行存格式使用槽位目录(slotted page)组织页面，字符串字段不保存末尾填充的0。
  */
 enum class StorageFormat
 {
   UNKNOWN_FORMAT = 0,
   ROW_FORMAT,
-  PAX_FORMAT
+  PAX_FORMAT,
+  VAR_ROW_FORMAT
 };
 
 /**
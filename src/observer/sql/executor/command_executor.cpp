@@ -22,6 +22,7 @@ See the Mulan PSL v2 for more details. */
 #include "sql/executor/help_executor.h"
 #include "sql/executor/load_data_executor.h"
 #include "sql/executor/set_variable_executor.h"
+#include "sql/executor/show_status_executor.h"
 #include "sql/executor/show_tables_executor.h"
 #include "sql/executor/trx_begin_executor.h"
 #include "sql/executor/trx_end_executor.h"
@@ -63,6 +64,11 @@ RC CommandExecutor::execute(SQLStageEvent *sql_event)
       rc = executor.execute(sql_event);
     } break;
 
+    case StmtType::SHOW_STATUS: {
+      ShowStatusExecutor executor;
+      rc = executor.execute(sql_event);
+    } break;
+
     case StmtType::BEGIN: {
       TrxBeginExecutor executor;
       rc = executor.execute(sql_event);
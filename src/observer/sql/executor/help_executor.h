@@ -33,6 +33,7 @@ public:
   RC execute(SQLStageEvent *sql_event)
   {
     const char *strings[] = {"show tables;",
+        "show status;",
         "desc `table name`;",
         "create table `table name` (`column name` `column type`, ...);",
         "create index `index name` on `table` (`column`);",
@@ -120,7 +120,8 @@ void LoadDataExecutor::load_data(Table *table, const char *file_name, char termi
     common::split_string(line, delim, file_values);
     stringstream errmsg;
 
-    if (table->table_meta().storage_format() == StorageFormat::ROW_FORMAT) {
+    if (table->table_meta().storage_format() == StorageFormat::ROW_FORMAT ||
+        table->table_meta().storage_format() == StorageFormat::VAR_ROW_FORMAT) {
       rc = insert_record_from_file(table, file_values, record_values, errmsg);
       if (rc != RC::SUCCESS) {
         result_string << "Line:" << line_num << " insert record failed:" << errmsg.str() << ". error:" << strrc(rc)
@@ -0,0 +1,63 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include "common/sys/rc.h"
+#include "event/session_event.h"
+#include "event/sql_event.h"
+#include "session/session.h"
+#include "sql/executor/sql_result.h"
+#include "sql/operator/string_list_physical_operator.h"
+#include "storage/buffer/disk_buffer_pool.h"
+#include "storage/db/db.h"
+
+/**
+ * @brief 显示运行时统计信息的执行器
+ * @ingroup Executor
+ * @details 当前只有缓冲池的统计。每种页面大小有一个页帧管理器，变量名带上页面大小，比如 buffer_pool_8192_hit
+ */
+class ShowStatusExecutor
+{
+public:
+  ShowStatusExecutor()          = default;
+  virtual ~ShowStatusExecutor() = default;
+
+  RC execute(SQLStageEvent *sql_event)
+  {
+    SqlResult    *sql_result    = sql_event->session_event()->sql_result();
+    SessionEvent *session_event = sql_event->session_event();
+
+    Db *db = session_event->session()->get_current_db();
+
+    TupleSchema tuple_schema;
+    tuple_schema.append_cell(TupleCellSpec("", "Variable_name", "Variable_name"));
+    tuple_schema.append_cell(TupleCellSpec("", "Value", "Value"));
+    sql_result->set_tuple_schema(tuple_schema);
+
+    auto oper = new StringListPhysicalOperator;
+    for (BPFrameManager *frame_manager : db->buffer_pool_manager().frame_managers()) {
+      const string               prefix = "buffer_pool_" + to_string(frame_manager->page_size()) + "_";
+      const BPFrameManager::Stat stat   = frame_manager->stat();
+      oper->append({prefix + "replacer", frame_manager->replacer_name()});
+      oper->append({prefix + "frames", to_string(frame_manager->frame_num())});
+      oper->append({prefix + "total_frames", to_string(frame_manager->total_frame_num())});
+      oper->append({prefix + "hit", to_string(stat.hit_count)});
+      oper->append({prefix + "miss", to_string(stat.miss_count)});
+      oper->append({prefix + "hit_ratio", to_string(stat.hit_ratio())});
+      oper->append({prefix + "read_ahead", to_string(stat.read_ahead_count)});
+      oper->append({prefix + "read_ahead_hit", to_string(stat.read_ahead_hit)});
+      oper->append({prefix + "read_ahead_wasted", to_string(stat.read_ahead_wasted)});
+    }
+
+    sql_result->set_operator(unique_ptr<PhysicalOperator>(oper));
+    return RC::SUCCESS;
+  }
+};
@@ -13,6 +13,7 @@ See the Mulan PSL v2 for more details. */
 //
 
 #include "sql/operator/index_scan_physical_operator.h"
+#include "common/lang/algorithm.h"
 #include "storage/index/index.h"
 #include "storage/trx/trx.h"
 
@@ -25,34 +26,105 @@ IndexScanPhysicalOperator::IndexScanPhysicalOperator(Table *table, Index *index,
       right_inclusive_(right_inclusive)
 {
   if (left_value) {
-    left_value_ = *left_value;
+    left_values_.push_back(*left_value);
   }
   if (right_value) {
-    right_value_ = *right_value;
+    right_values_.push_back(*right_value);
   }
 }
 
+IndexScanPhysicalOperator::IndexScanPhysicalOperator(Table *table, Index *index, ReadWriteMode mode,
+    vector<Value> left_values, bool left_inclusive, vector<Value> right_values, bool right_inclusive)
+    : table_(table),
+      index_(index),
+      mode_(mode),
+      left_values_(std::move(left_values)),
+      right_values_(std::move(right_values)),
+      left_inclusive_(left_inclusive),
+      right_inclusive_(right_inclusive)
+{}
+
+void IndexScanPhysicalOperator::make_key(const vector<Value> &values, vector<char> &key) const
+{
+  const vector<FieldMeta> &field_metas = index_->field_metas();
+  ASSERT(values.size() <= field_metas.size(), "too many values for index. values=%d, fields=%d",
+      static_cast<int>(values.size()), static_cast<int>(field_metas.size()));
+
+  key.clear();
+  for (size_t i = 0; i < values.size(); i++) {
+    const Value &value     = values[i];
+    const int    field_len = field_metas[i].len();
+    const int    copy_len  = std::min(value.length(), field_len);
+    key.insert(key.end(), value.data(), value.data() + copy_len);
+    key.resize(key.size() + field_len - copy_len, 0);
+  }
+}
+
+bool IndexScanPhysicalOperator::empty_range() const
+{
+  if (left_values_.empty() || left_values_.size() != right_values_.size()) {
+    return false;
+  }
+
+  for (size_t i = 0; i < left_values_.size(); i++) {
+    const int result = left_values_[i].compare(right_values_[i]);
+    if (result != 0) {
+      return result > 0;
+    }
+  }
+  return !(left_inclusive_ && right_inclusive_);
+}
+
 RC IndexScanPhysicalOperator::open(Trx *trx)
 {
   if (nullptr == table_ || nullptr == index_) {
     return RC::INTERNAL;
   }
 
-  IndexScanner *index_scanner = index_->create_scanner(left_value_.data(),
-      left_value_.length(),
-      left_inclusive_,
-      right_value_.data(),
-      right_value_.length(),
-      right_inclusive_);
+  tuple_.set_schema(table_, table_->table_meta().field_metas());
+  trx_ = trx;
+
+  if (empty_range()) {
+    LOG_TRACE("index scan range is empty");
+    return RC::SUCCESS;
+  }
+
+  // 单字段索引直接使用值的内存，由索引处理字符串长度与字段长度不同的情况
+  vector<char> left_key;
+  vector<char> right_key;
+  const char  *left_data  = nullptr;
+  const char  *right_data = nullptr;
+  int          left_len   = 0;
+  int          right_len  = 0;
+  if (index_->field_metas().size() == 1) {
+    if (!left_values_.empty()) {
+      left_data = left_values_[0].data();
+      left_len  = left_values_[0].length();
+    }
+    if (!right_values_.empty()) {
+      right_data = right_values_[0].data();
+      right_len  = right_values_[0].length();
+    }
+  } else {
+    if (!left_values_.empty()) {
+      make_key(left_values_, left_key);
+      left_data = left_key.data();
+      left_len  = static_cast<int>(left_key.size());
+    }
+    if (!right_values_.empty()) {
+      make_key(right_values_, right_key);
+      right_data = right_key.data();
+      right_len  = static_cast<int>(right_key.size());
+    }
+  }
+
+  IndexScanner *index_scanner =
+      index_->create_scanner(left_data, left_len, left_inclusive_, right_data, right_len, right_inclusive_);
   if (nullptr == index_scanner) {
     LOG_WARN("failed to create index scanner");
     return RC::INTERNAL;
   }
   index_scanner_ = index_scanner;
-
-  tuple_.set_schema(table_, table_->table_meta().field_metas());
-
-  trx_ = trx;
   return RC::SUCCESS;
 }
 
@@ -62,6 +134,10 @@ RC IndexScanPhysicalOperator::next()
   RID rid;
   RC  rc = RC::SUCCESS;
 
+  if (nullptr == index_scanner_) {
+    return RC::RECORD_EOF;
+  }
+
   bool filter_result = false;
   while (RC::SUCCESS == (rc = index_scanner_->next_entry(&rid))) {
     rc = table_->get_record(rid, current_record_);
@@ -98,8 +174,10 @@ RC IndexScanPhysicalOperator::next()
 
 RC IndexScanPhysicalOperator::close()
 {
-  index_scanner_->destroy();
-  index_scanner_ = nullptr;
+  if (index_scanner_ != nullptr) {
+    index_scanner_->destroy();
+    index_scanner_ = nullptr;
+  }
   return RC::SUCCESS;
 }
 
@@ -28,6 +28,13 @@ public:
   IndexScanPhysicalOperator(Table *table, Index *index, ReadWriteMode mode, const Value *left_value,
       bool left_inclusive, const Value *right_value, bool right_inclusive);
 
+  /**
+   * @brief 组合索引的扫描
+   * @details 边界值按照索引字段的顺序给出，可以只给出前面若干个字段。值为空表示没有这个边界
+   */
+  IndexScanPhysicalOperator(Table *table, Index *index, ReadWriteMode mode, vector<Value> left_values,
+      bool left_inclusive, vector<Value> right_values, bool right_inclusive);
+
   virtual ~IndexScanPhysicalOperator() = default;
 
   PhysicalOperatorType type() const override { return PhysicalOperatorType::INDEX_SCAN; }
@@ -46,6 +53,17 @@ private:
   // 与TableScanPhysicalOperator代码相同，可以优化
   RC filter(RowTuple &tuple, bool &result);
 
+  /**
+   * @brief 将边界值按照索引字段的长度拼接成索引的键值
+   */
+  void make_key(const vector<Value> &values, vector<char> &key) const;
+
+  /**
+   * @brief 左右边界是否矛盾，比如 a > 5 and a < 3
+   * @details 索引扫描器不接受这样的边界，这时候直接返回空结果
+   */
+  bool empty_range() const;
+
 private:
   Trx          *trx_           = nullptr;
   Table        *table_         = nullptr;
@@ -56,10 +74,10 @@ private:
   Record   current_record_;
   RowTuple tuple_;
 
-  Value left_value_;
-  Value right_value_;
-  bool  left_inclusive_  = false;
-  bool  right_inclusive_ = false;
+  vector<Value> left_values_;
+  vector<Value> right_values_;
+  bool          left_inclusive_  = false;
+  bool          right_inclusive_ = false;
 
   vector<unique_ptr<Expression>> predicates_;
 };
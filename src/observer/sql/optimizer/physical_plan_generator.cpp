@@ -120,63 +120,198 @@ RC PhysicalPlanGenerator::create_vec(LogicalOperator &logical_operator, unique_p
   return rc;
 }
 
+/**
+ * @brief 可以用于索引扫描的比较条件，形式是 字段 comp 值
+ */
+struct IndexPredicate
+{
+  const FieldMeta *field = nullptr;
+  CompOp           comp  = NO_OP;
+  Value            value;  ///< 已经转换成字段的类型
+};
+
+/**
+ * @brief 从比较表达式中找出 字段 comp 值 形式的条件
+ * @details 值需要能够无损地转换成字段的类型，否则使用索引的结果可能会不正确
+ */
+static bool extract_index_predicate(Expression &expr, const Table *table, IndexPredicate &predicate)
+{
+  if (expr.type() != ExprType::COMPARISON) {
+    return false;
+  }
+
+  auto  &comparison_expr = static_cast<ComparisonExpr &>(expr);
+  CompOp comp            = comparison_expr.comp();
+  if (comp != EQUAL_TO && comp != LESS_THAN && comp != LESS_EQUAL && comp != GREAT_THAN && comp != GREAT_EQUAL) {
+    return false;
+  }
+
+  Expression *left_expr  = comparison_expr.left().get();
+  Expression *right_expr = comparison_expr.right().get();
+  if (left_expr->type() == ExprType::VALUE && right_expr->type() == ExprType::FIELD) {
+    // 值 comp 字段，交换成 字段 comp' 值
+    std::swap(left_expr, right_expr);
+    switch (comp) {
+      case LESS_THAN: comp = GREAT_THAN; break;
+      case LESS_EQUAL: comp = GREAT_EQUAL; break;
+      case GREAT_THAN: comp = LESS_THAN; break;
+      case GREAT_EQUAL: comp = LESS_EQUAL; break;
+      default: break;
+    }
+  }
+
+  if (left_expr->type() != ExprType::FIELD || right_expr->type() != ExprType::VALUE) {
+    return false;
+  }
+
+  const Field &field = static_cast<FieldExpr *>(left_expr)->field();
+  const Value &value = static_cast<ValueExpr *>(right_expr)->get_value();
+  if (field.table() != table) {
+    return false;
+  }
+
+  const FieldMeta *field_meta = field.meta();
+  if (value.attr_type() == field_meta->type()) {
+    predicate.value = value;
+  } else if (OB_FAIL(Value::cast_to(value, field_meta->type(), predicate.value)) ||
+             value.compare(predicate.value) != 0) {
+    return false;
+  }
+
+  // 索引中的字符串最长是字段的长度，更长的值交给表扫描处理
+  if (field_meta->type() == AttrType::CHARS && predicate.value.length() > field_meta->len()) {
+    return false;
+  }
+
+  predicate.field = field_meta;
+  predicate.comp  = comp;
+  return true;
+}
+
+/**
+ * @brief 在条件中找到指定字段上的等值比较
+ */
+static const IndexPredicate *find_equal_predicate(const vector<IndexPredicate> &predicates, const string &field_name)
+{
+  for (const IndexPredicate &predicate : predicates) {
+    if (predicate.comp == EQUAL_TO && field_name == predicate.field->name()) {
+      return &predicate;
+    }
+  }
+  return nullptr;
+}
+
+/**
+ * @brief 一个字段上的取值范围，由这个字段上所有的范围比较合并而成
+ */
+struct IndexRange
+{
+  const Value *lower           = nullptr;  ///< 下界，为空表示没有下界
+  bool         lower_inclusive = false;
+  const Value *upper           = nullptr;  ///< 上界，为空表示没有上界
+  bool         upper_inclusive = false;
+};
+
+/**
+ * @brief 合并指定字段上的所有范围比较，下界取最大的，上界取最小的
+ * @details 值相同时，不包含边界的条件更严格
+ */
+static IndexRange merge_range_predicates(const vector<IndexPredicate> &predicates, const string &field_name)
+{
+  IndexRange range;
+  for (const IndexPredicate &predicate : predicates) {
+    if (predicate.comp == EQUAL_TO || field_name != predicate.field->name()) {
+      continue;
+    }
+
+    const bool inclusive = (predicate.comp == GREAT_EQUAL || predicate.comp == LESS_EQUAL);
+    if (predicate.comp == GREAT_THAN || predicate.comp == GREAT_EQUAL) {
+      const int result = range.lower == nullptr ? 1 : predicate.value.compare(*range.lower);
+      if (result > 0 || (result == 0 && !inclusive)) {
+        range.lower           = &predicate.value;
+        range.lower_inclusive = inclusive;
+      }
+    } else {
+      const int result = range.upper == nullptr ? -1 : predicate.value.compare(*range.upper);
+      if (result < 0 || (result == 0 && !inclusive)) {
+        range.upper           = &predicate.value;
+        range.upper_inclusive = inclusive;
+      }
+    }
+  }
+  return range;
+}
+
 RC PhysicalPlanGenerator::create_plan(TableGetLogicalOperator &table_get_oper, unique_ptr<PhysicalOperator> &oper, Session* session)
 {
   vector<unique_ptr<Expression>> &predicates = table_get_oper.predicates();
   // 看看是否有可以用于索引查找的表达式
   Table *table = table_get_oper.table();
 
-  Index     *index      = nullptr;
-  ValueExpr *value_expr = nullptr;
+  vector<IndexPredicate> index_predicates;
   for (auto &expr : predicates) {
-    if (expr->type() == ExprType::COMPARISON) {
-      auto comparison_expr = static_cast<ComparisonExpr *>(expr.get());
-      // 简单处理，就找等值查询
-      if (comparison_expr->comp() != EQUAL_TO && comparison_expr->comp() != NOT_EQUAL) {
-        continue;
-      }
-
-      unique_ptr<Expression> &left_expr  = comparison_expr->left();
-      unique_ptr<Expression> &right_expr = comparison_expr->right();
-      // 左右比较的一边最少是一个值
-      if (left_expr->type() != ExprType::VALUE && right_expr->type() != ExprType::VALUE) {
-        continue;
-      }
-
-      FieldExpr *field_expr = nullptr;
-      if (left_expr->type() == ExprType::FIELD) {
-        ASSERT(right_expr->type() == ExprType::VALUE, "right expr should be a value expr while left is field expr");
-        field_expr = static_cast<FieldExpr *>(left_expr.get());
-        value_expr = static_cast<ValueExpr *>(right_expr.get());
-      } else if (right_expr->type() == ExprType::FIELD) {
-        ASSERT(left_expr->type() == ExprType::VALUE, "left expr should be a value expr while right is a field expr");
-        field_expr = static_cast<FieldExpr *>(right_expr.get());
-        value_expr = static_cast<ValueExpr *>(left_expr.get());
-      }
+    IndexPredicate index_predicate;
+    if (extract_index_predicate(*expr, table, index_predicate)) {
+      index_predicates.push_back(std::move(index_predicate));
+    }
+  }
 
-      if (field_expr == nullptr) {
-        continue;
+  // 组合索引按照字段顺序匹配：前面的字段是等值条件，最多再跟一个字段上的范围条件。
+  // 匹配的等值条件越多越好，相同时范围条件的上下界都有的更好
+  Index           *index      = nullptr;
+  vector<Value>    equal_values;
+  IndexRange       range;
+  int              best_score = 0;
+  const TableMeta &table_meta = table->table_meta();
+  for (int i = 0; !index_predicates.empty() && i < table_meta.index_num(); i++) {
+    const IndexMeta      *index_meta = table_meta.index(i);
+    const vector<string> &fields     = index_meta->fields();
+
+    vector<Value> values;
+    IndexRange    field_range;
+    for (const string &field_name : fields) {
+      const IndexPredicate *predicate = find_equal_predicate(index_predicates, field_name);
+      if (nullptr == predicate) {
+        field_range = merge_range_predicates(index_predicates, field_name);
+        break;
       }
+      values.push_back(predicate->value);
+    }
 
-      const Field &field = field_expr->field();
-      index              = table->find_index_by_field(field.field_name());
-      if (nullptr != index) {
-        break;
+    const int score = static_cast<int>(values.size()) * 3 + (field_range.lower != nullptr ? 1 : 0) +
+                      (field_range.upper != nullptr ? 1 : 0);
+    if (score > best_score) {
+      Index *candidate = table->find_index(index_meta->name());
+      if (nullptr != candidate) {
+        index        = candidate;
+        equal_values = std::move(values);
+        range        = field_range;
+        best_score   = score;
       }
     }
   }
 
   if (index != nullptr) {
-    ASSERT(value_expr != nullptr, "got an index but value expr is null ?");
+    vector<Value> left_values     = equal_values;
+    vector<Value> right_values    = equal_values;
+    bool          left_inclusive  = true;
+    bool          right_inclusive = true;
+    if (range.lower != nullptr) {
+      left_values.push_back(*range.lower);
+      left_inclusive = range.lower_inclusive;
+    }
+    if (range.upper != nullptr) {
+      right_values.push_back(*range.upper);
+      right_inclusive = range.upper_inclusive;
+    }
 
-    const Value               &value           = value_expr->get_value();
     IndexScanPhysicalOperator *index_scan_oper = new IndexScanPhysicalOperator(table,
         index,
         table_get_oper.read_write_mode(),
-        &value,
-        true /*left_inclusive*/,
-        &value,
-        true /*right_inclusive*/);
+        std::move(left_values),
+        left_inclusive,
+        std::move(right_values),
+        right_inclusive);
 
     index_scan_oper->set_predicates(std::move(predicates));
     oper = unique_ptr<PhysicalOperator>(index_scan_oper);
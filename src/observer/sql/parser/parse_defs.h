@@ -185,13 +185,14 @@ struct AnalyzeTableSqlNode
  * @brief 描述一个create index语句
  * @ingroup SQLParser
  * @details 创建索引时，需要指定索引名，表名，字段名。
- * 正常的SQL语句中，一个索引可能包含了多个字段，这里仅支持一个字段。
+ * 一个索引可以包含多个字段，字段的顺序就是索引键值的顺序。
  */
 struct CreateIndexSqlNode
 {
-  string index_name;      ///< Index name
-  string relation_name;   ///< Relation name
-  string attribute_name;  ///< Attribute name
+  string         index_name;       ///< Index name
+  string         relation_name;    ///< Relation name
+  vector<string> attribute_names;  ///< Attribute names
+  bool           unique = false;   ///< 是否是唯一索引
 };
 
 /**
@@ -283,6 +284,7 @@ enum SqlCommandFlag
   SCF_DROP_INDEX,
   SCF_SYNC,
   SCF_SHOW_TABLES,
+  SCF_SHOW_STATUS,  ///< 显示运行时的统计信息
   SCF_DESC_TABLE,
   SCF_BEGIN,  ///< 事务开始语句，可以在这里扩展只读事务
   SCF_COMMIT,
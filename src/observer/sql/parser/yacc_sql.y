@@ -70,7 +70,9 @@ UnboundAggregateExpr *create_aggregate_expression(const char *aggregate_name,
         GROUP
         TABLE
         TABLES
+        STATUS
         INDEX
+        UNIQUE
         CALC
         SELECT
         DESC
@@ -159,6 +161,7 @@ UnboundAggregateExpr *create_aggregate_expression(const char *aggregate_name,
 
 /** type 定义了各种解析后的结果输出的是什么类型。类型对应了 union 中的定义的成员变量名称 **/
 %type <number>              type
+%type <number>              opt_unique
 %type <condition>           condition
 %type <value>               value
 %type <number>              number
@@ -189,6 +192,7 @@ UnboundAggregateExpr *create_aggregate_expression(const char *aggregate_name,
 %type <sql_node>            drop_table_stmt
 %type <sql_node>            analyze_table_stmt
 %type <sql_node>            show_tables_stmt
+%type <sql_node>            show_status_stmt
 %type <sql_node>            desc_table_stmt
 %type <sql_node>            create_index_stmt
 %type <sql_node>            drop_index_stmt
@@ -227,6 +231,7 @@ command_wrapper:
   | drop_table_stmt
   | analyze_table_stmt
   | show_tables_stmt
+  | show_status_stmt
   | desc_table_stmt
   | create_index_stmt
   | drop_index_stmt
@@ -295,6 +300,12 @@ show_tables_stmt:
     }
     ;
 
+show_status_stmt:
+    SHOW STATUS {
+      $$ = new ParsedSqlNode(SCF_SHOW_STATUS);
+    }
+    ;
+
 desc_table_stmt:
     DESC ID  {
       $$ = new ParsedSqlNode(SCF_DESC_TABLE);
@@ -303,13 +314,26 @@ desc_table_stmt:
     ;
 
 create_index_stmt:    /*create index 语句的语法解析树*/
-    CREATE INDEX ID ON ID LBRACE ID RBRACE
+    CREATE opt_unique INDEX ID ON ID LBRACE attr_list RBRACE
     {
       $$ = new ParsedSqlNode(SCF_CREATE_INDEX);
       CreateIndexSqlNode &create_index = $$->create_index;
-      create_index.index_name = $3;
-      create_index.relation_name = $5;
-      create_index.attribute_name = $7;
+      create_index.unique = ($2 != 0);
+      create_index.index_name = $4;
+      create_index.relation_name = $6;
+      create_index.attribute_names.swap(*$8);
+      delete $8;
+    }
+    ;
+
+opt_unique:
+    /* empty */
+    {
+      $$ = 0;
+    }
+    | UNIQUE
+    {
+      $$ = 1;
     }
     ;
 
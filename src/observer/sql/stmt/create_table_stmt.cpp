@@ -36,6 +36,8 @@ StorageFormat CreateTableStmt::get_storage_format(const char *format_str) {
     format = StorageFormat::ROW_FORMAT;
   } else if (0 == strcasecmp(format_str, "PAX")) {
     format = StorageFormat::PAX_FORMAT;
+  } else if (0 == strcasecmp(format_str, "VAR_ROW")) {
+    format = StorageFormat::VAR_ROW_FORMAT;
   } else {
     format = StorageFormat::UNKNOWN_FORMAT;
   }
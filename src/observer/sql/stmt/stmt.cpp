@@ -27,6 +27,7 @@ See the Mulan PSL v2 for more details. */
 #include "sql/stmt/load_data_stmt.h"
 #include "sql/stmt/select_stmt.h"
 #include "sql/stmt/set_variable_stmt.h"
+#include "sql/stmt/show_status_stmt.h"
 #include "sql/stmt/show_tables_stmt.h"
 #include "sql/stmt/trx_begin_stmt.h"
 #include "sql/stmt/trx_end_stmt.h"
@@ -88,6 +89,10 @@ RC Stmt::create_stmt(Db *db, ParsedSqlNode &sql_node, Stmt *&stmt)
       return ShowTablesStmt::create(db, stmt);
     }
 
+    case SCF_SHOW_STATUS: {
+      return ShowStatusStmt::create(db, stmt);
+    }
+
     case SCF_BEGIN: {
       return TrxBeginStmt::create(stmt);
     }
@@ -17,6 +17,7 @@ See the Mulan PSL v2 for more details. */
 #include "common/io/io.h"
 #include "common/lang/mutex.h"
 #include "common/lang/algorithm.h"
+#include "common/lang/limits.h"
 #include "common/log/log.h"
 #include "common/math/crc.h"
 #include "storage/buffer/disk_buffer_pool.h"
@@ -32,44 +33,85 @@ static const int MEM_POOL_ITEM_NUM = 20;
 string BPFileHeader::to_string() const
 {
   stringstream ss;
-  ss << "pageCount:" << page_count << ", allocatedCount:" << allocated_pages;
+  ss << "pageCount:" << page_count << ", allocatedCount:" << allocated_pages << ", groupCount:" << group_count();
   return ss.str();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-BPFrameManager::BPFrameManager(const char *name) : allocator_(name) {}
+BPFrameManager::BPFrameManager(const char *name, int page_size /* = BP_PAGE_SIZE */)
+    : tag_(name), page_size_(page_size), allocator_(name, page_size)
+{}
 
-RC BPFrameManager::init(int pool_num)
+RC BPFrameManager::init(int pool_num, int shard_num /* = 1 */, const char *replacer_name /* = nullptr */)
 {
-  int ret = allocator_.init(false, pool_num);
-  if (ret == 0) {
-    return RC::SUCCESS;
+  if (shard_num <= 0) {
+    shard_num = 1;
+  }
+  if (shard_num > pool_num) {
+    LOG_WARN("too many frame shards. pool num=%d, shard num=%d, use pool num instead", pool_num, shard_num);
+    shard_num = max(pool_num, 1);
+  }
+
+  int ret = allocator_.init(false, max(pool_num, 1));
+  if (ret != 0) {
+    return RC::NOMEM;
   }
-  return RC::NOMEM;
+
+  shards_.clear();
+  shards_.reserve(shard_num);
+  for (int i = 0; i < shard_num; i++) {
+    auto shard = make_unique<Shard>(allocator_);
+    RC   rc    = FrameReplacer::create(replacer_name, shard->replacer_);
+    if (OB_FAIL(rc)) {
+      LOG_ERROR("failed to create frame replacer. name=%s, rc=%s", replacer_name, strrc(rc));
+      shards_.clear();
+      return rc;
+    }
+    shards_.push_back(std::move(shard));
+  }
+  replacer_name_ = shards_.front()->replacer_->name();
+
+  LOG_INFO("frame manager init done. tag=%s, pool num=%d, shard num=%d, replacer=%s",
+           tag_.c_str(), pool_num, shard_num, replacer_name_.c_str());
+  return RC::SUCCESS;
 }
 
 RC BPFrameManager::cleanup()
 {
-  if (frames_.count() > 0) {
+  if (frame_num() > 0) {
     return RC::INTERNAL;
   }
 
-  frames_.destroy();
+  for (unique_ptr<Shard> &shard : shards_) {
+    shard->frames_.clear();
+  }
   return RC::SUCCESS;
 }
 
-int BPFrameManager::purge_frames(int count, function<RC(Frame *frame)> purger)
+int BPFrameManager::purge_frames(const FrameId &frame_id, int count, function<RC(Frame *frame)> purger)
 {
-  lock_guard<mutex> lock_guard(lock_);
-
-  vector<Frame *> frames_can_purge;
   if (count <= 0) {
     count = 1;
   }
+
+  // 页帧内存是共用的，其它分片淘汰出来的页帧也可以分配给这个页面
+  const size_t home_index  = frame_id.hash() % shards_.size();
+  int          freed_count = 0;
+  for (size_t i = 0; i < shards_.size() && freed_count == 0; i++) {
+    freed_count = shards_[(home_index + i) % shards_.size()]->purge_internal(count, purger);
+  }
+  return freed_count;
+}
+
+int BPFrameManager::Shard::purge_internal(int count, const function<RC(Frame *frame)> &purger)
+{
+  lock_guard<mutex> lock_guard(lock_);
+
+  vector<Frame *> frames_can_purge;
   frames_can_purge.reserve(count);
 
-  auto purge_finder = [&frames_can_purge, count](const FrameId &frame_id, Frame *const frame) {
+  auto purge_finder = [&frames_can_purge, count](Frame *frame) {
     if (frame->can_purge()) {
       frame->pin();
       frames_can_purge.push_back(frame);
@@ -80,11 +122,11 @@ int BPFrameManager::purge_frames(int count, function<RC(Frame *frame)> purger)
     return true;  // true continue to look up
   };
 
-  frames_.foreach_reverse(purge_finder);
+  replacer_->foreach_victim(purge_finder);
   LOG_INFO("purge frames find %ld pages total", frames_can_purge.size());
 
-  /// 当前还在frameManager的锁内，而 purger 是一个非常耗时的操作
-  /// 他需要把脏页数据刷新到磁盘上去，所以这里会极大地降低并发度
+  /// 当前还在分片的锁内，而 purger 是一个非常耗时的操作
+  /// 他需要把脏页数据刷新到磁盘上去，所以这里会降低当前分片的并发度
   int freed_count = 0;
   for (Frame *frame : frames_can_purge) {
     RC rc = purger(frame);
@@ -101,44 +143,63 @@ int BPFrameManager::purge_frames(int count, function<RC(Frame *frame)> purger)
   return freed_count;
 }
 
-Frame *BPFrameManager::get(int buffer_pool_id, PageNum page_num)
+Frame *BPFrameManager::get(int buffer_pool_id, PageNum page_num, bool *prefetched /* = nullptr */)
 {
-  FrameId                     frame_id(buffer_pool_id, page_num);
+  FrameId frame_id(buffer_pool_id, page_num);
+  Shard  &shard = shard_of(frame_id);
 
-  lock_guard<mutex> lock_guard(lock_);
-  return get_internal(frame_id);
+  lock_guard<mutex> lock_guard(shard.lock_);
+  Frame *frame = shard.get_internal(frame_id, prefetched);
+  if (frame != nullptr) {
+    shard.hit_count_.fetch_add(1, memory_order_relaxed);
+  } else {
+    shard.miss_count_.fetch_add(1, memory_order_relaxed);
+  }
+  return frame;
 }
 
-Frame *BPFrameManager::get_internal(const FrameId &frame_id)
+Frame *BPFrameManager::Shard::get_internal(const FrameId &frame_id, bool *prefetched /* = nullptr */)
 {
-  Frame *frame = nullptr;
-  (void)frames_.get(frame_id, frame);
-  if (frame != nullptr) {
-    frame->pin();
-    LOG_DEBUG("got a frame. frame=%s", frame->to_string().c_str());
+  auto iter = frames_.find(frame_id);
+  if (iter == frames_.end()) {
+    return nullptr;
+  }
+
+  Frame *frame = iter->second;
+  replacer_->on_access(frame);
+  frame->pin();
+  const bool is_prefetched = frame->clear_prefetched();
+  if (is_prefetched) {
+    read_ahead_hit_.fetch_add(1, memory_order_relaxed);
+  }
+  if (prefetched != nullptr) {
+    *prefetched = is_prefetched;
   }
+  LOG_DEBUG("got a frame. frame=%s", frame->to_string().c_str());
   return frame;
 }
 
 Frame *BPFrameManager::alloc(int buffer_pool_id, PageNum page_num)
 {
   FrameId frame_id(buffer_pool_id, page_num);
+  Shard  &shard = shard_of(frame_id);
 
-  lock_guard<mutex> lock_guard(lock_);
+  lock_guard<mutex> lock_guard(shard.lock_);
 
-  Frame                      *frame = get_internal(frame_id);
+  Frame *frame = shard.get_internal(frame_id);
   if (frame != nullptr) {
     return frame;
   }
 
-  frame = allocator_.alloc();
+  frame = shard.allocator_.alloc();
   if (frame != nullptr) {
     ASSERT(frame->pin_count() == 0, "got an invalid frame that pin count is not 0. frame=%s", 
            frame->to_string().c_str());
     frame->set_buffer_pool_id(buffer_pool_id);
     frame->set_page_num(page_num);
     frame->pin();
-    frames_.put(frame_id, frame);
+    shard.frames_.emplace(frame_id, frame);
+    shard.replacer_->on_insert(frame);
     LOG_DEBUG("allocate a new frame. frame=%s", frame->to_string().c_str());
   }
   return frame;
@@ -147,77 +208,217 @@ Frame *BPFrameManager::alloc(int buffer_pool_id, PageNum page_num)
 RC BPFrameManager::free(int buffer_pool_id, PageNum page_num, Frame *frame)
 {
   FrameId frame_id(buffer_pool_id, page_num);
+  Shard  &shard = shard_of(frame_id);
 
-  lock_guard<mutex> lock_guard(lock_);
-  return free_internal(frame_id, frame);
+  lock_guard<mutex> lock_guard(shard.lock_);
+  return shard.free_internal(frame_id, frame);
 }
 
-RC BPFrameManager::free_internal(const FrameId &frame_id, Frame *frame)
+RC BPFrameManager::Shard::free_internal(const FrameId &frame_id, Frame *frame)
 {
-  Frame                *frame_source = nullptr;
-  [[maybe_unused]] bool found        = frames_.get(frame_id, frame_source);
+  auto                    iter         = frames_.find(frame_id);
+  [[maybe_unused]] bool   found        = iter != frames_.end();
+  [[maybe_unused]] Frame *frame_source = found ? iter->second : nullptr;
   ASSERT(found && frame == frame_source && frame->pin_count() == 1,
       "failed to free frame. found=%d, frameId=%s, frame_source=%p, frame=%p, pinCount=%d, lbt=%s",
       found, frame_id.to_string().c_str(), frame_source, frame, frame->pin_count(), lbt());
 
+  if (frame->clear_prefetched()) {
+    read_ahead_wasted_.fetch_add(1, memory_order_relaxed);
+  }
+
+  // 淘汰策略可能需要记录被淘汰的页面编号
+  replacer_->on_remove(frame);
   frame->set_page_num(-1);
   frame->unpin();
-  frames_.remove(frame_id);
+  frames_.erase(iter);
   allocator_.free(frame);
   return RC::SUCCESS;
 }
 
-list<Frame *> BPFrameManager::find_list(int buffer_pool_id)
+bool BPFrameManager::contains(int buffer_pool_id, PageNum page_num)
 {
-  lock_guard<mutex> lock_guard(lock_);
+  FrameId frame_id(buffer_pool_id, page_num);
+  Shard  &shard = shard_of(frame_id);
+
+  lock_guard<mutex> lock_guard(shard.lock_);
+  return shard.frames_.find(frame_id) != shard.frames_.end();
+}
 
+void BPFrameManager::mark_prefetched(Frame *frame)
+{
+  Shard &shard = shard_of(frame->frame_id());
+
+  lock_guard<mutex> lock_guard(shard.lock_);
+  shard.read_ahead_count_.fetch_add(1, memory_order_relaxed);
+  if (frame->pin_count() > 1) {
+    // 加载的过程中已经有人在等待这个页面了
+    shard.read_ahead_hit_.fetch_add(1, memory_order_relaxed);
+  } else {
+    frame->set_prefetched();
+  }
+}
+
+list<Frame *> BPFrameManager::find_list(int buffer_pool_id)
+{
   list<Frame *> frames;
-  auto               fetcher = [&frames, buffer_pool_id](const FrameId &frame_id, Frame *const frame) -> bool {
-    if (buffer_pool_id == frame_id.buffer_pool_id()) {
-      frame->pin();
-      frames.push_back(frame);
+  for (unique_ptr<Shard> &shard : shards_) {
+    lock_guard<mutex> lock_guard(shard->lock_);
+    for (auto &[frame_id, frame] : shard->frames_) {
+      if (buffer_pool_id == frame_id.buffer_pool_id()) {
+        frame->pin();
+        frames.push_back(frame);
+      }
     }
-    return true;
-  };
-  frames_.foreach (fetcher);
+  }
   return frames;
 }
 
+vector<Frame *> BPFrameManager::find_dirty_list()
+{
+  // recovery lsn 可能会被并发修改，排序时使用收集时的值
+  vector<pair<LSN, Frame *>> dirty_frames;
+  for (unique_ptr<Shard> &shard : shards_) {
+    lock_guard<mutex> lock_guard(shard->lock_);
+    for (auto &[frame_id, frame] : shard->frames_) {
+      if (frame->dirty()) {
+        frame->pin();
+        dirty_frames.emplace_back(frame->recovery_lsn(), frame);
+      }
+    }
+  }
+
+  sort(dirty_frames.begin(), dirty_frames.end(), [](const pair<LSN, Frame *> &a, const pair<LSN, Frame *> &b) {
+    return a.first < b.first;
+  });
+
+  vector<Frame *> frames;
+  frames.reserve(dirty_frames.size());
+  for (auto &[recovery_lsn, frame] : dirty_frames) {
+    frames.push_back(frame);
+  }
+  return frames;
+}
+
+LSN BPFrameManager::min_recovery_lsn()
+{
+  LSN min_lsn = numeric_limits<LSN>::max();
+  for (unique_ptr<Shard> &shard : shards_) {
+    lock_guard<mutex> lock_guard(shard->lock_);
+    for (auto &[frame_id, frame] : shard->frames_) {
+      if (frame->dirty()) {
+        min_lsn = min(min_lsn, frame->recovery_lsn());
+      }
+    }
+  }
+  return min_lsn;
+}
+
+size_t BPFrameManager::frame_num() const
+{
+  size_t num = 0;
+  for (const unique_ptr<Shard> &shard : shards_) {
+    num += shard->frames_.size();
+  }
+  return num;
+}
+
+size_t BPFrameManager::total_frame_num() const
+{
+  return allocator_.get_size();
+}
+
+BPFrameManager::Stat BPFrameManager::stat() const
+{
+  Stat stat;
+  for (const unique_ptr<Shard> &shard : shards_) {
+    stat.hit_count += shard->hit_count_.load(memory_order_relaxed);
+    stat.miss_count += shard->miss_count_.load(memory_order_relaxed);
+    stat.read_ahead_count += shard->read_ahead_count_.load(memory_order_relaxed);
+    stat.read_ahead_hit += shard->read_ahead_hit_.load(memory_order_relaxed);
+    stat.read_ahead_wasted += shard->read_ahead_wasted_.load(memory_order_relaxed);
+  }
+  return stat;
+}
+
+double BPFrameManager::Stat::hit_ratio() const
+{
+  const int64_t total = hit_count + miss_count;
+  return total == 0 ? 0.0 : static_cast<double>(hit_count) / total;
+}
+
+string BPFrameManager::Stat::to_string() const
+{
+  stringstream ss;
+  ss << "hit:" << hit_count << ", miss:" << miss_count << ", hit ratio:" << hit_ratio()
+     << ", read ahead:" << read_ahead_count << ", read ahead hit:" << read_ahead_hit
+     << ", read ahead wasted:" << read_ahead_wasted;
+  return ss.str();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 BufferPoolIterator::BufferPoolIterator() {}
 BufferPoolIterator::~BufferPoolIterator() {}
 RC BufferPoolIterator::init(DiskBufferPool &bp, PageNum start_page /* = 0 */)
 {
-  bitmap_.init(bp.file_header_->bitmap, bp.file_header_->page_count);
+  buffer_pool_ = &bp;
   if (start_page <= 0) {
     current_page_num_ = -1;
   } else {
     current_page_num_ = start_page - 1;
   }
+  next_found_ = false;
   return RC::SUCCESS;
 }
 
-bool BufferPoolIterator::has_next() { return bitmap_.next_setted_bit(current_page_num_ + 1) != -1; }
+bool BufferPoolIterator::has_next()
+{
+  if (!next_found_) {
+    next_page_num_ = buffer_pool_->next_allocated_page(current_page_num_ + 1);
+    next_found_    = true;
+  }
+  return next_page_num_ != BP_INVALID_PAGE_NUM;
+}
 
 PageNum BufferPoolIterator::next()
 {
-  PageNum next_page = bitmap_.next_setted_bit(current_page_num_ + 1);
-  if (next_page != -1) {
-    current_page_num_ = next_page;
+  if (!has_next()) {
+    return BP_INVALID_PAGE_NUM;
   }
-  return next_page;
+
+  current_page_num_ = next_page_num_;
+  next_found_       = false;
+  return current_page_num_;
 }
 
 RC BufferPoolIterator::reset()
 {
   current_page_num_ = 0;
+  next_found_       = false;
   return RC::SUCCESS;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+bool BufferRing::need_ring(DiskBufferPool &buffer_pool)
+{
+  return static_cast<size_t>(buffer_pool.page_count()) * 4 > buffer_pool.frame_manager_->total_frame_num();
+}
+
+PageNum BufferRing::pop()
+{
+  if (pages_.empty()) {
+    return BP_INVALID_PAGE_NUM;
+  }
+
+  PageNum page_num = pages_.front();
+  pages_.pop_front();
+  return page_num;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 DiskBufferPool::DiskBufferPool(
     BufferPoolManager &bp_manager, BPFrameManager &frame_manager, DoubleWriteBuffer &dblwr_manager, LogHandler &log_handler)
-    : bp_manager_(bp_manager), frame_manager_(frame_manager), dblwr_manager_(dblwr_manager), log_handler_(*this, log_handler)
+    : bp_manager_(bp_manager), frame_manager_(&frame_manager), dblwr_manager_(dblwr_manager), log_handler_(*this, log_handler)
 {}
 
 DiskBufferPool::~DiskBufferPool()
@@ -226,9 +427,33 @@ DiskBufferPool::~DiskBufferPool()
   LOG_INFO("disk buffer pool exit");
 }
 
+/**
+ * @brief 打开数据文件，需要时使用 O_DIRECT
+ * @details 有些文件系统(比如 tmpfs)不支持 O_DIRECT，这时退化成普通的读写
+ */
+static int open_data_file(const char *file_name, bool direct_io)
+{
+  if (direct_io) {
+#if defined(O_DIRECT)
+    int fd = open(file_name, O_RDWR | O_DIRECT);
+    if (fd >= 0 || errno != EINVAL) {
+      return fd;
+    }
+    LOG_WARN("file system does not support direct io, fall back to buffered io. file=%s", file_name);
+#elif defined(F_NOCACHE)
+    int fd = open(file_name, O_RDWR);
+    if (fd >= 0 && fcntl(fd, F_NOCACHE, 1) == -1) {
+      LOG_WARN("failed to disable page cache, fall back to buffered io. file=%s, error=%s", file_name, strerror(errno));
+    }
+    return fd;
+#endif
+  }
+  return open(file_name, O_RDWR);
+}
+
 RC DiskBufferPool::open_file(const char *file_name)
 {
-  int fd = open(file_name, O_RDWR);
+  int fd = open_data_file(file_name, bp_manager_.direct_io());
   if (fd < 0) {
     LOG_ERROR("Failed to open file %s, because %s.", file_name, strerror(errno));
     return RC::IOERR_ACCESS;
@@ -238,19 +463,49 @@ RC DiskBufferPool::open_file(const char *file_name)
   file_name_ = file_name;
   file_desc_ = fd;
 
-  Page header_page;
-  int ret = readn(file_desc_, &header_page, sizeof(header_page));
-  if (ret != 0) {
+  // 使用 O_DIRECT 时读写的内存也需要对齐，不能直接读到栈上
+  // 文件头只在第一个页面的前 BP_PAGE_SIZE 个字节中，先读出来才知道文件的页面大小
+  unique_ptr<Page, decltype(&::free)> header_page(
+      static_cast<Page *>(aligned_alloc(BP_PAGE_ALIGNMENT, sizeof(Page))), &::free);
+  if (header_page == nullptr) {
+    LOG_ERROR("Failed to allocate memory for the first page of %s.", file_name);
+    close(fd);
+    file_desc_ = -1;
+    return RC::NOMEM;
+  }
+
+  RC rc = bp_manager_.io_engine().read(file_desc_, header_page.get(), BP_PAGE_SIZE, 0);
+  if (OB_FAIL(rc)) {
     LOG_ERROR("Failed to read first page of %s, due to %s.", file_name, strerror(errno));
     close(fd);
     file_desc_ = -1;
     return RC::IOERR_READ;
   }
 
-  BPFileHeader *tmp_file_header = reinterpret_cast<BPFileHeader *>(header_page.data);
+  BPFileHeader *tmp_file_header = reinterpret_cast<BPFileHeader *>(header_page->data);
   buffer_pool_id_ = tmp_file_header->buffer_pool_id;
+  page_size_      = tmp_file_header->page_size;
+  if (!bp_valid_page_size(page_size_)) {
+    LOG_ERROR("Invalid page size of %s. page size=%d", file_name, page_size_);
+    close(fd);
+    file_desc_ = -1;
+    return RC::INTERNAL;
+  }
 
-  RC rc = allocate_frame(BP_HEADER_PAGE, &hdr_frame_);
+  rc = bp_manager_.get_frame_manager(page_size_, frame_manager_);
+  if (OB_FAIL(rc)) {
+    LOG_ERROR("Failed to get frame manager of page size %d. file=%s, rc=%s", page_size_, file_name, strrc(rc));
+    close(fd);
+    file_desc_ = -1;
+    return rc;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) == 0) {
+    file_page_num_ = static_cast<PageNum>(st.st_size / page_size_);
+  }
+
+  rc = allocate_frame(BP_HEADER_PAGE, &hdr_frame_);
   if (rc != RC::SUCCESS) {
     LOG_ERROR("failed to allocate frame for header. file name %s", file_name_.c_str());
     close(fd);
@@ -271,6 +526,10 @@ RC DiskBufferPool::open_file(const char *file_name)
 
   file_header_ = (BPFileHeader *)hdr_frame_->data();
 
+  if (bp_manager_.read_ahead_window() > 0) {
+    read_ahead_detector_ = make_unique<ReadAheadDetector>(bp_manager_.read_ahead_window());
+  }
+
   LOG_INFO("Successfully open %s. file_desc=%d, hdr_frame=%p, file header=%s",
            file_name, file_desc_, hdr_frame_, file_header_->to_string().c_str());
   return RC::SUCCESS;
@@ -283,10 +542,23 @@ RC DiskBufferPool::close_file()
     return rc;
   }
 
+  // 预读任务会访问当前文件，需要等它们都结束
+  while (read_ahead_pending_.load() > 0) {
+    this_thread::yield();
+  }
+
   hdr_frame_->unpin();
 
-  // TODO: 理论上是在回放时回滚未提交事务，但目前没有undo log，因此不下刷数据page，只通过redo log回放
-  rc = purge_all_pages();
+  {
+    // 页面清理线程会pin住正在刷新的页面，需要等它结束当前一轮
+    unique_lock<mutex> cleaner_guard;
+    if (PageCleaner *page_cleaner = bp_manager_.page_cleaner(); page_cleaner != nullptr) {
+      cleaner_guard = unique_lock<mutex>(page_cleaner->flush_lock());
+    }
+
+    // TODO: 理论上是在回放时回滚未提交事务，但目前没有undo log，因此不下刷数据page，只通过redo log回放
+    rc = purge_all_pages();
+  }
   if (rc != RC::SUCCESS) {
     LOG_ERROR("failed to close %s, due to failed to purge pages. rc=%s", file_name_.c_str(), strrc(rc));
     return rc;
@@ -311,24 +583,79 @@ RC DiskBufferPool::close_file()
   return RC::SUCCESS;
 }
 
-RC DiskBufferPool::get_this_page(PageNum page_num, Frame **frame)
+RC DiskBufferPool::get_this_page(PageNum page_num, Frame **frame, BufferRing *ring /* = nullptr */)
 {
   RC rc  = RC::SUCCESS;
   *frame = nullptr;
 
-  Frame *used_match_frame = frame_manager_.get(id(), page_num);
+  PageNum read_ahead_start = BP_INVALID_PAGE_NUM;
+  int     read_ahead_count = 0;
+  if (read_ahead_detector_ && read_ahead_detector_->on_access(page_num, read_ahead_start, read_ahead_count)) {
+    (void)read_ahead(read_ahead_start, read_ahead_count);
+  }
+
+  auto recycle_ring_page = [this, ring]() {
+    if (ring == nullptr || !ring->full()) {
+      return;
+    }
+    // 把环中最早加载的页面还给缓冲池，新页面就可以复用这个页帧，而不是淘汰其它的页面
+    // 如果这个页面正在被其它人使用，就不管它了，由缓冲池按照正常的方式淘汰
+    PageNum recycle_page_num = ring->pop();
+    RC      recycle_rc       = purge_page(recycle_page_num);
+    if (OB_FAIL(recycle_rc)) {
+      LOG_TRACE("failed to recycle page in buffer ring. page_num=%d, rc=%s", recycle_page_num, strrc(recycle_rc));
+    }
+  };
+
+  bool   prefetched       = false;
+  Frame *used_match_frame = frame_manager_->get(id(), page_num, &prefetched);
   if (used_match_frame != nullptr) {
+    if (used_match_frame->loading()) {
+      // 其它线程(比如预读)正在加载这个页面，加载时持有 load_lock_
+      scoped_lock wait_guard(load_lock_);
+      if (used_match_frame->loading()) {
+        LOG_WARN("failed to load page. file=%s, page_num=%d", file_name_.c_str(), page_num);
+        used_match_frame->unpin();
+        return RC::IOERR_READ;
+      }
+    }
+
     used_match_frame->access();
+    if (ring != nullptr && prefetched) {
+      // 为这次扫描预读的页面，也交给环管理，否则预读会绕过环污染整个缓冲池
+      recycle_ring_page();
+      ring->push(page_num);
+    }
     *frame = used_match_frame;
     return RC::SUCCESS;
   }
 
+  recycle_ring_page();
+
   scoped_lock lock_guard(lock_);  // 直接加了一把大锁，其实可以根据访问的页面来细化提高并行度
 
+  Frame *allocated_frame = nullptr;
+  rc = load_frame(page_num, &allocated_frame);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  if (ring != nullptr) {
+    ring->push(page_num);
+  }
+
+  *frame = allocated_frame;
+  return RC::SUCCESS;
+}
+
+RC DiskBufferPool::load_frame(PageNum page_num, Frame **frame)
+{
+  scoped_lock load_guard(load_lock_);
+
   // Allocate one page and load the data into this page
   Frame *allocated_frame = nullptr;
 
-  rc = allocate_frame(page_num, &allocated_frame);
+  RC rc = allocate_frame(page_num, &allocated_frame);
   if (rc != RC::SUCCESS) {
     LOG_ERROR("Failed to alloc frame %s:%d, due to failed to alloc page.", file_name_.c_str(), page_num);
     return rc;
@@ -337,52 +664,146 @@ RC DiskBufferPool::get_this_page(PageNum page_num, Frame **frame)
   allocated_frame->set_buffer_pool_id(id());
   // allocated_frame->pin(); // pined in manager::get
   allocated_frame->access();
+  allocated_frame->set_loading(true);
 
   if ((rc = load_page(page_num, allocated_frame)) != RC::SUCCESS) {
     LOG_ERROR("Failed to load page %s:%d", file_name_.c_str(), page_num);
     purge_frame(page_num, allocated_frame);
     return rc;
   }
+  allocated_frame->set_loading(false);
 
   *frame = allocated_frame;
   return RC::SUCCESS;
 }
 
+RC DiskBufferPool::read_ahead(PageNum start_page, int count)
+{
+  if (bp_manager_.read_ahead_window() <= 0 || start_page <= BP_HEADER_PAGE || count <= 0) {
+    return RC::SUCCESS;
+  }
+
+  vector<PageNum> page_nums;
+  const PageNum   end_page = min(start_page + count, page_count());
+  for (PageNum page_num = start_page; page_num < end_page; page_num++) {
+    if (!frame_manager_->contains(id(), page_num)) {
+      page_nums.push_back(page_num);
+    }
+  }
+  if (page_nums.empty()) {
+    return RC::SUCCESS;
+  }
+
+  read_ahead_pending_++;
+  RC rc = bp_manager_.execute_read_ahead([this, page_nums = std::move(page_nums)]() {
+    RC rc = prefetch_pages(page_nums);
+    if (OB_FAIL(rc)) {
+      LOG_TRACE("failed to read ahead pages. file=%s, page_num=%d, count=%d, rc=%s",
+                file_name_.c_str(), page_nums.front(), static_cast<int>(page_nums.size()), strrc(rc));
+    }
+    read_ahead_pending_--;
+  });
+  if (OB_FAIL(rc)) {
+    read_ahead_pending_--;
+  }
+  return rc;
+}
+
+RC DiskBufferPool::prefetch_pages(const vector<PageNum> &page_nums)
+{
+  // 读取磁盘时持有 lock_，与 get_this_page 一样，避免读到被并发修改和刷出的旧数据
+  scoped_lock lock_guard(lock_);
+  scoped_lock load_guard(load_lock_);
+
+  vector<Frame *>   frames;
+  vector<IoRequest> requests;
+  vector<Frame *>   request_frames;
+  for (PageNum page_num : page_nums) {
+    // 页面可能已经被加载，或者在提交预读任务之后被释放了
+    if (frame_manager_->contains(id(), page_num) || OB_FAIL(check_page_num(page_num))) {
+      continue;
+    }
+
+    Frame *frame = nullptr;
+    RC     rc    = allocate_frame(page_num, &frame);
+    if (OB_FAIL(rc)) {
+      break;
+    }
+
+    frame->set_buffer_pool_id(id());
+    frame->access();
+    frame->set_loading(true);
+    frames.push_back(frame);
+
+    if (OB_SUCC(dblwr_manager_.read_page(this, page_num, frame->page()))) {
+      frame_manager_->mark_prefetched(frame);
+      frame->set_loading(false);
+      continue;
+    }
+    requests.push_back(IoRequest::read(file_desc_, &frame->page(), page_size_, (int64_t)page_num * page_size_));
+    request_frames.push_back(frame);
+  }
+
+  // 所有的页面一起提交读请求
+  RC rc = bp_manager_.io_engine().submit(requests);
+  for (size_t i = 0; i < requests.size(); i++) {
+    if (OB_FAIL(requests[i].rc)) {
+      Frame *frame = request_frames[i];
+      frames.erase(find(frames.begin(), frames.end(), frame));
+      if (OB_FAIL(purge_frame(frame->page_num(), frame))) {
+        frame->unpin();
+      }
+    } else {
+      frame_manager_->mark_prefetched(request_frames[i]);
+      request_frames[i]->set_loading(false);
+    }
+  }
+
+  for (Frame *frame : frames) {
+    frame->unpin();
+  }
+  return rc;
+}
+
 RC DiskBufferPool::allocate_page(Frame **frame)
 {
   RC rc = RC::SUCCESS;
 
   lock_.lock();
 
-  int byte = 0, bit = 0;
+  PageNum page_num = BP_INVALID_PAGE_NUM;
   if ((file_header_->allocated_pages) < (file_header_->page_count)) {
     // There is one free page
-    for (int i = 0; i < file_header_->page_count; i++) {
-      byte = i / 8;
-      bit  = i % 8;
-      if (((file_header_->bitmap[byte]) & (1 << bit)) == 0) {
-        (file_header_->allocated_pages)++;
-        file_header_->bitmap[byte] |= (1 << bit);
-        // TODO,  do we need clean the loaded page's data?
-        hdr_frame_->mark_dirty();
-        LSN lsn = 0;
-        rc = log_handler_.allocate_page(i, lsn);
-        if (OB_FAIL(rc)) {
-          LOG_ERROR("Failed to log allocate page %d, rc=%s", i, strrc(rc));
-          // 忽略了错误
-        }
-
-        hdr_frame_->set_lsn(lsn);
+    page_num = find_free_page();
+  }
 
-        LOG_DEBUG("allocate a new page without extend buffer pool. page num=%d, buffer pool=%d", i, id());
+  if (page_num != BP_INVALID_PAGE_NUM) {
+    LSN lsn = 0;
+    rc = log_handler_.allocate_page(page_num, lsn);
+    if (OB_FAIL(rc)) {
+      LOG_ERROR("Failed to log allocate page %d, rc=%s", page_num, strrc(rc));
+      // 忽略了错误
+    }
 
-        lock_.unlock();
-        return get_this_page(i, frame);
-      }
+    // TODO,  do we need clean the loaded page's data?
+    rc = set_page_allocated(page_num, true, lsn, false /*redo*/);
+    lock_.unlock();
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to allocate page %d. file=%s, rc=%s", page_num, file_name_.c_str(), strrc(rc));
+      return rc;
     }
+
+    LOG_DEBUG("allocate a new page without extend buffer pool. page num=%d, buffer pool=%d", page_num, id());
+    return get_this_page(page_num, frame);
+  }
+
+  // 扩展到新组的第一个页面时，这个页面是位图页，分配它后面的页面
+  page_num = file_header_->page_count;
+  if (BPFileHeader::is_bitmap_page(page_num)) {
+    page_num++;
   }
 
-  if (file_header_->page_count >= BPFileHeader::MAX_PAGE_NUM) {
+  if (page_num >= BPFileHeader::MAX_PAGE_NUM) {
     LOG_WARN("file buffer pool is full. page count %d, max page count %d",
         file_header_->page_count, BPFileHeader::MAX_PAGE_NUM);
     lock_.unlock();
@@ -390,15 +811,20 @@ RC DiskBufferPool::allocate_page(Frame **frame)
   }
 
   LSN lsn = 0;
-  rc = log_handler_.allocate_page(file_header_->page_count, lsn);
+  rc = log_handler_.allocate_page(page_num, lsn);
   if (OB_FAIL(rc)) {
-    LOG_ERROR("Failed to log allocate page %d, rc=%s", file_header_->page_count, strrc(rc));
+    LOG_ERROR("Failed to log allocate page %d, rc=%s", page_num, strrc(rc));
     // 忽略了错误
   }
-  hdr_frame_->set_lsn(lsn);
 
-  PageNum page_num        = file_header_->page_count;
-  Frame  *allocated_frame = nullptr;
+  if (OB_FAIL(rc = extend_pages(page_num, lsn, false /*redo*/)) ||
+      OB_FAIL(rc = set_page_allocated(page_num, true, lsn, false /*redo*/))) {
+    LOG_WARN("failed to extend buffer pool. file=%s, page num=%d, rc=%s", file_name_.c_str(), page_num, strrc(rc));
+    lock_.unlock();
+    return rc;
+  }
+
+  Frame *allocated_frame = nullptr;
   if ((rc = allocate_frame(page_num, &allocated_frame)) != RC::SUCCESS) {
     LOG_ERROR("Failed to allocate frame %s, due to no free page.", file_name_.c_str());
     lock_.unlock();
@@ -408,21 +834,14 @@ RC DiskBufferPool::allocate_page(Frame **frame)
   LOG_INFO("allocate new page by extending bufferpool. buffer_pool_id=%d, pageNum=%d, pin=%d",
            id(), page_num, allocated_frame->pin_count());
 
-  file_header_->allocated_pages++;
-  file_header_->page_count++;
-
-  byte = page_num / 8;
-  bit  = page_num % 8;
-  file_header_->bitmap[byte] |= (1 << bit);
-  hdr_frame_->mark_dirty();
-
   allocated_frame->set_buffer_pool_id(id());
   allocated_frame->access();
   allocated_frame->clear_page();
-  allocated_frame->set_page_num(file_header_->page_count - 1);
+  allocated_frame->set_page_num(page_num);
 
+  // 页面已经在预先分配的空间中时，从文件读取到的就是全0，不需要再写一次
   // Use flush operation to extension file
-  if ((rc = flush_page_internal(*allocated_frame)) != RC::SUCCESS) {
+  if (page_num >= file_page_num_ && (rc = flush_page_internal(*allocated_frame)) != RC::SUCCESS) {
     LOG_WARN("Failed to alloc page %s , due to failed to extend one page.", file_name_.c_str());
     // skip return false, delay flush the extended page
     // return tmp;
@@ -440,12 +859,16 @@ RC DiskBufferPool::dispose_page(PageNum page_num)
     LOG_ERROR("Failed to dispose page %d, because it is the first page. filename=%s", page_num, file_name_.c_str());
     return RC::INTERNAL;
   }
+  if (BPFileHeader::is_bitmap_page(page_num)) {
+    LOG_ERROR("Failed to dispose page %d, because it is a bitmap page. filename=%s", page_num, file_name_.c_str());
+    return RC::INTERNAL;
+  }
   
   scoped_lock lock_guard(lock_);
-  Frame           *used_frame = frame_manager_.get(id(), page_num);
+  Frame           *used_frame = frame_manager_->get(id(), page_num);
   if (used_frame != nullptr) {
     ASSERT("the page try to dispose is in use. frame:%s", used_frame->to_string().c_str());
-    frame_manager_.free(id(), page_num, used_frame);
+    frame_manager_->free(id(), page_num, used_frame);
   } else {
     LOG_DEBUG("page not found in memory while disposing it. pageNum=%d", page_num);
   }
@@ -457,14 +880,312 @@ RC DiskBufferPool::dispose_page(PageNum page_num)
     // ignore error handle
   }
 
-  hdr_frame_->set_lsn(lsn);
+  return set_page_allocated(page_num, false, lsn, false /*redo*/);
+}
+
+PageNum DiskBufferPool::find_free_page()
+{
+  Bitmap group_bitmap(file_header_->group_bitmap, file_header_->group_count());
+  for (int group = group_bitmap.next_setted_bit(0); group != -1; group = group_bitmap.next_setted_bit(group + 1)) {
+    const PageNum start_page = BPFileHeader::group_start(group);
+    if (group == 0) {
+      if (file_header_->free_pages > 0) {
+        Bitmap bitmap(file_header_->bitmap, min(file_header_->page_count, BPFileHeader::FIRST_GROUP_PAGE_NUM));
+        int    index = bitmap.next_unsetted_bit(1);
+        if (index != -1) {
+          return index;
+        }
+      }
+    } else {
+      Frame *bitmap_frame = nullptr;
+      RC     rc           = get_bitmap_frame(group, &bitmap_frame);
+      if (OB_FAIL(rc)) {
+        LOG_WARN("failed to get bitmap page. file=%s, group=%d, rc=%s", file_name_.c_str(), group, strrc(rc));
+        continue;
+      }
+
+      auto bitmap_page = reinterpret_cast<BPBitmapPage *>(bitmap_frame->data());
+      int  index       = -1;
+      if (bitmap_page->free_pages > 0) {
+        Bitmap bitmap(bitmap_page->bitmap, min(file_header_->page_count - start_page, BPBitmapPage::PAGE_NUM));
+        index = bitmap.next_unsetted_bit(1);
+      }
+      bitmap_frame->unpin();
+      if (index != -1) {
+        return start_page + index;
+      }
+    }
+
+    // 组位图只是一个提示，这个组中其实已经没有空闲页面了
+    group_bitmap.clear_bit(group);
+    hdr_frame_->mark_dirty();
+  }
+  return BP_INVALID_PAGE_NUM;
+}
+
+RC DiskBufferPool::get_bitmap_frame(int group, Frame **frame, bool create /* = false */)
+{
+  const PageNum page_num     = BPFileHeader::group_start(group);
+  Frame        *bitmap_frame = frame_manager_->get(id(), page_num);
+  if (bitmap_frame != nullptr) {
+    // 持有 lock_ 时不会有其它线程正在加载当前文件的页面
+    bitmap_frame->access();
+    *frame = bitmap_frame;
+    return RC::SUCCESS;
+  }
+
+  if (!create) {
+    return load_frame(page_num, frame);
+  }
+
+  RC rc = allocate_frame(page_num, &bitmap_frame);
+  if (OB_FAIL(rc)) {
+    LOG_ERROR("Failed to allocate frame for bitmap page %s:%d. rc=%s", file_name_.c_str(), page_num, strrc(rc));
+    return rc;
+  }
+
+  bitmap_frame->set_buffer_pool_id(id());
+  bitmap_frame->access();
+  bitmap_frame->clear_page();
+  bitmap_frame->set_page_num(page_num);
+
+  // 位图页自己总是已分配的
+  auto bitmap_page = reinterpret_cast<BPBitmapPage *>(bitmap_frame->data());
+  bitmap_page->bitmap[0] |= 0x01;
+  bitmap_frame->mark_dirty();
+
+  *frame = bitmap_frame;
+  return RC::SUCCESS;
+}
+
+RC DiskBufferPool::reserve_pages(PageNum page_num)
+{
+  if (page_num < file_page_num_) {
+    return RC::SUCCESS;
+  }
+
+  const int64_t extent_page_num = bp_manager_.extent_page_num();
+  const int64_t new_page_num    = min<int64_t>((page_num / extent_page_num + 1) * extent_page_num,
+      BPFileHeader::MAX_PAGE_NUM);
+  const off_t   offset          = static_cast<off_t>(file_page_num_) * page_size_;
+  const off_t   length          = static_cast<off_t>(new_page_num - file_page_num_) * page_size_;
+
+  int ret = -1;
+#ifdef __linux__
+  ret = fallocate(file_desc_, 0 /*mode*/, offset, length);
+  if (ret != 0 && errno != EOPNOTSUPP && errno != ENOSYS) {
+    LOG_WARN("failed to preallocate pages. file=%s, page num=%d, new page num=%ld, error=%s",
+             file_name_.c_str(), file_page_num_, new_page_num, strerror(errno));
+    return RC::IOERR_WRITE;
+  }
+#endif
+
+  // 文件系统不支持 fallocate，只扩大文件，读取没有写过的页面时是全0
+  if (ret != 0 && ftruncate(file_desc_, offset + length) != 0) {
+    LOG_WARN("failed to extend file. file=%s, page num=%d, new page num=%ld, error=%s",
+             file_name_.c_str(), file_page_num_, new_page_num, strerror(errno));
+    return RC::IOERR_WRITE;
+  }
+
+  LOG_DEBUG("reserve pages for file %s. page num=%d, new page num=%ld", file_name_.c_str(), file_page_num_, new_page_num);
+  file_page_num_ = static_cast<PageNum>(new_page_num);
+  return RC::SUCCESS;
+}
+
+RC DiskBufferPool::extend_pages(PageNum page_num, LSN lsn, bool redo)
+{
+  // 分配空间失败时，新页面通过刷盘来扩展文件
+  RC rc = reserve_pages(page_num);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to reserve pages, extend the file page by page. file=%s, page num=%d, rc=%s",
+             file_name_.c_str(), page_num, strrc(rc));
+  }
+
+  // 这里不修改页面的LSN，由接下来的 set_page_allocated 统一设置，否则它会认为修改已经做过了
+  Bitmap group_bitmap(file_header_->group_bitmap, BPFileHeader::GROUP_BITMAP_SIZE * 8);
+  while (file_header_->page_count <= page_num) {
+    const PageNum new_page = file_header_->page_count;
+    const int     group    = BPFileHeader::group_of(new_page);
+    if (group == 0) {
+      file_header_->free_pages++;
+      file_header_->page_count++;
+      group_bitmap.set_bit(group);
+      continue;
+    }
+
+    Frame *bitmap_frame = nullptr;
+    if (BPFileHeader::is_bitmap_page(new_page)) {
+      // 回放日志时，位图页可能已经写到了文件中
+      rc = RC::SUCCESS;
+      if (!redo || OB_FAIL(get_bitmap_frame(group, &bitmap_frame))) {
+        rc = get_bitmap_frame(group, &bitmap_frame, true /*create*/);
+      }
+      if (OB_FAIL(rc)) {
+        LOG_WARN("failed to create bitmap page. file=%s, page num=%d, rc=%s", file_name_.c_str(), new_page, strrc(rc));
+        return rc;
+      }
+
+      // 读到的是预先分配的空间，位图页还没有写过
+      auto bitmap_page = reinterpret_cast<BPBitmapPage *>(bitmap_frame->data());
+      if ((bitmap_page->bitmap[0] & 0x01) == 0) {
+        bitmap_page->bitmap[0] |= 0x01;
+        bitmap_frame->mark_dirty();
+      }
+
+      // 与普通页面一样，没有预先分配空间时通过刷新页面来扩展文件
+      if (!redo && new_page >= file_page_num_ && OB_FAIL(rc = flush_page_internal(*bitmap_frame))) {
+        LOG_WARN("failed to flush bitmap page. file=%s, page num=%d, rc=%s", file_name_.c_str(), new_page, strrc(rc));
+      }
+      bitmap_frame->unpin();
+
+      file_header_->page_count++;
+      file_header_->allocated_pages++;
+      LOG_INFO("add a new page group. file=%s, group=%d, bitmap page=%d", file_name_.c_str(), group, new_page);
+      continue;
+    }
+
+    rc = get_bitmap_frame(group, &bitmap_frame);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to get bitmap page. file=%s, group=%d, rc=%s", file_name_.c_str(), group, strrc(rc));
+      return rc;
+    }
+    if (!redo || lsn <= 0 || bitmap_frame->lsn() < lsn) {
+      reinterpret_cast<BPBitmapPage *>(bitmap_frame->data())->free_pages++;
+      bitmap_frame->mark_dirty();
+    }
+    bitmap_frame->unpin();
+
+    file_header_->page_count++;
+    group_bitmap.set_bit(group);
+  }
+
+  hdr_frame_->mark_dirty();
+  return RC::SUCCESS;
+}
+
+RC DiskBufferPool::set_page_allocated(PageNum page_num, bool allocated, LSN lsn, bool redo)
+{
+  if (page_num <= BP_HEADER_PAGE || page_num >= file_header_->page_count || BPFileHeader::is_bitmap_page(page_num)) {
+    LOG_WARN("invalid page num. file=%s, page num=%d, page count=%d",
+             file_name_.c_str(), page_num, file_header_->page_count);
+    return RC::BUFFERPOOL_INVALID_PAGE_NUM;
+  }
+
+  // 回放日志时，文件头和位图页分别根据自己的LSN判断是否需要修改。lsn 为0时不检查也不设置LSN
+  auto need_apply = [redo, lsn](Frame *frame) { return !redo || lsn <= 0 || frame->lsn() < lsn; };
+
+  const int group = BPFileHeader::group_of(page_num);
+  bool      group_has_free_page = false;
+  if (group == 0) {
+    if (!need_apply(hdr_frame_)) {
+      return RC::SUCCESS;
+    }
+
+    Bitmap bitmap(file_header_->bitmap, BPFileHeader::FIRST_GROUP_PAGE_NUM);
+    if (bitmap.get_bit(page_num) == allocated) {
+      LOG_DEBUG("page has been %s. file=%s, page num=%d",
+                allocated ? "allocated" : "deallocated", file_name_.c_str(), page_num);
+      return allocated ? RC::SUCCESS : RC::INTERNAL;
+    }
+
+    if (allocated) {
+      bitmap.set_bit(page_num);
+      file_header_->free_pages--;
+    } else {
+      bitmap.clear_bit(page_num);
+      file_header_->free_pages++;
+    }
+    group_has_free_page = file_header_->free_pages > 0;
+  } else {
+    Frame *bitmap_frame = nullptr;
+    RC     rc           = get_bitmap_frame(group, &bitmap_frame);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to get bitmap page. file=%s, group=%d, rc=%s", file_name_.c_str(), group, strrc(rc));
+      return rc;
+    }
+
+    auto bitmap_page = reinterpret_cast<BPBitmapPage *>(bitmap_frame->data());
+    if (need_apply(bitmap_frame)) {
+      Bitmap    bitmap(bitmap_page->bitmap, BPBitmapPage::PAGE_NUM);
+      const int index = page_num - BPFileHeader::group_start(group);
+      if (bitmap.get_bit(index) == allocated) {
+        bitmap_frame->unpin();
+        LOG_DEBUG("page has been %s. file=%s, page num=%d",
+                  allocated ? "allocated" : "deallocated", file_name_.c_str(), page_num);
+        return allocated ? RC::SUCCESS : RC::INTERNAL;
+      }
+
+      if (allocated) {
+        bitmap.set_bit(index);
+        bitmap_page->free_pages--;
+      } else {
+        bitmap.clear_bit(index);
+        bitmap_page->free_pages++;
+      }
+      if (lsn > 0) {
+        bitmap_frame->set_lsn(lsn);
+      }
+      bitmap_frame->mark_dirty();
+    }
+    group_has_free_page = bitmap_page->free_pages > 0;
+    bitmap_frame->unpin();
+
+    if (!need_apply(hdr_frame_)) {
+      return RC::SUCCESS;
+    }
+  }
+
+  file_header_->allocated_pages += allocated ? 1 : -1;
+  Bitmap group_bitmap(file_header_->group_bitmap, BPFileHeader::GROUP_BITMAP_SIZE * 8);
+  if (group_has_free_page) {
+    group_bitmap.set_bit(group);
+  } else {
+    group_bitmap.clear_bit(group);
+  }
+  if (lsn > 0) {
+    hdr_frame_->set_lsn(lsn);
+  }
   hdr_frame_->mark_dirty();
-  file_header_->allocated_pages--;
-  char tmp = 1 << (page_num % 8);
-  file_header_->bitmap[page_num / 8] &= ~tmp;
   return RC::SUCCESS;
 }
 
+PageNum DiskBufferPool::next_allocated_page(PageNum start_page)
+{
+  scoped_lock lock_guard(lock_);
+
+  PageNum page_num = max(start_page, 0);
+  while (page_num < file_header_->page_count) {
+    const int     group      = BPFileHeader::group_of(page_num);
+    const PageNum group_page = BPFileHeader::group_start(group);
+    if (group == 0) {
+      Bitmap bitmap(file_header_->bitmap, min(file_header_->page_count, BPFileHeader::FIRST_GROUP_PAGE_NUM));
+      int    index = bitmap.next_setted_bit(max(page_num, 1));
+      if (index != -1) {
+        return index;
+      }
+      page_num = BPFileHeader::FIRST_GROUP_PAGE_NUM;
+      continue;
+    }
+
+    Frame *bitmap_frame = nullptr;
+    RC     rc           = get_bitmap_frame(group, &bitmap_frame);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to get bitmap page. file=%s, group=%d, rc=%s", file_name_.c_str(), group, strrc(rc));
+      return BP_INVALID_PAGE_NUM;
+    }
+
+    auto   bitmap_page = reinterpret_cast<BPBitmapPage *>(bitmap_frame->data());
+    Bitmap bitmap(bitmap_page->bitmap, min(file_header_->page_count - group_page, BPBitmapPage::PAGE_NUM));
+    int    index = bitmap.next_setted_bit(max(page_num - group_page, 1));
+    bitmap_frame->unpin();
+    if (index != -1) {
+      return group_page + index;
+    }
+    page_num = group_page + BPBitmapPage::PAGE_NUM;
+  }
+  return BP_INVALID_PAGE_NUM;
+}
+
 RC DiskBufferPool::unpin_page(Frame *frame)
 {
   frame->unpin();
@@ -488,7 +1209,7 @@ RC DiskBufferPool::purge_frame(PageNum page_num, Frame *buf)
   }
 
   LOG_DEBUG("Successfully purge frame =%p, page %d frame_id=%s", buf, buf->page_num(), buf->frame_id().to_string().c_str());
-  frame_manager_.free(id(), page_num, buf);
+  frame_manager_->free(id(), page_num, buf);
   return RC::SUCCESS;
 }
 
@@ -496,9 +1217,13 @@ RC DiskBufferPool::purge_page(PageNum page_num)
 {
   scoped_lock lock_guard(lock_);
 
-  Frame           *used_frame = frame_manager_.get(id(), page_num);
+  Frame           *used_frame = frame_manager_->get(id(), page_num);
   if (used_frame != nullptr) {
-    return purge_frame(page_num, used_frame);
+    RC rc = purge_frame(page_num, used_frame);
+    if (OB_FAIL(rc)) {
+      used_frame->unpin();
+    }
+    return rc;
   }
 
   return RC::SUCCESS;
@@ -506,7 +1231,7 @@ RC DiskBufferPool::purge_page(PageNum page_num)
 
 RC DiskBufferPool::purge_all_pages()
 {
-  list<Frame *> used = frame_manager_.find_list(id());
+  list<Frame *> used = frame_manager_->find_list(id());
 
   scoped_lock lock_guard(lock_);
   for (list<Frame *>::iterator it = used.begin(); it != used.end(); ++it) {
@@ -519,7 +1244,7 @@ RC DiskBufferPool::purge_all_pages()
 
 RC DiskBufferPool::check_all_pages_unpinned()
 {
-  list<Frame *> frames = frame_manager_.find_list(id());
+  list<Frame *> frames = frame_manager_->find_list(id());
 
   scoped_lock lock_guard(lock_);
   for (Frame *frame : frames) {
@@ -553,7 +1278,7 @@ RC DiskBufferPool::flush_page_internal(Frame &frame)
     // ignore error handle
   }
 
-  frame.set_check_sum(crc32(frame.page().data, BP_PAGE_DATA_SIZE));
+  frame.set_check_sum(crc32(frame.page().data, frame.page_data_size()));
 
   rc = dblwr_manager_.add_page(this, frame.page_num(), frame.page());
   if (OB_FAIL(rc)) {
@@ -568,7 +1293,7 @@ RC DiskBufferPool::flush_page_internal(Frame &frame)
 
 RC DiskBufferPool::flush_all_pages()
 {
-  list<Frame *> used = frame_manager_.find_list(id());
+  list<Frame *> used = frame_manager_->find_list(id());
   for (Frame *frame : used) {
     RC rc = flush_page(*frame);
     frame->unpin();
@@ -582,32 +1307,41 @@ RC DiskBufferPool::flush_all_pages()
 
 RC DiskBufferPool::recover_page(PageNum page_num)
 {
-  int byte = 0, bit = 0;
-  byte = page_num / 8;
-  bit  = page_num % 8;
-
   scoped_lock lock_guard(lock_);
-  if (!(file_header_->bitmap[byte] & (1 << bit))) {
-    file_header_->bitmap[byte] |= (1 << bit);
-    file_header_->allocated_pages++;
-    file_header_->page_count++;
-    hdr_frame_->mark_dirty();
+
+  // 分配页面的日志可能还没有回放，这里不知道对应的LSN，不检查也不修改页面的LSN
+  RC rc = RC::SUCCESS;
+  if (page_num >= file_header_->page_count) {
+    rc = extend_pages(page_num, 0 /*lsn*/, true /*redo*/);
+  }
+  if (OB_SUCC(rc)) {
+    rc = set_page_allocated(page_num, true, 0 /*lsn*/, true /*redo*/);
+  }
+  return rc;
+}
+
+IoRequest DiskBufferPool::write_page_request(PageNum page_num, const Page &page) const
+{
+  return IoRequest::write(file_desc_, &page, page_size_, static_cast<int64_t>(page_num) * page_size_);
+}
+
+RC DiskBufferPool::sync()
+{
+  if (0 != fsync(file_desc_)) {
+    LOG_ERROR("Failed to sync file %s. error=%s", file_name_.c_str(), strerror(errno));
+    return RC::IOERR_SYNC;
   }
   return RC::SUCCESS;
 }
 
 RC DiskBufferPool::write_page(PageNum page_num, Page &page)
 {
-  scoped_lock lock_guard(wr_lock_);
-  int64_t     offset = ((int64_t)page_num) * sizeof(Page);
-  if (lseek(file_desc_, offset, SEEK_SET) == -1) {
-    LOG_ERROR("Failed to write page %lld of %d due to failed to seek %s.", offset, file_desc_, strerror(errno));
-    return RC::IOERR_SEEK;
-  }
+  vector<IoRequest> requests{write_page_request(page_num, page)};
 
-  if (writen(file_desc_, &page, sizeof(Page)) != 0) {
-    LOG_ERROR("Failed to write page %lld of %d due to %s.", offset, file_desc_, strerror(errno));
-    return RC::IOERR_WRITE;
+  RC rc = bp_manager_.io_engine().submit(requests);
+  if (OB_FAIL(rc)) {
+    LOG_ERROR("Failed to write page %s:%d. rc=%s", file_name_.c_str(), page_num, strrc(rc));
+    return rc;
   }
 
   LOG_TRACE("write_page: buffer_pool_id:%d, page_num:%d, lsn=%d, check_sum=%d", id(), page_num, page.lsn, page.check_sum);
@@ -616,71 +1350,39 @@ RC DiskBufferPool::write_page(PageNum page_num, Page &page)
 
 RC DiskBufferPool::redo_allocate_page(LSN lsn, PageNum page_num)
 {
-  if (hdr_frame_->lsn() >= lsn) {
-    return RC::SUCCESS;
-  }
-
-  // scoped_lock lock_guard(lock_); // redo 过程中可以不加锁
-  if (page_num < file_header_->page_count) {
-    Bitmap bitmap(file_header_->bitmap, file_header_->page_count);
-    if (bitmap.get_bit(page_num)) {
-      LOG_WARN("page %d has been allocated. file=%s", page_num, file_name_.c_str());
-      return RC::SUCCESS;
-    }
-
-    bitmap.set_bit(page_num);
-    file_header_->allocated_pages++;
-    hdr_frame_->mark_dirty();
-    return RC::SUCCESS;
-  }
-
-  if (page_num > file_header_->page_count) {
-    LOG_WARN("page %d is not continuous. file=%s, page_count=%d",
-             page_num, file_name_.c_str(), file_header_->page_count);
+  // 回放时其它线程可能在回放同一个文件中页面的日志，也会修改文件头(参考 recover_page)
+  scoped_lock lock_guard(lock_);
+  if (page_num >= BPFileHeader::MAX_PAGE_NUM) {
+    LOG_WARN("file buffer pool is full. page num %d, max page count %d", page_num, BPFileHeader::MAX_PAGE_NUM);
     return RC::INTERNAL;
   }
 
-  // page_num == file_header_->page_count
-  if (file_header_->page_count >= BPFileHeader::MAX_PAGE_NUM) {
-    LOG_WARN("file buffer pool is full. page count %d, max page count %d",
-        file_header_->page_count, BPFileHeader::MAX_PAGE_NUM);
-    return RC::INTERNAL;
+  RC rc = RC::SUCCESS;
+  if (page_num >= file_header_->page_count) {
+    // TODO 应该检查文件是否足够大，包含了当前新分配的页面
+    rc = extend_pages(page_num, lsn, true /*redo*/);
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+    LOG_TRACE("[redo] allocate new page. file=%s, pageNum=%d", file_name_.c_str(), page_num);
   }
 
-  file_header_->allocated_pages++;
-  file_header_->page_count++;
-  hdr_frame_->set_lsn(lsn);
-  hdr_frame_->mark_dirty();
-  
-  // TODO 应该检查文件是否足够大，包含了当前新分配的页面
-
-  Bitmap bitmap(file_header_->bitmap, file_header_->page_count);
-  bitmap.set_bit(page_num);
-  LOG_TRACE("[redo] allocate new page. file=%s, pageNum=%d", file_name_.c_str(), page_num);
-  return RC::SUCCESS;
+  return set_page_allocated(page_num, true, lsn, true /*redo*/);
 }
 
 RC DiskBufferPool::redo_deallocate_page(LSN lsn, PageNum page_num)
 {
-  if (hdr_frame_->lsn() >= lsn) {
-    return RC::SUCCESS;
-  }
-
+  scoped_lock lock_guard(lock_);
   if (page_num >= file_header_->page_count) {
     LOG_WARN("page %d is not exist. file=%s", page_num, file_name_.c_str());
     return RC::INTERNAL;
   }
 
-  Bitmap bitmap(file_header_->bitmap, file_header_->page_count);
-  if (!bitmap.get_bit(page_num)) {
-    LOG_WARN("page %d has been deallocated. file=%s", page_num, file_name_.c_str());
-    return RC::INTERNAL;
+  RC rc = set_page_allocated(page_num, false, lsn, true /*redo*/);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to deallocate page %d. file=%s, rc=%s", page_num, file_name_.c_str(), strrc(rc));
+    return rc;
   }
-
-  bitmap.clear_bit(page_num);
-  file_header_->allocated_pages--;
-  hdr_frame_->set_lsn(lsn);
-  hdr_frame_->mark_dirty();
   LOG_TRACE("[redo] deallocate page. file=%s, pageNum=%d", file_name_.c_str(), page_num);
   return RC::SUCCESS;
 }
@@ -706,7 +1408,7 @@ RC DiskBufferPool::allocate_frame(PageNum page_num, Frame **buffer)
   };
 
   while (true) {
-    Frame *frame = frame_manager_.alloc(id(), page_num);
+    Frame *frame = frame_manager_->alloc(id(), page_num);
     if (frame != nullptr) {
       *buffer = frame;
       LOG_DEBUG("allocate frame %p, page num %d, frame=%s", frame, page_num, frame->to_string().c_str());
@@ -714,9 +1416,12 @@ RC DiskBufferPool::allocate_frame(PageNum page_num, Frame **buffer)
     }
 
     LOG_TRACE("frames are all allocated, so we should purge some frames to get one free frame");
-    (void)frame_manager_.purge_frames(1 /*count*/, purger);
+    if (frame_manager_->purge_frames(FrameId(id(), page_num), 1 /*count*/, purger) == 0) {
+      // 所有分片都淘汰不出页帧，继续等待只会一直空转
+      LOG_WARN("no frame can be purged. file=%s, page_num=%d", file_name_.c_str(), page_num);
+      return RC::BUFFERPOOL_NOBUF;
+    }
   }
-  return RC::BUFFERPOOL_NOBUF;
 }
 
 RC DiskBufferPool::check_page_num(PageNum page_num)
@@ -725,7 +1430,10 @@ RC DiskBufferPool::check_page_num(PageNum page_num)
     LOG_ERROR("Invalid pageNum:%d, file's name:%s", page_num, file_name_.c_str());
     return RC::BUFFERPOOL_INVALID_PAGE_NUM;
   }
-  if ((file_header_->bitmap[page_num / 8] & (1 << (page_num % 8))) == 0) {
+  // 其它组的分配信息在位图页中，为了检查一个页面再加载位图页不划算，这里只排除位图页
+  if (BPFileHeader::is_bitmap_page(page_num) ||
+      (page_num < BPFileHeader::FIRST_GROUP_PAGE_NUM &&
+          (file_header_->bitmap[page_num / 8] & (1 << (page_num % 8))) == 0)) {
     LOG_ERROR("Invalid pageNum:%d, file's name:%s", page_num, file_name_.c_str());
     return RC::BUFFERPOOL_INVALID_PAGE_NUM;
   }
@@ -740,19 +1448,12 @@ RC DiskBufferPool::load_page(PageNum page_num, Frame *frame)
     return rc;
   }
 
-  scoped_lock lock_guard(wr_lock_);
-  int64_t          offset = ((int64_t)page_num) * BP_PAGE_SIZE;
-  if (lseek(file_desc_, offset, SEEK_SET) == -1) {
-    LOG_ERROR("Failed to load page %s:%d, due to failed to lseek:%s.", file_name_.c_str(), page_num, strerror(errno));
-
-    return RC::IOERR_SEEK;
-  }
-
-  int ret = readn(file_desc_, &page, BP_PAGE_SIZE);
-  if (ret != 0) {
-    LOG_ERROR("Failed to load page %s, file_desc:%d, page num:%d, due to failed to read data:%s, ret=%d, page count=%d",
-              file_name_.c_str(), file_desc_, page_num, strerror(errno), ret, file_header_->allocated_pages);
-    return RC::IOERR_READ;
+  int64_t offset = ((int64_t)page_num) * page_size_;
+  rc             = bp_manager_.io_engine().read(file_desc_, &page, page_size_, offset);
+  if (OB_FAIL(rc)) {
+    LOG_ERROR("Failed to load page %s, file_desc:%d, page num:%d, rc=%s, page count=%d",
+              file_name_.c_str(), file_desc_, page_num, strrc(rc), file_header_->allocated_pages);
+    return rc;
   }
 
   frame->set_page_num(page_num);
@@ -765,35 +1466,178 @@ RC DiskBufferPool::load_page(PageNum page_num, Frame *frame)
 int DiskBufferPool::file_desc() const { return file_desc_; }
 
 ////////////////////////////////////////////////////////////////////////////////
-BufferPoolManager::BufferPoolManager(int memory_size /* = 0 */)
+BufferPoolManager::BufferPoolManager(int memory_size /* = 0 */, int frame_shard_num /* = 1 */,
+    const char *frame_replacer /* = nullptr */, int page_size_class_num /* = 1 */)
+    : io_engine_(make_unique<SyncIoEngine>())
 {
   if (memory_size <= 0) {
     memory_size = MEM_POOL_ITEM_NUM * DEFAULT_ITEM_NUM_PER_POOL * BP_PAGE_SIZE;
   }
-  const int pool_num = max(memory_size / BP_PAGE_SIZE / DEFAULT_ITEM_NUM_PER_POOL, 1);
-  frame_manager_.init(pool_num);
-  LOG_INFO("buffer pool manager init with memory size %d, page num: %d, pool num: %d",
-           memory_size, pool_num * DEFAULT_ITEM_NUM_PER_POOL, pool_num);
+  memory_size_         = memory_size;
+  page_size_class_num_ = max(page_size_class_num, 1);
+  frame_shard_num_     = frame_shard_num;
+  frame_replacer_      = frame_replacer == nullptr ? "" : frame_replacer;
+
+  const int pool_num = max(memory_size / page_size_class_num_ / BP_PAGE_SIZE / DEFAULT_ITEM_NUM_PER_POOL, 1);
+  RC rc = frame_manager_.init(pool_num, frame_shard_num, frame_replacer);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to init frame manager with replacer %s, use the default one. rc=%s", frame_replacer, strrc(rc));
+    frame_manager_.init(pool_num, frame_shard_num);
+  }
+  LOG_INFO("buffer pool manager init with memory size %d, page num: %d, pool num: %d, frame shard num: %d, replacer: %s",
+           memory_size, pool_num * DEFAULT_ITEM_NUM_PER_POOL, pool_num, frame_manager_.shard_num(),
+           frame_manager_.replacer_name());
 }
 
 BufferPoolManager::~BufferPoolManager()
 {
+  if (page_cleaner_) {
+    page_cleaner_->stop();
+  }
+
   unordered_map<string, DiskBufferPool *> tmp_bps;
   tmp_bps.swap(buffer_pools_);
 
   for (auto &iter : tmp_bps) {
     delete iter.second;
   }
+
+  if (read_ahead_window_ > 0) {
+    read_ahead_executor_.shutdown();
+    read_ahead_executor_.await_termination();
+  }
+
+  LOG_INFO("buffer pool manager exit. replacer=%s, %s",
+           frame_manager_.replacer_name(), frame_manager_.stat().to_string().c_str());
+}
+
+RC BufferPoolManager::init(unique_ptr<DoubleWriteBuffer> dblwr_buffer, int read_ahead_window /* = 0 */,
+    const char *io_engine /* = nullptr */, bool direct_io /* = false */,
+    int extent_page_num /* = DEFAULT_EXTENT_PAGE_NUM */)
+{
+  dblwr_buffer_    = std::move(dblwr_buffer);
+  direct_io_       = direct_io;
+  extent_page_num_ = max(extent_page_num, 1);
+  if (direct_io_) {
+    LOG_INFO("buffer pool files are opened with direct io");
+  }
+  LOG_INFO("buffer pool files grow by extent of %d pages", extent_page_num_);
+
+  if (io_engine != nullptr) {
+    RC rc = IoEngine::create(io_engine, io_engine_);
+    if (OB_FAIL(rc)) {
+      LOG_ERROR("failed to create io engine. name=%s, rc=%s", io_engine, strrc(rc));
+      return rc;
+    }
+  }
+  LOG_INFO("buffer pool manager use io engine %s", io_engine_->name());
+
+  if (read_ahead_window > 0) {
+    int ret = read_ahead_executor_.init("ReadAhead", 1 /*core_size*/, 1 /*max_size*/, 60 * 1000 /*keep_alive_time_ms*/);
+    if (ret != 0) {
+      LOG_ERROR("failed to init read ahead executor. ret=%d", ret);
+      return RC::INTERNAL;
+    }
+    read_ahead_window_ = read_ahead_window;
+    LOG_INFO("buffer pool read ahead enabled. window=%d", read_ahead_window_);
+  }
+  return RC::SUCCESS;
+}
+
+RC BufferPoolManager::start_page_cleaner(int clean_percent, int io_capacity)
+{
+  if (page_cleaner_) {
+    LOG_WARN("page cleaner has been started");
+    return RC::INTERNAL;
+  }
+
+  page_cleaner_ = make_unique<PageCleaner>(*this, clean_percent, io_capacity);
+  return page_cleaner_->start();
+}
+
+RC BufferPoolManager::execute_read_ahead(const function<void()> &task)
+{
+  if (read_ahead_window_ <= 0) {
+    return RC::UNSUPPORTED;
+  }
+
+  int ret = read_ahead_executor_.execute(task);
+  if (ret != 0) {
+    LOG_WARN("failed to execute read ahead task. ret=%d", ret);
+    return RC::INTERNAL;
+  }
+  return RC::SUCCESS;
 }
 
-RC BufferPoolManager::init(unique_ptr<DoubleWriteBuffer> dblwr_buffer)
+RC BufferPoolManager::get_frame_manager(int page_size, BPFrameManager *&frame_manager)
 {
-  dblwr_buffer_ = std::move(dblwr_buffer);
+  if (page_size == BP_PAGE_SIZE) {
+    frame_manager = &frame_manager_;
+    return RC::SUCCESS;
+  }
+
+  if (!bp_valid_page_size(page_size)) {
+    LOG_WARN("invalid page size %d", page_size);
+    return RC::INVALID_ARGUMENT;
+  }
+
+  lock_guard<mutex> guard(frame_manager_lock_);
+  auto iter = sized_frame_managers_.find(page_size);
+  if (iter != sized_frame_managers_.end()) {
+    frame_manager = iter->second.get();
+    return RC::SUCCESS;
+  }
+
+  // 默认的页帧管理器已经占用了一份内存
+  int pool_num = 1;
+  if (static_cast<int>(sized_frame_managers_.size()) + 1 < page_size_class_num_) {
+    pool_num = max(memory_size_ / page_size_class_num_ / page_size / DEFAULT_ITEM_NUM_PER_POOL, 1);
+  } else {
+    LOG_WARN("memory of buffer pool has been split to %d page sizes, page size %d gets only one pool",
+             page_size_class_num_, page_size);
+  }
+
+  auto        new_frame_manager = make_unique<BPFrameManager>("BufPool", page_size);
+  const char *replacer          = frame_replacer_.empty() ? nullptr : frame_replacer_.c_str();
+  RC          rc                = new_frame_manager->init(pool_num, frame_shard_num_, replacer);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to init frame manager. page size=%d, rc=%s", page_size, strrc(rc));
+    return rc;
+  }
+
+  LOG_INFO("frame manager of page size %d created. page num: %d", page_size, pool_num * DEFAULT_ITEM_NUM_PER_POOL);
+  frame_manager = new_frame_manager.get();
+  sized_frame_managers_.emplace(page_size, std::move(new_frame_manager));
   return RC::SUCCESS;
 }
 
-RC BufferPoolManager::create_file(const char *file_name)
+vector<BPFrameManager *> BufferPoolManager::frame_managers()
+{
+  vector<BPFrameManager *> result{&frame_manager_};
+
+  lock_guard<mutex> guard(frame_manager_lock_);
+  for (auto &[page_size, frame_manager] : sized_frame_managers_) {
+    result.push_back(frame_manager.get());
+  }
+  return result;
+}
+
+LSN BufferPoolManager::min_recovery_lsn()
 {
+  LSN min_lsn = numeric_limits<LSN>::max();
+  for (BPFrameManager *frame_manager : frame_managers()) {
+    min_lsn = min(min_lsn, frame_manager->min_recovery_lsn());
+  }
+  return min_lsn;
+}
+
+RC BufferPoolManager::create_file(const char *file_name, int page_size /* = BP_PAGE_SIZE */)
+{
+  if (!bp_valid_page_size(page_size)) {
+    LOG_ERROR("Failed to create %s, invalid page size %d.", file_name, page_size);
+    return RC::INVALID_ARGUMENT;
+  }
+
   int fd = open(file_name, O_RDWR | O_CREAT | O_EXCL, S_IREAD | S_IWRITE);
   if (fd < 0) {
     LOG_ERROR("Failed to create %s, due to %s.", file_name, strerror(errno));
@@ -811,12 +1655,15 @@ RC BufferPoolManager::create_file(const char *file_name)
     return RC::IOERR_ACCESS;
   }
 
-  Page page;
-  memset(&page, 0, BP_PAGE_SIZE);
+  // 第一个页面写成一个完整的页面，文件大小总是页面大小的整数倍
+  vector<char> page_buffer(page_size, 0);
+  Page        &page = *reinterpret_cast<Page *>(page_buffer.data());
 
   BPFileHeader *file_header    = (BPFileHeader *)page.data;
   file_header->allocated_pages = 1;
   file_header->page_count      = 1;
+  file_header->free_pages      = 0;
+  file_header->page_size       = page_size;
   file_header->buffer_pool_id  = next_buffer_pool_id_.fetch_add(1);
 
   char *bitmap = file_header->bitmap;
@@ -827,14 +1674,14 @@ RC BufferPoolManager::create_file(const char *file_name)
     return RC::IOERR_SEEK;
   }
 
-  if (writen(fd, (char *)&page, BP_PAGE_SIZE) != 0) {
+  if (writen(fd, page_buffer.data(), page_size) != 0) {
     LOG_ERROR("Failed to write header to file %s, due to %s.", file_name, strerror(errno));
     close(fd);
     return RC::IOERR_WRITE;
   }
 
   close(fd);
-  LOG_INFO("Successfully create %s.", file_name);
+  LOG_INFO("Successfully create %s. page size=%d", file_name, page_size);
   return RC::SUCCESS;
 }
 
@@ -880,9 +1727,25 @@ RC BufferPoolManager::close_file(const char *_file_name)
     return RC::INTERNAL;
   }
 
-  id_to_buffer_pools_.erase(iter->second->id());
-
   DiskBufferPool *bp = iter->second;
+  if (bp->file_desc() >= 0) {
+    // 关闭文件时刷出的脏页可能会让 double write buffer 写数据文件，需要根据ID找到 buffer pool，
+    // 所以先关闭文件再注销。关闭成功时会再次调用这个函数删除 bp
+    lock_.unlock();
+    RC rc = bp->close_file();
+    if (OB_SUCC(rc)) {
+      return rc;
+    }
+
+    lock_.lock();
+    iter = buffer_pools_.find(file_name);
+    if (iter == buffer_pools_.end()) {
+      lock_.unlock();
+      return rc;
+    }
+  }
+
+  id_to_buffer_pools_.erase(bp->id());
   buffer_pools_.erase(iter);
   lock_.unlock();
 
@@ -905,6 +1768,32 @@ RC BufferPoolManager::flush_page(Frame &frame)
   return bp->flush_page(frame);
 }
 
+RC BufferPoolManager::sync_files(LSN &durable_lsn)
+{
+  // 先获取脏页的LSN再同步，不是脏页的页面都已经写到了文件中，同步之后就落盘了
+  const LSN lsn = min_recovery_lsn();
+
+  // 共享表空间中的页面可能还没有写入数据文件，两者都要同步。
+  // 这里不同时持有两边的锁，共享表空间刷新页面时会获取 lock_
+  RC rc = dblwr_buffer_->sync_file();
+  if (OB_FAIL(rc)) {
+    LOG_ERROR("Failed to sync double write buffer. rc=%s", strrc(rc));
+    return rc;
+  }
+
+  scoped_lock lock_guard(lock_);
+  for (auto &[id, bp] : id_to_buffer_pools_) {
+    rc = bp->sync();
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+  }
+
+  durable_lsn = lsn;
+  durable_lsn_.store(lsn);
+  return RC::SUCCESS;
+}
+
 RC BufferPoolManager::get_buffer_pool(int32_t id, DiskBufferPool *&bp)
 {
   bp = nullptr;
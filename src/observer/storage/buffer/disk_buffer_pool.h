@@ -25,16 +25,26 @@ See the Mulan PSL v2 for more details. */
 #include <time.h>
 #include <optional>
 
+#include "common/lang/algorithm.h"
 #include "common/lang/bitmap.h"
-#include "common/lang/lru_cache.h"
+#include "common/lang/deque.h"
+#include "common/lang/limits.h"
+#include "common/lang/map.h"
 #include "common/lang/mutex.h"
 #include "common/lang/memory.h"
 #include "common/lang/unordered_map.h"
+#include "common/lang/vector.h"
 #include "common/mm/mem_pool.h"
 #include "common/sys/rc.h"
+#include "common/thread/thread_pool_executor.h"
 #include "common/types.h"
 #include "storage/buffer/frame.h"
+#include "storage/buffer/frame_allocator.h"
+#include "storage/buffer/frame_replacer.h"
+#include "storage/buffer/io_engine.h"
 #include "storage/buffer/page.h"
+#include "storage/buffer/page_cleaner.h"
+#include "storage/buffer/read_ahead.h"
 #include "storage/buffer/buffer_pool_log.h"
 
 class BufferPoolManager;
@@ -51,28 +61,75 @@ class BufferPoolLogHandler;
 #define BP_FILE_SUB_HDR_SIZE (sizeof(BPFileSubHeader))
 
 /**
- * @brief BufferPool的文件第一个页面，存放一些元数据信息，包括了后面每页的分配信息。
+ * @brief 页面分配位图页
  * @ingroup BufferPool
- * @details
- * @code
- * TODO 1. 当前的做法，只能分配比较少的页面，你可以扩展一下，支持更多的页面或无限多的页面吗？
- *         可以参考Linux ext(n)和Windows NTFS等文件系统
- *      2. 当前使用bitmap存放页面分配情况，但是这种方法在页面非常多的时候，查找空闲页面的
- *         效率非常低，你有办法优化吗？
- * @endcode
+ * @details 除了第0组，每个页面组的第一个页面都是位图页，记录这个组中每个页面的分配情况。
+ * 位图页自己对应第0位，总是1。
+ * 不管文件的页面大小是多少，位图页都只使用前 BP_PAGE_SIZE 个字节，每个组的页面个数是固定的。
+ */
+struct BPBitmapPage
+{
+  int32_t free_pages;  //! 当前组中已经扩展到文件中，但是没有分配的页面个数
+  int32_t reserved;
+  char    bitmap[0];   //! 页面分配位图
+
+  /// 一个位图页能够管理的页面个数，包含位图页自己
+  static constexpr int PAGE_NUM = (BP_PAGE_DATA_SIZE - sizeof(int32_t) * 2) * 8;
+};
+
+/**
+ * @brief BufferPool的文件第一个页面，存放一些元数据信息，包括了前面一部分页面的分配信息。
+ * @ingroup BufferPool
+ * @details 文件中的页面被划分成多个组(group)，类似于 ext4 的块组：
+ * 第0组从文件开始，位图直接存放在文件头中；后面的每个组固定 BPBitmapPage::PAGE_NUM 个页面，
+ * 组中第一个页面是位图页。文件头中还有一个组位图，记录哪些组中可能有空闲页面，
+ * 分配页面时先在组位图中找到一个有空闲页面的组，再在这个组的位图中查找，不需要扫描整个文件的位图。
+ * 组位图只是一个提示，分配时发现组中没有空闲页面会清掉对应的位。
+ * 与位图页一样，文件头只使用第一个页面的前 BP_PAGE_SIZE 个字节。
  */
 struct BPFileHeader
 {
-  int32_t buffer_pool_id;   //! buffer pool id
-  int32_t page_count;       //! 当前文件一共有多少个页面
-  int32_t allocated_pages;  //! 已经分配了多少个页面
-  char    bitmap[0];        //! 页面分配位图, 第0个页面(就是当前页面)，总是1
+  /// 组位图的字节数，决定了文件最多有多少个组
+  static constexpr int GROUP_BITMAP_SIZE = 4096;
+
+  int32_t buffer_pool_id;                   //! buffer pool id
+  int32_t page_count;                       //! 当前文件一共有多少个页面
+  int32_t allocated_pages;                  //! 已经分配了多少个页面，包括文件头和位图页
+  int32_t free_pages;                       //! 第0组中空闲的页面个数
+  int32_t page_size;                        //! 页面大小，创建文件时确定，参考 bp_valid_page_size
+  char    group_bitmap[GROUP_BITMAP_SIZE];  //! 组位图，1表示组中可能有空闲页面
+  char    bitmap[0];                        //! 第0组的页面分配位图, 第0个页面(就是当前页面)，总是1
+
+  /// 第0组的页面个数，即文件头中剩余空间的字节数乘以8
+  static constexpr int FIRST_GROUP_PAGE_NUM =
+      (BP_PAGE_DATA_SIZE - sizeof(int32_t) * 5 - GROUP_BITMAP_SIZE) * 8;
 
   /**
-   * 能够分配的最大的页面个数，即bitmap的字节数 乘以8
+   * 能够分配的最大的页面个数
    */
-  static const int MAX_PAGE_NUM =
-      (BP_PAGE_DATA_SIZE - sizeof(buffer_pool_id) - sizeof(page_count) - sizeof(allocated_pages)) * 8;
+  static constexpr int MAX_PAGE_NUM = static_cast<int>(
+      min<int64_t>(numeric_limits<int32_t>::max(),
+          FIRST_GROUP_PAGE_NUM + static_cast<int64_t>(GROUP_BITMAP_SIZE * 8 - 1) * BPBitmapPage::PAGE_NUM));
+
+  /// 页面所在的组
+  static int group_of(PageNum page_num)
+  {
+    return page_num < FIRST_GROUP_PAGE_NUM ? 0 : (page_num - FIRST_GROUP_PAGE_NUM) / BPBitmapPage::PAGE_NUM + 1;
+  }
+
+  /// 组的第一个页面，第0组之外就是组的位图页
+  static PageNum group_start(int group)
+  {
+    return group == 0 ? 0 : FIRST_GROUP_PAGE_NUM + (group - 1) * BPBitmapPage::PAGE_NUM;
+  }
+
+  static bool is_bitmap_page(PageNum page_num)
+  {
+    return page_num >= FIRST_GROUP_PAGE_NUM && (page_num - FIRST_GROUP_PAGE_NUM) % BPBitmapPage::PAGE_NUM == 0;
+  }
+
+  /// 当前文件中有多少个组
+  int group_count() const { return page_count <= 0 ? 0 : group_of(page_count - 1) + 1; }
 
   string to_string() const;
 };
@@ -84,13 +141,29 @@ struct BPFileHeader
  * 当内存中的页帧不够用时，需要从内存中淘汰一些页帧，以便为新的页帧腾出空间。
  * 这个管理器负责为所有的BufferPool提供页帧管理服务，也就是所有的BufferPool磁盘文件
  * 在访问时都使用这个管理器映射到内存。
+ *
+ * 为了避免所有线程都竞争同一把锁，页面按照 FrameId::hash() 划分到多个分片(shard)中，
+ * 每个分片有自己的锁、页面映射表和 FrameReplacer，查找页面只访问它所属的分片。
+ * 页帧内存由所有分片共用一个 FrameAllocator 分配，一个分片释放的页帧可以给其它分片使用。
+ *
+ * 淘汰页面时先在页面所属的分片中查找，这个分片中的页帧都被pin住时再依次到其它分片中淘汰。
  */
 class BPFrameManager
 {
 public:
-  BPFrameManager(const char *tag);
+  /**
+   * @param page_size 页帧的页面大小，不同页面大小的文件使用不同的页帧管理器
+   */
+  BPFrameManager(const char *tag, int page_size = BP_PAGE_SIZE);
 
-  RC init(int pool_num);
+  /**
+   * @brief 初始化
+   *
+   * @param pool_num 内存池的个数，每个内存池包含 DEFAULT_ITEM_NUM_PER_POOL 个页帧
+   * @param shard_num 分片个数，不超过内存池的个数。所有分片共用页帧内存，分片只划分页面的查找和淘汰
+   * @param replacer_name 页帧淘汰策略，参考 FrameReplacer::create
+   */
+  RC init(int pool_num, int shard_num = 1, const char *replacer_name = nullptr);
   RC cleanup();
 
   /**
@@ -98,9 +171,10 @@ public:
    *
    * @param buffer_pool_id buffer Pool标识
    * @param page_num  页面号
+   * @param[out] prefetched 页面是否是预读加载并且第一次被访问
    * @return Frame* 页帧指针
    */
-  Frame *get(int buffer_pool_id, PageNum page_num);
+  Frame *get(int buffer_pool_id, PageNum page_num, bool *prefetched = nullptr);
 
   /**
    * @brief 列出所有指定文件的页面
@@ -110,6 +184,20 @@ public:
    */
   list<Frame *> find_list(int buffer_pool_id);
 
+  /**
+   * @brief 列出所有的脏页
+   * @details 返回的页帧都会被pin住，使用完需要unpin
+   * @return vector<Frame *> 按照 Frame::recovery_lsn 从小到大排序
+   */
+  vector<Frame *> find_dirty_list();
+
+  /**
+   * @brief 所有脏页中最小的 recovery lsn
+   * @details 重启时至少要从这个位置开始回放日志。没有脏页时返回LSN的最大值。
+   * 有脏页不知道 recovery lsn 时返回0。
+   */
+  LSN min_recovery_lsn();
+
   /**
    * @brief 分配一个新的页面
    *
@@ -128,22 +216,54 @@ public:
   /**
    * 如果不能从空闲链表中分配新的页面，就使用这个接口，
    * 尝试从pin count=0的页面中淘汰一些
+   * @param frame_id 想要分配的页面，优先在它所属的分片中淘汰页面，这个分片淘汰不出页面时再依次尝试其它分片
    * @param count 想要purge多少个页面
    * @param purger 需要在释放frame之前，对页面做些什么操作。当前是刷新脏数据到磁盘
    * @return 返回本次清理了多少个页面
    */
-  int purge_frames(int count, function<RC(Frame *frame)> purger);
+  int purge_frames(const FrameId &frame_id, int count, function<RC(Frame *frame)> purger);
+
+  /**
+   * @brief 页面是否已经在内存中
+   * @details 与 get 不同，不会pin页帧，也不会影响命中统计和淘汰顺序
+   */
+  bool contains(int buffer_pool_id, PageNum page_num);
+
+  /**
+   * @brief 标记页帧是预读加载的，用于统计预读的效果
+   * @details 如果加载的过程中已经有其它人拿到了这个页帧，直接算作一次预读命中
+   */
+  void mark_prefetched(Frame *frame);
 
-  size_t frame_num() const { return frames_.count(); }
+  size_t frame_num() const;
 
   /**
    * 测试使用。返回已经从内存申请的个数
    */
-  size_t total_frame_num() const { return allocator_.get_size(); }
+  size_t total_frame_num() const;
 
-private:
-  Frame *get_internal(const FrameId &frame_id);
-  RC     free_internal(const FrameId &frame_id, Frame *frame);
+  int shard_num() const { return static_cast<int>(shards_.size()); }
+  int page_size() const { return page_size_; }
+
+  /**
+   * @brief 页帧的命中统计
+   * @details 每次获取页面时，如果页面已经在内存中就是命中，否则是未命中，需要从磁盘加载。
+   * 预读加载的页面如果在淘汰之前被访问过，就是预读命中，否则就是预读浪费。
+   */
+  struct Stat
+  {
+    int64_t hit_count         = 0;
+    int64_t miss_count        = 0;
+    int64_t read_ahead_count  = 0;  ///< 预读加载的页面个数
+    int64_t read_ahead_hit    = 0;
+    int64_t read_ahead_wasted = 0;
+
+    double hit_ratio() const;
+    string to_string() const;
+  };
+
+  Stat        stat() const;
+  const char *replacer_name() const { return replacer_name_.c_str(); }
 
 private:
   class BPFrameIdHasher
@@ -152,17 +272,49 @@ private:
     size_t operator()(const FrameId &frame_id) const { return frame_id.hash(); }
   };
 
-  using FrameLruCache  = common::LruCache<FrameId, Frame *, BPFrameIdHasher>;
-  using FrameAllocator = common::MemPoolSimple<Frame>;
+  using FrameMap = unordered_map<FrameId, Frame *, BPFrameIdHasher>;
+
+  /**
+   * @brief 页帧分片
+   * @details 每个分片单独管理一部分页面的查找和淘汰，分片内的所有操作都在分片的锁保护下进行。
+   * 页帧内存由所有分片共用，否则一个分片的页帧都被pin住时，即使其它分片还有空闲页帧也分配不出来
+   */
+  class Shard
+  {
+  public:
+    explicit Shard(FrameAllocator &allocator) : allocator_(allocator) {}
+
+    Frame *get_internal(const FrameId &frame_id, bool *prefetched = nullptr);
+    RC     free_internal(const FrameId &frame_id, Frame *frame);
+    int    purge_internal(int count, const function<RC(Frame *frame)> &purger);
+
+  public:
+    mutex                     lock_;
+    FrameMap                  frames_;
+    unique_ptr<FrameReplacer> replacer_;
+    FrameAllocator           &allocator_;
+
+    atomic<int64_t> hit_count_{0};
+    atomic<int64_t> miss_count_{0};
+    atomic<int64_t> read_ahead_count_{0};
+    atomic<int64_t> read_ahead_hit_{0};
+    atomic<int64_t> read_ahead_wasted_{0};
+  };
+
+  Shard &shard_of(const FrameId &frame_id) { return *shards_[frame_id.hash() % shards_.size()]; }
 
-  mutex          lock_;
-  FrameLruCache  frames_;
-  FrameAllocator allocator_;
+private:
+  string                    tag_;
+  int                       page_size_ = BP_PAGE_SIZE;
+  string                    replacer_name_;
+  FrameAllocator            allocator_;  ///< 需要在 shards_ 之后析构
+  vector<unique_ptr<Shard>> shards_;
 };
 
 /**
  * @brief 用于遍历BufferPool中的所有页面
  * @ingroup BufferPool
+ * @details 只返回已经分配的页面，不会返回文件头和位图页
  */
 class BufferPoolIterator
 {
@@ -176,8 +328,45 @@ public:
   RC      reset();
 
 private:
-  common::Bitmap bitmap_;
-  PageNum        current_page_num_ = -1;
+  DiskBufferPool *buffer_pool_      = nullptr;
+  PageNum         current_page_num_ = -1;
+  PageNum         next_page_num_    = -1;  ///< has_next 找到的下一个页面，next_found_ 为 true 时有效
+  bool            next_found_       = false;
+};
+
+/**
+ * @brief 顺序扫描使用的私有页帧环
+ * @ingroup BufferPool
+ * @details 大表的全表扫描会把每个页面都加载到缓冲池中，把其它热点页面(比如B+树的内部节点)
+ * 都淘汰出去，而这些扫描过的页面通常不会很快再被访问。类似于 PostgreSQL 的 buffer access strategy，
+ * 扫描时记录下自己从磁盘加载的页面，加载的页面个数超过环的大小后，就把最早加载的页面释放回缓冲池，
+ * 这样一次扫描最多只会占用环大小个页帧，不会污染整个缓冲池。
+ * 已经在缓冲池中的页面(比如被其它请求访问的页面)不会放到环中，按照正常的方式访问。
+ * 如果页帧管理器有多个分片，释放的页帧和新页面可能不在同一个分片，这时只能近似地限制页帧个数。
+ */
+class BufferRing
+{
+public:
+  static constexpr int DEFAULT_RING_SIZE = 16;
+
+  explicit BufferRing(int capacity = DEFAULT_RING_SIZE) : capacity_(capacity) {}
+
+  /**
+   * @brief 大文件的顺序扫描才需要使用页帧环
+   * @details 文件的页面个数超过缓冲池页帧个数的1/4时，认为是大文件
+   */
+  static bool need_ring(DiskBufferPool &buffer_pool);
+
+  bool full() const { return static_cast<int>(pages_.size()) >= capacity_; }
+
+  void    push(PageNum page_num) { pages_.push_back(page_num); }
+  PageNum pop();
+
+  int capacity() const { return capacity_; }
+
+private:
+  int            capacity_;
+  deque<PageNum> pages_;  ///< 通过当前环加载的页面，最早加载的在前面
 };
 
 /**
@@ -205,8 +394,19 @@ public:
 
   /**
    * 根据文件ID和页号获取指定页面到缓冲区，返回页面句柄指针。
+   * @param ring 顺序扫描时使用的页帧环，页面不在缓冲区时，会先释放环中最早加载的页面，参考 BufferRing
+   */
+  RC get_this_page(PageNum page_num, Frame **frame, BufferRing *ring = nullptr);
+
+  /**
+   * @brief 在后台把指定的页面加载到缓冲区中
+   * @details 调用者知道接下来要访问哪些页面时(比如B+树扫描时的下一个叶子节点)，可以直接
+   * 提交预读请求。不在文件中的页面、已经在缓冲区中的页面会被忽略。
+   * 如果缓冲池管理器没有开启预读，什么都不做。
+   * @param start_page 第一个预读的页面
+   * @param count 预读的页面个数
    */
-  RC get_this_page(PageNum page_num, Frame **frame);
+  RC read_ahead(PageNum start_page, int count);
 
   /**
    * @brief 在指定文件中分配一个新的页面，并将其放入缓冲区，返回页面句柄指针。
@@ -266,12 +466,33 @@ public:
    */
   RC write_page(PageNum page_num, Page &page);
 
+  /**
+   * @brief 生成把页面写入磁盘的请求，用于批量刷新页面，参考 IoEngine::submit
+   */
+  IoRequest write_page_request(PageNum page_num, const Page &page) const;
+
+  /**
+   * @brief 把已经写入文件的页面同步到磁盘(fsync)
+   * @details 页面写入文件后只是在操作系统的缓存中，推进检查点、回收日志之前要先同步
+   */
+  RC sync();
+
   RC redo_allocate_page(LSN lsn, PageNum page_num);
   RC redo_deallocate_page(LSN lsn, PageNum page_num);
 
+  /**
+   * @brief 查找从 start_page 开始的第一个已经分配的页面，跳过文件头和位图页
+   * @return 没有找到时返回 BP_INVALID_PAGE_NUM
+   */
+  PageNum next_allocated_page(PageNum start_page);
+
 public:
   int32_t id() const { return buffer_pool_id_; }
 
+  int32_t page_count() const { return file_header_->page_count; }
+  int     page_size() const { return page_size_; }
+  int     page_data_size() const { return bp_page_data_size(page_size_); }
+
   const char *filename() const { return file_name_.c_str(); }
 
 protected:
@@ -288,6 +509,49 @@ protected:
    */
   RC load_page(PageNum page_num, Frame *frame);
 
+  /**
+   * @brief 为页面申请页帧并从磁盘加载，调用者需要持有 lock_
+   */
+  RC load_frame(PageNum page_num, Frame **frame);
+
+  /**
+   * @brief 获取组的位图页，调用者需要持有 lock_
+   * @param create 位图页不在文件中时，是否直接在内存中创建一个新的位图页。回放日志时使用
+   */
+  RC get_bitmap_frame(int group, Frame **frame, bool create = false);
+
+  /**
+   * @brief 查找一个空闲页面，调用者需要持有 lock_
+   * @return 没有空闲页面时返回 BP_INVALID_PAGE_NUM
+   */
+  PageNum find_free_page();
+
+  /**
+   * @brief 保证文件的空间足够存放 page_num，调用者需要持有 lock_
+   * @details 文件按照区(extent)扩展，一次使用 fallocate 分配一个区的空间，
+   * 这样一个文件的页面在磁盘上基本是连续的，也不需要每分配一个页面就写一次文件来扩展文件大小。
+   * 文件系统不支持 fallocate 时，只修改文件大小。
+   */
+  RC reserve_pages(PageNum page_num);
+
+  /**
+   * @brief 扩展文件直到包含 page_num，新扩展的页面都是空闲的。调用者需要持有 lock_
+   * @details 扩展到新组的第一个页面时，会先初始化这个组的位图页
+   * @param redo 是否在回放日志，回放时只修改LSN比日志小的页面
+   */
+  RC extend_pages(PageNum page_num, LSN lsn, bool redo);
+
+  /**
+   * @brief 修改页面的分配状态，同时更新文件头和位图页。调用者需要持有 lock_
+   * @param redo 是否在回放日志，回放时只修改LSN比日志小的页面
+   */
+  RC set_page_allocated(PageNum page_num, bool allocated, LSN lsn, bool redo);
+
+  /**
+   * 预读一批页面，在后台线程中执行。需要从磁盘读取的页面会一起提交给 IoEngine
+   */
+  RC prefetch_pages(const vector<PageNum> &page_nums);
+
   /**
    * 如果页面是脏的，就将数据刷新到磁盘
    */
@@ -295,11 +559,13 @@ protected:
 
 private:
   BufferPoolManager   &bp_manager_;     /// BufferPool 管理器
-  BPFrameManager      &frame_manager_;  /// Frame 管理器
+  BPFrameManager      *frame_manager_;  /// Frame 管理器，与文件的页面大小对应
   DoubleWriteBuffer   &dblwr_manager_;  /// Double Write Buffer 管理器
   BufferPoolLogHandler log_handler_;    /// BufferPool 日志处理器
 
-  int file_desc_ = -1;  /// 文件描述符
+  int     file_desc_     = -1;  /// 文件描述符
+  PageNum file_page_num_ = 0;   /// 文件已经分配了空间的页面个数，可能比 page_count 大
+  int     page_size_     = BP_PAGE_SIZE;  /// 文件的页面大小，打开文件时从文件头中读取
   /// 由于在最开始打开文件时，没有正确的buffer pool id不能加载header frame，所以单独从文件中读取此标识
   int32_t       buffer_pool_id_ = -1;
   Frame        *hdr_frame_      = nullptr;  /// 文件头页面
@@ -309,10 +575,15 @@ private:
   string file_name_;  /// 文件名
 
   common::Mutex lock_;
-  common::Mutex wr_lock_;
+  /// 从磁盘加载页面时持有。预读在后台线程中执行，而没有开启 CONCURRENCY 时 lock_ 不会真正加锁
+  mutex         load_lock_;
+
+  unique_ptr<ReadAheadDetector> read_ahead_detector_;     /// 顺序访问检测，没有开启预读时为空
+  atomic<int>                   read_ahead_pending_{0};  /// 还没有执行完成的预读任务个数
 
 private:
   friend class BufferPoolIterator;
+  friend class BufferRing;
 };
 
 /**
@@ -322,19 +593,76 @@ private:
 class BufferPoolManager final
 {
 public:
-  BufferPoolManager(int memory_size = 0);
+  /// 默认一个区(extent)的页面个数
+  static constexpr int DEFAULT_EXTENT_PAGE_NUM = 64;
+
+  /**
+   * @param memory_size 页帧可以使用的内存大小，0 表示使用默认值
+   * @param frame_shard_num 页帧管理器的分片个数，参考 BPFrameManager
+   * @param frame_replacer 页帧淘汰策略，参考 FrameReplacer::create
+   * @param page_size_class_num 会用到几种页面大小。memory_size 平分给这些页面大小，参考 get_frame_manager
+   */
+  BufferPoolManager(int memory_size = 0, int frame_shard_num = 1, const char *frame_replacer = nullptr,
+      int page_size_class_num = 1);
   ~BufferPoolManager();
 
-  RC init(unique_ptr<DoubleWriteBuffer> dblwr_buffer);
+  /**
+   * @param read_ahead_window 每次预读的页面个数，0 表示不开启预读
+   * @param io_engine 页面读写引擎，参考 IoEngine::create。不指定时使用同步读写
+   * @param direct_io 是否使用 O_DIRECT 打开数据文件，页面不再经过操作系统的页缓存
+   * @param extent_page_num 数据文件每次扩展的页面个数，参考 DiskBufferPool::reserve_pages
+   */
+  RC init(unique_ptr<DoubleWriteBuffer> dblwr_buffer, int read_ahead_window = 0, const char *io_engine = nullptr,
+      bool direct_io = false, int extent_page_num = DEFAULT_EXTENT_PAGE_NUM);
+
+  /**
+   * @brief 启动后台刷脏页的线程，参考 PageCleaner
+   * @param clean_percent 希望保持的干净页帧比例
+   * @param io_capacity 每秒最多刷新的页面个数
+   */
+  RC start_page_cleaner(int clean_percent, int io_capacity);
 
-  RC create_file(const char *file_name);
+  /**
+   * @brief 创建文件
+   * @param page_size 文件的页面大小，参考 bp_valid_page_size。创建之后不能修改
+   */
+  RC create_file(const char *file_name, int page_size = BP_PAGE_SIZE);
   RC open_file(LogHandler &log_handler, const char *file_name, DiskBufferPool *&bp);
   RC close_file(const char *file_name);
 
   RC flush_page(Frame &frame);
 
+  /**
+   * @brief 把共享表空间文件和所有打开的数据文件同步到磁盘
+   * @details 推进检查点之前调用，检查点之前的日志回收后，页面只能从这些文件中恢复
+   * @param[out] durable_lsn 同步之前脏页最小的 recovery lsn，参考 min_recovery_lsn。
+   * 这之前的日志修改的页面都已经落盘，检查点不能超过它
+   */
+  RC sync_files(LSN &durable_lsn);
+
+  /// 最近一次 sync_files 成功时的 durable_lsn，还没有同步过时是0
+  LSN durable_lsn() const { return durable_lsn_.load(); }
+
+  /// 默认页面大小(BP_PAGE_SIZE)的页帧管理器
   BPFrameManager    &get_frame_manager() { return frame_manager_; }
+
+  /**
+   * @brief 获取指定页面大小的页帧管理器
+   * @details 每种页面大小使用一个单独的页帧管理器，第一次使用时创建。所有页帧管理器共用 memory_size，
+   * 每种页面大小分到 memory_size / page_size_class_num 的内存。页面大小的种类超过 page_size_class_num 时，
+   * 多出来的页帧管理器只申请一个内存池，保证总的内存基本不会超过 memory_size。
+   */
+  RC get_frame_manager(int page_size, BPFrameManager *&frame_manager);
+
+  /// 所有已经创建的页帧管理器，包括默认的页帧管理器
+  vector<BPFrameManager *> frame_managers();
+
+  /// 所有页帧管理器中脏页最小的 recovery lsn，参考 BPFrameManager::min_recovery_lsn
+  LSN min_recovery_lsn();
+
   DoubleWriteBuffer *get_dblwr_buffer() { return dblwr_buffer_.get(); }
+  IoEngine          &io_engine() { return *io_engine_; }
+  PageCleaner       *page_cleaner() { return page_cleaner_.get(); }
 
   /**
    * @brief 根据ID获取对应的BufferPool对象
@@ -344,13 +672,39 @@ public:
    */
   RC get_buffer_pool(int32_t id, DiskBufferPool *&bp);
 
+  int  read_ahead_window() const { return read_ahead_window_; }
+  bool direct_io() const { return direct_io_; }
+  int  extent_page_num() const { return extent_page_num_; }
+
+  /**
+   * @brief 把预读任务交给后台线程执行
+   */
+  RC execute_read_ahead(const function<void()> &task);
+
 private:
   BPFrameManager frame_manager_{"BufPool"};
 
+  int    memory_size_         = 0;  ///< 所有页帧管理器一共使用的内存大小
+  int    page_size_class_num_ = 1;  ///< memory_size_ 平分给几种页面大小
+  int    frame_shard_num_ = 1;
+  string frame_replacer_;
+
+  mutex                                frame_manager_lock_;  ///< 打开文件时已经持有 lock_，使用单独的锁
+  map<int, unique_ptr<BPFrameManager>> sized_frame_managers_;  ///< 页面大小不是 BP_PAGE_SIZE 的页帧管理器
+
+  unique_ptr<IoEngine>          io_engine_;  ///< 需要在 dblwr_buffer_ 之后析构，析构 dblwr_buffer_ 时还会写页面
   unique_ptr<DoubleWriteBuffer> dblwr_buffer_;
+  unique_ptr<PageCleaner>       page_cleaner_;
+
+  int                        read_ahead_window_ = 0;
+  common::ThreadPoolExecutor read_ahead_executor_;  /// 预读使用的后台线程
+
+  bool direct_io_       = false;  ///< 数据文件是否使用 O_DIRECT 打开
+  int  extent_page_num_ = DEFAULT_EXTENT_PAGE_NUM;
 
   common::Mutex                            lock_;
   unordered_map<string, DiskBufferPool *>  buffer_pools_;
   unordered_map<int32_t, DiskBufferPool *> id_to_buffer_pools_;
+  atomic<LSN>                              durable_lsn_{0};
   atomic<int32_t>                          next_buffer_pool_id_{1};  // 系统启动时，会打开所有的表，这样就可以知道当前系统最大的ID是多少了
 };
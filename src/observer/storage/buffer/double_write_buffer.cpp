@@ -16,32 +16,67 @@ See the Mulan PSL v2 for more details. */
 #include "storage/buffer/double_write_buffer.h"
 #include "storage/buffer/disk_buffer_pool.h"
 #include "common/io/io.h"
+#include "common/lang/new.h"
+#include "common/lang/unordered_set.h"
 #include "common/log/log.h"
 #include "common/math/crc.h"
 #include <algorithm>
 
 using namespace common;
 
+/**
+ * @note 页面会直接写入数据文件，数据文件使用 O_DIRECT 打开时要求内存对齐，
+ * 所以按照 BP_PAGE_ALIGNMENT 对齐申请内存，元数据放在前面并占用 META_SIZE 个字节，页面紧跟在元数据后面。
+ * 每个文件的页面大小可能不同，内存中按照页面的实际大小申请，
+ * 共享表空间文件中每个页面按照最大的页面大小预留空间(SLOT_SIZE)，但只写入实际的大小。
+ */
 struct DoubleWritePage
 {
 public:
-  DoubleWritePage() = default;
-  DoubleWritePage(int32_t buffer_pool_id, PageNum page_num, int32_t page_index, Page &page);
+  static constexpr int32_t META_SIZE = BP_PAGE_ALIGNMENT;
+  static constexpr int32_t SLOT_SIZE = META_SIZE + BP_MAX_PAGE_SIZE;
+
+  explicit DoubleWritePage(int32_t page_size) : page_size(page_size) {}
+  DoubleWritePage(const DoubleWritePage &other) = default;
+  DoubleWritePage(int32_t buffer_pool_id, PageNum page_num, int32_t page_index, int32_t page_size, const Page &page);
+
+  static void *operator new(size_t size, int32_t page_size);
+  static void  operator delete(void *ptr, int32_t page_size);
+  static void  operator delete(void *ptr);
+
+  Page       &page() { return *reinterpret_cast<Page *>(reinterpret_cast<char *>(this) + META_SIZE); }
+  const Page &page() const { return *reinterpret_cast<const Page *>(reinterpret_cast<const char *>(this) + META_SIZE); }
+
+  /// 元数据和页面一共占用的字节数，也是写入共享表空间文件的字节数
+  int32_t size() const { return META_SIZE + page_size; }
 
 public:
   DoubleWritePageKey key;
-  int32_t            page_index = -1; /// 页面在double write buffer文件中的页索引
-  bool               valid = true; /// 表示页面是否有效，在页面被删除时，需要同时标记磁盘上的值。
-  Page               page;
-
-  static const int32_t SIZE;
+  int32_t            page_index = -1;  /// 页面在double write buffer文件中的页索引
+  int32_t            page_size  = BP_PAGE_SIZE;
+  bool               valid      = true;  /// 表示页面是否有效，在页面被删除时，需要同时标记磁盘上的值。
 };
 
-DoubleWritePage::DoubleWritePage(int32_t buffer_pool_id, PageNum page_num, int32_t page_index, Page &_page)
-  : key{buffer_pool_id, page_num}, page_index(page_index), page(_page)
-{}
+static_assert(sizeof(DoubleWritePage) <= DoubleWritePage::META_SIZE, "double write page meta is too large");
 
-const int32_t DoubleWritePage::SIZE = sizeof(DoubleWritePage);
+DoubleWritePage::DoubleWritePage(
+    int32_t buffer_pool_id, PageNum page_num, int32_t page_index, int32_t page_size, const Page &_page)
+    : key{buffer_pool_id, page_num}, page_index(page_index), page_size(page_size)
+{
+  memcpy(&page(), &_page, page_size);
+}
+
+void *DoubleWritePage::operator new(size_t size, int32_t page_size)
+{
+  return ::operator new(META_SIZE + page_size, align_val_t(BP_PAGE_ALIGNMENT));
+}
+
+void DoubleWritePage::operator delete(void *ptr, int32_t page_size)
+{
+  ::operator delete(ptr, align_val_t(BP_PAGE_ALIGNMENT));
+}
+
+void DoubleWritePage::operator delete(void *ptr) { ::operator delete(ptr, align_val_t(BP_PAGE_ALIGNMENT)); }
 
 const int32_t DoubleWriteBufferHeader::SIZE = sizeof(DoubleWriteBufferHeader);
 
@@ -75,18 +110,45 @@ RC DiskDoubleWriteBuffer::open_file(const char *filename)
 
 RC DiskDoubleWriteBuffer::flush_page()
 {
-  sync();
+  if (dblwr_pages_.empty()) {
+    return RC::SUCCESS;
+  }
 
+  // 共享表空间中的页面落盘之后，才能覆盖写数据文件中的页面
+  if (0 != fsync(file_desc_)) {
+    LOG_ERROR("Failed to sync double write buffer file. error=%s", strerror(errno));
+    return RC::IOERR_SYNC;
+  }
+
+  // 所有页面一起写入各自的文件，全部成功之后，再一起在共享表空间中标记为无效
+  vector<IoRequest> requests;
+  requests.reserve(dblwr_pages_.size());
+  for (const auto &pair : dblwr_pages_) {
+    write_page(pair.second, requests);
+  }
+
+  RC rc = bp_manager_.io_engine().submit(requests);
+  if (OB_FAIL(rc)) {
+    LOG_ERROR("Failed to write pages in double write buffer to disk. page count=%d, rc=%s",
+              static_cast<int>(requests.size()), strrc(rc));
+    return rc;
+  }
+
+  rc = sync_buffer_pools();
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  requests.clear();
   for (const auto &pair : dblwr_pages_) {
-    RC rc = write_page(pair.second);
-    if (rc != RC::SUCCESS) {
-      return rc;
-    }
     pair.second->valid = false;
-    write_page_internal(pair.second);
-    delete pair.second;
+    requests.push_back(write_page_internal_request(pair.second));
   }
+  (void)bp_manager_.io_engine().submit(requests);
 
+  for (const auto &pair : dblwr_pages_) {
+    delete pair.second;
+  }
   dblwr_pages_.clear();
   header_.page_cnt = 0;
 
@@ -99,14 +161,14 @@ RC DiskDoubleWriteBuffer::add_page(DiskBufferPool *bp, PageNum page_num, Page &p
   DoubleWritePageKey key{bp->id(), page_num};
   auto iter = dblwr_pages_.find(key);
   if (iter != dblwr_pages_.end()) {
-    iter->second->page = page;
+    memcpy(&iter->second->page(), &page, iter->second->page_size);
     LOG_TRACE("[cache hit]add page into double write buffer. buffer_pool_id:%d,page_num:%d,lsn=%d, dwb size=%d",
               bp->id(), page_num, page.lsn, static_cast<int>(dblwr_pages_.size()));
     return write_page_internal(iter->second);
   }
 
   int64_t          page_cnt   = dblwr_pages_.size();
-  DoubleWritePage *dblwr_page = new DoubleWritePage(bp->id(), page_num, page_cnt, page);
+  DoubleWritePage *dblwr_page = new (bp->page_size()) DoubleWritePage(bp->id(), page_num, page_cnt, bp->page_size(), page);
   dblwr_pages_.insert(pair<DoubleWritePageKey, DoubleWritePage *>(key, dblwr_page));
   LOG_TRACE("insert page into double write buffer. buffer_pool_id:%d,page_num:%d,lsn=%d, dwb size:%d",
             bp->id(), page_num, page.lsn, static_cast<int>(dblwr_pages_.size()));
@@ -120,14 +182,10 @@ RC DiskDoubleWriteBuffer::add_page(DiskBufferPool *bp, PageNum page_num, Page &p
 
   if (page_cnt + 1 > header_.page_cnt) {
     header_.page_cnt = page_cnt + 1;
-    if (lseek(file_desc_, 0, SEEK_SET) == -1) {
-      LOG_ERROR("Failed to add page header due to failed to seek %s.", strerror(errno));
-      return RC::IOERR_SEEK;
-    }
-
-    if (writen(file_desc_, &header_, sizeof(header_)) != 0) {
-      LOG_ERROR("Failed to add page header due to %s.", strerror(errno));
-      return RC::IOERR_WRITE;
+    rc               = bp_manager_.io_engine().write(file_desc_, &header_, sizeof(header_), 0);
+    if (OB_FAIL(rc)) {
+      LOG_ERROR("Failed to add page header. rc=%s", strrc(rc));
+      return rc;
     }
   }
 
@@ -142,39 +200,72 @@ RC DiskDoubleWriteBuffer::add_page(DiskBufferPool *bp, PageNum page_num, Page &p
   return RC::SUCCESS;
 }
 
+IoRequest DiskDoubleWriteBuffer::write_page_internal_request(DoubleWritePage *page)
+{
+  int64_t offset = static_cast<int64_t>(page->page_index) * DoubleWritePage::SLOT_SIZE + DoubleWriteBufferHeader::SIZE;
+  return IoRequest::write(file_desc_, page, page->size(), offset);
+}
+
 RC DiskDoubleWriteBuffer::write_page_internal(DoubleWritePage *page)
 {
-  int32_t page_index = page->page_index;
-  int64_t offset = page_index * DoubleWritePage::SIZE + DoubleWriteBufferHeader::SIZE;
-  if (lseek(file_desc_, offset, SEEK_SET) == -1) {
-    LOG_ERROR("Failed to add page %lld of %d due to failed to seek %s.", offset, file_desc_, strerror(errno));
-    return RC::IOERR_SEEK;
-  }
+  vector<IoRequest> requests{write_page_internal_request(page)};
 
-  if (writen(file_desc_, page, DoubleWritePage::SIZE) != 0) {
-    LOG_ERROR("Failed to add page %lld of %d due to %s.", offset, file_desc_, strerror(errno));
-    return RC::IOERR_WRITE;
+  RC rc = bp_manager_.io_engine().submit(requests);
+  if (OB_FAIL(rc)) {
+    LOG_ERROR("Failed to add page %lld of %d. rc=%s", requests[0].offset, file_desc_, strrc(rc));
   }
-
-  return RC::SUCCESS;
+  return rc;
 }
 
-RC DiskDoubleWriteBuffer::write_page(DoubleWritePage *dblwr_page)
+void DiskDoubleWriteBuffer::write_page(DoubleWritePage *dblwr_page, vector<IoRequest> &requests)
 {
   DiskBufferPool *disk_buffer = nullptr;
   // skip invalid page
   if (!dblwr_page->valid) {
     LOG_TRACE("double write buffer write page invalid. buffer_pool_id:%d,page_num:%d,lsn=%d",
-              dblwr_page->key.buffer_pool_id, dblwr_page->key.page_num, dblwr_page->page.lsn);
-    return RC::SUCCESS;
+              dblwr_page->key.buffer_pool_id, dblwr_page->key.page_num, dblwr_page->page().lsn);
+    return;
   }
   RC rc = bp_manager_.get_buffer_pool(dblwr_page->key.buffer_pool_id, disk_buffer);
   ASSERT(OB_SUCC(rc) && disk_buffer != nullptr, "failed to get disk buffer pool of %d", dblwr_page->key.buffer_pool_id);
 
   LOG_TRACE("double write buffer write page. buffer_pool_id:%d,page_num:%d,lsn=%d",
-            dblwr_page->key.buffer_pool_id, dblwr_page->key.page_num, dblwr_page->page.lsn);
+            dblwr_page->key.buffer_pool_id, dblwr_page->key.page_num, dblwr_page->page().lsn);
 
-  return disk_buffer->write_page(dblwr_page->key.page_num, dblwr_page->page);
+  requests.push_back(disk_buffer->write_page_request(dblwr_page->key.page_num, dblwr_page->page()));
+}
+
+RC DiskDoubleWriteBuffer::sync_buffer_pools()
+{
+  unordered_set<int32_t> buffer_pool_ids;
+  for (const auto &pair : dblwr_pages_) {
+    if (pair.second->valid) {
+      buffer_pool_ids.insert(pair.first.buffer_pool_id);
+    }
+  }
+
+  for (int32_t buffer_pool_id : buffer_pool_ids) {
+    DiskBufferPool *disk_buffer = nullptr;
+    RC              rc          = bp_manager_.get_buffer_pool(buffer_pool_id, disk_buffer);
+    if (OB_SUCC(rc)) {
+      rc = disk_buffer->sync();
+    }
+    if (OB_FAIL(rc)) {
+      LOG_ERROR("Failed to sync buffer pool %d. rc=%s", buffer_pool_id, strrc(rc));
+      return rc;
+    }
+  }
+  return RC::SUCCESS;
+}
+
+RC DiskDoubleWriteBuffer::sync_file()
+{
+  scoped_lock lock_guard(lock_);
+  if (file_desc_ >= 0 && 0 != fsync(file_desc_)) {
+    LOG_ERROR("Failed to sync double write buffer file. error=%s", strerror(errno));
+    return RC::IOERR_SYNC;
+  }
+  return RC::SUCCESS;
 }
 
 RC DiskDoubleWriteBuffer::read_page(DiskBufferPool *bp, PageNum page_num, Page &page)
@@ -183,7 +274,7 @@ RC DiskDoubleWriteBuffer::read_page(DiskBufferPool *bp, PageNum page_num, Page &
   DoubleWritePageKey key{bp->id(), page_num};
   auto iter = dblwr_pages_.find(key);
   if (iter != dblwr_pages_.end()) {
-    page = iter->second->page;
+    memcpy(&page, &iter->second->page(), iter->second->page_size);
     LOG_TRACE("double write buffer read page success. bp id=%d, page_num:%d, lsn:%d", bp->id(), page_num, page.lsn);
     return RC::SUCCESS;
   }
@@ -211,22 +302,32 @@ RC DiskDoubleWriteBuffer::clear_pages(DiskBufferPool *buffer_pool)
   LOG_INFO("clear pages in double write buffer. file name=%s, page count=%d",
            buffer_pool->filename(), spec_pages.size());
 
-  // 页面从小到大排序，防止出现小页面还没有写入，而页面编号更大的seek失败的情况
+  // 页面从小到大排序，按照文件中的顺序提交写请求
   sort(spec_pages.begin(), spec_pages.end(), [](DoubleWritePage *a, DoubleWritePage *b) {
     return a->key.page_num < b->key.page_num;
   });
 
-  RC rc = RC::SUCCESS;
+  vector<IoRequest> requests;
+  requests.reserve(spec_pages.size());
   for (DoubleWritePage *dbl_page : spec_pages) {
-    rc = buffer_pool->write_page(dbl_page->key.page_num, dbl_page->page);
-    if (OB_FAIL(rc)) {
-      LOG_WARN("Failed to write page %s:%d to disk buffer pool. rc=%s",
-               buffer_pool->filename(), dbl_page->key.page_num, strrc(rc));
-      break;
+    requests.push_back(buffer_pool->write_page_request(dbl_page->key.page_num, dbl_page->page()));
+  }
+
+  RC rc = bp_manager_.io_engine().submit(requests);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("Failed to write pages to disk buffer pool %s. rc=%s", buffer_pool->filename(), strrc(rc));
+  }
+  const bool synced = OB_SUCC(buffer_pool->sync());
+
+  // 只有成功写入文件并且落盘的页面，才能在共享表空间中标记为无效
+  vector<IoRequest> invalid_requests;
+  for (size_t i = 0; i < spec_pages.size() && synced; i++) {
+    if (OB_SUCC(requests[i].rc)) {
+      spec_pages[i]->valid = false;
+      invalid_requests.push_back(write_page_internal_request(spec_pages[i]));
     }
-    dbl_page->valid = false;
-    write_page_internal(dbl_page);
   }
+  (void)bp_manager_.io_engine().submit(invalid_requests);
 
   for_each(spec_pages.begin(), spec_pages.end(), [](DoubleWritePage *dbl_page) { delete dbl_page; });
 
@@ -258,25 +359,43 @@ RC DiskDoubleWriteBuffer::load_pages()
   }
 
   for (int page_num = 0; page_num < header_.page_cnt; page_num++) {
-    int64_t offset = ((int64_t)page_num) * DoubleWritePage::SIZE + DoubleWriteBufferHeader::SIZE;
+    int64_t offset = ((int64_t)page_num) * DoubleWritePage::SLOT_SIZE + DoubleWriteBufferHeader::SIZE;
 
     if (lseek(file_desc_, offset, SEEK_SET) == -1) {
       LOG_ERROR("Failed to load page %d, offset=%ld, due to failed to lseek:%s.", page_num, offset, strerror(errno));
       return RC::IOERR_SEEK;
     }
 
-    auto dblwr_page = make_unique<DoubleWritePage>();
-    Page &page     = dblwr_page->page;
+    // 先读元数据，知道页面大小之后再读页面
+    DoubleWritePage meta(BP_PAGE_SIZE);
+    ret = readn(file_desc_, &meta, sizeof(meta));
+    if (ret != 0) {
+      LOG_ERROR("Failed to load page meta, file_desc:%d, page num:%d, due to failed to read data:%s, ret=%d",
+                file_desc_, page_num, strerror(errno), ret);
+      return RC::IOERR_READ;
+    }
+    if (!bp_valid_page_size(meta.page_size)) {
+      LOG_TRACE("got a page with an invalid page size. page num:%d, page size:%d", page_num, meta.page_size);
+      continue;
+    }
+
+    unique_ptr<DoubleWritePage> dblwr_page(new (meta.page_size) DoubleWritePage(meta));
+    Page &page     = dblwr_page->page();
     page.check_sum = (CheckSum)-1;
 
-    ret = readn(file_desc_, dblwr_page.get(), DoubleWritePage::SIZE);
+    if (lseek(file_desc_, offset + DoubleWritePage::META_SIZE, SEEK_SET) == -1) {
+      LOG_ERROR("Failed to load page %d, offset=%ld, due to failed to lseek:%s.", page_num, offset, strerror(errno));
+      return RC::IOERR_SEEK;
+    }
+
+    ret = readn(file_desc_, &page, meta.page_size);
     if (ret != 0) {
       LOG_ERROR("Failed to load page, file_desc:%d, page num:%d, due to failed to read data:%s, ret=%d, page count=%d",
                 file_desc_, page_num, strerror(errno), ret, page_num);
       return RC::IOERR_READ;
     }
 
-    const CheckSum check_sum = crc32(page.data, BP_PAGE_DATA_SIZE);
+    const CheckSum check_sum = crc32(page.data, bp_page_data_size(dblwr_page->page_size));
     if (check_sum == page.check_sum) {
       DoubleWritePageKey key = dblwr_page->key;
       dblwr_pages_.insert(pair<DoubleWritePageKey, DoubleWritePage *>(key, dblwr_page.release()));
@@ -18,6 +18,7 @@ See the Mulan PSL v2 for more details. */
 #include "common/lang/unordered_map.h"
 #include "common/types.h"
 #include "common/sys/rc.h"
+#include "storage/buffer/io_engine.h"
 #include "storage/buffer/page.h"
 
 class DiskBufferPool;
@@ -41,6 +42,11 @@ public:
    * @brief 清空所有与指定buffer pool关联的页面
    */
   virtual RC clear_pages(DiskBufferPool *bp) = 0;
+
+  /**
+   * @brief 把共享表空间文件同步到磁盘
+   */
+  virtual RC sync_file() = 0;
 };
 
 struct DoubleWriteBufferHeader
@@ -117,6 +123,8 @@ public:
    */
   RC clear_pages(DiskBufferPool *bp) override;
 
+  RC sync_file() override;
+
   /**
    * 将共享表空间的页读入buffer
    */
@@ -124,16 +132,23 @@ public:
 
 private:
   /**
-   * 将buffer中的页面写入对应的磁盘
+   * 生成将buffer中的页面写入对应磁盘的请求，无效的页面会被跳过
    */
-  RC write_page(DoubleWritePage *page);
+  void write_page(DoubleWritePage *page, vector<IoRequest> &requests);
+
+  /**
+   * @brief 同步buffer中有效页面所在的数据文件
+   * @details 数据文件落盘之后，才能在共享表空间中把这些页面标记为无效
+   */
+  RC sync_buffer_pools();
 
   /**
    * 将页面写到当前double write buffer文件中
    * @details 每次页面更新都应该写入到磁盘中。保证double write buffer
    * 内存和文件中的数据都是最新的。
    */
-  RC write_page_internal(DoubleWritePage *page);
+  RC        write_page_internal(DoubleWritePage *page);
+  IoRequest write_page_internal_request(DoubleWritePage *page);
 
   /**
    * @brief 将磁盘文件中的内容加载到内存中。在启动时调用
@@ -166,4 +181,6 @@ public:
    * @brief 清空所有与指定buffer pool关联的页面
    */
   RC clear_pages(DiskBufferPool *bp) override { return RC::SUCCESS; }
+
+  RC sync_file() override { return RC::SUCCESS; }
 };
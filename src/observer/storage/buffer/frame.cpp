@@ -12,6 +12,8 @@ See the Mulan PSL v2 for more details. */
 // Created by lianyu on 2022/10/29.
 //
 
+#include <stdlib.h>
+
 #include "storage/buffer/frame.h"
 #include "session/session.h"
 #include "session/thread_data.h"
@@ -38,6 +40,23 @@ string FrameId::to_string() const
 }
 
 ////////////////////////////////////////////////////////////////////////////////
+Frame::Frame() : owns_page_(true)
+{
+  page_ = static_cast<Page *>(aligned_alloc(BP_PAGE_ALIGNMENT, sizeof(Page)));
+  ASSERT(page_ != nullptr, "failed to allocate page for frame");
+  memset(page_, 0, sizeof(Page));
+}
+
+Frame::Frame(Page *page, int page_size /* = BP_PAGE_SIZE */) : page_(page), page_size_(page_size) {}
+
+Frame::~Frame()
+{
+  // LOG_DEBUG("deallocate frame. this=%p, lbt=%s", this, common::lbt());
+  if (owns_page_) {
+    ::free(page_);
+  }
+}
+
 intptr_t get_default_debug_xid()
 {
 #if 0
@@ -65,20 +65,40 @@ private:
 class Frame
 {
 public:
-  ~Frame()
-  {
-    // LOG_DEBUG("deallocate frame. this=%p, lbt=%s", this, common::lbt());
-  }
+  /**
+   * @brief 自己申请一个对齐的页面，单独使用页帧时(比如测试)使用
+   */
+  Frame();
+
+  /**
+   * @brief 使用外部的页面内存，由 FrameAllocator 管理页面内存的生命周期
+   * @param page_size 页面内存的大小
+   */
+  explicit Frame(Page *page, int page_size = BP_PAGE_SIZE);
+
+  ~Frame();
+
+  Frame(const Frame &)            = delete;
+  Frame &operator=(const Frame &) = delete;
 
   /**
    * @brief reinit 和 reset 在 MemPoolSimple 中使用
    * @details 在 MemPoolSimple 分配和释放一个Frame对象时，不会调用构造函数和析构函数，
    * 而是调用reinit和reset。
    */
-  void reinit() {}
-  void reset() {}
+  void reinit()
+  {
+    prefetched_.store(false);
+    loading_.store(false);
+    recovery_lsn_.store(0);
+  }
+  void reset()
+  {
+    prefetched_.store(false);
+    loading_.store(false);
+  }
 
-  void clear_page() { memset(&page_, 0, sizeof(page_)); }
+  void clear_page() { memset(page_, 0, page_size_); }
 
   int  buffer_pool_id() const { return frame_id_.buffer_pool_id(); }
   void set_buffer_pool_id(int id) { frame_id_.set_buffer_pool_id(id); }
@@ -88,7 +108,7 @@ public:
    * @details 磁盘文件划分为一个个页面，每次从磁盘加载到内存中，也是一个页面，就是 Page。
    * frame 是为了管理这些页面而维护的一个数据结构。
    */
-  Page &page() { return page_; }
+  Page &page() { return *page_; }
 
   /**
    * @brief 每个页面都有一个编号
@@ -103,15 +123,27 @@ public:
    * @details 如果当前页面从磁盘中加载出来时，它的日志序列号比当前WAL(Write-Ahead-Logging)中的一些
    * 序列号要小，那就可以从日志中读取这些更大序列号的日志，做重做操作，将页面恢复到最新状态，也就是redo。
    */
-  LSN  lsn() const { return page_.lsn; }
-  void set_lsn(LSN lsn) { page_.lsn = lsn; }
+  LSN  lsn() const { return page_->lsn; }
+  void set_lsn(LSN lsn)
+  {
+    page_->lsn = lsn;
+    LSN expected = 0;
+    recovery_lsn_.compare_exchange_strong(expected, lsn);
+  }
+
+  /**
+   * @brief 上次刷盘之后，第一次修改页面的日志序列号
+   * @details 页面刷盘之前，从这个位置开始的日志都不能丢弃，重启时至少需要从这里开始重做。
+   * 0 表示不知道(比如没有记录日志的修改)，按照最老的页面处理。
+   */
+  LSN recovery_lsn() const { return recovery_lsn_.load(); }
 
   /**
    * @brief 页面校验和
    * @details 用于校验页面完整性。如果页面写入一半时出现异常，可以通过校验和检测出来。
    */
-  CheckSum check_sum() const { return page_.check_sum; }
-  void     set_check_sum(CheckSum check_sum) { page_.check_sum = check_sum; }
+  CheckSum check_sum() const { return page_->check_sum; }
+  void     set_check_sum(CheckSum check_sum) { page_->check_sum = check_sum; }
 
   /**
    * @brief 刷新当前内存页面的访问时间
@@ -132,10 +164,33 @@ public:
    * @brief 重置“脏”标记
    * @details 如果页面已经被写入磁盘文件，则应调用此函数。
    */
-  void clear_dirty() { dirty_ = false; }
+  void clear_dirty()
+  {
+    dirty_ = false;
+    recovery_lsn_.store(0);
+  }
   bool dirty() const { return dirty_; }
 
-  char *data() { return page_.data; }
+  char *data() { return page_->data; }
+
+  int page_size() const { return page_size_; }
+  int page_data_size() const { return bp_page_data_size(page_size_); }
+
+  /**
+   * @brief 页面是否是预读加载的，并且还没有被访问过
+   * @details 用来统计预读的效果。预读的页面被访问时清除这个标识，算作一次预读命中；
+   * 如果直到淘汰都没有被访问过，就是一次无效的预读。
+   */
+  void set_prefetched() { prefetched_.store(true); }
+  bool clear_prefetched() { return prefetched_.exchange(false); }
+
+  /**
+   * @brief 页帧已经放到缓冲池中，但是页面数据还没有从磁盘读上来
+   * @details 加载页面的线程会持有 DiskBufferPool 的锁，其它线程拿到这样的页帧时，需要等待加载结束。
+   * 加载失败的页帧会一直保持这个标识，直到被释放。
+   */
+  void set_loading(bool loading) { loading_.store(loading); }
+  bool loading() const { return loading_.load(); }
 
   bool can_purge() { return pin_count_.load() == 0; }
 
@@ -173,9 +228,14 @@ private:
 
   bool          dirty_ = false;
   atomic<int>   pin_count_{0};
+  atomic<bool>  prefetched_{false};
+  atomic<bool>  loading_{false};
+  atomic<LSN>   recovery_lsn_{0};
   unsigned long acc_time_ = 0;
   FrameId       frame_id_;
-  Page          page_;
+  Page         *page_      = nullptr;  ///< 页面内存是单独申请的，保证按照 BP_PAGE_ALIGNMENT 对齐
+  int           page_size_ = BP_PAGE_SIZE;
+  bool          owns_page_ = false;
 
   /// 在非并发编译时，加锁解锁动作将什么都不做
   common::RecursiveSharedMutex lock_;
@@ -0,0 +1,196 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "storage/buffer/frame_allocator.h"
+#include "common/lang/new.h"
+#include "common/lang/sstream.h"
+#include "common/log/log.h"
+
+using namespace common;
+
+/// 使用大页时的页面大小，申请的内存不足一个大页时不使用大页
+static constexpr size_t HUGE_PAGE_SIZE = 2UL << 20;
+
+FrameAllocator::FrameAllocator(const char *tag, int page_size /* = BP_PAGE_SIZE */) : name_(tag), page_size_(page_size)
+{}
+
+FrameAllocator::~FrameAllocator() { cleanup(); }
+
+int FrameAllocator::init(bool dynamic, int pool_num, int item_num_per_pool /* = DEFAULT_ITEM_NUM_PER_POOL */)
+{
+  lock_guard<mutex> guard(lock_);
+  if (!chunks_.empty()) {
+    LOG_WARN("frame allocator has been initialized. name=%s", name_.c_str());
+    return 0;
+  }
+
+  if (pool_num <= 0 || item_num_per_pool <= 0) {
+    LOG_ERROR("invalid arguments. pool_num=%d, item_num_per_pool=%d, name=%s", pool_num, item_num_per_pool, name_.c_str());
+    return -1;
+  }
+
+  item_num_per_pool_ = item_num_per_pool;
+  dynamic_           = dynamic;
+
+  // 初始的页帧一次申请，内存连续才有机会使用大页
+  if (extend(pool_num * item_num_per_pool) != 0) {
+    return -1;
+  }
+
+  LOG_INFO("frame allocator init done. %s", to_string().c_str());
+  return 0;
+}
+
+void FrameAllocator::cleanup()
+{
+  lock_guard<mutex> guard(lock_);
+  for (Chunk &chunk : chunks_) {
+    release(chunk);
+  }
+  chunks_.clear();
+  frees_.clear();
+  used_.clear();
+  size_ = 0;
+}
+
+Frame *FrameAllocator::alloc()
+{
+  lock_guard<mutex> guard(lock_);
+  if (frees_.empty()) {
+    if (!dynamic_ || extend(item_num_per_pool_) != 0) {
+      return nullptr;
+    }
+  }
+
+  Frame *frame = frees_.back();
+  frees_.pop_back();
+  used_.insert(frame);
+
+  frame->reinit();
+  return frame;
+}
+
+void FrameAllocator::free(Frame *frame)
+{
+  frame->reset();
+
+  lock_guard<mutex> guard(lock_);
+  if (used_.erase(frame) == 0) {
+    LOG_WARN("no entry of %p in %s.", frame, name_.c_str());
+    return;
+  }
+  frees_.push_back(frame);
+}
+
+int FrameAllocator::get_size() const
+{
+  lock_guard<mutex> guard(lock_);
+  return size_;
+}
+
+int FrameAllocator::get_used_num() const
+{
+  lock_guard<mutex> guard(lock_);
+  return static_cast<int>(used_.size());
+}
+
+bool FrameAllocator::huge_page() const
+{
+  lock_guard<mutex> guard(lock_);
+  for (const Chunk &chunk : chunks_) {
+    if (chunk.huge_page) {
+      return true;
+    }
+  }
+  return false;
+}
+
+string FrameAllocator::to_string() const
+{
+  stringstream ss;
+  ss << "name:" << name_ << ",page_size:" << page_size_ << ",dynamic:" << dynamic_ << ",size:" << size_ << ",chunk_num:" << chunks_.size()
+     << ",used_size:" << used_.size() << ",free_size:" << frees_.size();
+  return ss.str();
+}
+
+int FrameAllocator::extend(int item_num)
+{
+  Chunk chunk;
+  chunk.item_num = item_num;
+  chunk.pages    = map_pages(static_cast<size_t>(item_num) * page_size_, chunk.mapped_size, chunk.huge_page);
+  if (chunk.pages == nullptr) {
+    LOG_ERROR("failed to allocate pages. item_num=%d, name=%s, error=%s", item_num, name_.c_str(), strerror(errno));
+    return -1;
+  }
+
+  chunk.frames = static_cast<Frame *>(::operator new(sizeof(Frame) * item_num, nothrow));
+  if (chunk.frames == nullptr) {
+    LOG_ERROR("failed to allocate frames. item_num=%d, name=%s", item_num, name_.c_str());
+    munmap(chunk.pages, chunk.mapped_size);
+    return -1;
+  }
+
+  for (int i = 0; i < item_num; i++) {
+    auto   page  = reinterpret_cast<Page *>(chunk.pages + static_cast<size_t>(i) * page_size_);
+    Frame *frame = new (chunk.frames + i) Frame(page, page_size_);
+    frees_.push_back(frame);
+  }
+  chunks_.push_back(chunk);
+  size_ += item_num;
+
+  LOG_INFO("frame allocator extended. item_num=%d, mapped_size=%zu, huge_page=%d, name=%s",
+           item_num, chunk.mapped_size, chunk.huge_page, name_.c_str());
+  return 0;
+}
+
+void FrameAllocator::release(Chunk &chunk)
+{
+  for (int i = 0; i < chunk.item_num; i++) {
+    chunk.frames[i].~Frame();
+  }
+  ::operator delete(chunk.frames);
+  munmap(chunk.pages, chunk.mapped_size);
+}
+
+char *FrameAllocator::map_pages(size_t size, size_t &mapped_size, bool &huge_page)
+{
+  huge_page = false;
+
+#ifdef MAP_HUGETLB
+  // 只有预留了大页(vm.nr_hugepages)才能申请成功
+  if (size >= HUGE_PAGE_SIZE) {
+    const size_t huge_size = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    void *addr = mmap(nullptr, huge_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (addr != MAP_FAILED) {
+      mapped_size = huge_size;
+      huge_page   = true;
+      return static_cast<char *>(addr);
+    }
+  }
+#endif
+
+  void *addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (addr == MAP_FAILED) {
+    return nullptr;
+  }
+
+#ifdef MADV_HUGEPAGE
+  if (size >= HUGE_PAGE_SIZE) {
+    (void)madvise(addr, size, MADV_HUGEPAGE);
+  }
+#endif
+
+  mapped_size = size;
+  return static_cast<char *>(addr);
+}
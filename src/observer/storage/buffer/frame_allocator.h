@@ -0,0 +1,95 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include "common/lang/mutex.h"
+#include "common/lang/string.h"
+#include "common/lang/unordered_set.h"
+#include "common/lang/vector.h"
+#include "common/mm/mem_pool.h"
+#include "storage/buffer/frame.h"
+
+/**
+ * @brief 页帧分配器
+ * @ingroup BufferPool
+ * @details 接口与 MemPoolSimple<Frame> 相同，但是页面内存与 Frame 对象分开申请。
+ * 每次扩展时，一次性通过 mmap 申请一整块页面内存，按照页面大小切分给各个页帧，
+ * 所以每个页面都是按照 BP_PAGE_ALIGNMENT 对齐的，可以直接用来做 O_DIRECT 读写。
+ * 申请的内存足够大时，优先使用大页(MAP_HUGETLB)，系统没有预留大页时退化成普通页面，
+ * 并建议内核使用透明大页，减少 TLB 缺失。
+ */
+class FrameAllocator
+{
+public:
+  /**
+   * @param page_size 页帧的页面大小，一个分配器只分配一种大小的页帧
+   */
+  explicit FrameAllocator(const char *tag, int page_size = BP_PAGE_SIZE);
+  ~FrameAllocator();
+
+  /**
+   * @brief 申请内存
+   * @param dynamic           页帧用完之后是否可以继续申请
+   * @param pool_num          初始申请的内存池个数
+   * @param item_num_per_pool 每个内存池的页帧个数
+   * @return 0 表示成功
+   */
+  int init(bool dynamic, int pool_num, int item_num_per_pool = DEFAULT_ITEM_NUM_PER_POOL);
+
+  /**
+   * @brief 释放所有内存，已经分配出去的页帧也会失效
+   */
+  void cleanup();
+
+  Frame *alloc();
+  void   free(Frame *frame);
+
+  /// 已经申请的页帧个数
+  int get_size() const;
+  int get_used_num() const;
+
+  /// 是否有内存块使用了大页(MAP_HUGETLB)
+  bool huge_page() const;
+
+  int page_size() const { return page_size_; }
+
+  string to_string() const;
+
+private:
+  /**
+   * @brief 一次扩展申请的内存
+   */
+  struct Chunk
+  {
+    Frame *frames      = nullptr;
+    char  *pages       = nullptr;
+    int    item_num    = 0;
+    size_t mapped_size = 0;
+    bool   huge_page   = false;
+  };
+
+  int  extend(int item_num);
+  void release(Chunk &chunk);
+
+  static char *map_pages(size_t size, size_t &mapped_size, bool &huge_page);
+
+private:
+  string name_;
+  int    page_size_         = BP_PAGE_SIZE;
+  bool   dynamic_           = false;
+  int    item_num_per_pool_ = DEFAULT_ITEM_NUM_PER_POOL;
+  int    size_              = 0;
+
+  mutable mutex          lock_;
+  vector<Chunk>          chunks_;
+  vector<Frame *>        frees_;
+  unordered_set<Frame *> used_;
+};
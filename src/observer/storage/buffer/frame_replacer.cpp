@@ -0,0 +1,219 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <strings.h>
+
+#include "storage/buffer/frame_replacer.h"
+#include "common/lang/algorithm.h"
+#include "common/lang/string.h"
+#include "common/log/log.h"
+
+RC FrameReplacer::create(const char *name, unique_ptr<FrameReplacer> &replacer)
+{
+  if (name == nullptr || common::is_blank(name)) {
+    name = "lru";
+  }
+
+  if (strcasecmp(name, "lru") == 0) {
+    replacer = make_unique<LruFrameReplacer>();
+  } else if (strcasecmp(name, "clock") == 0) {
+    replacer = make_unique<ClockFrameReplacer>();
+  } else if (strcasecmp(name, "2q") == 0) {
+    replacer = make_unique<TwoQueueFrameReplacer>();
+  } else {
+    LOG_WARN("unknown frame replacer: %s", name);
+    return RC::INVALID_ARGUMENT;
+  }
+  return RC::SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void LruFrameReplacer::on_insert(Frame *frame)
+{
+  frames_.push_front(frame);
+  positions_[frame] = frames_.begin();
+}
+
+void LruFrameReplacer::on_access(Frame *frame)
+{
+  auto iter = positions_.find(frame);
+  if (iter == positions_.end()) {
+    return;
+  }
+
+  frames_.splice(frames_.begin(), frames_, iter->second);
+}
+
+void LruFrameReplacer::on_remove(Frame *frame)
+{
+  auto iter = positions_.find(frame);
+  if (iter == positions_.end()) {
+    return;
+  }
+
+  frames_.erase(iter->second);
+  positions_.erase(iter);
+}
+
+void LruFrameReplacer::foreach_victim(function<bool(Frame *)> func)
+{
+  for (auto iter = frames_.rbegin(); iter != frames_.rend(); ++iter) {
+    if (!func(*iter)) {
+      break;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void ClockFrameReplacer::on_insert(Frame *frame)
+{
+  size_t index = 0;
+  if (!free_slots_.empty()) {
+    index = free_slots_.back();
+    free_slots_.pop_back();
+  } else {
+    index = slots_.size();
+    slots_.emplace_back();
+  }
+
+  slots_[index].frame      = frame;
+  slots_[index].referenced = true;
+  positions_[frame]        = index;
+}
+
+void ClockFrameReplacer::on_access(Frame *frame)
+{
+  auto iter = positions_.find(frame);
+  if (iter != positions_.end()) {
+    slots_[iter->second].referenced = true;
+  }
+}
+
+void ClockFrameReplacer::on_remove(Frame *frame)
+{
+  auto iter = positions_.find(frame);
+  if (iter == positions_.end()) {
+    return;
+  }
+
+  slots_[iter->second] = Slot();
+  free_slots_.push_back(iter->second);
+  positions_.erase(iter);
+}
+
+void ClockFrameReplacer::foreach_victim(function<bool(Frame *)> func)
+{
+  if (slots_.empty()) {
+    return;
+  }
+
+  // 最多转两圈：第一圈可能只是清除了访问标识，第二圈一定能遍历到所有的页帧
+  const size_t max_steps = slots_.size() * 2;
+  for (size_t step = 0; step < max_steps; step++) {
+    Slot &slot = slots_[hand_];
+    hand_      = (hand_ + 1) % slots_.size();
+
+    if (slot.frame == nullptr) {
+      continue;
+    }
+
+    if (slot.referenced) {
+      slot.referenced = false;
+      continue;
+    }
+
+    if (!func(slot.frame)) {
+      break;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void TwoQueueFrameReplacer::on_insert(Frame *frame)
+{
+  auto ghost = a1out_positions_.find(frame->frame_id());
+  if (ghost != a1out_positions_.end()) {
+    // 刚从A1in淘汰不久又被加载，是热点页面
+    a1out_.erase(ghost->second);
+    a1out_positions_.erase(ghost);
+    am_.push_front(frame);
+    positions_[frame] = Position{false, am_.begin()};
+  } else {
+    a1_.push_front(frame);
+    positions_[frame] = Position{true, a1_.begin()};
+  }
+  max_size_ = max(max_size_, positions_.size());
+}
+
+void TwoQueueFrameReplacer::on_access(Frame *frame)
+{
+  auto iter = positions_.find(frame);
+  if (iter == positions_.end()) {
+    return;
+  }
+
+  // A1in 中的页帧再次被访问时保持不动。短时间内的重复访问(比如扫描时反复读取同一个页面)
+  // 不能说明页面是热点，只有从A1out中再次加载的页面才会进入Am
+  Position &position = iter->second;
+  if (!position.in_a1) {
+    am_.splice(am_.begin(), am_, position.iter);
+  }
+}
+
+void TwoQueueFrameReplacer::on_remove(Frame *frame)
+{
+  auto iter = positions_.find(frame);
+  if (iter == positions_.end()) {
+    return;
+  }
+
+  if (iter->second.in_a1) {
+    a1_.erase(iter->second.iter);
+
+    const FrameId frame_id = frame->frame_id();
+    if (frame_id.page_num() >= 0 && a1out_positions_.find(frame_id) == a1out_positions_.end()) {
+      a1out_.push_front(frame_id);
+      a1out_positions_[frame_id] = a1out_.begin();
+
+      const size_t a1out_limit = max<size_t>(max_size_ * a1out_percent_ / 100, 1);
+      while (a1out_.size() > a1out_limit) {
+        a1out_positions_.erase(a1out_.back());
+        a1out_.pop_back();
+      }
+    }
+  } else {
+    am_.erase(iter->second.iter);
+  }
+  positions_.erase(iter);
+}
+
+void TwoQueueFrameReplacer::foreach_victim(function<bool(Frame *)> func)
+{
+  auto visit = [&func](list<Frame *> &frames) {
+    for (auto iter = frames.rbegin(); iter != frames.rend(); ++iter) {
+      if (!func(*iter)) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  // A1 超过配额时优先淘汰A1，否则优先淘汰Am。两个队列都遍历，保证所有页帧都有机会被淘汰
+  const bool a1_first = a1_.size() * 100 > positions_.size() * a1_percent_;
+  if (a1_first) {
+    if (visit(a1_)) {
+      visit(am_);
+    }
+  } else {
+    if (visit(am_)) {
+      visit(a1_);
+    }
+  }
+}
@@ -0,0 +1,176 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include "common/lang/functional.h"
+#include "common/lang/list.h"
+#include "common/lang/memory.h"
+#include "common/lang/unordered_map.h"
+#include "common/lang/vector.h"
+#include "common/sys/rc.h"
+#include "storage/buffer/frame.h"
+
+/**
+ * @brief 页帧淘汰策略
+ * @ingroup BufferPool
+ * @details 页帧管理器在内存不够用时，需要选择一些页帧淘汰出去。FrameReplacer 只负责
+ * 记录页帧的访问情况，并按照淘汰的优先级给出候选页帧，页帧是否可以淘汰(比如是否被pin住)
+ * 由调用者判断。
+ * FrameReplacer 不是线程安全的，需要调用者加锁保护，当前是由页帧管理器的分片锁保护。
+ */
+class FrameReplacer
+{
+public:
+  virtual ~FrameReplacer() = default;
+
+  virtual const char *name() const = 0;
+
+  /**
+   * @brief 有新的页帧放到缓冲池中
+   */
+  virtual void on_insert(Frame *frame) = 0;
+
+  /**
+   * @brief 页帧被访问(命中)
+   */
+  virtual void on_access(Frame *frame) = 0;
+
+  /**
+   * @brief 页帧从缓冲池中删除
+   */
+  virtual void on_remove(Frame *frame) = 0;
+
+  /**
+   * @brief 按照淘汰优先级从高到低遍历页帧
+   * @param func 返回false时停止遍历
+   */
+  virtual void foreach_victim(function<bool(Frame *)> func) = 0;
+
+  virtual size_t size() const = 0;
+
+  /**
+   * @brief 根据名字创建淘汰策略
+   * @details 当前支持 lru(默认)，clock 和 2q
+   */
+  static RC create(const char *name, unique_ptr<FrameReplacer> &replacer);
+};
+
+/**
+ * @brief 最近最少使用淘汰策略
+ * @ingroup BufferPool
+ * @details 每次访问都会把页帧移动到链表头，淘汰时从链表尾部开始。
+ * 一次大的顺序扫描就可能把所有的热点页面淘汰出去。
+ */
+class LruFrameReplacer : public FrameReplacer
+{
+public:
+  const char *name() const override { return "lru"; }
+
+  void on_insert(Frame *frame) override;
+  void on_access(Frame *frame) override;
+  void on_remove(Frame *frame) override;
+  void foreach_victim(function<bool(Frame *)> func) override;
+
+  size_t size() const override { return frames_.size(); }
+
+private:
+  list<Frame *>                                  frames_;  ///< 链表头是最近访问的页帧
+  unordered_map<Frame *, list<Frame *>::iterator> positions_;
+};
+
+/**
+ * @brief CLOCK 淘汰策略
+ * @ingroup BufferPool
+ * @details 所有页帧放在一个环上，每个页帧有一个访问标识。访问页帧时只设置访问标识，不需要
+ * 调整任何链表。淘汰时时钟指针沿着环转动，遇到访问标识为1的页帧，就清除标识给它第二次机会，
+ * 遇到标识为0的页帧就作为淘汰的候选。
+ */
+class ClockFrameReplacer : public FrameReplacer
+{
+public:
+  const char *name() const override { return "clock"; }
+
+  void on_insert(Frame *frame) override;
+  void on_access(Frame *frame) override;
+  void on_remove(Frame *frame) override;
+  void foreach_victim(function<bool(Frame *)> func) override;
+
+  size_t size() const override { return positions_.size(); }
+
+private:
+  struct Slot
+  {
+    Frame *frame      = nullptr;
+    bool   referenced = false;
+  };
+
+  vector<Slot>                   slots_;
+  vector<size_t>                 free_slots_;  ///< 页帧删除后留下的空位，可以复用
+  unordered_map<Frame *, size_t> positions_;
+  size_t                         hand_ = 0;  ///< 时钟指针
+};
+
+/**
+ * @brief 2Q 淘汰策略
+ * @ingroup BufferPool
+ * @details 新加载的页帧先放到一个FIFO队列(A1in)中，在A1in中再次被访问时位置不变。
+ * 当A1in中的页帧个数超过一定比例时，优先淘汰A1in中的页帧，因此全表扫描的页面，即使在扫描时
+ * 被重复访问，也不会把热点页面挤出缓冲池。这是 LRU-K(K=2) 的一种常数时间近似实现。
+ *
+ * 从A1in中淘汰的页面只把页面编号记录在幽灵队列(A1out)中，不占用页帧。页面在A1out中的时候
+ * 再次被加载，说明它在一段时间之后又被访问了，这时才放到LRU链表(Am)中。
+ */
+class TwoQueueFrameReplacer : public FrameReplacer
+{
+public:
+  /**
+   * @param a1_percent A1in 队列最多占用的页帧比例，超过这个比例就优先从A1in中淘汰
+   * @param a1out_percent A1out 最多记录的页面个数，相对于最多的页帧个数的比例
+   */
+  explicit TwoQueueFrameReplacer(int a1_percent = 25, int a1out_percent = 50)
+      : a1_percent_(a1_percent), a1out_percent_(a1out_percent)
+  {}
+
+  const char *name() const override { return "2q"; }
+
+  void on_insert(Frame *frame) override;
+  void on_access(Frame *frame) override;
+  void on_remove(Frame *frame) override;
+  void foreach_victim(function<bool(Frame *)> func) override;
+
+  size_t size() const override { return positions_.size(); }
+
+  /// A1out 中记录的页面个数
+  size_t ghost_size() const { return a1out_.size(); }
+
+private:
+  struct Position
+  {
+    bool                     in_a1;
+    list<Frame *>::iterator iter;
+  };
+
+  class FrameIdHasher
+  {
+  public:
+    size_t operator()(const FrameId &frame_id) const { return frame_id.hash(); }
+  };
+
+  int                              a1_percent_;
+  int                              a1out_percent_;
+  size_t                           max_size_ = 0;  ///< 最多同时管理的页帧个数，用来限制A1out的长度
+  list<Frame *>                    a1_;  ///< 只访问过一次的页帧，链表头是最新加入的
+  list<Frame *>                    am_;  ///< 访问过多次的页帧，链表头是最近访问的
+  unordered_map<Frame *, Position> positions_;
+
+  list<FrameId>                                                  a1out_;  ///< 链表头是最近淘汰的
+  unordered_map<FrameId, list<FrameId>::iterator, FrameIdHasher> a1out_positions_;
+};
@@ -0,0 +1,401 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <errno.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define HAVE_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#include "storage/buffer/io_engine.h"
+#include "common/lang/algorithm.h"
+#include "common/lang/string.h"
+#include "common/log/log.h"
+
+IoRequest IoRequest::read(int fd, void *buf, int size, int64_t offset)
+{
+  IoRequest request;
+  request.type   = Type::READ;
+  request.fd     = fd;
+  request.buf    = buf;
+  request.size   = size;
+  request.offset = offset;
+  return request;
+}
+
+IoRequest IoRequest::write(int fd, const void *buf, int size, int64_t offset)
+{
+  IoRequest request;
+  request.type   = Type::WRITE;
+  request.fd     = fd;
+  request.buf    = const_cast<void *>(buf);
+  request.size   = size;
+  request.offset = offset;
+  return request;
+}
+
+static RC io_error(const IoRequest &request)
+{
+  return request.type == IoRequest::Type::READ ? RC::IOERR_READ : RC::IOERR_WRITE;
+}
+
+static RC first_error(const IoRequest *requests, int count)
+{
+  for (int i = 0; i < count; i++) {
+    if (OB_FAIL(requests[i].rc)) {
+      return requests[i].rc;
+    }
+  }
+  return RC::SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+RC IoEngine::read(int fd, void *buf, int size, int64_t offset)
+{
+  vector<IoRequest> requests{IoRequest::read(fd, buf, size, offset)};
+  return submit(requests);
+}
+
+RC IoEngine::write(int fd, const void *buf, int size, int64_t offset)
+{
+  vector<IoRequest> requests{IoRequest::write(fd, buf, size, offset)};
+  return submit(requests);
+}
+
+RC IoEngine::create(const char *name, unique_ptr<IoEngine> &engine)
+{
+  if (name == nullptr || common::is_blank(name) || strcasecmp(name, "sync") == 0) {
+    engine = make_unique<SyncIoEngine>();
+    return RC::SUCCESS;
+  }
+
+  if (strcasecmp(name, "io_uring") == 0) {
+    auto io_uring_engine = make_unique<IoUringIoEngine>();
+    RC   rc              = io_uring_engine->init();
+    if (OB_FAIL(rc)) {
+      LOG_WARN("io_uring is not available, use sync io engine instead. rc=%s", strrc(rc));
+      engine = make_unique<SyncIoEngine>();
+    } else {
+      engine = std::move(io_uring_engine);
+    }
+    return RC::SUCCESS;
+  }
+
+  LOG_WARN("unknown io engine: %s", name);
+  return RC::INVALID_ARGUMENT;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+RC SyncIoEngine::submit(vector<IoRequest> &requests)
+{
+  for (IoRequest &request : requests) {
+    (void)execute(request);
+  }
+  return first_error(requests.data(), static_cast<int>(requests.size()));
+}
+
+RC SyncIoEngine::execute(IoRequest &request)
+{
+  char   *buf    = static_cast<char *>(request.buf);
+  int64_t offset = request.offset;
+  int     left   = request.size;
+  while (left > 0) {
+    ssize_t ret = request.type == IoRequest::Type::READ ? ::pread(request.fd, buf, left, offset)
+                                                         : ::pwrite(request.fd, buf, left, offset);
+    if (ret < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (ret <= 0) {
+      // 读取时返回0表示读到了文件尾
+      LOG_WARN("failed to %s file. fd=%d, offset=%ld, size=%d, ret=%ld, error=%s",
+               request.type == IoRequest::Type::READ ? "read" : "write",
+               request.fd, offset, left, ret, ret < 0 ? strerror(errno) : "eof");
+      request.rc = io_error(request);
+      return request.rc;
+    }
+
+    buf += ret;
+    offset += ret;
+    left -= ret;
+  }
+
+  request.rc = RC::SUCCESS;
+  return request.rc;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+#ifdef HAVE_IO_URING
+
+struct IoUringIoEngine::Ring
+{
+  int fd = -1;
+
+  void  *sq_ptr    = nullptr;
+  size_t sq_size   = 0;
+  void  *cq_ptr    = nullptr;
+  size_t cq_size   = 0;
+  void  *sqes_ptr  = nullptr;
+  size_t sqes_size = 0;
+
+  unsigned     *sq_head    = nullptr;
+  unsigned     *sq_tail    = nullptr;
+  unsigned     *sq_mask    = nullptr;
+  unsigned     *sq_array   = nullptr;
+  io_uring_sqe *sqes       = nullptr;
+  unsigned      sq_entries = 0;
+
+  unsigned     *cq_head = nullptr;
+  unsigned     *cq_tail = nullptr;
+  unsigned     *cq_mask = nullptr;
+  io_uring_cqe *cqes    = nullptr;
+
+  ~Ring()
+  {
+    if (sqes_ptr != nullptr) {
+      munmap(sqes_ptr, sqes_size);
+    }
+    if (cq_ptr != nullptr && cq_ptr != sq_ptr) {
+      munmap(cq_ptr, cq_size);
+    }
+    if (sq_ptr != nullptr) {
+      munmap(sq_ptr, sq_size);
+    }
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+};
+
+IoUringIoEngine::IoUringIoEngine(int queue_depth /* = 64 */) : queue_depth_(queue_depth) {}
+
+IoUringIoEngine::~IoUringIoEngine() = default;
+
+RC IoUringIoEngine::init()
+{
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+
+  auto ring = make_unique<Ring>();
+  ring->fd  = static_cast<int>(syscall(__NR_io_uring_setup, queue_depth_, &params));
+  if (ring->fd < 0) {
+    LOG_WARN("failed to setup io_uring. queue depth=%d, error=%s", queue_depth_, strerror(errno));
+    return RC::UNSUPPORTED;
+  }
+
+  ring->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  ring->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+  // 新的内核中提交队列和完成队列可以使用一次mmap映射
+  const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    ring->sq_size = ring->cq_size = max(ring->sq_size, ring->cq_size);
+  }
+
+  void *sq_ptr =
+      mmap(nullptr, ring->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+  if (sq_ptr == MAP_FAILED) {
+    LOG_WARN("failed to mmap io_uring submission queue. error=%s", strerror(errno));
+    return RC::UNSUPPORTED;
+  }
+  ring->sq_ptr = sq_ptr;
+
+  if (single_mmap) {
+    ring->cq_ptr = sq_ptr;
+  } else {
+    void *cq_ptr =
+        mmap(nullptr, ring->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+    if (cq_ptr == MAP_FAILED) {
+      LOG_WARN("failed to mmap io_uring completion queue. error=%s", strerror(errno));
+      return RC::UNSUPPORTED;
+    }
+    ring->cq_ptr = cq_ptr;
+  }
+
+  ring->sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+  void *sqes_ptr =
+      mmap(nullptr, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+  if (sqes_ptr == MAP_FAILED) {
+    LOG_WARN("failed to mmap io_uring submission entries. error=%s", strerror(errno));
+    return RC::UNSUPPORTED;
+  }
+  ring->sqes_ptr = sqes_ptr;
+
+  char *sq_base    = static_cast<char *>(ring->sq_ptr);
+  ring->sq_head    = reinterpret_cast<unsigned *>(sq_base + params.sq_off.head);
+  ring->sq_tail    = reinterpret_cast<unsigned *>(sq_base + params.sq_off.tail);
+  ring->sq_mask    = reinterpret_cast<unsigned *>(sq_base + params.sq_off.ring_mask);
+  ring->sq_array   = reinterpret_cast<unsigned *>(sq_base + params.sq_off.array);
+  ring->sqes       = static_cast<io_uring_sqe *>(sqes_ptr);
+  ring->sq_entries = params.sq_entries;
+
+  char *cq_base = static_cast<char *>(ring->cq_ptr);
+  ring->cq_head = reinterpret_cast<unsigned *>(cq_base + params.cq_off.head);
+  ring->cq_tail = reinterpret_cast<unsigned *>(cq_base + params.cq_off.tail);
+  ring->cq_mask = reinterpret_cast<unsigned *>(cq_base + params.cq_off.ring_mask);
+  ring->cqes    = reinterpret_cast<io_uring_cqe *>(cq_base + params.cq_off.cqes);
+
+  ring_ = std::move(ring);
+  LOG_INFO("io_uring io engine init done. sq entries=%u, cq entries=%u", params.sq_entries, params.cq_entries);
+  return RC::SUCCESS;
+}
+
+RC IoUringIoEngine::submit(vector<IoRequest> &requests)
+{
+  if (!ring_) {
+    SyncIoEngine sync_engine;
+    return sync_engine.submit(requests);
+  }
+
+  lock_guard<mutex> guard(lock_);
+
+  const int total      = static_cast<int>(requests.size());
+  const int batch_size = static_cast<int>(ring_->sq_entries);
+  for (int start = 0; start < total; start += batch_size) {
+    (void)submit_batch(requests.data() + start, min(batch_size, total - start));
+  }
+  return first_error(requests.data(), total);
+}
+
+RC IoUringIoEngine::submit_batch(IoRequest *requests, int count)
+{
+  Ring &ring = *ring_;
+
+  // 每一批请求使用不同的序号作为 user_data 的高 32 位，之前批次遗留在完成队列中的结果不会被误认
+  const uint64_t batch_tag = static_cast<uint64_t>(++batch_seq_) << 32;
+
+  unsigned tail = *ring.sq_tail;
+  for (int i = 0; i < count; i++) {
+    IoRequest &request = requests[i];
+
+    const unsigned index = tail & *ring.sq_mask;
+    io_uring_sqe  *sqe   = &ring.sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode    = request.type == IoRequest::Type::READ ? IORING_OP_READ : IORING_OP_WRITE;
+    sqe->fd        = request.fd;
+    sqe->addr      = reinterpret_cast<uint64_t>(request.buf);
+    sqe->len       = static_cast<uint32_t>(request.size);
+    sqe->off       = static_cast<uint64_t>(request.offset);
+    sqe->user_data = batch_tag | static_cast<uint64_t>(i);
+    ring.sq_array[index] = index;
+    tail++;
+  }
+  // 内核看到新的 tail 之前，提交项必须已经填写完成
+  __atomic_store_n(ring.sq_tail, tail, __ATOMIC_RELEASE);
+
+  vector<bool> done(count, false);
+  int          completed = 0;
+
+  // 收割完成队列中已有的结果
+  auto reap = [&]() {
+    unsigned head    = *ring.cq_head;
+    unsigned cq_tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+    while (head != cq_tail) {
+      const io_uring_cqe &cqe = ring.cqes[head & *ring.cq_mask];
+      const uint64_t      tag = cqe.user_data & ~static_cast<uint64_t>(UINT32_MAX);
+      const uint64_t      idx = cqe.user_data & UINT32_MAX;
+      const int           res = cqe.res;
+      head++;
+
+      if (tag != batch_tag || idx >= static_cast<uint64_t>(count) || done[idx]) {
+        LOG_WARN("skip stale io_uring completion. user_data=%lx, res=%d", cqe.user_data, res);
+        continue;
+      }
+
+      IoRequest &request = requests[idx];
+      done[idx]          = true;
+      completed++;
+
+      if (res == request.size) {
+        request.rc = RC::SUCCESS;
+      } else if (res >= 0 || res == -EINVAL || res == -EOPNOTSUPP || res == -EAGAIN) {
+        // 读写不完整，或者内核不支持这个操作，剩下的部分同步完成
+        IoRequest rest = request;
+        if (res > 0) {
+          rest.buf    = static_cast<char *>(request.buf) + res;
+          rest.size   = request.size - res;
+          rest.offset = request.offset + res;
+        }
+        request.rc = SyncIoEngine::execute(rest);
+      } else {
+        LOG_WARN("io_uring request failed. fd=%d, offset=%ld, size=%d, error=%s",
+                 request.fd, request.offset, request.size, strerror(-res));
+        request.rc = io_error(request);
+      }
+    }
+    __atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+  };
+
+  int to_submit = count;
+  while (completed < count) {
+    int ret = static_cast<int>(
+        syscall(__NR_io_uring_enter, ring.fd, to_submit, 1 /*min_complete*/, IORING_ENTER_GETEVENTS, nullptr, 0));
+    if (ret < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      LOG_WARN("failed to enter io_uring. to submit=%d, completed=%d, error=%s", to_submit, completed, strerror(errno));
+      if (to_submit > 0) {
+        // 内核没有取走的请求，从提交队列中撤回，然后同步执行
+        __atomic_store_n(ring.sq_tail, tail - to_submit, __ATOMIC_RELEASE);
+        for (int i = count - to_submit; i < count; i++) {
+          (void)SyncIoEngine::execute(requests[i]);
+          done[i] = true;
+        }
+        completed += to_submit;
+        to_submit = 0;
+        tail      = *ring.sq_tail;
+        continue;
+      }
+
+      // 已经提交给内核的请求无法撤回。先收割已经完成的结果，其余的标记为失败，
+      // 它们之后才到达的完成结果带着本批次的序号，会被后面的批次跳过
+      reap();
+      for (int i = 0; i < count; i++) {
+        if (!done[i]) {
+          requests[i].rc = io_error(requests[i]);
+        }
+      }
+      return first_error(requests, count);
+    }
+
+    to_submit -= ret;
+    reap();
+  }
+  return first_error(requests, count);
+}
+
+#else  // HAVE_IO_URING
+
+struct IoUringIoEngine::Ring
+{};
+
+IoUringIoEngine::IoUringIoEngine(int queue_depth /* = 64 */) : queue_depth_(queue_depth) {}
+
+IoUringIoEngine::~IoUringIoEngine() = default;
+
+RC IoUringIoEngine::init() { return RC::UNSUPPORTED; }
+
+RC IoUringIoEngine::submit(vector<IoRequest> &requests)
+{
+  SyncIoEngine sync_engine;
+  return sync_engine.submit(requests);
+}
+
+RC IoUringIoEngine::submit_batch(IoRequest *requests, int count) { return RC::UNSUPPORTED; }
+
+#endif  // HAVE_IO_URING
@@ -0,0 +1,123 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include "common/lang/memory.h"
+#include "common/lang/mutex.h"
+#include "common/lang/vector.h"
+#include "common/sys/rc.h"
+
+/**
+ * @brief 一次文件读写请求
+ * @ingroup BufferPool
+ */
+struct IoRequest
+{
+  enum class Type
+  {
+    READ,
+    WRITE
+  };
+
+  Type    type   = Type::READ;
+  int     fd     = -1;
+  void   *buf    = nullptr;
+  int     size   = 0;
+  int64_t offset = 0;
+  RC      rc     = RC::SUCCESS;  ///< 请求完成后的结果
+
+  static IoRequest read(int fd, void *buf, int size, int64_t offset);
+  static IoRequest write(int fd, const void *buf, int size, int64_t offset);
+};
+
+/**
+ * @brief 页面读写引擎
+ * @ingroup BufferPool
+ * @details 缓冲池和 double write buffer 都通过这个接口按照偏移量读写文件，不再依赖文件描述符
+ * 当前的读写位置，因此同一个文件的多个读写请求可以并行执行。
+ * 需要读写多个页面时(比如刷新 double write buffer、预读)，可以把请求放在一起批量提交，
+ * 由具体的实现决定如何执行，比如 io_uring 可以一次系统调用提交所有请求并等待它们完成。
+ */
+class IoEngine
+{
+public:
+  virtual ~IoEngine() = default;
+
+  virtual const char *name() const = 0;
+
+  /**
+   * @brief 批量执行读写请求，所有请求都完成后才返回
+   * @details 每个请求的结果记录在 IoRequest::rc 中，请求之间的执行顺序是不确定的
+   * @return 所有请求都成功时返回成功，否则返回第一个失败请求的错误码
+   */
+  virtual RC submit(vector<IoRequest> &requests) = 0;
+
+  RC read(int fd, void *buf, int size, int64_t offset);
+  RC write(int fd, const void *buf, int size, int64_t offset);
+
+  /**
+   * @brief 根据名字创建读写引擎
+   * @details 当前支持 sync(默认) 和 io_uring。如果系统不支持 io_uring，就使用 sync
+   */
+  static RC create(const char *name, unique_ptr<IoEngine> &engine);
+};
+
+/**
+ * @brief 使用 pread/pwrite 同步读写
+ * @ingroup BufferPool
+ */
+class SyncIoEngine : public IoEngine
+{
+public:
+  const char *name() const override { return "sync"; }
+
+  RC submit(vector<IoRequest> &requests) override;
+
+  /**
+   * @brief 同步执行一个请求，会处理读写不完整和被信号中断的情况
+   */
+  static RC execute(IoRequest &request);
+};
+
+/**
+ * @brief 基于 io_uring 的批量读写
+ * @ingroup BufferPool
+ * @details 直接使用 io_uring 的系统调用，不依赖 liburing。一批请求填写到提交队列后，
+ * 只需要一次 io_uring_enter 就可以提交并等待所有请求完成。
+ * 只有一个提交队列，多个线程同时提交时需要排队。
+ * 如果内核返回不完整的读写结果，剩余的部分使用同步的方式完成。
+ */
+class IoUringIoEngine : public IoEngine
+{
+public:
+  /**
+   * @param queue_depth 提交队列的长度，一批请求超过这个长度时会分多次提交
+   */
+  explicit IoUringIoEngine(int queue_depth = 64);
+  ~IoUringIoEngine() override;
+
+  RC init();
+
+  const char *name() const override { return "io_uring"; }
+
+  RC submit(vector<IoRequest> &requests) override;
+
+private:
+  RC submit_batch(IoRequest *requests, int count);
+
+private:
+  struct Ring;
+
+  int              queue_depth_ = 0;
+  unique_ptr<Ring> ring_;
+  mutex            lock_;
+  uint32_t         batch_seq_ = 0;  ///< 批次序号，放在 user_data 的高 32 位，区分不同批次的完成结果
+};
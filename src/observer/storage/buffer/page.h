@@ -23,12 +23,31 @@ static constexpr PageNum BP_INVALID_PAGE_NUM = -1;
 
 static constexpr PageNum BP_HEADER_PAGE = 0;
 
-static constexpr const int BP_PAGE_SIZE      = (1 << 13);
-static constexpr const int BP_PAGE_DATA_SIZE = (BP_PAGE_SIZE - sizeof(LSN) - sizeof(CheckSum));
+/// 默认的页面大小。每个文件可以有自己的页面大小，参考 BPFileHeader::page_size
+static constexpr const int BP_PAGE_SIZE        = (1 << 13);
+static constexpr const int BP_PAGE_HEADER_SIZE = (sizeof(LSN) + sizeof(CheckSum));
+static constexpr const int BP_PAGE_DATA_SIZE   = (BP_PAGE_SIZE - BP_PAGE_HEADER_SIZE);
+
+/// 支持的最大页面大小
+static constexpr const int BP_MAX_PAGE_SIZE = (1 << 16);
+
+/// 页面大小必须是 BP_PAGE_SIZE 到 BP_MAX_PAGE_SIZE 之间的2的幂
+inline bool bp_valid_page_size(int page_size)
+{
+  return page_size >= BP_PAGE_SIZE && page_size <= BP_MAX_PAGE_SIZE && (page_size & (page_size - 1)) == 0;
+}
+
+/// 页面中除去LSN和校验和之后，可以存放数据的大小
+inline int bp_page_data_size(int page_size) { return page_size - BP_PAGE_HEADER_SIZE; }
+
+/// 页面内存的对齐大小，使用 O_DIRECT 读写文件时，内存地址、长度和文件偏移都需要按照它对齐
+static constexpr const int BP_PAGE_ALIGNMENT = 4096;
 
 /**
  * @brief 表示一个页面，可能放在内存或磁盘上
  * @ingroup BufferPool
+ * @details 页面比 BP_PAGE_SIZE 大时，数据会超出 data 的范围，需要按照页面大小申请内存，
+ * 数据的大小以 bp_page_data_size 为准
  */
 struct Page
 {
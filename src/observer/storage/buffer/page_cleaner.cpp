@@ -0,0 +1,206 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "storage/buffer/page_cleaner.h"
+#include "common/lang/algorithm.h"
+#include "common/lang/chrono.h"
+#include "common/lang/sstream.h"
+#include "common/log/log.h"
+#include "common/thread/thread_util.h"
+#include "storage/buffer/disk_buffer_pool.h"
+
+using namespace common;
+
+string PageCleaner::Stat::to_string() const
+{
+  stringstream ss;
+  ss << "rounds:" << rounds << ", flushed pages:" << flushed_pages << ", skipped pages:" << skipped_pages
+     << ", failed pages:" << failed_pages << ", flush rate:" << flush_rate << " pages/s";
+  return ss.str();
+}
+
+PageCleaner::PageCleaner(BufferPoolManager &bp_manager, int clean_percent, int io_capacity)
+    : bp_manager_(bp_manager), clean_percent_(min(max(clean_percent, 0), 100)), io_capacity_(max(io_capacity, 1))
+{}
+
+PageCleaner::~PageCleaner() { stop(); }
+
+RC PageCleaner::start()
+{
+  lock_guard<mutex> guard(lock_);
+  if (running_) {
+    return RC::SUCCESS;
+  }
+
+  running_ = true;
+  thread_  = make_unique<thread>(&PageCleaner::thread_func, this);
+  LOG_INFO("page cleaner started. clean percent=%d, io capacity=%d", clean_percent_, io_capacity_);
+  return RC::SUCCESS;
+}
+
+RC PageCleaner::stop()
+{
+  {
+    lock_guard<mutex> guard(lock_);
+    if (!running_) {
+      return RC::SUCCESS;
+    }
+    running_ = false;
+  }
+
+  cond_.notify_all();
+  thread_->join();
+  thread_.reset();
+  LOG_INFO("page cleaner stopped. %s", stat().to_string().c_str());
+  return RC::SUCCESS;
+}
+
+void PageCleaner::wakeup()
+{
+  {
+    lock_guard<mutex> guard(lock_);
+    wakeup_ = true;
+  }
+  cond_.notify_all();
+}
+
+void PageCleaner::thread_func()
+{
+  thread_set_name("PageCleaner");
+
+  // 每秒更新一次刷新速度
+  auto    rate_start   = chrono::steady_clock::now();
+  int64_t rate_flushed = 0;
+
+  unique_lock<mutex> guard(lock_);
+  while (running_) {
+    cond_.wait_for(guard, chrono::milliseconds(INTERVAL_MS), [this]() { return !running_ || wakeup_; });
+    if (!running_) {
+      break;
+    }
+    wakeup_ = false;
+
+    guard.unlock();
+    rate_flushed += run_once();
+
+    auto    now     = chrono::steady_clock::now();
+    int64_t elapsed = chrono::duration_cast<chrono::milliseconds>(now - rate_start).count();
+    if (elapsed >= 1000) {
+      flush_rate_.store(rate_flushed * 100 * 1000 / elapsed);
+      rate_start   = now;
+      rate_flushed = 0;
+    }
+    guard.lock();
+  }
+}
+
+int PageCleaner::flush_quota(size_t dirty_num) const
+{
+  size_t total_num = 0;
+  for (BPFrameManager *frame_manager : bp_manager_.frame_managers()) {
+    total_num += frame_manager->total_frame_num();
+  }
+  if (dirty_num == 0 || total_num == 0) {
+    return 0;
+  }
+
+  const int    round_capacity = max(io_capacity_ * INTERVAL_MS / 1000, 1);
+  const size_t clean_num      = total_num - min(dirty_num, total_num);
+  if (clean_num * 100 < total_num * clean_percent_) {
+    return round_capacity;
+  }
+
+  // 干净页帧足够，只慢慢地刷新最老的脏页
+  return max(round_capacity / 8, 1);
+}
+
+vector<Frame *> PageCleaner::find_dirty_list()
+{
+  vector<BPFrameManager *> frame_managers = bp_manager_.frame_managers();
+  if (frame_managers.size() == 1) {
+    return frame_managers.front()->find_dirty_list();
+  }
+
+  // 不同页面大小的页帧在不同的页帧管理器中，合并之后仍然按照 recovery lsn 排序。
+  // 页帧的 recovery lsn 可能被并发修改，先记录下来再排序
+  vector<pair<LSN, Frame *>> lsn_frames;
+  for (BPFrameManager *frame_manager : frame_managers) {
+    for (Frame *frame : frame_manager->find_dirty_list()) {
+      lsn_frames.emplace_back(frame->recovery_lsn(), frame);
+    }
+  }
+  sort(lsn_frames.begin(), lsn_frames.end(), [](const pair<LSN, Frame *> &a, const pair<LSN, Frame *> &b) {
+    return a.first < b.first;
+  });
+
+  vector<Frame *> dirty_frames;
+  dirty_frames.reserve(lsn_frames.size());
+  for (auto &[lsn, frame] : lsn_frames) {
+    dirty_frames.push_back(frame);
+  }
+  return dirty_frames;
+}
+
+int PageCleaner::run_once()
+{
+  lock_guard<mutex> flush_guard(flush_lock_);
+
+  vector<Frame *> dirty_frames = find_dirty_list();
+  const int       quota        = flush_quota(dirty_frames.size());
+
+  int flushed = 0;
+  for (Frame *frame : dirty_frames) {
+    if (flushed >= quota) {
+      frame->unpin();
+      continue;
+    }
+
+    // 不等待正在修改页面的线程，下一轮再刷新
+    if (!frame->try_read_latch()) {
+      skipped_pages_++;
+      frame->unpin();
+      continue;
+    }
+
+    DiskBufferPool *buffer_pool = nullptr;
+    RC              rc          = bp_manager_.get_buffer_pool(frame->buffer_pool_id(), buffer_pool);
+    if (OB_SUCC(rc) && frame->dirty()) {
+      rc = buffer_pool->flush_page(*frame);
+    }
+    if (OB_FAIL(rc)) {
+      failed_pages_++;
+      LOG_WARN("page cleaner failed to flush page. frame=%s, rc=%s", frame->to_string().c_str(), strrc(rc));
+    } else {
+      flushed++;
+    }
+
+    frame->read_unlatch();
+    frame->unpin();
+  }
+
+  rounds_++;
+  flushed_pages_ += flushed;
+  if (flushed > 0) {
+    LOG_TRACE("page cleaner flushed pages. dirty=%d, quota=%d, flushed=%d",
+              static_cast<int>(dirty_frames.size()), quota, flushed);
+  }
+  return flushed;
+}
+
+PageCleaner::Stat PageCleaner::stat() const
+{
+  Stat stat;
+  stat.rounds        = rounds_.load();
+  stat.flushed_pages = flushed_pages_.load();
+  stat.skipped_pages = skipped_pages_.load();
+  stat.failed_pages  = failed_pages_.load();
+  stat.flush_rate    = flush_rate_.load() / 100.0;
+  return stat;
+}
@@ -0,0 +1,120 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include "common/lang/atomic.h"
+#include "common/lang/condition_variable.h"
+#include "common/lang/memory.h"
+#include "common/lang/mutex.h"
+#include "common/lang/string.h"
+#include "common/lang/thread.h"
+#include "common/lang/vector.h"
+#include "common/sys/rc.h"
+
+class BufferPoolManager;
+class Frame;
+
+/**
+ * @brief 后台刷脏页
+ * @ingroup BufferPool
+ * @details 缓冲池中的脏页原本只在淘汰页帧时或者 Db::sync 时才会刷盘，这样前台请求在淘汰页面时
+ * 就需要等待写盘。页面清理线程周期性地收集所有脏页，按照 recovery lsn 从小到大的顺序刷新
+ * (先刷最老的脏页，这样检查点也可以尽快推进)，页面通过 DoubleWriteBuffer 写入磁盘。
+ *
+ * 刷新的速度由 io_capacity 控制：干净页帧(包括空闲页帧)的比例低于 clean_percent 时，
+ * 每秒最多刷新 io_capacity 个页面；否则只以很低的速度刷新最老的脏页。
+ *
+ * 正在被修改的页面(拿不到读锁)会跳过，等下一轮再刷新。没有开启 CONCURRENCY 时页帧的latch不会
+ * 真正加锁，因此 Db 只在开启 CONCURRENCY 时启动页面清理线程。
+ */
+class PageCleaner
+{
+public:
+  /// 每一轮之间的间隔
+  static constexpr int INTERVAL_MS = 100;
+
+  /**
+   * @brief 刷新统计
+   */
+  struct Stat
+  {
+    int64_t rounds        = 0;  ///< 执行了多少轮
+    int64_t flushed_pages = 0;  ///< 一共刷新了多少个页面
+    int64_t skipped_pages = 0;  ///< 因为正在被修改而跳过的页面
+    int64_t failed_pages  = 0;
+    double  flush_rate    = 0;  ///< 最近一段时间每秒刷新的页面个数
+
+    string to_string() const;
+  };
+
+public:
+  /**
+   * @param clean_percent 希望保持的干净页帧比例，取值 [0, 100]
+   * @param io_capacity 每秒最多刷新的页面个数
+   */
+  PageCleaner(BufferPoolManager &bp_manager, int clean_percent, int io_capacity);
+  ~PageCleaner();
+
+  RC start();
+  RC stop();
+
+  /**
+   * @brief 执行一轮刷新
+   * @details 通常由后台线程调用，测试时也可以直接调用
+   * @return 本轮刷新的页面个数
+   */
+  int run_once();
+
+  /**
+   * @brief 唤醒后台线程，立即执行一轮刷新
+   */
+  void wakeup();
+
+  Stat stat() const;
+
+  /**
+   * @brief 每一轮刷新都会持有这把锁
+   * @details 刷新时会pin住脏页，关闭文件之前需要加这把锁，等待当前一轮刷新结束，
+   * 否则文件的页帧可能无法释放
+   */
+  mutex &flush_lock() { return flush_lock_; }
+
+private:
+  void thread_func();
+
+  /**
+   * @brief 当前一轮最多刷新多少个页面
+   */
+  int flush_quota(size_t dirty_num) const;
+
+  /**
+   * @brief 所有页帧管理器中的脏页，按照 recovery lsn 排序，参考 BPFrameManager::find_dirty_list
+   */
+  vector<Frame *> find_dirty_list();
+
+private:
+  BufferPoolManager &bp_manager_;
+  const int          clean_percent_;
+  const int          io_capacity_;
+
+  mutex              flush_lock_;
+  mutex              lock_;
+  condition_variable cond_;
+  bool               running_ = false;
+  bool               wakeup_  = false;
+  unique_ptr<thread> thread_;
+
+  atomic<int64_t> rounds_{0};
+  atomic<int64_t> flushed_pages_{0};
+  atomic<int64_t> skipped_pages_{0};
+  atomic<int64_t> failed_pages_{0};
+  atomic<int64_t> flush_rate_{0};  ///< 每秒刷新页面个数乘以100，保留两位小数
+};
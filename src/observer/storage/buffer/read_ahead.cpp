@@ -0,0 +1,44 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "storage/buffer/read_ahead.h"
+#include "common/lang/algorithm.h"
+
+bool ReadAheadDetector::on_access(PageNum page_num, PageNum &start, int &count)
+{
+  if (window_ <= 0) {
+    return false;
+  }
+
+  lock_guard<mutex> guard(lock_);
+
+  const bool sequential = page_num > last_page_num_ && page_num - last_page_num_ <= MAX_PAGE_GAP;
+  last_page_num_        = page_num;
+  if (!sequential) {
+    sequential_count_ = 0;
+    read_ahead_end_   = -1;
+    return false;
+  }
+
+  sequential_count_++;
+  if (sequential_count_ < SEQUENTIAL_THRESHOLD) {
+    return false;
+  }
+
+  // 还没有访问到预读区域的一半，不需要再预读
+  if (read_ahead_end_ - page_num > window_ / 2) {
+    return false;
+  }
+
+  start           = max(read_ahead_end_, page_num + 1);
+  count           = page_num + 1 + window_ - start;
+  read_ahead_end_ = start + count;
+  return count > 0;
+}
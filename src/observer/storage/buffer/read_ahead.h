@@ -0,0 +1,52 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include "common/lang/mutex.h"
+#include "common/types.h"
+
+/**
+ * @brief 顺序访问检测
+ * @ingroup BufferPool
+ * @details 记录一个文件最近访问的页面，如果连续几次访问的页面号是递增的(允许中间有少量空洞，
+ * 比如被释放的页面)，就认为当前是顺序访问，需要把后面的页面预先读取到缓冲池中。
+ * 每次预读一个窗口大小的页面，当访问到已经预读区域的一半时，再预读下一个窗口，这样在后台线程
+ * 读取磁盘的同时，前台线程可以继续处理已经加载好的页面。
+ */
+class ReadAheadDetector
+{
+public:
+  /// 连续访问多少次之后开始预读
+  static constexpr int SEQUENTIAL_THRESHOLD = 2;
+  /// 两次访问的页面号之差不超过这个值，都认为是顺序访问
+  static constexpr int MAX_PAGE_GAP = 2;
+
+  explicit ReadAheadDetector(int window) : window_(window) {}
+
+  int window() const { return window_; }
+
+  /**
+   * @brief 记录一次页面访问
+   * @param page_num 访问的页面
+   * @param[out] start 如果需要预读，返回预读的第一个页面
+   * @param[out] count 如果需要预读，返回预读的页面个数
+   * @return 是否需要预读
+   */
+  bool on_access(PageNum page_num, PageNum &start, int &count);
+
+private:
+  int window_ = 0;
+
+  mutex   lock_;
+  PageNum last_page_num_    = -1;
+  int     sequential_count_ = 0;
+  PageNum read_ahead_end_   = -1;  ///< 已经预读到的位置(不包含)
+};
@@ -14,6 +14,7 @@ See the Mulan PSL v2 for more details. */
 
 #include "common/thread/thread_util.h"
 #include "storage/clog/disk_log_handler.h"
+#include "storage/clog/log_codec.h"
 #include "storage/clog/log_file.h"
 #include "storage/clog/log_replayer.h"
 #include "common/lang/chrono.h"
@@ -25,8 +26,19 @@ using namespace common;
 
 RC DiskLogHandler::init(const char *path)
 {
-  const int max_entry_number_per_file = 1000;
-  return file_manager_.init(path, max_entry_number_per_file);
+  return init(path, DEFAULT_MAX_FILE_SIZE, DEFAULT_MAX_RECYCLED_FILES, "none");
+}
+
+RC DiskLogHandler::init(const char *path, int64_t max_file_size, int max_recycled_files, const char *codec_name)
+{
+  const LogCodec *codec = nullptr;
+  RC              rc    = LogCodec::find(codec_name, codec);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("invalid log codec. codec=%s, rc=%s", codec_name, strrc(rc));
+    return rc;
+  }
+
+  return file_manager_.init(path, max_file_size, max_recycled_files, codec);
 }
 
 RC DiskLogHandler::start()
@@ -49,7 +61,12 @@ RC DiskLogHandler::stop()
     return RC::INTERNAL;
   }
 
-  running_.store(false);
+  {
+    lock_guard<mutex> guard(lock_);
+    running_.store(false);
+  }
+  flush_cond_.notify_all();
+  flushed_cond_.notify_all();
 
   LOG_INFO("log handler stopped");
   return RC::SUCCESS;
@@ -108,7 +125,13 @@ RC DiskLogHandler::iterate(function<RC(LogEntry&)> consumer, LSN start_lsn)
     return rc;
   }
 
-  for (auto &file : log_files) {
+  // 只有最后一个文件允许有写了一半的日志。前面的文件中出现损坏的日志，或者文件之间的LSN接不上，
+  // 说明有日志丢失了，不能当作日志的结尾继续恢复
+  LSN last_lsn = 0;
+  for (size_t i = 0; i < log_files.size(); i++) {
+    const string &file      = log_files[i];
+    const bool    last_file = (i + 1 == log_files.size());
+
     LogFileReader file_handle;
     rc = file_handle.open(file.c_str());
     if (OB_FAIL(rc)) {
@@ -116,12 +139,24 @@ RC DiskLogHandler::iterate(function<RC(LogEntry&)> consumer, LSN start_lsn)
       return rc;
     }
 
-    rc = file_handle.iterate(consumer, start_lsn);
+    rc = file_handle.iterate(consumer, start_lsn, last_lsn);
     if (OB_FAIL(rc)) {
       LOG_WARN("failed to iterate clog file. rc=%s, file=%s", strrc(rc), file.c_str());
       return rc;
     }
 
+    if (!last_file && file_handle.corrupted()) {
+      LOG_ERROR("found corrupted log batch in clog file which is not the last one. file=%s, last lsn=%ld",
+                file.c_str(), file_handle.last_lsn());
+      return RC::IOERR_READ;
+    }
+
+    if (!last_file && last_lsn != 0 && file_handle.last_lsn() == last_lsn) {
+      LOG_ERROR("clog file does not start with the next lsn. file=%s, expected lsn=%ld", file.c_str(), last_lsn + 1);
+      return RC::IOERR_READ;
+    }
+    last_lsn = file_handle.last_lsn();
+
     rc = file_handle.close();
     if (OB_FAIL(rc)) {
       LOG_WARN("failed to close clog file. rc=%s, file=%s", strrc(rc), file.c_str());
@@ -134,26 +169,36 @@ RC DiskLogHandler::iterate(function<RC(LogEntry&)> consumer, LSN start_lsn)
 }
 
 RC DiskLogHandler::_append(LSN &lsn, LogModule module, vector<char> &&data)
+{
+  return _append(lsn, module, span<const char>(data));
+}
+
+RC DiskLogHandler::_append(LSN &lsn, LogModule module, span<const char> data)
 {
   ASSERT(running_.load(), "log handler is not running. lsn=%ld, module=%s, size=%d", 
         lsn, module.name(), data.size());
 
-  RC rc = entry_buffer_.append(lsn, module, std::move(data));
+  RC rc = entry_buffer_.append(lsn, module, data);
   if (OB_FAIL(rc)) {
     LOG_WARN("failed to append log entry to buffer. rc=%s", strrc(rc));
     return rc;
   }
 
+  // 这里不加锁，刷新线程可能错过这次通知，等待刷盘的线程会在 wait_lsn 中再次唤醒它
+  flush_cond_.notify_one();
   return RC::SUCCESS;
 }
 
 RC DiskLogHandler::wait_lsn(LSN lsn)
 {
-  // 直接强制等待。在生产系统中，我们可能会使用条件变量来等待。
-  while (running_.load() && current_flushed_lsn() < lsn) {
-    this_thread::sleep_for(chrono::milliseconds(100));
+  if (current_flushed_lsn() >= lsn) {
+    return RC::SUCCESS;
   }
 
+  unique_lock<mutex> guard(lock_);
+  flush_cond_.notify_one();
+  flushed_cond_.wait(guard, [this, lsn]() { return !running_.load() || current_flushed_lsn() >= lsn; });
+
   if (current_flushed_lsn() >= lsn) {
     return RC::SUCCESS;
   } else {
@@ -161,12 +206,21 @@ RC DiskLogHandler::wait_lsn(LSN lsn)
   }
 }
 
+RC DiskLogHandler::purge(LSN lsn)
+{
+  RC rc = file_manager_.purge_files(lsn);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to purge clog files. lsn=%ld, rc=%s", lsn, strrc(rc));
+  }
+  return rc;
+}
+
 void DiskLogHandler::thread_func()
 {
   /*
-  这个线程一直不停的循环，检查日志缓冲区中是否有日志在内存中，如果在内存中就刷新到磁盘。
-  这种做法很粗暴简单，与生产数据库的做法不同。生产数据库通常会在内存达到一定量，或者一定时间
-  之后，会刷新一下磁盘。这样做的好处是减少磁盘的IO次数，提高性能。
+  这个线程在没有日志时等待在条件变量上，有日志写入或者有线程等待日志刷盘时被唤醒。
+  每次把缓冲区中的所有日志一起写入文件，只刷一次盘，再唤醒所有等待的线程。
+  刷盘的过程中，其它线程写入的日志会在下一轮一起刷盘，这样并发提交的事务越多，每次刷盘的日志就越多。
   */
   thread_set_name("LogHandler");
   LOG_INFO("log handler thread started");
@@ -177,8 +231,8 @@ void DiskLogHandler::thread_func()
   while (running_.load() || entry_buffer_.entry_number() > 0) {
     if (!file_writer.valid() || rc == RC::LOG_FILE_FULL) {
       if (rc == RC::LOG_FILE_FULL) {
-        // 我们在这里判断日志文件是否写满了。
-        rc = file_manager_.next_file(file_writer);
+        // 我们在这里判断日志文件是否写满了。新文件从下一条还没有刷盘的日志开始
+        rc = file_manager_.next_file(file_writer, entry_buffer_.flushed_lsn() + 1);
       } else {
         rc = file_manager_.last_file(file_writer);
       }
@@ -198,11 +252,23 @@ void DiskLogHandler::thread_func()
       LOG_WARN("failed to flush log entry buffer. rc=%s", strrc(rc));
     }
 
+    unique_lock<mutex> guard(lock_);
+    if (flush_count > 0) {
+      flushed_cond_.notify_all();
+    }
+
     if (flush_count == 0 && rc == RC::SUCCESS) {
-      this_thread::sleep_for(chrono::milliseconds(100));
-      continue;
+      // 超时只是为了防止错过 _append 中的通知
+      flush_cond_.wait_for(guard, chrono::milliseconds(100), [this]() {
+        return !running_.load() || entry_buffer_.flushable();
+      });
     }
   }
 
+  // 剩下的线程等不到日志刷盘了
+  {
+    lock_guard<mutex> guard(lock_);
+    flushed_cond_.notify_all();
+  }
   LOG_INFO("log handler thread stopped");
 }
@@ -19,6 +19,8 @@ See the Mulan PSL v2 for more details. */
 #include "common/lang/vector.h"
 #include "common/lang/deque.h"
 #include "common/lang/memory.h"
+#include "common/lang/mutex.h"
+#include "common/lang/condition_variable.h"
 #include "common/lang/thread.h"
 #include "storage/clog/log_module.h"
 #include "storage/clog/log_file.h"
@@ -31,8 +33,11 @@ class LogReplayer;
  * @brief 对外提供服务的CLog模块
  * @ingroup CLog
  * @details 该模块负责日志的写入、读取、回放等功能。
- * 会在后台开启一个线程，一直尝试刷新内存中的日志到磁盘。
- * 所有的CLog日志文件都存放在指定的目录下，每个日志文件按照日志条数来划分。
+ * 会在后台开启一个线程，刷新内存中的日志到磁盘。
+ * 提交事务时会调用 wait_lsn 唤醒刷新线程，并在条件变量上等待。刷新线程每次把缓冲区中所有的日志
+ * 一起写入文件并只刷一次盘，然后唤醒所有等待的线程，这样同时提交的多个事务只需要一次磁盘IO(group commit)。
+ * 所有的CLog日志文件都存放在指定的目录下，每个日志文件按照字节数来划分，文件是预先分配好空间的，
+ * 不再需要的日志文件会回收复用，参考 LogFileManager。
  * 调用的顺序应该是：
  * @code {.cpp}
  * DiskLogHandler handler;
@@ -47,6 +52,10 @@ class LogReplayer;
  */
 class DiskLogHandler : public LogHandler
 {
+public:
+  static constexpr int64_t DEFAULT_MAX_FILE_SIZE      = 16 * 1024 * 1024;  ///< 默认每个日志文件16M
+  static constexpr int     DEFAULT_MAX_RECYCLED_FILES = 4;                 ///< 默认最多保留的回收文件个数
+
 public:
   DiskLogHandler()          = default;
   virtual ~DiskLogHandler() = default;
@@ -58,6 +67,16 @@ public:
    */
   RC init(const char *path) override;
 
+  /**
+   * @brief 初始化日志模块
+   *
+   * @param path 日志文件存放的目录
+   * @param max_file_size 每个日志文件的大小
+   * @param max_recycled_files 最多保留多少个回收的日志文件
+   * @param codec_name 写日志时使用的压缩算法，参考 LogCodec
+   */
+  RC init(const char *path, int64_t max_file_size, int max_recycled_files, const char *codec_name);
+
   /**
    * @brief 启动线程刷新日志到磁盘
    */
@@ -92,7 +111,7 @@ public:
 
   /**
    * @brief 等待指定的日志刷盘
-   *
+   * @details 会唤醒刷新线程，然后在条件变量上等待，直到日志刷盘或者日志模块停止
    * @param lsn 想要等待的日志
    */
   RC wait_lsn(LSN lsn) override;
@@ -102,6 +121,12 @@ public:
   /// @brief 当前刷新到哪个日志
   LSN current_flushed_lsn() const { return entry_buffer_.flushed_lsn(); }
 
+  /**
+   * @brief 回收检查点之前的日志文件
+   * @details 以文件为单位回收，检查点所在的日志文件会保留下来
+   */
+  RC purge(LSN lsn) override;
+
 private:
   /**
    * @brief 在缓存中增加一条日志
@@ -112,6 +137,11 @@ private:
    */
   RC _append(LSN &lsn, LogModule module, vector<char> &&data) override;
 
+  /**
+   * @brief 直接把日志数据拷贝到缓冲区，不需要先构造一个 vector
+   */
+  RC _append(LSN &lsn, LogModule module, span<const char> data) override;
+
 private:
   /**
    * @brief 刷新日志的线程函数
@@ -122,6 +152,10 @@ private:
   unique_ptr<thread> thread_;          /// 刷新日志的线程
   atomic_bool        running_{false};  /// 是否还要继续运行
 
+  mutex              lock_;           /// 保护下面的条件变量
+  condition_variable flush_cond_;     /// 有日志需要刷新时唤醒刷新线程
+  condition_variable flushed_cond_;   /// 一批日志刷盘之后唤醒等待的线程
+
   LogFileManager file_manager_;  /// 管理所有的日志文件
   LogEntryBuffer entry_buffer_;  /// 缓存日志
 
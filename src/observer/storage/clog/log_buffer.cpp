@@ -14,18 +14,42 @@ See the Mulan PSL v2 for more details. */
 
 #include "storage/clog/log_buffer.h"
 #include "storage/clog/log_file.h"
+#include "common/lang/algorithm.h"
 #include "common/lang/chrono.h"
+#include "common/lang/thread.h"
+#include "common/log/log.h"
 
 using namespace common;
 
+/// 每个槽位对应的平均日志大小。槽位用完的时候，即使缓冲区还有空间也需要等待刷新
+static constexpr int64_t BYTES_PER_SLOT = 64;
+
 RC LogEntryBuffer::init(LSN lsn, int32_t max_bytes /*= 0*/)
 {
-  current_lsn_.store(lsn);
-  flushed_lsn_.store(lsn);
-
   if (max_bytes > 0) {
     max_bytes_ = max_bytes;
   }
+
+  // 至少可以放下两条最大的日志，这样任何一条日志都可以放进缓冲区
+  const uint64_t min_capacity = max(static_cast<uint64_t>(max_bytes_), 2 * static_cast<uint64_t>(LogEntry::max_size()));
+  capacity_ = 1;
+  pos_bits_ = 1;
+  while (capacity_ < min_capacity) {
+    capacity_ <<= 1;
+    pos_bits_++;
+  }
+  pos_mask_ = (static_cast<uint64_t>(1) << pos_bits_) - 1;
+  buffer_   = make_unique<char[]>(capacity_);
+
+  slot_num_ = static_cast<int64_t>(capacity_ / BYTES_PER_SLOT);
+  slots_    = make_unique<atomic<int32_t>[]>(slot_num_);
+  for (int64_t i = 0; i < slot_num_; i++) {
+    slots_[i].store(0);
+  }
+
+  reserved_.store(static_cast<uint64_t>(lsn) << pos_bits_);
+  flushed_pos_.store(0);
+  flushed_lsn_.store(lsn);
   return RC::SUCCESS;
 }
 
@@ -36,71 +60,154 @@ RC LogEntryBuffer::append(LSN &lsn, LogModule::Id module_id, vector<char> &&data
 
 RC LogEntryBuffer::append(LSN &lsn, LogModule module, vector<char> &&data)
 {
-  /// 控制当前buffer使用的内存
-  /// 简单粗暴，强制原地等待
-  /// 但是如果当前想要新插入的日志比较大，不会做控制。所以理论上容纳的最大buffer内存是2*max_bytes_
-  while (bytes_.load() >= max_bytes_) {
-    this_thread::sleep_for(chrono::milliseconds(10));
+  return append(lsn, module, span<const char>(data));
+}
+
+RC LogEntryBuffer::append(LSN &lsn, LogModule module, span<const char> data)
+{
+  if (!buffer_) {
+    LOG_WARN("log entry buffer is not initialized");
+    return RC::INTERNAL;
   }
 
-  LogEntry entry;
-  RC rc = entry.init(lsn, module, std::move(data));
-  if (OB_FAIL(rc)) {
-    LOG_WARN("failed to init log entry. rc=%s", strrc(rc));
-    return rc;
+  if (static_cast<int32_t>(data.size()) > LogEntry::max_payload_size()) {
+    LOG_DEBUG("log entry size is too large. size=%d, max_payload_size=%d", data.size(), LogEntry::max_payload_size());
+    return RC::INVALID_ARGUMENT;
   }
 
-  lock_guard guard(mutex_);
-  lsn = ++current_lsn_;
-  entry.set_lsn(lsn);
+  LogHeader header;
+  header.size      = static_cast<int32_t>(data.size());
+  header.module_id = module.index();
+
+  const int32_t total_size = LogHeader::SIZE + header.size;
+  uint64_t      pos        = 0;
+  reserve(total_size, lsn, pos);
 
-  entries_.push_back(std::move(entry));
-  bytes_ += entry.total_size();
+  header.lsn = lsn;
+  copy_in(pos, reinterpret_cast<const char *>(&header), LogHeader::SIZE);
+  copy_in(pos + LogHeader::SIZE, data.data(), header.size);
+
+  // 刷新线程看到槽位上的大小之后，就可以读取这条日志了
+  slots_[lsn % slot_num_].store(total_size, std::memory_order_release);
   return RC::SUCCESS;
 }
 
+void LogEntryBuffer::reserve(int32_t size, LSN &lsn, uint64_t &pos)
+{
+  uint64_t reserved = reserved_.load();
+  while (true) {
+    const LSN      last_lsn = unpack_lsn(reserved);
+    const uint64_t last_pos = unpack_pos(reserved);
+
+    // 刷新只会释放更多的空间，所以这里读到旧的值只会让判断更保守
+    const uint64_t used_bytes = (last_pos - flushed_pos_.load()) & pos_mask_;
+    if (used_bytes + size > capacity_ || last_lsn + 1 - flushed_lsn_.load() > slot_num_) {
+      /// 简单粗暴，强制原地等待
+      this_thread::sleep_for(chrono::microseconds(100));
+      reserved = reserved_.load();
+      continue;
+    }
+
+    const uint64_t new_reserved =
+        (static_cast<uint64_t>(last_lsn + 1) << pos_bits_) | ((last_pos + size) & pos_mask_);
+    if (reserved_.compare_exchange_weak(reserved, new_reserved)) {
+      lsn = last_lsn + 1;
+      pos = last_pos;
+      return;
+    }
+  }
+}
+
+void LogEntryBuffer::copy_in(uint64_t pos, const char *data, int32_t size)
+{
+  const uint64_t offset = pos & (capacity_ - 1);
+  const uint64_t first  = min(static_cast<uint64_t>(size), capacity_ - offset);
+  memcpy(buffer_.get() + offset, data, first);
+  if (first < static_cast<uint64_t>(size)) {
+    memcpy(buffer_.get(), data + first, size - first);
+  }
+}
+
+void LogEntryBuffer::copy_out(uint64_t pos, char *data, int32_t size) const
+{
+  const uint64_t offset = pos & (capacity_ - 1);
+  const uint64_t first  = min(static_cast<uint64_t>(size), capacity_ - offset);
+  memcpy(data, buffer_.get() + offset, first);
+  if (first < static_cast<uint64_t>(size)) {
+    memcpy(data + first, buffer_.get(), size - first);
+  }
+}
+
 RC LogEntryBuffer::flush(LogFileWriter &writer, int &count)
 {
   count = 0;
+  if (!buffer_) {
+    return RC::SUCCESS;
+  }
 
-  while (entry_number() > 0) {
-    LogEntry entry;
-    {
-      lock_guard guard(mutex_);
-      if (entries_.empty()) {
-        break;
-      }
-
-      LogEntry &front_entry = entries_.front();
-      ASSERT(front_entry.lsn() > 0 && front_entry.payload_size() > 0, "invalid log entry");
-      entry = std::move(entries_.front());
-      ASSERT(entry.payload_size() > 0 && entry.lsn() > 0, "invalid log entry");
-      entries_.pop_front();
-      bytes_ -= entry.total_size();
+  // 找出从上次刷新的位置开始，连续的已经写完的日志
+  const LSN      first_lsn = flushed_lsn_.load() + 1;
+  const uint64_t first_pos = flushed_pos_.load();
+  LSN            lsn       = first_lsn;
+  uint64_t       pos       = first_pos;
+  int64_t        bytes     = 0;
+  bool           file_full = false;
+  // 最多 slot_num_ 条，再往后就是本轮还没有清理的槽位了
+  while (lsn - first_lsn < slot_num_) {
+    const int32_t size = slots_[lsn % slot_num_].load(std::memory_order_acquire);
+    if (size == 0) {
+      break;
     }
-    
-    RC rc = writer.write(entry);
-    if (OB_FAIL(rc)) {
-      lock_guard guard(mutex_);
-      entries_.emplace_front(std::move(entry));
-      LogEntry &front_entry = entries_.front();
-      ASSERT(front_entry.lsn() > 0 && front_entry.payload_size() > 0, "invalid log entry");
-      return rc;
-    } else {
-      ++count;
-      flushed_lsn_ = entry.lsn();
+    // 空文件至少要写入一条日志，否则一条比文件还大的日志永远也写不进去
+    if (bytes + size > writer.remain() && !(lsn == first_lsn && writer.empty())) {
+      file_full = true;
+      break;
     }
+    bytes += size;
+    lsn++;
+    pos = (pos + size) & pos_mask_;
   }
-  
-  return RC::SUCCESS;
+
+  if (lsn == first_lsn) {
+    return file_full ? RC::LOG_FILE_FULL : RC::SUCCESS;
+  }
+
+  // 缓冲区回绕的时候需要分两段写
+  vector<struct iovec> iovs;
+  const uint64_t       start_offset = first_pos & (capacity_ - 1);
+  const uint64_t       first_bytes  = min(static_cast<uint64_t>(bytes), capacity_ - start_offset);
+  iovs.push_back({buffer_.get() + start_offset, first_bytes});
+  if (first_bytes < static_cast<uint64_t>(bytes)) {
+    iovs.push_back({buffer_.get(), bytes - first_bytes});
+  }
+
+  RC rc = writer.write(span<struct iovec>(iovs), first_lsn, lsn - 1);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  // 先清理槽位再更新刷新位置，写日志的线程看到新的刷新位置之后才会复用这些槽位
+  for (LSN i = first_lsn; i < lsn; i++) {
+    slots_[i % slot_num_].store(0, std::memory_order_relaxed);
+  }
+  flushed_pos_.store(pos);
+  flushed_lsn_.store(lsn - 1);
+
+  count = static_cast<int>(lsn - first_lsn);
+  return file_full ? RC::LOG_FILE_FULL : RC::SUCCESS;
 }
 
 int64_t LogEntryBuffer::bytes() const
 {
-  return bytes_.load();
+  return static_cast<int64_t>((unpack_pos(reserved_.load()) - flushed_pos_.load()) & pos_mask_);
 }
 
 int32_t LogEntryBuffer::entry_number() const
 {
-  return entries_.size();
+  return static_cast<int32_t>(current_lsn() - flushed_lsn());
+}
+
+bool LogEntryBuffer::flushable() const
+{
+  return buffer_ && slots_[(flushed_lsn_.load() + 1) % slot_num_].load(std::memory_order_acquire) != 0;
 }
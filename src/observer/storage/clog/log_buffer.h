@@ -16,10 +16,10 @@ See the Mulan PSL v2 for more details. */
 
 #include "common/sys/rc.h"
 #include "common/types.h"
-#include "common/lang/mutex.h"
-#include "common/lang/vector.h"
-#include "common/lang/deque.h"
 #include "common/lang/atomic.h"
+#include "common/lang/memory.h"
+#include "common/lang/span.h"
+#include "common/lang/vector.h"
 #include "storage/clog/log_module.h"
 #include "storage/clog/log_entry.h"
 
@@ -29,15 +29,28 @@ class LogFileWriter;
  * @brief 日志数据缓冲区
  * @ingroup CLog
  * @details 缓存一部分日志在内存中而不是直接写入磁盘。
- * 这里的缓存没有考虑高性能操作，比如使用预分配内存、环形缓冲池等。
- * 在生产数据库中，通常会使用预分配内存形式的缓存来提高性能，并且可以减少内存碎片。
+ * 缓冲区是一块连续的环形内存，日志按照与文件中相同的格式(日志头+数据)依次存放。
+ * 写日志时不需要加锁：
+ * - 使用一次CAS同时预留LSN和缓冲区中的空间，LSN的顺序与日志在缓冲区中的顺序一致；
+ * - 把日志直接拷贝到预留的位置，不需要再为每条日志申请内存；
+ * - 拷贝完成后在LSN对应的槽位上记录日志大小，表示这条日志已经写完。
+ * 刷新日志时，从上次刷新的位置开始，找出连续的已经写完的日志，一次写入文件。
+ * 缓冲区满了的时候，写日志的线程需要等待日志刷新。
+ * 同一时刻只能有一个线程刷新日志。
  */
 class LogEntryBuffer
 {
 public:
-  LogEntryBuffer()  = default;
+  /// 不调用 init 也可以直接使用，LSN 从1开始
+  LogEntryBuffer() { (void)init(0); }
   ~LogEntryBuffer() = default;
 
+  /**
+   * @brief 初始化
+   * @details 可以重复调用，会丢弃缓冲区中还没有刷新的日志
+   * @param lsn 当前最大的LSN，新的日志从 lsn+1 开始
+   * @param max_bytes 缓冲区大小，会向上取整到2的幂，并且至少能够放下两条最大的日志
+   */
   RC init(LSN lsn, int32_t max_bytes = 0);
 
   /**
@@ -45,10 +58,11 @@ public:
    */
   RC append(LSN &lsn, LogModule::Id module_id, vector<char> &&data);
   RC append(LSN &lsn, LogModule module, vector<char> &&data);
+  RC append(LSN &lsn, LogModule module, span<const char> data);
 
   /**
    * @brief 刷新缓冲区中的日志到磁盘
-   *
+   * @details 把所有连续的已经写完的日志一起写入文件，如果文件写满了，只写入文件能够容纳的部分
    * @param file_handle 使用它来写文件
    * @param count 刷了多少条日志
    */
@@ -56,24 +70,58 @@ public:
 
   /**
    * @brief 当前缓冲区中有多少字节的日志
+   * @details 包括已经预留空间但还没有写完的日志
    */
   int64_t bytes() const;
 
   /**
    * @brief 当前缓冲区中有多少条日志
+   * @details 包括已经预留空间但还没有写完的日志
    */
   int32_t entry_number() const;
 
-  LSN current_lsn() const { return current_lsn_.load(); }
+  /**
+   * @brief 下一条要刷新的日志是否已经写完
+   */
+  bool flushable() const;
+
+  LSN current_lsn() const { return unpack_lsn(reserved_.load()); }
   LSN flushed_lsn() const { return flushed_lsn_.load(); }
 
 private:
-  mutex           mutex_;  /// 当前数据结构一定会在多线程中访问，所以强制使用有效的锁，而不是有条件生效的common::Mutex
-  deque<LogEntry> entries_;  /// 日志缓冲区
-  atomic<int64_t> bytes_;    /// 当前缓冲区中的日志数据大小
+  /**
+   * @brief 预留一条日志的LSN和空间
+   * @details 缓冲区没有足够的空间或者槽位时，会等待日志刷新
+   * @param size 日志总大小，包括日志头
+   * @param[out] lsn 预留的LSN
+   * @param[out] pos 日志在缓冲区中的位置
+   */
+  void reserve(int32_t size, LSN &lsn, uint64_t &pos);
+
+  /// @brief 从pos开始拷贝数据到缓冲区，处理环形缓冲区回绕的情况
+  void copy_in(uint64_t pos, const char *data, int32_t size);
+  void copy_out(uint64_t pos, char *data, int32_t size) const;
+
+  LSN      unpack_lsn(uint64_t reserved) const { return static_cast<LSN>(reserved >> pos_bits_); }
+  uint64_t unpack_pos(uint64_t reserved) const { return reserved & pos_mask_; }
+
+private:
+  unique_ptr<char[]> buffer_;        /// 环形缓冲区
+  uint64_t           capacity_ = 0;  /// 缓冲区大小，2的幂
+
+  /// 缓冲区中的位置对 2*capacity_ 取模，这样可以区分缓冲区满和空的情况
+  int      pos_bits_ = 0;
+  uint64_t pos_mask_ = 0;
+
+  /// 高位是最后预留的LSN，低 pos_bits_ 位是下一条日志在缓冲区中的位置
+  atomic<uint64_t> reserved_{0};
+
+  /// 每条日志写完之后，在 lsn % slot_num_ 的槽位上记录日志大小，刷新之后清零
+  unique_ptr<atomic<int32_t>[]> slots_;
+  int64_t                       slot_num_ = 0;
 
-  atomic<LSN> current_lsn_{0};
-  atomic<LSN> flushed_lsn_{0};
+  atomic<uint64_t> flushed_pos_{0};  /// 已经刷新的位置，与 reserved_ 中的位置取模方式相同
+  atomic<LSN>      flushed_lsn_{0};
 
   int32_t max_bytes_ = 4 * 1024 * 1024;  /// 缓冲区最大字节数
 };
@@ -0,0 +1,108 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <string.h>
+#include <strings.h>
+
+#include "storage/clog/log_codec.h"
+#include "common/compress/lz4.h"
+#include "common/lang/string.h"
+#include "common/log/log.h"
+
+using namespace common;
+
+/**
+ * @brief 不压缩，原样复制
+ */
+class NoneLogCodec : public LogCodec
+{
+public:
+  Type        type() const override { return Type::NONE; }
+  const char *name() const override { return "none"; }
+
+  RC compress(const char *data, int32_t size, vector<char> &output) const override
+  {
+    output.assign(data, data + size);
+    return RC::SUCCESS;
+  }
+
+  RC decompress(const char *data, int32_t size, int32_t raw_size, vector<char> &output) const override
+  {
+    if (size != raw_size) {
+      return RC::INVALID_ARGUMENT;
+    }
+    output.assign(data, data + size);
+    return RC::SUCCESS;
+  }
+};
+
+/**
+ * @brief 使用 LZ4 block 格式压缩
+ * @details 压缩和解压的速度都很快，适合写日志这种对延迟敏感的场景
+ */
+class Lz4LogCodec : public LogCodec
+{
+public:
+  Type        type() const override { return Type::LZ4; }
+  const char *name() const override { return "lz4"; }
+
+  RC compress(const char *data, int32_t size, vector<char> &output) const override
+  {
+    output.resize(Lz4::compress_bound(size));
+    int ret = Lz4::compress(data, size, output.data(), static_cast<int>(output.size()));
+    if (ret <= 0) {
+      LOG_WARN("failed to compress data with lz4. size=%d", size);
+      return RC::INTERNAL;
+    }
+    output.resize(ret);
+    return RC::SUCCESS;
+  }
+
+  RC decompress(const char *data, int32_t size, int32_t raw_size, vector<char> &output) const override
+  {
+    output.resize(raw_size);
+    int ret = Lz4::decompress(data, size, output.data(), raw_size);
+    if (ret != raw_size) {
+      LOG_WARN("failed to decompress data with lz4. size=%d, raw size=%d, ret=%d", size, raw_size, ret);
+      return RC::INVALID_ARGUMENT;
+    }
+    return RC::SUCCESS;
+  }
+};
+
+const LogCodec *LogCodec::get(Type type)
+{
+  static const NoneLogCodec none_codec;
+  static const Lz4LogCodec  lz4_codec;
+
+  switch (type) {
+    case Type::NONE: return &none_codec;
+    case Type::LZ4: return &lz4_codec;
+    default: return nullptr;
+  }
+}
+
+RC LogCodec::find(const char *name, const LogCodec *&codec)
+{
+  if (name == nullptr || is_blank(name)) {
+    name = "none";
+  }
+
+  for (Type type : {Type::NONE, Type::LZ4}) {
+    const LogCodec *candidate = get(type);
+    if (strcasecmp(name, candidate->name()) == 0) {
+      codec = candidate;
+      return RC::SUCCESS;
+    }
+  }
+
+  LOG_WARN("unknown log codec. name=%s", name);
+  return RC::INVALID_ARGUMENT;
+}
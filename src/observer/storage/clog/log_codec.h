@@ -0,0 +1,64 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include "common/sys/rc.h"
+#include "common/types.h"
+#include "common/lang/vector.h"
+
+/**
+ * @brief 日志压缩算法
+ * @ingroup CLog
+ * @details 日志文件按批写入，每批日志可以使用一种压缩算法压缩，批次头中记录了使用的算法，
+ * 所以读取日志时不依赖当前的配置。增加新的算法时，需要在 Type 中分配一个新的编号，并在 get 中返回。
+ */
+class LogCodec
+{
+public:
+  /// 压缩算法编号，会写到日志文件中，不能修改已有的值
+  enum class Type : int32_t
+  {
+    NONE = 0,  ///< 不压缩
+    LZ4  = 1,
+  };
+
+public:
+  virtual ~LogCodec() = default;
+
+  virtual Type        type() const = 0;
+  virtual const char *name() const = 0;
+
+  /**
+   * @brief 压缩数据
+   * @param[out] output 压缩之后的数据
+   */
+  virtual RC compress(const char *data, int32_t size, vector<char> &output) const = 0;
+
+  /**
+   * @brief 解压数据
+   * @param raw_size 压缩前的数据大小
+   * @param[out] output 解压之后的数据
+   */
+  virtual RC decompress(const char *data, int32_t size, int32_t raw_size, vector<char> &output) const = 0;
+
+public:
+  /**
+   * @brief 根据编号获取压缩算法
+   * @return 不认识的编号返回 nullptr
+   */
+  static const LogCodec *get(Type type);
+
+  /**
+   * @brief 根据名字获取压缩算法
+   * @details 名字不区分大小写，空字符串当作 none
+   */
+  static RC find(const char *name, const LogCodec *&codec);
+};
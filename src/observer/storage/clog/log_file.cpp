@@ -13,16 +13,33 @@ See the Mulan PSL v2 for more details. */
 //
 
 #include <fcntl.h>
+#include <limits.h>
+#include <sys/stat.h>
 
+#include "common/lang/algorithm.h"
 #include "common/lang/string_view.h"
 #include "common/lang/charconv.h"
+#include "common/lang/limits.h"
 #include "common/log/log.h"
 #include "storage/clog/log_file.h"
 #include "storage/clog/log_entry.h"
+#include "storage/clog/log_codec.h"
 #include "common/io/io.h"
+#include "common/math/crc.h"
 
 using namespace common;
 
+uint32_t LogBatchHeader::calc_crc(const struct iovec *data, int iovcnt) const
+{
+  uint32_t value = ::crc32c(0, reinterpret_cast<const char *>(this), offsetof(LogBatchHeader, crc));
+  for (int i = 0; i < iovcnt; i++) {
+    value = ::crc32c(value, static_cast<const char *>(data[i].iov_base), data[i].iov_len);
+  }
+  return value;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// LogFileReader
 RC LogFileReader::open(const char *filename)
 {
   filename_ = filename;
@@ -33,6 +50,15 @@ RC LogFileReader::open(const char *filename)
     return RC::FILE_OPEN;
   }
 
+  struct stat st;
+  if (0 != fstat(fd_, &st)) {
+    LOG_WARN("stat file failed. filename=%s, error=%s", filename, strerror(errno));
+    ::close(fd_);
+    fd_ = -1;
+    return RC::IOERR_ACCESS;
+  }
+  file_size_ = st.st_size;
+
   LOG_INFO("open file success. filename=%s, fd=%d", filename, fd_);
   return RC::SUCCESS;
 }
@@ -48,97 +74,177 @@ RC LogFileReader::close()
   return RC::SUCCESS;
 }
 
-RC LogFileReader::iterate(function<RC(LogEntry &)> callback, LSN start_lsn /*=0*/)
+RC LogFileReader::iterate(function<RC(LogEntry &)> callback, LSN start_lsn /*=0*/, LSN prev_lsn /*=0*/)
 {
-  RC rc = skip_to(start_lsn);
-  if (OB_FAIL(rc)) {
-    return rc;
+  if (fd_ < 0) {
+    return RC::FILE_NOT_OPENED;
   }
 
-  LogHeader header;
-  while (true) {
-    int ret = readn(fd_, reinterpret_cast<char *>(&header), LogHeader::SIZE);
-    if (0 != ret) {
-      if (-1 == ret) {
-        // EOF
-        break;
-      }
-      LOG_WARN("read file failed. filename=%s, ret = %d, error=%s", filename_.c_str(), ret, strerror(errno));
-      return RC::IOERR_READ;
-    }
+  offset_    = 0;
+  last_lsn_  = prev_lsn;
+  corrupted_ = false;
 
-    if (header.size < 0 || header.size > LogEntry::max_payload_size()) {
-      LOG_WARN("invalid log entry size. filename=%s, size=%d", filename_.c_str(), header.size);
-      return RC::IOERR_READ;
-    }
+  RC             rc = RC::SUCCESS;
+  LogBatchHeader header;
+  vector<char>   data;
+  while (OB_SUCC(rc = read_batch(header, data))) {
+    offset_ += LogBatchHeader::SIZE + header.data_size;
+    last_lsn_ = header.last_lsn;
 
-    vector<char> data(header.size);
-    ret = readn(fd_, data.data(), header.size);
-    if (0 != ret) {
-      LOG_WARN("read file failed. filename=%s, size=%d, ret=%d, error=%s", filename_.c_str(), header.size, ret, strerror(errno));
-      return RC::IOERR_READ;
+    // 整批日志都在 start_lsn 之前，就不需要解压了
+    if (header.last_lsn < start_lsn) {
+      continue;
     }
 
-    LogEntry entry;
-    entry.init(header.lsn, LogModule(header.module_id), std::move(data));
-    rc = callback(entry);
+    rc = iterate_batch(header, data, callback, start_lsn);
     if (OB_FAIL(rc)) {
-      LOG_INFO("iterate log entry failed. entry=%s, rc=%s", entry.to_string().c_str(), strrc(rc));
       return rc;
     }
-    LOG_TRACE("redo log iterate entry success. entry=%s", entry.to_string().c_str());
   }
 
-  return RC::SUCCESS;
+  return rc == RC::RECORD_EOF ? RC::SUCCESS : rc;
 }
 
-RC LogFileReader::skip_to(LSN start_lsn)
+RC LogFileReader::find_end(int64_t &end_offset, LSN &last_lsn)
 {
   if (fd_ < 0) {
     return RC::FILE_NOT_OPENED;
   }
 
-  off_t pos = lseek(fd_, 0, SEEK_SET);
-  if (off_t(-1) == pos) {
-    LOG_WARN("seek file failed. seek to the beginning. filename=%s, error=%s", filename_.c_str(), strerror(errno));
+  offset_    = 0;
+  last_lsn_  = 0;
+  corrupted_ = false;
+
+  RC             rc = RC::SUCCESS;
+  LogBatchHeader header;
+  vector<char>   data;
+  while (OB_SUCC(rc = read_batch(header, data))) {
+    offset_ += LogBatchHeader::SIZE + header.data_size;
+    last_lsn_ = header.last_lsn;
+  }
+
+  if (rc != RC::RECORD_EOF) {
+    return rc;
+  }
+
+  end_offset = offset_;
+  last_lsn   = last_lsn_;
+  return RC::SUCCESS;
+}
+
+RC LogFileReader::read_batch(LogBatchHeader &header, vector<char> &data)
+{
+  if (offset_ + LogBatchHeader::SIZE > file_size_) {
+    return RC::RECORD_EOF;
+  }
+
+  if (off_t(-1) == lseek(fd_, offset_, SEEK_SET)) {
+    LOG_WARN("seek file failed. filename=%s, offset=%ld, error=%s", filename_.c_str(), offset_, strerror(errno));
     return RC::IOERR_SEEK;
   }
 
-  LogHeader header;
-  while (true) {
-    int ret = readn(fd_, reinterpret_cast<char *>(&header), LogHeader::SIZE);
-    if (0 != ret) {
-      if (-1 == ret) {
-        // EOF
-        break;
-      }
-      LOG_WARN("read file failed. filename=%s, ret = %d, error=%s", filename_.c_str(), ret, strerror(errno));
+  int ret = readn(fd_, reinterpret_cast<char *>(&header), LogBatchHeader::SIZE);
+  if (-1 == ret) {
+    return RC::RECORD_EOF;
+  }
+  if (0 != ret) {
+    LOG_WARN("read file failed. filename=%s, ret = %d, error=%s", filename_.c_str(), ret, strerror(errno));
+    return RC::IOERR_READ;
+  }
+
+  // 预分配的空间是0，回收的文件中是旧的日志，它们的LSN都接不上前面的日志
+  if (header.first_lsn <= 0 || header.last_lsn < header.first_lsn ||
+      (last_lsn_ != 0 && header.first_lsn != last_lsn_ + 1)) {
+    LOG_TRACE("reach the end of log file. filename=%s, offset=%ld, last lsn=%ld, next lsn=%ld",
+              filename_.c_str(), offset_, last_lsn_, header.first_lsn);
+    return RC::RECORD_EOF;
+  }
+
+  if (header.data_size <= 0 || header.raw_size <= 0 ||
+      offset_ + LogBatchHeader::SIZE + header.data_size > file_size_) {
+    LOG_WARN("incomplete log batch at the end of file. filename=%s, offset=%ld, first lsn=%ld, size=%d",
+             filename_.c_str(), offset_, header.first_lsn, header.data_size);
+    corrupted_ = true;
+    return RC::RECORD_EOF;
+  }
+
+  data.resize(header.data_size);
+  ret = readn(fd_, data.data(), header.data_size);
+  if (0 != ret) {
+    LOG_WARN("read file failed. filename=%s, size=%d, ret=%d, error=%s", 
+             filename_.c_str(), header.data_size, ret, strerror(errno));
+    return RC::IOERR_READ;
+  }
+
+  struct iovec iov = {data.data(), data.size()};
+  if (header.calc_crc(&iov, 1) != header.crc) {
+    LOG_WARN("log batch checksum mismatch, treat it as the end of log. filename=%s, offset=%ld, first lsn=%ld, last lsn=%ld",
+             filename_.c_str(), offset_, header.first_lsn, header.last_lsn);
+    corrupted_ = true;
+    return RC::RECORD_EOF;
+  }
+  return RC::SUCCESS;
+}
+
+RC LogFileReader::iterate_batch(
+    const LogBatchHeader &header, vector<char> &data, function<RC(LogEntry &)> &callback, LSN start_lsn)
+{
+  // 校验码已经通过了，下面再出错就是写入的数据本身有问题
+  const LogCodec *codec = LogCodec::get(static_cast<LogCodec::Type>(header.codec));
+  if (codec == nullptr) {
+    LOG_WARN("unknown log codec. filename=%s, first lsn=%ld, codec=%d", filename_.c_str(), header.first_lsn, header.codec);
+    return RC::IOERR_READ;
+  }
+
+  vector<char> raw_data;
+  if (codec->type() != LogCodec::Type::NONE) {
+    RC rc = codec->decompress(data.data(), header.data_size, header.raw_size, raw_data);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to decompress log batch. filename=%s, first lsn=%ld, rc=%s", 
+               filename_.c_str(), header.first_lsn, strrc(rc));
       return RC::IOERR_READ;
     }
+  } else {
+    raw_data.swap(data);
+  }
 
-    if (header.lsn >= start_lsn) {
-      off_t pos = lseek(fd_, -LogHeader::SIZE, SEEK_CUR);
-      if (off_t(-1) == pos) {
-        LOG_WARN("seek file failed. skip back log header. filename=%s, error=%s", filename_.c_str(), strerror(errno));
-        return RC::IOERR_SEEK;
-      }
+  int32_t pos = 0;
+  LSN     lsn = header.first_lsn;
+  for (; pos < header.raw_size; lsn++) {
+    LogHeader entry_header;
+    if (pos + LogHeader::SIZE > header.raw_size) {
+      break;
+    }
+    memcpy(&entry_header, raw_data.data() + pos, LogHeader::SIZE);
+    if (entry_header.lsn != lsn || entry_header.size < 0 || entry_header.size > LogEntry::max_payload_size() ||
+        pos + LogHeader::SIZE + entry_header.size > header.raw_size) {
       break;
     }
 
-    if (header.size < 0 || header.size > LogEntry::max_payload_size()) {
-      LOG_WARN("invalid log entry size. filename=%s, size=%d", filename_.c_str(), header.size);
-      return RC::IOERR_READ;
+    const char *payload = raw_data.data() + pos + LogHeader::SIZE;
+    pos += LogHeader::SIZE + entry_header.size;
+    if (lsn < start_lsn) {
+      continue;
     }
 
-    pos = lseek(fd_, header.size, SEEK_CUR);
-    if (off_t(-1) == pos) {
-      LOG_WARN("seek file failed. skip log entry payload. filename=%s, error=%s", filename_.c_str(), strerror(errno));
-      return RC::IOERR_SEEK;
+    LogEntry entry;
+    entry.init(entry_header.lsn, LogModule(entry_header.module_id), vector<char>(payload, payload + entry_header.size));
+    RC rc = callback(entry);
+    if (OB_FAIL(rc)) {
+      LOG_INFO("iterate log entry failed. entry=%s, rc=%s", entry.to_string().c_str(), strrc(rc));
+      return rc;
     }
+    LOG_TRACE("redo log iterate entry success. entry=%s", entry.to_string().c_str());
   }
 
+  if (pos != header.raw_size || lsn != header.last_lsn + 1) {
+    LOG_WARN("invalid log batch. filename=%s, first lsn=%ld, last lsn=%ld, raw size=%d, pos=%d, lsn=%ld",
+             filename_.c_str(), header.first_lsn, header.last_lsn, header.raw_size, pos, lsn);
+    return RC::IOERR_READ;
+  }
   return RC::SUCCESS;
 }
+
 ////////////////////////////////////////////////////////////////////////////////
 // LogFileWriter
 LogFileWriter::~LogFileWriter()
@@ -146,22 +252,51 @@ LogFileWriter::~LogFileWriter()
   (void)this->close();
 }
 
-RC LogFileWriter::open(const char *filename, int end_lsn)
+RC LogFileWriter::open(const char *filename, int64_t max_file_size, const LogCodec *codec /*=nullptr*/)
 {
   if (fd_ >= 0) {
     return RC::FILE_OPEN;
   }
 
-  filename_ = filename;
-  end_lsn_ = end_lsn;
+  filename_      = filename;
+  max_file_size_ = max_file_size;
+  codec_         = codec;
 
-  fd_ = ::open(filename, O_WRONLY | O_APPEND | O_CREAT | O_SYNC, 0644);
+  // 不使用 O_SYNC，每批日志写完之后统一调用 fdatasync
+  // 也不使用 O_APPEND，文件是预先分配好的，日志写在有效日志的后面
+  fd_ = ::open(filename, O_WRONLY | O_CREAT, 0644);
   if (fd_ < 0) {
     LOG_WARN("open file failed. filename=%s, error=%s", filename, strerror(errno));
     return RC::FILE_OPEN;
   }
 
-  LOG_INFO("open file success. filename=%s, fd=%d", filename, fd_);
+  LogFileReader reader;
+  RC            rc = reader.open(filename);
+  if (OB_SUCC(rc)) {
+    rc = reader.find_end(offset_, last_lsn_);
+    (void)reader.close();
+  }
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to find the end of log file. filename=%s, rc=%s", filename, strrc(rc));
+    (void)close();
+    return rc;
+  }
+
+  struct stat st;
+  if (0 == fstat(fd_, &st) && st.st_size < max_file_size_) {
+    // 分配失败也没有关系，写日志时文件会自动扩展
+    // 不支持 fallocate 时只扩大文件，没有写过的部分读出来是全0，与预分配的效果一样
+    int ret = -1;
+#ifdef __linux__
+    ret = fallocate(fd_, 0 /*mode*/, 0, max_file_size_);
+#endif
+    if (ret != 0 && 0 != ftruncate(fd_, max_file_size_)) {
+      LOG_WARN("failed to preallocate log file. filename=%s, size=%ld, error=%s",
+               filename, max_file_size_, strerror(errno));
+    }
+  }
+
+  LOG_INFO("open file success. filename=%s, fd=%d, offset=%ld, last lsn=%ld", filename, fd_, offset_, last_lsn_);
   return RC::SUCCESS;
 }
 
@@ -178,39 +313,150 @@ RC LogFileWriter::close()
 
 RC LogFileWriter::write(LogEntry &entry)
 {
-  // 一个日志文件写的日志条数是有限制的
-  if (entry.lsn() > end_lsn_) {
-    return RC::LOG_FILE_FULL;
+  int count = 0;
+  return write(span<LogEntry>(&entry, 1), count);
+}
+
+/**
+ * @brief 在 offset 处写入所有的数据，处理 pwritev 只写入了一部分的情况
+ */
+static int pwritevn(int fd, struct iovec *iov, int iovcnt, int64_t offset)
+{
+  while (iovcnt > 0) {
+    ssize_t ret = ::pwritev(fd, iov, min(iovcnt, IOV_MAX), offset);
+    if (ret < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return errno;
+    }
+
+    offset += ret;
+    // 跳过已经写完的部分
+    while (iovcnt > 0 && ret >= static_cast<ssize_t>(iov->iov_len)) {
+      ret -= iov->iov_len;
+      iov++;
+      iovcnt--;
+    }
+    if (ret > 0) {
+      iov->iov_base = static_cast<char *>(iov->iov_base) + ret;
+      iov->iov_len -= ret;
+    }
+  }
+  return 0;
+}
+
+RC LogFileWriter::write(span<LogEntry> entries, int &count)
+{
+  count = 0;
+  if (fd_ < 0) {
+    return RC::FILE_NOT_OPENED;
+  }
+
+  // 只写入文件中放得下的日志
+  size_t               write_num = 0;
+  int64_t              bytes     = 0;
+  vector<struct iovec> iovs;
+  iovs.reserve(entries.size() * 2);
+  for (LogEntry &entry : entries) {
+    if (bytes + entry.total_size() > remain() && !(empty() && write_num == 0)) {
+      break;
+    }
+
+    iovs.push_back({const_cast<LogHeader *>(&entry.header()), static_cast<size_t>(LogHeader::SIZE)});
+    iovs.push_back({const_cast<char *>(entry.data()), static_cast<size_t>(entry.payload_size())});
+    bytes += entry.total_size();
+    write_num++;
+  }
+
+  if (write_num == 0) {
+    return entries.empty() ? RC::SUCCESS : RC::LOG_FILE_FULL;
+  }
+
+  RC rc = write(span<struct iovec>(iovs), entries.front().lsn(), entries[write_num - 1].lsn());
+  if (OB_FAIL(rc)) {
+    return rc;
   }
 
+  count = static_cast<int>(write_num);
+  return write_num < entries.size() ? RC::LOG_FILE_FULL : RC::SUCCESS;
+}
+
+RC LogFileWriter::write(span<struct iovec> data, LSN first_lsn, LSN last_lsn)
+{
   if (fd_ < 0) {
     return RC::FILE_NOT_OPENED;
   }
 
-  if (entry.lsn() <= last_lsn_) {
-    LOG_WARN("write log entry failed. lsn is too small. filename=%s, last_lsn=%ld, entry=%s", 
-             filename_.c_str(), last_lsn_, entry.to_string().c_str());
+  // 日志必须是连续的，否则读取时会认为日志已经结束了
+  if (first_lsn > last_lsn || first_lsn <= 0 || (last_lsn_ != 0 && first_lsn != last_lsn_ + 1)) {
+    LOG_WARN("write log entries failed. lsn is not continuous. filename=%s, last_lsn=%ld, first_lsn=%ld",
+             filename_.c_str(), last_lsn_, first_lsn);
     return RC::INVALID_ARGUMENT;
   }
 
-  /// WARNING 这里需要处理日志写一半的情况
-  /// 日志只写成功一部分到文件中非常难处理
-  int ret = writen(fd_, reinterpret_cast<const char *>(&entry.header()), LogHeader::SIZE);
-  if (0 != ret) {
-    LOG_WARN("write log entry header failed. filename=%s, ret = %d, error=%s, entry=%s", 
-             filename_.c_str(), ret, strerror(errno), entry.to_string().c_str());
-    return RC::IOERR_WRITE;
+  int64_t bytes = 0;
+  for (const struct iovec &iov : data) {
+    bytes += iov.iov_len;
   }
+  if (bytes > remain() && !empty()) {
+    return RC::LOG_FILE_FULL;
+  }
+  if (bytes > numeric_limits<int32_t>::max()) {
+    LOG_WARN("too many log entries in one batch. filename=%s, size=%ld", filename_.c_str(), bytes);
+    return RC::INVALID_ARGUMENT;
+  }
+
+  LogBatchHeader header;
+  header.first_lsn = first_lsn;
+  header.last_lsn  = last_lsn;
+  header.raw_size  = static_cast<int32_t>(bytes);
+  header.data_size = header.raw_size;
+  header.codec     = static_cast<int32_t>(LogCodec::Type::NONE);
+
+  vector<struct iovec> iovs;
+  iovs.reserve(data.size() + 1);
+  iovs.push_back({&header, static_cast<size_t>(LogBatchHeader::SIZE)});
+  if (codec_ != nullptr && codec_->type() != LogCodec::Type::NONE) {
+    // 压缩需要连续的内存，先把日志复制出来
+    raw_buffer_.resize(bytes);
+    char *dst = raw_buffer_.data();
+    for (const struct iovec &iov : data) {
+      memcpy(dst, iov.iov_base, iov.iov_len);
+      dst += iov.iov_len;
+    }
 
-  ret = writen(fd_, entry.data(), entry.payload_size());
+    // 压缩之后没有变小就不压缩了，读取时可以少解压一次
+    RC rc = codec_->compress(raw_buffer_.data(), header.raw_size, compressed_buffer_);
+    if (OB_SUCC(rc) && static_cast<int64_t>(compressed_buffer_.size()) < bytes) {
+      header.data_size = static_cast<int32_t>(compressed_buffer_.size());
+      header.codec     = static_cast<int32_t>(codec_->type());
+      iovs.push_back({compressed_buffer_.data(), compressed_buffer_.size()});
+    } else {
+      iovs.push_back({raw_buffer_.data(), raw_buffer_.size()});
+    }
+  } else {
+    iovs.insert(iovs.end(), data.begin(), data.end());
+  }
+  header.crc = header.calc_crc(iovs.data() + 1, static_cast<int>(iovs.size() - 1));
+
+  // 日志写了一半时，读取日志会发现校验码不对，把这批日志当作不存在
+  int ret = pwritevn(fd_, iovs.data(), static_cast<int>(iovs.size()), offset_);
   if (0 != ret) {
-    LOG_WARN("write log entry payload failed. filename=%s, ret = %d, error=%s, entry=%s", 
-             filename_.c_str(), ret, strerror(errno), entry.to_string().c_str());
+    LOG_WARN("write log entries failed. filename=%s, ret = %d, error=%s, first_lsn=%ld, last_lsn=%ld", 
+             filename_.c_str(), ret, strerror(ret), first_lsn, last_lsn);
     return RC::IOERR_WRITE;
   }
 
-  last_lsn_ = entry.lsn();
-  LOG_TRACE("write log entry success. filename=%s, entry=%s", filename_.c_str(), entry.to_string().c_str());
+  if (0 != ::fdatasync(fd_)) {
+    LOG_WARN("sync log file failed. filename=%s, error=%s", filename_.c_str(), strerror(errno));
+    return RC::IOERR_SYNC;
+  }
+
+  offset_ += LogBatchHeader::SIZE + header.data_size;
+  last_lsn_ = last_lsn;
+  LOG_TRACE("write log entries success. filename=%s, first lsn=%ld, last lsn=%ld", 
+            filename_.c_str(), first_lsn, last_lsn);
   return RC::SUCCESS;
 }
 
@@ -221,7 +467,7 @@ bool LogFileWriter::valid() const
 
 bool LogFileWriter::full() const
 {
-  return last_lsn_ >= end_lsn_;
+  return offset_ >= max_file_size_;
 }
 
 string LogFileWriter::to_string() const
@@ -232,10 +478,16 @@ string LogFileWriter::to_string() const
 ////////////////////////////////////////////////////////////////////////////////
 // LogFileManager
 
-RC LogFileManager::init(const char *directory, int max_entry_number_per_file)
+RC LogFileManager::init(
+    const char *directory, int64_t max_file_size, int max_recycled_files, const LogCodec *codec /*=nullptr*/)
 {
-  directory_ = filesystem::absolute(filesystem::path(directory));
-  max_entry_number_per_file_ = max_entry_number_per_file;
+  directory_          = filesystem::absolute(filesystem::path(directory));
+  max_file_size_      = max_file_size;
+  max_recycled_files_ = max_recycled_files;
+  codec_              = codec;
+
+  log_files_.clear();
+  recycled_files_.clear();
 
   // 检查目录是否存在，不存在就创建出来
   if (!filesystem::is_directory(directory_)) {
@@ -249,13 +501,19 @@ RC LogFileManager::init(const char *directory, int max_entry_number_per_file)
     }
   }
 
-  // 列出所有的日志文件
+  // 列出所有的日志文件和回收的文件
+  // 这里不删除多余的回收文件，只读取日志的工具也会调用 init
   for (const filesystem::directory_entry &dir_entry : filesystem::directory_iterator(directory_)) {
     if (!dir_entry.is_regular_file()) {
       continue;
     }
 
     string filename = dir_entry.path().filename().string();
+    if (filename.starts_with(recycled_file_prefix_)) {
+      recycled_files_.push_back(dir_entry.path());
+      continue;
+    }
+
     LSN lsn = 0;
     RC rc = get_lsn_from_filename(filename, lsn);
     if (OB_FAIL(rc)) {
@@ -272,8 +530,8 @@ RC LogFileManager::init(const char *directory, int max_entry_number_per_file)
     log_files_.emplace(lsn, dir_entry.path());
   }
 
-  LOG_INFO("init log file manager success. directory=%s, log files=%d", 
-           directory_.c_str(), static_cast<int>(log_files_.size()));
+  LOG_INFO("init log file manager success. directory=%s, log files=%d, recycled files=%d", 
+           directory_.c_str(), static_cast<int>(log_files_.size()), static_cast<int>(recycled_files_.size()));
   return RC::SUCCESS;
 }
 
@@ -298,12 +556,15 @@ RC LogFileManager::list_files(vector<string> &files, LSN start_lsn)
 {
   files.clear();
 
-  // 这里的代码是AI自动生成的
-  // 其实写的不好，我们只需要找到比start_lsn相等或者小的第一个日志文件就可以了
-  for (auto &file : log_files_) {
-    if (file.first + max_entry_number_per_file_ - 1 >= start_lsn) {
-      files.emplace_back(file.second.string());
-    }
+  lock_guard<mutex> guard(lock_);
+  // 文件中日志的LSN范围是从文件名中的LSN到下一个文件的LSN，
+  // 从最后一个第一条LSN不大于 start_lsn 的文件开始
+  auto iter = log_files_.upper_bound(start_lsn);
+  if (iter != log_files_.begin()) {
+    --iter;
+  }
+  for (; iter != log_files_.end(); ++iter) {
+    files.emplace_back(iter->second.string());
   }
 
   return RC::SUCCESS;
@@ -311,29 +572,126 @@ RC LogFileManager::list_files(vector<string> &files, LSN start_lsn)
 
 RC LogFileManager::last_file(LogFileWriter &file_writer)
 {
+  unique_lock<mutex> guard(lock_);
   if (log_files_.empty()) {
-    return next_file(file_writer);
+    guard.unlock();
+    return next_file(file_writer, 0);
   }
 
   file_writer.close();
 
   auto last_file_item = log_files_.rbegin();
-  return file_writer.open(last_file_item->second.c_str(), 
-                          last_file_item->first + max_entry_number_per_file_ - 1);
+  return file_writer.open(last_file_item->second.c_str(), max_file_size_, codec_);
 }
 
-RC LogFileManager::next_file(LogFileWriter &file_writer)
+RC LogFileManager::next_file(LogFileWriter &file_writer, LSN first_lsn)
 {
   file_writer.close();
 
-  LSN lsn = 0;
-  if (!log_files_.empty()) {
-    lsn = log_files_.rbegin()->first + max_entry_number_per_file_;
+  lock_guard<mutex> guard(lock_);
+  if (!log_files_.empty() && first_lsn <= log_files_.rbegin()->first) {
+    LOG_WARN("invalid lsn of next log file. lsn=%ld, last file lsn=%ld", first_lsn, log_files_.rbegin()->first);
+    return RC::INVALID_ARGUMENT;
   }
 
-  string filename = file_prefix_ + to_string(lsn) + file_suffix_;
+  string filename = file_prefix_ + to_string(first_lsn) + file_suffix_;
   filesystem::path file_path = directory_ / filename;
-  log_files_.emplace(lsn, file_path);
+  if (!recycled_files_.empty()) {
+    filesystem::path recycled_file = recycled_files_.front();
+    error_code       ec;
+    filesystem::rename(recycled_file, file_path, ec);
+    if (ec) {
+      LOG_WARN("failed to reuse recycled log file. file=%s, error=%s", recycled_file.c_str(), ec.message().c_str());
+    } else {
+      LOG_INFO("reuse recycled log file. file=%s, new file=%s", recycled_file.c_str(), file_path.c_str());
+    }
+    recycled_files_.pop_front();
+  }
+
+  log_files_.emplace(first_lsn, file_path);
+
+  return file_writer.open(file_path.c_str(), max_file_size_, codec_);
+}
+
+RC LogFileManager::purge_files(LSN lsn)
+{
+  vector<pair<LSN, filesystem::path>> purged_files;
+  {
+    lock_guard<mutex> guard(lock_);
+    while (log_files_.size() > 1) {
+      // 下一个文件的第一条日志不大于 lsn 时，这个文件中的日志都小于 lsn
+      auto first_file  = log_files_.begin();
+      auto second_file = next(first_file);
+      if (second_file->first > lsn) {
+        break;
+      }
 
-  return file_writer.open(file_path.c_str(), lsn + max_entry_number_per_file_ - 1);
+      purged_files.emplace_back(*first_file);
+      log_files_.erase(first_file);
+    }
+  }
+
+  // 文件已经不在 log_files_ 中了，不会有人再访问，处理文件时就不需要持有锁
+  RC rc = RC::SUCCESS;
+  for (const auto &[file_lsn, file] : purged_files) {
+    if (OB_SUCC(recycle_file(file, file_lsn))) {
+      continue;
+    }
+
+    error_code ec;
+    if (!filesystem::remove(file, ec)) {
+      LOG_WARN("failed to remove log file. file=%s, error=%s", file.c_str(), ec.message().c_str());
+      rc = RC::FILE_REMOVE;
+      continue;
+    }
+    LOG_INFO("remove log file. file=%s, lsn=%ld", file.c_str(), lsn);
+  }
+  return rc;
+}
+
+RC LogFileManager::recycle_file(const filesystem::path &file, LSN lsn)
+{
+  {
+    lock_guard<mutex> guard(lock_);
+    if (static_cast<int>(recycled_files_.size()) >= max_recycled_files_) {
+      return RC::INTERNAL;
+    }
+  }
+
+  int fd = ::open(file.c_str(), O_WRONLY);
+  if (fd < 0) {
+    LOG_WARN("failed to open log file. file=%s, error=%s", file.c_str(), strerror(errno));
+    return RC::FILE_OPEN;
+  }
+
+  char header[LogBatchHeader::SIZE];
+  memset(header, 0, sizeof(header));
+  int ret = writen(fd, header, sizeof(header));
+  if (0 == ret) {
+    ret = ::fdatasync(fd) == 0 ? 0 : errno;
+  }
+  ::close(fd);
+  if (0 != ret) {
+    LOG_WARN("failed to clear log file header. file=%s, error=%s", file.c_str(), strerror(ret));
+    return RC::IOERR_WRITE;
+  }
+
+  filesystem::path recycled_file = directory_ / (recycled_file_prefix_ + to_string(lsn) + file_suffix_);
+  error_code       ec;
+  filesystem::rename(file, recycled_file, ec);
+  if (ec) {
+    LOG_WARN("failed to rename log file. file=%s, error=%s", file.c_str(), ec.message().c_str());
+    return RC::IOERR_ACCESS;
+  }
+
+  lock_guard<mutex> guard(lock_);
+  recycled_files_.push_back(recycled_file);
+  LOG_INFO("recycle log file. file=%s, recycled file=%s", file.c_str(), recycled_file.c_str());
+  return RC::SUCCESS;
+}
+
+int LogFileManager::recycled_file_num()
+{
+  lock_guard<mutex> guard(lock_);
+  return static_cast<int>(recycled_files_.size());
 }
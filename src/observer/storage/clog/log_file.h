@@ -14,20 +14,52 @@ See the Mulan PSL v2 for more details. */
 
 #pragma once
 
+#include <sys/uio.h>
+
 #include "common/sys/rc.h"
 #include "common/types.h"
 #include "common/lang/map.h"
+#include "common/lang/deque.h"
 #include "common/lang/functional.h"
 #include "common/lang/filesystem.h"
 #include "common/lang/fstream.h"
+#include "common/lang/mutex.h"
+#include "common/lang/span.h"
 #include "common/lang/string.h"
+#include "common/lang/vector.h"
 
 class LogEntry;
+class LogCodec;
+
+/**
+ * @brief 日志文件中一批日志的头
+ * @ingroup CLog
+ * @details 日志是按批写入文件的，每批是一次刷盘时写入的LSN连续的若干条日志。文件中每批日志的格式是
+ * LogBatchHeader + 数据，数据是连续的 LogHeader + payload，可能是压缩过的。
+ * crc 是 CRC32C，覆盖批次头中 crc 之前的字段和文件中的数据，用来发现写了一半或者被破坏的日志。
+ */
+struct LogBatchHeader final
+{
+  LSN      first_lsn;  /// 第一条日志的LSN
+  LSN      last_lsn;   /// 最后一条日志的LSN
+  int32_t  raw_size;   /// 压缩前的数据大小
+  int32_t  data_size;  /// 文件中的数据大小
+  int32_t  codec;      /// 压缩算法，参考 LogCodec::Type
+  uint32_t crc;        /// 校验码
+
+  static constexpr int32_t SIZE = 32;  /// 批次头大小
+
+  /// 计算校验码，data 是文件中的数据
+  uint32_t calc_crc(const struct iovec *data, int iovcnt) const;
+};
+static_assert(sizeof(LogBatchHeader) == LogBatchHeader::SIZE, "LogBatchHeader is written to file directly");
 
 /**
  * @brief 负责处理一个日志文件，包括读取和写入
  * @ingroup CLog
- * @details 日志文件中的日志是按照LSN从小到大排列的
+ * @details 日志文件中的日志是按照LSN从小到大排列的，并且LSN是连续的。
+ * 日志文件是预先分配好空间的，还可能是回收的旧文件，有效日志之后可能是0或者旧的日志，
+ * 所以读到第一个LSN不连续、校验码不对或者不完整的批次时，就认为日志结束了。
  */
 class LogFileReader
 {
@@ -38,24 +70,55 @@ public:
   RC open(const char *filename);
   RC close();
 
-  RC iterate(function<RC(LogEntry &)> callback, LSN start_lsn = 0);
+  /**
+   * @brief 逐条回调文件中的日志
+   * @param start_lsn 只回调LSN不小于 start_lsn 的日志
+   * @param prev_lsn 前一个日志文件的最后一条日志LSN，文件中第一批日志必须从 prev_lsn + 1 开始。0表示不检查
+   */
+  RC iterate(function<RC(LogEntry &)> callback, LSN start_lsn = 0, LSN prev_lsn = 0);
+
+  /**
+   * @brief 找到文件中有效日志的结尾
+   * @param[out] end_offset 最后一批有效日志之后的位置，新的日志从这里开始写
+   * @param[out] last_lsn 最后一条有效日志的LSN，没有日志时是0
+   */
+  RC find_end(int64_t &end_offset, LSN &last_lsn);
+
+  /// 最后一条读到的日志LSN，没有读到日志时是 iterate 的 prev_lsn
+  LSN last_lsn() const { return last_lsn_; }
+
+  /// 是否因为校验码不对或者数据不完整而停止读取。只有最后一个日志文件允许出现这种情况
+  bool corrupted() const { return corrupted_; }
 
 private:
   /**
-   * @brief 跳到第一条不小于start_lsn的日志
-   *
-   * @param start_lsn 期望开始的第一条日志的LSN
+   * @brief 读取 offset_ 处的一批日志，并检查校验码
+   * @details 读到文件尾、数据不完整、LSN不连续或者校验码不对时返回 RECORD_EOF，数据不完整和校验码不对时还会设置 corrupted_
+   * @param[out] data 文件中的数据，可能是压缩过的
    */
-  RC skip_to(LSN start_lsn);
+  RC read_batch(LogBatchHeader &header, vector<char> &data);
+
+  /**
+   * @brief 解压一批日志，并逐条回调
+   * @details 只回调LSN不小于 start_lsn 的日志
+   */
+  RC iterate_batch(
+      const LogBatchHeader &header, vector<char> &data, function<RC(LogEntry &)> &callback, LSN start_lsn);
 
 private:
-  int    fd_ = -1;
-  string filename_;
+  int     fd_ = -1;
+  string  filename_;
+  int64_t file_size_ = 0;      /// 打开文件时的文件大小
+  int64_t offset_    = 0;      /// 下一批日志在文件中的位置
+  LSN     last_lsn_  = 0;      /// 上一条读到的日志LSN，用来判断日志是否连续
+  bool    corrupted_ = false;  /// 读到了损坏的日志批次
 };
 
 /**
  * @brief 负责写入一个日志文件
  * @ingroup CLog
+ * @details 日志文件按照字节数划分。打开文件时会预先分配好整个文件的空间，写日志时只是覆盖写文件中的数据，
+ * 不会修改文件大小，fdatasync 时就不需要同步文件的元数据。
  */
 class LogFileWriter
 {
@@ -65,10 +128,13 @@ public:
 
   /**
    * @brief 打开一个日志文件
+   * @details 文件不足 max_file_size 时使用 fallocate 预先分配空间，不支持 fallocate 时只扩大文件。
+   * 如果文件中已经有日志，新的日志写在最后一条有效日志之后。
    * @param filename 日志文件名
-   * @param end_lsn 当前日志文件允许的最大LSN（包含）
+   * @param max_file_size 日志文件的大小，写满之后就要切换到下一个文件
+   * @param codec 压缩算法，为空时不压缩
    */
-  RC open(const char *filename, int end_lsn);
+  RC open(const char *filename, int64_t max_file_size, const LogCodec *codec = nullptr);
 
   /// @brief 关闭当前文件
   RC close();
@@ -76,32 +142,68 @@ public:
   /// @brief 写入一条日志
   RC write(LogEntry &entry);
 
+  /**
+   * @brief 批量写入日志
+   * @details 所有日志一次写入文件，最后只调用一次 fdatasync，这样一批日志只需要等待一次磁盘IO。
+   * 如果文件放不下所有的日志，就只写入前面的一部分，并返回 LOG_FILE_FULL。
+   * @param entries 要写入的日志，LSN从小到大排列
+   * @param[out] count 成功写入了多少条日志
+   */
+  RC write(span<LogEntry> entries, int &count);
+
+  /**
+   * @brief 写入一段连续的日志数据
+   * @details data 中是LSN从 first_lsn 到 last_lsn 的完整日志(LogHeader + payload)，作为一批写入文件，
+   * 按需压缩并加上批次头。first_lsn 必须紧接着文件中的最后一条日志。写入之后只调用一次 fdatasync。
+   * 文件剩余的空间放不下时返回 LOG_FILE_FULL，但是空文件总是可以写入，即使数据比文件还大。
+   */
+  RC write(span<struct iovec> data, LSN first_lsn, LSN last_lsn);
+
   /**
    * @brief 当前文件是否已经打开
    */
   bool valid() const;
 
   /**
-   * @brief 文件是否已经写满。当前是按照日志条数来判断的
+   * @brief 文件是否已经写满
    */
   bool full() const;
 
+  /// @brief 还没有写入任何日志
+  bool empty() const { return offset_ == 0; }
+
+  /// @brief 文件中还可以写入多少字节的日志，已经去掉了批次头的大小，按照不压缩计算
+  int64_t remain() const
+  {
+    return offset_ + LogBatchHeader::SIZE >= max_file_size_ ? 0 : max_file_size_ - offset_ - LogBatchHeader::SIZE;
+  }
+
   string to_string() const;
 
   const char *filename() const { return filename_.c_str(); }
 
+  /// @brief 写入的最后一条日志LSN
+  LSN last_lsn() const { return last_lsn_; }
+
 private:
-  string filename_;       /// 日志文件名
-  int    fd_       = -1;  /// 日志文件描述符
-  int    last_lsn_ = 0;   /// 写入的最后一条日志LSN
-  int    end_lsn_  = 0;   /// 当前日志文件中允许写入的最大的LSN，包括这条日志
+  string  filename_;            /// 日志文件名
+  int     fd_            = -1;  /// 日志文件描述符
+  LSN     last_lsn_      = 0;   /// 写入的最后一条日志LSN
+  int64_t offset_        = 0;   /// 下一条日志写入的位置
+  int64_t max_file_size_ = 0;   /// 日志文件的大小
+
+  const LogCodec *codec_ = nullptr;  /// 压缩算法，为空时不压缩
+  vector<char>    raw_buffer_;       /// 压缩时把日志数据复制到连续的内存中
+  vector<char>    compressed_buffer_;
 };
 
 /**
  * @brief 管理所有的日志文件
  * @ingroup CLog
  * @details 日志文件都在某个目录下，使用固定的前缀加上日志文件的第一个LSN作为文件名。
- * 每个日志文件没有最大字节数要求，但是以固定条数的日志为一个文件，这样方便查找。
+ * 每个日志文件的大小是固定的，写满之后切换到下一个文件，下一个文件的名字是写满时的下一个LSN。
+ * 检查点之前的日志文件不再需要时，不会直接删除，而是改名之后放到回收列表中，
+ * 需要新的日志文件时优先复用这些文件，这样写日志时不需要再分配磁盘空间。
  */
 class LogFileManager
 {
@@ -113,9 +215,11 @@ public:
    * @brief 初始化
    *
    * @param directory 日志文件目录
-   * @param max_entry_number_per_file 一个文件最多存储多少条日志
+   * @param max_file_size 每个日志文件的大小
+   * @param max_recycled_files 最多保留多少个回收的日志文件
+   * @param codec 写日志时使用的压缩算法，为空时不压缩
    */
-  RC init(const char *directory, int max_entry_number_per_file);
+  RC init(const char *directory, int64_t max_file_size, int max_recycled_files, const LogCodec *codec = nullptr);
 
   /**
    * @brief 列出所有的日志文件，第一个日志文件包含大于等于start_lsn最小的日志
@@ -126,16 +230,28 @@ public:
   RC list_files(vector<string> &files, LSN start_lsn);
 
   /**
-   * @brief 获取最新的一个日志文件名
-   * @details 如果当前有文件就获取最后一个日志文件，否则创建一个日志文件，也就是第一个日志文件
+   * @brief 打开最新的一个日志文件
+   * @details 如果当前有文件就打开最后一个日志文件，否则创建一个日志文件，也就是第一个日志文件
    */
   RC last_file(LogFileWriter &file_writer);
 
   /**
-   * @brief 获取一个新的日志文件名
-   * @details 获取下一个日志文件名。通常是上一个日志文件写满了，通过这个接口生成下一个日志文件
+   * @brief 打开一个新的日志文件
+   * @details 通常是上一个日志文件写满了，通过这个接口生成下一个日志文件。优先复用回收的文件。
+   * @param first_lsn 新文件中第一条日志的LSN，必须比已有文件的LSN都大
+   */
+  RC next_file(LogFileWriter &file_writer, LSN first_lsn);
+
+  /**
+   * @brief 回收不再需要的日志文件
+   * @details 回收所有日志的LSN都小于 lsn 的日志文件。最后一个日志文件可能正在写入，不会被回收。
+   * 回收的文件超过 max_recycled_files 之后就直接删除。
+   * @param lsn 这个LSN之前的日志都不再需要了，通常是检查点
    */
-  RC next_file(LogFileWriter &file_writer);
+  RC purge_files(LSN lsn);
+
+  /// @brief 当前有多少个回收的日志文件
+  int recycled_file_num();
 
 private:
   /**
@@ -144,12 +260,23 @@ private:
    */
   static RC get_lsn_from_filename(const string &filename, LSN &lsn);
 
+  /**
+   * @brief 回收一个日志文件
+   * @details 先清掉第一个批次头，这样复用时旧的日志不会被当成有效的日志，再改名放到回收列表中
+   */
+  RC recycle_file(const filesystem::path &file, LSN lsn);
+
 private:
-  static constexpr const char *file_prefix_ = "clog_";
-  static constexpr const char *file_suffix_ = ".log";
+  static constexpr const char *file_prefix_          = "clog_";
+  static constexpr const char *file_suffix_          = ".log";
+  static constexpr const char *recycled_file_prefix_ = "clog_recycled_";
 
-  filesystem::path directory_;                  /// 日志文件存放的目录
-  int              max_entry_number_per_file_;  /// 一个文件最大允许存放多少条日志
+  filesystem::path directory_;               /// 日志文件存放的目录
+  int64_t          max_file_size_      = 0;  /// 每个日志文件的大小
+  int              max_recycled_files_ = 0;  /// 最多保留多少个回收的日志文件
+  const LogCodec  *codec_              = nullptr;  /// 写日志时使用的压缩算法
 
-  map<LSN, filesystem::path> log_files_;  /// 日志文件名和第一个LSN的映射
+  mutex                      lock_;            /// 保护 log_files_ 和 recycled_files_，检查点和刷日志的线程会同时访问
+  map<LSN, filesystem::path> log_files_;       /// 日志文件名和第一个LSN的映射
+  deque<filesystem::path>    recycled_files_;  /// 可以复用的日志文件
 };
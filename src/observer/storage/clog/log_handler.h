@@ -96,6 +96,13 @@ public:
 
   virtual LSN current_lsn() const = 0;
 
+  /**
+   * @brief 清理不再需要的日志
+   * @details 做完检查点之后，检查点之前的日志在重启时都不需要回放了
+   * @param lsn 这个LSN之前的日志都可以删除，通常是检查点
+   */
+  virtual RC purge(LSN lsn) = 0;
+
   static RC create(const char *name, LogHandler *&handler);
 
 private:
@@ -104,4 +111,10 @@ private:
    * @details 子类应该重现实现这个函数
    */
   virtual RC _append(LSN &lsn, LogModule module, vector<char> &&data) = 0;
+
+  /**
+   * @brief 写入一条日志
+   * @details 默认会把数据拷贝到一个 vector 中。子类可以重新实现这个函数，直接使用数据，避免申请内存
+   */
+  virtual RC _append(LSN &lsn, LogModule module, span<const char> data);
 };
@@ -0,0 +1,268 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "storage/clog/parallel_log_replayer.h"
+#include "common/lang/serializer.h"
+#include "common/log/log.h"
+#include "common/thread/thread_util.h"
+#include "storage/buffer/page.h"
+
+using namespace common;
+
+ParallelLogReplayer::ParallelLogReplayer(
+    BufferPoolManager &bpm, unique_ptr<LogReplayer> trx_log_replayer, int worker_num)
+    : buffer_pool_log_replayer_(bpm),
+      record_log_replayer_(bpm),
+      bplus_tree_log_replayer_(bpm),
+      trx_log_replayer_(std::move(trx_log_replayer)),
+      worker_num_(worker_num > 0 ? worker_num : 1)
+{}
+
+ParallelLogReplayer::~ParallelLogReplayer() { (void)stop(); }
+
+RC ParallelLogReplayer::start()
+{
+  if (!workers_.empty()) {
+    LOG_WARN("parallel log replayer has been started");
+    return RC::INTERNAL;
+  }
+
+  for (int i = 0; i < worker_num_; i++) {
+    workers_.push_back(make_unique<Worker>());
+  }
+  for (auto &worker : workers_) {
+    worker->worker_thread = thread(&ParallelLogReplayer::worker_func, this, std::ref(*worker));
+  }
+
+  LOG_INFO("parallel log replayer started. worker num=%d", worker_num_);
+  return RC::SUCCESS;
+}
+
+RC ParallelLogReplayer::replay(const LogEntry &entry)
+{
+  if (failed_.load()) {
+    for (auto &worker : workers_) {
+      lock_guard<mutex> guard(worker->lock);
+      if (OB_FAIL(worker->rc)) {
+        return worker->rc;
+      }
+    }
+  }
+
+  switch (entry.module().id()) {
+    case LogModule::Id::BUFFER_POOL:
+    case LogModule::Id::RECORD_MANAGER:
+    case LogModule::Id::BPLUS_TREE: break;
+    case LogModule::Id::TRANSACTION: {
+      if (trx_log_replayer_ == nullptr) {
+        return RC::SUCCESS;
+      }
+    } break;
+    default: return RC::INVALID_ARGUMENT;
+  }
+
+  if (workers_.empty()) {
+    LOG_WARN("parallel log replayer is not started");
+    return RC::INTERNAL;
+  }
+
+  // 回放接口只给了日志的引用，需要复制一份交给其它线程
+  LogEntry copied_entry;
+  RC       rc = copied_entry.init(
+      entry.lsn(), entry.module(), vector<char>(entry.data(), entry.data() + entry.payload_size()));
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to copy log entry. entry=%s, rc=%s", entry.to_string().c_str(), strrc(rc));
+    return rc;
+  }
+
+  if (entry.module().id() == LogModule::Id::TRANSACTION) {
+    trx_entries_.push_back(std::move(copied_entry));
+    return RC::SUCCESS;
+  }
+
+  Worker &worker = *workers_[worker_index(entry)];
+  worker.pending.push_back(std::move(copied_entry));
+  if (worker.pending.size() >= BATCH_SIZE) {
+    rc = submit(worker);
+  }
+  return rc;
+}
+
+RC ParallelLogReplayer::on_done()
+{
+  RC rc = stop();
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to replay page logs in parallel. rc=%s", strrc(rc));
+    return rc;
+  }
+
+  rc = buffer_pool_log_replayer_.on_done();
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to do buffer pool log replay. rc=%s", strrc(rc));
+    return rc;
+  }
+  rc = record_log_replayer_.on_done();
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to do record log replay. rc=%s", strrc(rc));
+    return rc;
+  }
+
+  rc = bplus_tree_log_replayer_.on_done();
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to do bplus tree log replay. rc=%s", strrc(rc));
+    return rc;
+  }
+
+  if (trx_log_replayer_ == nullptr) {
+    return RC::SUCCESS;
+  }
+
+  // 页面都已经恢复到最新状态，再按照LSN顺序回放事务日志，回滚未提交的事务
+  for (const LogEntry &entry : trx_entries_) {
+    rc = trx_log_replayer_->replay(entry);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to replay trx log. entry=%s, rc=%s", entry.to_string().c_str(), strrc(rc));
+      return rc;
+    }
+  }
+  trx_entries_.clear();
+
+  rc = trx_log_replayer_->on_done();
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to do mvcc trx log replay. rc=%s", strrc(rc));
+    return rc;
+  }
+
+  return RC::SUCCESS;
+}
+
+int ParallelLogReplayer::worker_index(const LogEntry &entry) const
+{
+  // 格式错误的日志随便交给一个线程，由对应模块的回放器报错
+  int32_t buffer_pool_id = 0;
+  PageNum page_num       = BP_HEADER_PAGE;
+  switch (entry.module().id()) {
+    case LogModule::Id::BUFFER_POOL: {
+      if (entry.payload_size() >= static_cast<int32_t>(sizeof(BufferPoolLogEntry))) {
+        buffer_pool_id = reinterpret_cast<const BufferPoolLogEntry *>(entry.data())->buffer_pool_id;
+      }
+    } break;
+    case LogModule::Id::RECORD_MANAGER: {
+      if (entry.payload_size() >= RecordLogHeader::SIZE) {
+        auto header    = reinterpret_cast<const RecordLogHeader *>(entry.data());
+        buffer_pool_id = header->buffer_pool_id;
+        page_num       = header->page_num;
+      }
+    } break;
+    case LogModule::Id::BPLUS_TREE: {
+      Deserializer buffer(entry.data(), entry.payload_size());
+      (void)buffer.read_int32(buffer_pool_id);
+      page_num = BP_INVALID_PAGE_NUM;
+    } break;
+    default: break;
+  }
+
+  // 乘法哈希把相邻的页面打散，否则 worker_num 是2的幂时 buffer_pool_id 不参与分配
+  const uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(buffer_pool_id)) << 32) |
+                       static_cast<uint32_t>(page_num);
+  return static_cast<int>(((key * 0x9E3779B97F4A7C15ULL) >> 32) % static_cast<uint64_t>(worker_num_));
+}
+
+RC ParallelLogReplayer::submit(Worker &worker)
+{
+  unique_lock<mutex> guard(worker.lock);
+  worker.space_cond.wait(guard, [&worker]() { return worker.queue.size() < MAX_QUEUE_SIZE; });
+  for (LogEntry &entry : worker.pending) {
+    worker.queue.push_back(std::move(entry));
+  }
+  worker.pending.clear();
+
+  RC rc = worker.rc;
+  guard.unlock();
+  worker.cond.notify_one();
+  return rc;
+}
+
+void ParallelLogReplayer::worker_func(Worker &worker)
+{
+  thread_set_name("LogReplayer");
+
+  RC                 rc = RC::SUCCESS;
+  deque<LogEntry>    entries;
+  unique_lock<mutex> guard(worker.lock);
+  while (true) {
+    worker.cond.wait(guard, [&worker]() { return worker.stopped || !worker.queue.empty(); });
+    if (worker.queue.empty()) {
+      break;
+    }
+
+    entries.swap(worker.queue);
+    guard.unlock();
+    worker.space_cond.notify_one();
+
+    // 回放失败之后仍然取走日志，避免分发线程等待队列空闲时卡住
+    for (const LogEntry &entry : entries) {
+      if (OB_FAIL(rc)) {
+        break;
+      }
+
+      rc = replay_page_entry(entry);
+      if (OB_FAIL(rc)) {
+        LOG_WARN("failed to replay log entry. entry=%s, rc=%s", entry.to_string().c_str(), strrc(rc));
+        failed_.store(true);
+      }
+    }
+    entries.clear();
+
+    guard.lock();
+    if (OB_FAIL(rc) && OB_SUCC(worker.rc)) {
+      worker.rc = rc;
+    }
+  }
+}
+
+RC ParallelLogReplayer::replay_page_entry(const LogEntry &entry)
+{
+  switch (entry.module().id()) {
+    case LogModule::Id::BUFFER_POOL: return buffer_pool_log_replayer_.replay(entry);
+    case LogModule::Id::RECORD_MANAGER: return record_log_replayer_.replay(entry);
+    case LogModule::Id::BPLUS_TREE: return bplus_tree_log_replayer_.replay(entry);
+    default: return RC::INVALID_ARGUMENT;
+  }
+}
+
+RC ParallelLogReplayer::stop()
+{
+  if (workers_.empty()) {
+    return RC::SUCCESS;
+  }
+
+  for (auto &worker : workers_) {
+    if (!worker->pending.empty()) {
+      (void)submit(*worker);
+    }
+
+    lock_guard<mutex> guard(worker->lock);
+    worker->stopped = true;
+    worker->cond.notify_one();
+  }
+
+  RC rc = RC::SUCCESS;
+  for (auto &worker : workers_) {
+    worker->worker_thread.join();
+    if (OB_SUCC(rc) && OB_FAIL(worker->rc)) {
+      rc = worker->rc;
+    }
+  }
+  workers_.clear();
+
+  LOG_INFO("parallel log replayer stopped. rc=%s", strrc(rc));
+  return rc;
+}
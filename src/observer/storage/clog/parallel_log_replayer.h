@@ -0,0 +1,110 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include "common/lang/atomic.h"
+#include "common/lang/condition_variable.h"
+#include "common/lang/deque.h"
+#include "common/lang/memory.h"
+#include "common/lang/mutex.h"
+#include "common/lang/thread.h"
+#include "common/lang/vector.h"
+#include "storage/clog/log_entry.h"
+#include "storage/clog/log_replayer.h"
+#include "storage/buffer/buffer_pool_log.h"
+#include "storage/record/record_log.h"
+#include "storage/index/bplus_tree_log.h"
+
+class BufferPoolManager;
+
+/**
+ * @brief 并行日志回放类
+ * @ingroup Clog
+ * @details 与 IntegratedLogReplayer 回放的日志相同，但是把页面相关的日志分发给多个线程回放。
+ * 日志按照修改的页面(buffer_pool_id, page_num)分配给固定的线程，每个线程按照LSN顺序回放，
+ * 所以同一个页面上的修改顺序与串行回放相同，不同页面之间互不影响。
+ * - buffer pool 日志修改的是文件头页面；
+ * - record manager 日志修改的是日志中记录的页面；
+ * - B+树的一条日志是一个mini transaction，会修改多个页面，因此同一个索引文件的日志都交给同一个线程。
+ *
+ * 事务日志不修改页面，先缓存下来，等所有页面日志回放完成后，在 on_done 中按照顺序回放。
+ * 调用顺序：start -> replay ... -> on_done。
+ */
+class ParallelLogReplayer : public LogReplayer
+{
+public:
+  /**
+   * @param bpm              恢复时使用的 BufferPoolManager
+   * @param trx_log_replayer 事务日志回放器，可以为空，为空时忽略事务日志
+   * @param worker_num       回放页面日志的线程数
+   */
+  ParallelLogReplayer(BufferPoolManager &bpm, unique_ptr<LogReplayer> trx_log_replayer, int worker_num);
+  virtual ~ParallelLogReplayer();
+
+  /**
+   * @brief 启动回放线程
+   */
+  RC start();
+
+  /**
+   * @brief 分发一条日志
+   * @details 如果某个回放线程已经失败，返回它的错误码
+   */
+  RC replay(const LogEntry &entry) override;
+
+  /**
+   * @brief 等待所有页面日志回放完成，再按顺序回放事务日志
+   */
+  RC on_done() override;
+
+  int worker_num() const { return worker_num_; }
+
+private:
+  /**
+   * @brief 回放线程
+   * @details 分发线程先把日志攒在 pending 中，攒够一批再放到 queue 中，减少加锁和唤醒的次数
+   */
+  struct Worker
+  {
+    mutex              lock;
+    condition_variable cond;        ///< 通知回放线程有新的日志或者需要退出
+    condition_variable space_cond;  ///< 通知分发线程队列有空闲位置
+    deque<LogEntry>    queue;       ///< 等待回放的日志
+    vector<LogEntry>   pending;     ///< 分发线程还没有提交到队列中的日志，只有分发线程访问
+    bool               stopped = false;
+    RC                 rc      = RC::SUCCESS;  ///< 第一个回放失败的错误码
+    thread             worker_thread;
+  };
+
+  /// 每攒够这么多条日志提交一次
+  static constexpr size_t BATCH_SIZE = 64;
+  /// 每个回放线程队列中最多的日志条数，避免日志读取速度太快占用太多内存
+  static constexpr size_t MAX_QUEUE_SIZE = 4096;
+
+  /// 计算一条页面日志应该交给哪个回放线程
+  int worker_index(const LogEntry &entry) const;
+
+  RC   submit(Worker &worker);
+  void worker_func(Worker &worker);
+  RC   replay_page_entry(const LogEntry &entry);
+  RC   stop();
+
+private:
+  BufferPoolLogReplayer   buffer_pool_log_replayer_;  ///< 缓冲池日志回放器
+  RecordLogReplayer       record_log_replayer_;       ///< record manager 日志回放器
+  BplusTreeLogReplayer    bplus_tree_log_replayer_;   ///< bplus tree 日志回放器
+  unique_ptr<LogReplayer> trx_log_replayer_;          ///< trx 日志回放器
+
+  int                        worker_num_ = 0;
+  vector<unique_ptr<Worker>> workers_;
+  atomic_bool                failed_{false};  ///< 是否有回放线程失败，分发线程用来尽早结束
+  vector<LogEntry>           trx_entries_;    ///< 缓存的事务日志，页面日志回放完成后再回放
+};
@@ -17,21 +17,28 @@ See the Mulan PSL v2 for more details. */
 #include <fcntl.h>
 #include <sys/stat.h>
 
+#include "common/conf/ini.h"
 #include "common/lang/string.h"
 #include "common/log/log.h"
 #include "common/os/path.h"
 #include "common/global_context.h"
+#include "common/ini_setting.h"
+#include "common/lang/chrono.h"
+#include "common/thread/thread_util.h"
 #include "storage/common/meta_util.h"
 #include "storage/table/table.h"
 #include "storage/table/table_meta.h"
 #include "storage/trx/trx.h"
 #include "storage/clog/disk_log_handler.h"
 #include "storage/clog/integrated_log_replayer.h"
+#include "storage/clog/parallel_log_replayer.h"
 
 using namespace common;
 
 Db::~Db()
 {
+  stop_checkpoint_thread();
+
   for (auto &iter : opened_tables_) {
     delete iter.second;
   }
@@ -83,7 +90,89 @@ RC Db::init(const char *name, const char *dbpath, const char *trx_kit_name, cons
 
   storage_engine_ = storage_engine;
 
-  buffer_pool_manager_ = make_unique<BufferPoolManager>();
+  int    frame_shard_num = BUFFER_POOL_FRAME_SHARD_NUM_DEFAULT;
+  string frame_shard_num_str =
+      get_properties()->get(BUFFER_POOL_FRAME_SHARD_NUM, std::to_string(frame_shard_num), STORAGE);
+  str_to_val(frame_shard_num_str, frame_shard_num);
+
+  string frame_replacer =
+      get_properties()->get(BUFFER_POOL_FRAME_REPLACER, BUFFER_POOL_FRAME_REPLACER_DEFAULT, STORAGE);
+
+  int    read_ahead_window = BUFFER_POOL_READ_AHEAD_WINDOW_DEFAULT;
+  string read_ahead_window_str =
+      get_properties()->get(BUFFER_POOL_READ_AHEAD_WINDOW, std::to_string(read_ahead_window), STORAGE);
+  str_to_val(read_ahead_window_str, read_ahead_window);
+
+  string io_engine = get_properties()->get(BUFFER_POOL_IO_ENGINE, BUFFER_POOL_IO_ENGINE_DEFAULT, STORAGE);
+
+  int    direct_io = BUFFER_POOL_DIRECT_IO_DEFAULT;
+  string direct_io_str = get_properties()->get(BUFFER_POOL_DIRECT_IO, std::to_string(direct_io), STORAGE);
+  str_to_val(direct_io_str, direct_io);
+
+  int    extent_page_num = BUFFER_POOL_EXTENT_PAGE_NUM_DEFAULT;
+  string extent_page_num_str =
+      get_properties()->get(BUFFER_POOL_EXTENT_PAGE_NUM, std::to_string(extent_page_num), STORAGE);
+  str_to_val(extent_page_num_str, extent_page_num);
+
+  int    pax_page_size = PAX_TABLE_PAGE_SIZE_DEFAULT;
+  string pax_page_size_str = get_properties()->get(PAX_TABLE_PAGE_SIZE, std::to_string(pax_page_size), STORAGE);
+  str_to_val(pax_page_size_str, pax_page_size);
+  if (!bp_valid_page_size(pax_page_size)) {
+    LOG_WARN("invalid pax table page size %d, use the default one", pax_page_size);
+    pax_page_size = BP_PAGE_SIZE;
+  }
+  pax_page_size_ = pax_page_size;
+
+  int    clean_percent = BUFFER_POOL_CLEAN_PERCENT_DEFAULT;
+  string clean_percent_str =
+      get_properties()->get(BUFFER_POOL_CLEAN_PERCENT, std::to_string(clean_percent), STORAGE);
+  str_to_val(clean_percent_str, clean_percent);
+
+  int    io_capacity = BUFFER_POOL_IO_CAPACITY_DEFAULT;
+  string io_capacity_str = get_properties()->get(BUFFER_POOL_IO_CAPACITY, std::to_string(io_capacity), STORAGE);
+  str_to_val(io_capacity_str, io_capacity);
+
+  int    checkpoint_interval = CHECKPOINT_INTERVAL_MS_DEFAULT;
+  string checkpoint_interval_str =
+      get_properties()->get(CHECKPOINT_INTERVAL_MS, std::to_string(checkpoint_interval), STORAGE);
+  str_to_val(checkpoint_interval_str, checkpoint_interval);
+
+  int    recovery_thread_num     = RECOVERY_THREAD_NUM_DEFAULT;
+  string recovery_thread_num_str =
+      get_properties()->get(RECOVERY_THREAD_NUM, std::to_string(recovery_thread_num), STORAGE);
+  str_to_val(recovery_thread_num_str, recovery_thread_num);
+
+  int64_t clog_file_size     = CLOG_FILE_SIZE_DEFAULT;
+  string  clog_file_size_str = get_properties()->get(CLOG_FILE_SIZE, std::to_string(clog_file_size), STORAGE);
+  str_to_val(clog_file_size_str, clog_file_size);
+
+  int    clog_recycled_file_num = CLOG_RECYCLED_FILE_NUM_DEFAULT;
+  string clog_recycled_file_num_str =
+      get_properties()->get(CLOG_RECYCLED_FILE_NUM, std::to_string(clog_recycled_file_num), STORAGE);
+  str_to_val(clog_recycled_file_num_str, clog_recycled_file_num);
+
+  string clog_compression = get_properties()->get(CLOG_COMPRESSION, CLOG_COMPRESSION_DEFAULT, STORAGE);
+
+  int64_t index_build_sort_buffer_size = INDEX_BUILD_SORT_BUFFER_SIZE_DEFAULT;
+  string  index_build_sort_buffer_size_str =
+      get_properties()->get(INDEX_BUILD_SORT_BUFFER_SIZE, std::to_string(index_build_sort_buffer_size), STORAGE);
+  str_to_val(index_build_sort_buffer_size_str, index_build_sort_buffer_size);
+  index_build_sort_buffer_size_ = index_build_sort_buffer_size;
+
+  int    index_build_fill_percent = INDEX_BUILD_FILL_PERCENT_DEFAULT;
+  string index_build_fill_percent_str =
+      get_properties()->get(INDEX_BUILD_FILL_PERCENT, std::to_string(index_build_fill_percent), STORAGE);
+  str_to_val(index_build_fill_percent_str, index_build_fill_percent);
+  if (index_build_fill_percent <= 0 || index_build_fill_percent > 100) {
+    LOG_WARN("invalid index build fill percent %d, use the default one", index_build_fill_percent);
+    index_build_fill_percent = INDEX_BUILD_FILL_PERCENT_DEFAULT;
+  }
+  index_build_fill_percent_ = index_build_fill_percent;
+
+  // PAX 表使用不同的页面大小时，缓冲池的内存由两种页面大小平分
+  const int page_size_class_num = (pax_page_size_ == BP_PAGE_SIZE) ? 1 : 2;
+  buffer_pool_manager_          = make_unique<BufferPoolManager>(
+      0 /*memory_size*/, frame_shard_num, frame_replacer.c_str(), page_size_class_num);
   auto dblwr_buffer    = make_unique<DiskDoubleWriteBuffer>(*buffer_pool_manager_);
 
   const char      *double_write_buffer_filename  = "dblwr.db";
@@ -95,7 +184,8 @@ RC Db::init(const char *name, const char *dbpath, const char *trx_kit_name, cons
     return rc;
   }
 
-  rc = buffer_pool_manager_->init(std::move(dblwr_buffer));
+  rc = buffer_pool_manager_->init(std::move(dblwr_buffer), read_ahead_window, io_engine.c_str(), direct_io != 0,
+      extent_page_num);
   if (OB_FAIL(rc)) {
     LOG_ERROR("Failed to init buffer pool manager. dbpath=%s, rc=%s", dbpath, strrc(rc));
     return rc;
@@ -110,7 +200,12 @@ RC Db::init(const char *name, const char *dbpath, const char *trx_kit_name, cons
   }
   log_handler_.reset(tmp_log_handler);
 
-  rc = log_handler_->init(clog_path.c_str());
+  auto disk_log_handler = dynamic_cast<DiskLogHandler *>(log_handler_.get());
+  if (disk_log_handler != nullptr) {
+    rc = disk_log_handler->init(clog_path.c_str(), clog_file_size, clog_recycled_file_num, clog_compression.c_str());
+  } else {
+    rc = log_handler_->init(clog_path.c_str());
+  }
   if (OB_FAIL(rc)) {
     LOG_WARN("failed to init log handler. dbpath=%s, rc=%s", dbpath, strrc(rc));
     return rc;
@@ -141,12 +236,39 @@ RC Db::init(const char *name, const char *dbpath, const char *trx_kit_name, cons
   }
 
   // 尝试恢复数据库，重做redo日志
-  rc = recover();
+  rc = recover(recovery_thread_num);
   if (OB_FAIL(rc)) {
     LOG_WARN("failed to recover db. dbpath=%s, rc=%s", dbpath, strrc(rc));
     return rc;
   }
 
+  // 恢复完成之后再启动后台刷脏页线程
+  // 没有开启 CONCURRENCY 时页帧的latch不会真正加锁，后台线程可能刷出正在修改的页面
+  if (clean_percent > 0) {
+#ifdef CONCURRENCY
+    rc = buffer_pool_manager_->start_page_cleaner(clean_percent, io_capacity);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to start page cleaner. rc=%s", strrc(rc));
+      return rc;
+    }
+#else
+    LOG_WARN("page cleaner is disabled as CONCURRENCY is off");
+#endif
+  }
+
+  // 后台检查点会访问活跃事务列表，没有开启 CONCURRENCY 时事务列表没有真正加锁
+  if (checkpoint_interval > 0) {
+#ifdef CONCURRENCY
+    rc = start_checkpoint_thread(checkpoint_interval);
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to start checkpoint thread. rc=%s", strrc(rc));
+      return rc;
+    }
+#else
+    LOG_WARN("background checkpoint is disabled as CONCURRENCY is off");
+#endif
+  }
+
   return rc;
 }
 
@@ -272,17 +394,124 @@ RC Db::sync()
     return rc;
   }
 
-  check_point_lsn_ = current_lsn;
-  rc               = flush_meta();
+  // 日志回收之后，页面只能从数据文件和共享表空间中恢复，它们要先落盘
+  LSN durable_lsn = 0;
+  rc              = buffer_pool_manager_->sync_files(durable_lsn);
+  if (OB_FAIL(rc)) {
+    LOG_ERROR("Failed to sync buffer pool files. db=%s, rc=%d:%s", name_.c_str(), rc, strrc(rc));
+    return rc;
+  }
+
+  lock_guard<mutex> checkpoint_guard(checkpoint_lock_);
+  check_point_lsn_             = min(current_lsn, durable_lsn);
+  last_checkpoint_current_lsn_ = current_lsn;
+  rc                           = flush_meta();
   if (OB_FAIL(rc)) {
     LOG_ERROR("Failed to flush meta. db=%s, rc=%d:%s", name_.c_str(), rc, strrc(rc));
     return rc;
   }
+
+  (void)log_handler_->purge(check_point_lsn_);
   LOG_INFO("Successfully sync db. db=%s", name_.c_str());
   return rc;
 }
 
-RC Db::recover()
+RC Db::checkpoint()
+{
+  lock_guard<mutex> checkpoint_guard(checkpoint_lock_);
+
+  // 先获取最新的LSN，之后写入的日志都留给下一次检查点
+  const LSN current_lsn        = log_handler_->current_lsn();
+  const LSN last_current_lsn   = last_checkpoint_current_lsn_;
+  last_checkpoint_current_lsn_ = current_lsn;
+  if (last_current_lsn < 0) {
+    return RC::SUCCESS;
+  }
+
+  // 写出的页面可能还在操作系统的缓存中，持久化检查点和回收日志之前要先落盘。
+  // 同步之后，脏页最小的 recovery lsn 之前的修改都已经落盘
+  LSN dirty_page_lsn = 0;
+  RC  rc             = buffer_pool_manager_->sync_files(dirty_page_lsn);
+  if (OB_FAIL(rc)) {
+    LOG_ERROR("Failed to sync buffer pool files. db=%s, rc=%s", name_.c_str(), strrc(rc));
+    return rc;
+  }
+
+  const LSN active_trx_lsn = trx_kit_->min_active_trx_lsn();
+  const LSN lsn            = min({last_current_lsn, dirty_page_lsn, active_trx_lsn});
+  if (lsn <= check_point_lsn_) {
+    LOG_TRACE("checkpoint does not move. db=%s, check_point_lsn=%ld, dirty page lsn=%ld, active trx lsn=%ld",
+              name_.c_str(), check_point_lsn_, dirty_page_lsn, active_trx_lsn);
+    return RC::SUCCESS;
+  }
+
+  const LSN old_check_point_lsn = check_point_lsn_;
+  check_point_lsn_              = lsn;
+  rc                            = flush_meta();
+  if (OB_FAIL(rc)) {
+    LOG_ERROR("Failed to flush meta. db=%s, rc=%s", name_.c_str(), strrc(rc));
+    check_point_lsn_ = old_check_point_lsn;
+    return rc;
+  }
+
+  // 日志文件删除失败不影响检查点，下一次还会再删除
+  (void)log_handler_->purge(check_point_lsn_);
+  LOG_INFO("checkpoint done. db=%s, check_point_lsn=%ld, dirty page lsn=%ld, active trx lsn=%ld",
+           name_.c_str(), check_point_lsn_, dirty_page_lsn, active_trx_lsn);
+  return rc;
+}
+
+RC Db::start_checkpoint_thread(int interval_ms)
+{
+  lock_guard<mutex> guard(checkpoint_thread_lock_);
+  if (checkpoint_thread_) {
+    LOG_WARN("checkpoint thread has been started. db=%s", name_.c_str());
+    return RC::INTERNAL;
+  }
+
+  checkpoint_running_ = true;
+  checkpoint_thread_  = make_unique<thread>(&Db::checkpoint_thread_func, this, interval_ms);
+  LOG_INFO("checkpoint thread started. db=%s, interval=%dms", name_.c_str(), interval_ms);
+  return RC::SUCCESS;
+}
+
+void Db::stop_checkpoint_thread()
+{
+  {
+    lock_guard<mutex> guard(checkpoint_thread_lock_);
+    if (!checkpoint_thread_) {
+      return;
+    }
+    checkpoint_running_ = false;
+  }
+
+  checkpoint_cond_.notify_all();
+  checkpoint_thread_->join();
+  checkpoint_thread_.reset();
+  LOG_INFO("checkpoint thread stopped. db=%s", name_.c_str());
+}
+
+void Db::checkpoint_thread_func(int interval_ms)
+{
+  thread_set_name("Checkpoint");
+
+  unique_lock<mutex> guard(checkpoint_thread_lock_);
+  while (checkpoint_running_) {
+    checkpoint_cond_.wait_for(guard, chrono::milliseconds(interval_ms), [this]() { return !checkpoint_running_; });
+    if (!checkpoint_running_) {
+      break;
+    }
+
+    guard.unlock();
+    RC rc = checkpoint();
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to do checkpoint. db=%s, rc=%s", name_.c_str(), strrc(rc));
+    }
+    guard.lock();
+  }
+}
+
+RC Db::recover(int thread_num)
 {
   LOG_TRACE("db recover begin. check_point_lsn=%d", check_point_lsn_);
 
@@ -292,8 +521,30 @@ RC Db::recover()
     return RC::INTERNAL;
   }
 
-  IntegratedLogReplayer log_replayer(*buffer_pool_manager_, unique_ptr<LogReplayer>(trx_log_replayer));
-  RC                    rc = log_handler_->replay(log_replayer, check_point_lsn_ /*start_lsn*/);
+  // 并行回放时多个线程同时访问 buffer pool，没有开启 CONCURRENCY 时 buffer pool 没有真正加锁
+#ifndef CONCURRENCY
+  if (thread_num > 1) {
+    LOG_WARN("parallel recovery is disabled as CONCURRENCY is off");
+    thread_num = 1;
+  }
+#endif
+
+  RC                      rc = RC::SUCCESS;
+  unique_ptr<LogReplayer> log_replayer;
+  if (thread_num > 1) {
+    auto parallel_replayer = make_unique<ParallelLogReplayer>(
+        *buffer_pool_manager_, unique_ptr<LogReplayer>(trx_log_replayer), thread_num);
+    rc = parallel_replayer->start();
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to start parallel log replayer. rc=%s", strrc(rc));
+      return rc;
+    }
+    log_replayer = std::move(parallel_replayer);
+  } else {
+    log_replayer = make_unique<IntegratedLogReplayer>(*buffer_pool_manager_, unique_ptr<LogReplayer>(trx_log_replayer));
+  }
+
+  rc = log_handler_->replay(*log_replayer, check_point_lsn_ /*start_lsn*/);
   if (OB_FAIL(rc)) {
     LOG_WARN("failed to replay log. rc=%s", strrc(rc));
     return rc;
@@ -305,12 +556,23 @@ RC Db::recover()
     return rc;
   }
 
-  rc = log_replayer.on_done();
+  rc = log_replayer->on_done();
   if (OB_FAIL(rc)) {
     LOG_WARN("failed to on_done. rc=%s", strrc(rc));
     return rc;
   }
 
+  // 表是在回放日志之前打开的，回放过日志时需要刷新表在内存中维护的页面信息，比如空闲空间表
+  if (log_handler_->current_lsn() > check_point_lsn_) {
+    for (auto &iter : opened_tables_) {
+      rc = iter.second->on_recovered();
+      if (OB_FAIL(rc)) {
+        LOG_WARN("failed to refresh table after recovery. table=%s, rc=%s", iter.first.c_str(), strrc(rc));
+        return rc;
+      }
+    }
+  }
+
   LOG_INFO("Successfully recover db. db=%s checkpoint_lsn=%d", name_.c_str(), check_point_lsn_);
   return rc;
 }
@@ -15,6 +15,9 @@ See the Mulan PSL v2 for more details. */
 #pragma once
 
 #include "common/sys/rc.h"
+#include "common/lang/condition_variable.h"
+#include "common/lang/mutex.h"
+#include "common/lang/thread.h"
 #include "common/lang/vector.h"
 #include "common/lang/string.h"
 #include "common/lang/unordered_map.h"
@@ -91,6 +94,18 @@ public:
    */
   RC sync();
 
+  /**
+   * @brief 做一次模糊检查点
+   * @details 与 sync 不同，做检查点时不需要停止事务，也不会刷新页面。
+   * 检查点取下面几个LSN中最小的一个：
+   * - 所有脏页的 recovery lsn，这之前的修改都已经写入磁盘；
+   * - 活跃事务开始时的LSN，重启之后需要这些事务的日志来回滚它们；
+   * - 上一次做检查点时的最新LSN。日志写入之后，修改页面的LSN和设置脏页标识之间有一个很短的间隔，
+   *   上一次检查点之前写入的日志，其页面都已经设置好了。
+   * 检查点记录到元数据文件中之后，就会删除检查点之前的日志文件。第一次调用只会记录当前的LSN。
+   */
+  RC checkpoint();
+
   /// @brief 获取当前数据库的日志处理器
   LogHandler &log_handler();
 
@@ -102,13 +117,24 @@ public:
 
   string path() const { return path_; }
 
+  /// @brief PAX 格式的表新建数据文件时使用的页面大小
+  int pax_page_size() const { return pax_page_size_; }
+
+  /// @brief 创建索引时排序使用的内存大小，超过后写到临时文件中
+  int64_t index_build_sort_buffer_size() const { return index_build_sort_buffer_size_; }
+  /// @brief 创建索引时B+树页面的填充比例
+  int index_build_fill_percent() const { return index_build_fill_percent_; }
+
   oceanbase::ObLsm *lsm() { return lsm_; }
 
 private:
   /// @brief 打开所有的表。在数据库初始化的时候会执行
   RC open_all_tables();
-  /// @brief 恢复数据。在数据库初始化的时候运行。
-  RC recover();
+  /**
+   * @brief 恢复数据。在数据库初始化的时候运行。
+   * @param thread_num 并行回放页面日志的线程数，不大于1时串行回放
+   */
+  RC recover(int thread_num);
 
   /// @brief 初始化元数据。在数据库初始化的时候，加载元数据
   RC init_meta();
@@ -118,6 +144,11 @@ private:
   /// @brief 初始化数据库的double buffer pool
   RC init_dblwr_buffer();
 
+  /// @brief 启动后台定期做检查点的线程
+  RC start_checkpoint_thread(int interval_ms);
+  void stop_checkpoint_thread();
+  void checkpoint_thread_func(int interval_ms);
+
   StorageEngine get_storage_engine()
   {
     StorageEngine engine = StorageEngine::UNKNOWN_ENGINE;
@@ -147,4 +178,16 @@ private:
 
   LSN    check_point_lsn_ = 0;  ///< 当前数据库的检查点LSN。会记录到磁盘中。
   string storage_engine_;
+  int    pax_page_size_ = BP_PAGE_SIZE;
+
+  int64_t index_build_sort_buffer_size_ = 64 * 1024 * 1024;
+  int     index_build_fill_percent_     = 90;
+
+  mutex checkpoint_lock_;                   ///< sync 和 checkpoint 不能同时修改检查点
+  LSN   last_checkpoint_current_lsn_ = -1;  ///< 上一次做检查点时的最新LSN，-1表示还没有做过
+
+  mutex              checkpoint_thread_lock_;
+  condition_variable checkpoint_cond_;
+  bool               checkpoint_running_ = false;
+  unique_ptr<thread> checkpoint_thread_;  ///< 后台定期做检查点的线程
 };
@@ -15,6 +15,7 @@ See the Mulan PSL v2 for more details. */
 
 #include "storage/index/bplus_tree.h"
 #include "common/lang/lower_bound.h"
+#include "common/lang/limits.h"
 #include "common/log/log.h"
 #include "common/global_context.h"
 #include "sql/parser/parse_defs.h"
@@ -29,17 +30,17 @@ using namespace common;
  */
 #define FIRST_INDEX_PAGE 1
 
-int calc_internal_page_capacity(int attr_length)
+int calc_internal_page_capacity(int key_length, int page_data_size)
 {
-  int item_size = attr_length + sizeof(RID) + sizeof(PageNum);
-  int capacity  = ((int)BP_PAGE_DATA_SIZE - InternalIndexNode::HEADER_SIZE) / item_size;
+  int item_size = key_length + sizeof(PageNum);
+  int capacity  = (page_data_size - InternalIndexNode::HEADER_SIZE) / item_size;
   return capacity;
 }
 
-int calc_leaf_page_capacity(int attr_length)
+int calc_leaf_page_capacity(int key_length, int page_data_size)
 {
-  int item_size = attr_length + sizeof(RID) + sizeof(RID);
-  int capacity  = ((int)BP_PAGE_DATA_SIZE - LeafIndexNode::HEADER_SIZE) / item_size;
+  int item_size = key_length + sizeof(RID);
+  int capacity  = (page_data_size - LeafIndexNode::HEADER_SIZE) / item_size;
   return capacity;
 }
 
@@ -228,7 +229,8 @@ int LeafIndexNodeHandler::lookup(const KeyComparator &comparator, const char *ke
   const int                    size = this->size();
   common::BinaryIterator<char> iter_begin(item_size(), __key_at(0));
   common::BinaryIterator<char> iter_end(item_size(), __key_at(size));
-  common::BinaryIterator<char> iter = lower_bound(iter_begin, iter_end, key, comparator, found);
+  common::BinaryIterator<char> iter = comparator.visit(
+      [&](const auto &typed_comparator) { return lower_bound(iter_begin, iter_end, key, typed_comparator, found); });
   return iter - iter_begin;
 }
 
@@ -527,7 +529,8 @@ int InternalIndexNodeHandler::lookup(const KeyComparator &comparator, const char
 
   common::BinaryIterator<char> iter_begin(item_size(), __key_at(1));
   common::BinaryIterator<char> iter_end(item_size(), __key_at(size));
-  common::BinaryIterator<char> iter = lower_bound(iter_begin, iter_end, key, comparator, found);
+  common::BinaryIterator<char> iter = comparator.visit(
+      [&](const auto &typed_comparator) { return lower_bound(iter_begin, iter_end, key, typed_comparator, found); });
   int                          ret  = static_cast<int>(iter - iter_begin) + 1;
   if (insert_position) {
     *insert_position = ret;
@@ -800,6 +803,19 @@ RC BplusTreeHandler::create(LogHandler &log_handler,
                             int attr_length, 
                             int internal_max_size /* = -1*/,
                             int leaf_max_size /* = -1 */)
+{
+  return this->create(log_handler, bpm, file_name, vector<AttrType>{attr_type}, vector<int>{attr_length},
+      internal_max_size, leaf_max_size);
+}
+
+RC BplusTreeHandler::create(LogHandler &log_handler,
+                            BufferPoolManager &bpm,
+                            const char *file_name,
+                            const vector<AttrType> &attr_types,
+                            const vector<int> &attr_lengths,
+                            int internal_max_size /* = -1*/,
+                            int leaf_max_size /* = -1 */,
+                            bool unique /* = false */)
 {
   RC rc = bpm.create_file(file_name);
   if (OB_FAIL(rc)) {
@@ -817,7 +833,7 @@ RC BplusTreeHandler::create(LogHandler &log_handler,
   }
   LOG_INFO("Successfully open index file %s.", file_name);
 
-  rc = this->create(log_handler, *bp, attr_type, attr_length, internal_max_size, leaf_max_size);
+  rc = this->create(log_handler, *bp, attr_types, attr_lengths, internal_max_size, leaf_max_size, unique);
   if (OB_FAIL(rc)) {
     bpm.close_file(file_name);
     return rc;
@@ -834,11 +850,42 @@ RC BplusTreeHandler::create(LogHandler &log_handler,
             int internal_max_size /* = -1 */,
             int leaf_max_size /* = -1 */)
 {
+  return this->create(log_handler, buffer_pool, vector<AttrType>{attr_type}, vector<int>{attr_length},
+      internal_max_size, leaf_max_size);
+}
+
+RC BplusTreeHandler::create(LogHandler &log_handler,
+            DiskBufferPool &buffer_pool,
+            const vector<AttrType> &attr_types,
+            const vector<int> &attr_lengths,
+            int internal_max_size /* = -1 */,
+            int leaf_max_size /* = -1 */,
+            bool unique /* = false */)
+{
+  const int field_num = static_cast<int>(attr_types.size());
+  if (field_num == 0 || field_num > MAX_INDEX_FIELD_NUM || attr_lengths.size() != attr_types.size()) {
+    LOG_WARN("invalid index fields. field num=%d, max=%d", field_num, MAX_INDEX_FIELD_NUM);
+    return RC::INVALID_ARGUMENT;
+  }
+
+  int attr_length = 0;
+  for (int i = 0; i < field_num; i++) {
+    // 组合索引做前缀扫描时需要用类型的最小值、最大值补齐后面的字段
+    if (field_num > 1 && attr_types[i] != AttrType::INTS && attr_types[i] != AttrType::FLOATS &&
+        attr_types[i] != AttrType::CHARS) {
+      LOG_WARN("unsupported field type of composite index. type=%s", attr_type_to_string(attr_types[i]));
+      return RC::UNSUPPORTED;
+    }
+    attr_length += attr_lengths[i];
+  }
+
+  // 唯一索引的属性值不会重复，不需要在键值后面追加RID
+  const int key_length = unique ? attr_length : attr_length + static_cast<int>(sizeof(RID));
   if (internal_max_size < 0) {
-    internal_max_size = calc_internal_page_capacity(attr_length);
+    internal_max_size = calc_internal_page_capacity(key_length, buffer_pool.page_data_size());
   }
   if (leaf_max_size < 0) {
-    leaf_max_size = calc_leaf_page_capacity(attr_length);
+    leaf_max_size = calc_leaf_page_capacity(key_length, buffer_pool.page_data_size());
   }
 
   log_handler_      = &log_handler;
@@ -865,8 +912,14 @@ RC BplusTreeHandler::create(LogHandler &log_handler,
   char            *pdata         = header_frame->data();
   IndexFileHeader *file_header   = (IndexFileHeader *)pdata;
   file_header->attr_length       = attr_length;
-  file_header->key_length        = attr_length + sizeof(RID);
-  file_header->attr_type         = attr_type;
+  file_header->key_length        = key_length;
+  file_header->attr_type         = attr_types[0];
+  file_header->field_num         = field_num;
+  file_header->unique            = unique ? 1 : 0;
+  for (int i = 0; i < field_num; i++) {
+    file_header->field_types[i]   = attr_types[i];
+    file_header->field_lengths[i] = attr_lengths[i];
+  }
   file_header->internal_max_size = internal_max_size;
   file_header->leaf_max_size     = leaf_max_size;
   file_header->root_page         = BP_INVALID_PAGE_NUM;
@@ -886,8 +939,7 @@ RC BplusTreeHandler::create(LogHandler &log_handler,
     return RC::NOMEM;
   }
 
-  key_comparator_.init(file_header->attr_type, file_header->attr_length);
-  key_printer_.init(file_header->attr_type, file_header->attr_length);
+  init_key_comparator();
 
   /*
   虽然我们针对B+树记录了WAL，但是我们记录的都是逻辑日志，并没有记录某个页面如何修改的物理日志。
@@ -958,8 +1010,7 @@ RC BplusTreeHandler::open(LogHandler &log_handler, DiskBufferPool &buffer_pool)
   // close old page_handle
   buffer_pool.unpin_page(frame);
 
-  key_comparator_.init(file_header_.attr_type, file_header_.attr_length);
-  key_printer_.init(file_header_.attr_type, file_header_.attr_length);
+  init_key_comparator();
   LOG_INFO("Successfully open index");
   return RC::SUCCESS;
 }
@@ -1437,8 +1488,7 @@ RC BplusTreeHandler::recover_init_header_page(BplusTreeMiniTransaction &mtr, Fra
   header_dirty_ = false;
   frame->mark_dirty();
 
-  key_comparator_.init(file_header_.attr_type, file_header_.attr_length);
-  key_printer_.init(file_header_.attr_type, file_header_.attr_length);
+  init_key_comparator();
 
   return RC::SUCCESS;
 }
@@ -1484,6 +1534,19 @@ RC BplusTreeHandler::create_new_tree(BplusTreeMiniTransaction &mtr, const char *
   return rc;
 }
 
+void BplusTreeHandler::init_key_comparator()
+{
+  if (file_header_.field_num <= 0) {
+    file_header_.field_num        = 1;
+    file_header_.field_types[0]   = file_header_.attr_type;
+    file_header_.field_lengths[0] = file_header_.attr_length;
+  }
+
+  const bool unique = file_header_.unique != 0;
+  key_comparator_.init(file_header_.field_types, file_header_.field_lengths, file_header_.field_num, unique);
+  key_printer_.init(file_header_.field_types, file_header_.field_lengths, file_header_.field_num, unique);
+}
+
 MemPoolItem::item_unique_ptr BplusTreeHandler::make_key(const char *user_key, const RID &rid)
 {
   MemPoolItem::item_unique_ptr key = mem_pool_item_->alloc_unique_ptr();
@@ -1492,7 +1555,9 @@ MemPoolItem::item_unique_ptr BplusTreeHandler::make_key(const char *user_key, co
     return nullptr;
   }
   memcpy(static_cast<char *>(key.get()), user_key, file_header_.attr_length);
-  memcpy(static_cast<char *>(key.get()) + file_header_.attr_length, &rid, sizeof(rid));
+  if (!file_header_.unique) {
+    memcpy(static_cast<char *>(key.get()) + file_header_.attr_length, &rid, sizeof(rid));
+  }
   return key;
 }
 
@@ -1762,16 +1827,25 @@ RC BplusTreeHandler::redistribute(BplusTreeMiniTransaction &mtr, Frame *neighbor
   return RC::SUCCESS;
 }
 
-RC BplusTreeHandler::delete_entry_internal(BplusTreeMiniTransaction &mtr, Frame *leaf_frame, const char *key)
+RC BplusTreeHandler::delete_entry_internal(
+    BplusTreeMiniTransaction &mtr, Frame *leaf_frame, const char *key, const RID &rid)
 {
   LeafIndexNodeHandler leaf_index_node(mtr, file_header_, leaf_frame);
 
-  const int remove_count = leaf_index_node.remove(key, key_comparator_);
-  if (remove_count == 0) {
+  bool      found = false;
+  const int index = leaf_index_node.lookup(key_comparator_, key, &found);
+  // 唯一索引的键值中没有RID，相同的键值可能指向其它记录
+  if (!found || (file_header_.unique && memcmp(leaf_index_node.value_at(index), &rid, sizeof(rid)) != 0)) {
     LOG_TRACE("no data need to remove");
     // disk_buffer_pool_->unpin_page(leaf_frame);
     return RC::RECORD_NOT_EXIST;
   }
+
+  RC rc = leaf_index_node.remove(index);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to remove item from leaf node. rc=%s", strrc(rc));
+    return rc;
+  }
   // leaf_index_node.validate(key_comparator_, disk_buffer_pool_, file_id_);
 
   leaf_frame->mark_dirty();
@@ -1793,7 +1867,9 @@ RC BplusTreeHandler::delete_entry(const char *user_key, const RID *rid)
   char *key = static_cast<char *>(pkey.get());
 
   memcpy(key, user_key, file_header_.attr_length);
-  memcpy(key + file_header_.attr_length, rid, sizeof(*rid));
+  if (!file_header_.unique) {
+    memcpy(key + file_header_.attr_length, rid, sizeof(*rid));
+  }
 
   BplusTreeOperationType op = BplusTreeOperationType::DELETE;
 
@@ -1814,7 +1890,7 @@ RC BplusTreeHandler::delete_entry(const char *user_key, const RID *rid)
     return rc;
   }
 
-  rc = delete_entry_internal(mtr, leaf_frame, key);
+  rc = delete_entry_internal(mtr, leaf_frame, key, *rid);
   return rc;
 }
 
@@ -1835,13 +1911,23 @@ RC BplusTreeScanner::open(const char *left_user_key, int left_len, bool left_inc
     return RC::INTERNAL;
   }
 
-  inited_        = true;
-  first_emitted_ = false;
+  inited_          = true;
+  first_emitted_   = false;
+  point_lookup_    = false;
+  right_inclusive_ = right_inclusive;
 
   LatchMemo &latch_memo = mtr_.latch_memo();
 
+  const IndexFileHeader &file_header = tree_handler_.file_header_;
+  const bool             composite   = file_header.field_num > 1;
+  const bool             unique      = file_header.unique != 0;
+
+  MemPoolItem::item_unique_ptr left_pkey;
+
   // 校验输入的键值是否是合法范围
-  if (left_user_key && right_user_key) {
+  // 组合索引的前缀键值不能直接比较，范围不合法时扫描结果为空
+  const bool full_key = !composite || (left_len == file_header.attr_length && right_len == file_header.attr_length);
+  if (left_user_key && right_user_key && full_key) {
     const auto &attr_comparator = tree_handler_.key_comparator_.attr_comparator();
     const int   result          = attr_comparator(left_user_key, right_user_key);
     if (result > 0 ||  // left < right
@@ -1867,7 +1953,14 @@ RC BplusTreeScanner::open(const char *left_user_key, int left_len, bool left_inc
   } else {
 
     char *fixed_left_key = const_cast<char *>(left_user_key);
-    if (tree_handler_.file_header_.attr_type == AttrType::CHARS) {
+    if (composite) {
+      // 不包含左边界时，跳过所有前缀相同的键值
+      rc = fix_prefix_key(left_user_key, left_len, !left_inclusive /*fill_max*/, &fixed_left_key);
+      if (OB_FAIL(rc)) {
+        LOG_WARN("failed to fix left prefix key. rc=%s", strrc(rc));
+        return rc;
+      }
+    } else if (tree_handler_.file_header_.attr_type == AttrType::CHARS) {
       bool should_inclusive_after_fix = false;
       rc = fix_user_key(left_user_key, left_len, true /*greater*/, &fixed_left_key, &should_inclusive_after_fix);
       if (OB_FAIL(rc)) {
@@ -1880,7 +1973,6 @@ RC BplusTreeScanner::open(const char *left_user_key, int left_len, bool left_inc
       }
     }
 
-    MemPoolItem::item_unique_ptr left_pkey;
     if (left_inclusive) {
       left_pkey = tree_handler_.make_key(fixed_left_key, *RID::min());
     } else {
@@ -1905,7 +1997,12 @@ RC BplusTreeScanner::open(const char *left_user_key, int left_len, bool left_inc
     }
 
     LeafIndexNodeHandler left_node(mtr_, tree_handler_.file_header_, current_frame_);
-    int                  left_index = left_node.lookup(tree_handler_.key_comparator_, left_key);
+    bool                 left_found = false;
+    int                  left_index = left_node.lookup(tree_handler_.key_comparator_, left_key, &left_found);
+    // 唯一索引的键值中没有RID，不包含左边界时需要跳过相同的键值
+    if (unique && left_found && !left_inclusive) {
+      left_index++;
+    }
     // lookup 返回的是适合插入的位置，还需要判断一下是否在合适的边界范围内
     if (left_index >= left_node.size()) {  // 超出了当前页，就需要向后移动一个位置
       const PageNum next_page_num = left_node.next_page();
@@ -1934,7 +2031,13 @@ RC BplusTreeScanner::open(const char *left_user_key, int left_len, bool left_inc
 
     char *fixed_right_key          = const_cast<char *>(right_user_key);
     bool  should_include_after_fix = false;
-    if (tree_handler_.file_header_.attr_type == AttrType::CHARS) {
+    if (composite) {
+      rc = fix_prefix_key(right_user_key, right_len, right_inclusive /*fill_max*/, &fixed_right_key);
+      if (OB_FAIL(rc)) {
+        LOG_WARN("failed to fix right prefix key. rc=%s", strrc(rc));
+        return rc;
+      }
+    } else if (tree_handler_.file_header_.attr_type == AttrType::CHARS) {
       rc = fix_user_key(right_user_key, right_len, false /*want_greater*/, &fixed_right_key, &should_include_after_fix);
       if (OB_FAIL(rc)) {
         LOG_WARN("failed to fix right user key. rc=%s", strrc(rc));
@@ -1945,6 +2048,7 @@ RC BplusTreeScanner::open(const char *left_user_key, int left_len, bool left_inc
         right_inclusive = true;
       }
     }
+    right_inclusive_ = right_inclusive;
     if (right_inclusive) {
       right_key_ = tree_handler_.make_key(fixed_right_key, *RID::max());
     } else {
@@ -1957,6 +2061,12 @@ RC BplusTreeScanner::open(const char *left_user_key, int left_len, bool left_inc
     }
   }
 
+  // 唯一索引上的等值查询最多只有一条数据，返回第一条之后就可以结束
+  if (unique && left_pkey != nullptr && right_key_ != nullptr && left_inclusive && right_inclusive_) {
+    point_lookup_ = tree_handler_.key_comparator_(
+                        static_cast<const char *>(left_pkey.get()), static_cast<const char *>(right_key_.get())) == 0;
+  }
+
   if (touch_end()) {
     current_frame_ = nullptr;
   }
@@ -1980,6 +2090,10 @@ bool BplusTreeScanner::touch_end()
 
   const char *this_key       = node.key_at(iter_index_);
   int         compare_result = tree_handler_.key_comparator_(this_key, static_cast<char *>(right_key_.get()));
+  // 唯一索引的右边界键值中没有RID，不包含右边界时遇到相同的键值就结束
+  if (tree_handler_.file_header_.unique && !right_inclusive_) {
+    return compare_result >= 0;
+  }
   return compare_result > 0;
 }
 
@@ -1995,6 +2109,10 @@ RC BplusTreeScanner::next_entry(RID &rid)
     return RC::SUCCESS;
   }
 
+  if (point_lookup_) {
+    return RC::RECORD_EOF;
+  }
+
   iter_index_++;
 
   LeafIndexNodeHandler node(mtr_, tree_handler_.file_header_, current_frame_);
@@ -2034,6 +2152,12 @@ RC BplusTreeScanner::next_entry(RID &rid)
 
   latch_memo.release_to(memo_point);
   iter_index_ = -1;  // `next` will add 1
+
+  // 叶子节点在文件中不一定是连续的，不能依赖顺序访问检测，直接预读下一个叶子节点
+  LeafIndexNodeHandler next_node(mtr_, tree_handler_.file_header_, current_frame_);
+  if (next_node.next_page() != BP_INVALID_PAGE_NUM) {
+    (void)tree_handler_.disk_buffer_pool_->read_ahead(next_node.next_page(), 1);
+  }
   return next_entry(rid);
 }
 
@@ -2094,3 +2218,54 @@ RC BplusTreeScanner::fix_user_key(
   *fixed_key = key_buf;
   return RC::SUCCESS;
 }
+
+RC BplusTreeScanner::fix_prefix_key(const char *user_key, int key_len, bool fill_max, char **fixed_key)
+{
+  const IndexFileHeader &file_header = tree_handler_.file_header_;
+  if (key_len == file_header.attr_length) {
+    *fixed_key = const_cast<char *>(user_key);
+    return RC::SUCCESS;
+  }
+
+  int prefix_len = 0;
+  int field_idx  = 0;
+  for (; field_idx < file_header.field_num && prefix_len < key_len; field_idx++) {
+    prefix_len += file_header.field_lengths[field_idx];
+  }
+  if (prefix_len != key_len) {
+    LOG_WARN("key length should be the length of a prefix of the index fields. key_len=%d", key_len);
+    return RC::INVALID_ARGUMENT;
+  }
+
+  char *key_buf = new char[file_header.attr_length];
+  memcpy(key_buf, user_key, key_len);
+
+  char *field_buf = key_buf + key_len;
+  for (; field_idx < file_header.field_num; field_idx++) {
+    const int field_len = file_header.field_lengths[field_idx];
+    switch (file_header.field_types[field_idx]) {
+      case AttrType::INTS: {
+        const int32_t bound = fill_max ? numeric_limits<int32_t>::max() : numeric_limits<int32_t>::min();
+        memcpy(field_buf, &bound, sizeof(bound));
+      } break;
+      case AttrType::FLOATS: {
+        const float bound = fill_max ? numeric_limits<float>::infinity() : -numeric_limits<float>::infinity();
+        memcpy(field_buf, &bound, sizeof(bound));
+      } break;
+      case AttrType::CHARS: {
+        // 字符串按照 unsigned char 比较，空串最小，全部是 0xFF 最大
+        memset(field_buf, fill_max ? 0xFF : 0, field_len);
+      } break;
+      default: {
+        LOG_WARN("unsupported field type of composite index. type=%s",
+            attr_type_to_string(file_header.field_types[field_idx]));
+        delete[] key_buf;
+        return RC::UNSUPPORTED;
+      }
+    }
+    field_buf += field_len;
+  }
+
+  *fixed_key = key_buf;
+  return RC::SUCCESS;
+}
@@ -19,10 +19,12 @@ See the Mulan PSL v2 for more details. */
 
 #include <string.h>
 
+#include "common/defs.h"
 #include "common/lang/comparator.h"
 #include "common/lang/memory.h"
 #include "common/lang/sstream.h"
 #include "common/lang/functional.h"
+#include "common/lang/vector.h"
 #include "common/log/log.h"
 #include "sql/parser/parse_defs.h"
 #include "storage/buffer/disk_buffer_pool.h"
@@ -49,54 +51,204 @@ enum class BplusTreeOperationType
   DELETE,
 };
 
+/**
+ * @brief 按照类型特化的属性比较
+ * @ingroup BPlusTree
+ * @details 直接比较键值的内存，不需要构造 Value，也没有虚函数调用。比较的语义与对应 DataType::compare 相同。
+ * 没有特化的类型使用 DataType::compare。
+ */
+template <AttrType TYPE>
+struct TypedAttrCompare
+{
+  static int compare(const char *v1, const char *v2, int attr_length)
+  {
+    Value left;
+    left.set_type(TYPE);
+    left.set_data(v1, attr_length);
+    Value right;
+    right.set_type(TYPE);
+    right.set_data(v2, attr_length);
+    return DataType::type_instance(TYPE)->compare(left, right);
+  }
+};
+
+template <>
+struct TypedAttrCompare<AttrType::INTS>
+{
+  static int compare(const char *v1, const char *v2, int /*attr_length*/)
+  {
+    int32_t left;
+    int32_t right;
+    memcpy(&left, v1, sizeof(left));
+    memcpy(&right, v2, sizeof(right));
+    return (left > right) - (left < right);
+  }
+};
+
+template <>
+struct TypedAttrCompare<AttrType::FLOATS>
+{
+  static int compare(const char *v1, const char *v2, int /*attr_length*/)
+  {
+    float left;
+    float right;
+    memcpy(&left, v1, sizeof(left));
+    memcpy(&right, v2, sizeof(right));
+    // 与 common::compare_float 一样，差值在 EPSILON 之内认为相等
+    const float cmp = left - right;
+    if (cmp > EPSILON) {
+      return 1;
+    }
+    if (cmp < -EPSILON) {
+      return -1;
+    }
+    return 0;
+  }
+};
+
+template <>
+struct TypedAttrCompare<AttrType::CHARS>
+{
+  static int compare(const char *v1, const char *v2, int attr_length)
+  {
+    // 字符串以 '\0' 结束或者占满整个字段，与 common::compare_string 的结果相同
+    const int result = strncmp(v1, v2, attr_length);
+    return (result > 0) - (result < 0);
+  }
+};
+
+/**
+ * @brief 组合索引最多包含的字段个数
+ * @ingroup BPlusTree
+ */
+static constexpr int MAX_INDEX_FIELD_NUM = 8;
+
 /**
  * @brief 属性比较(BplusTree)
  * @ingroup BPlusTree
+ * @details 初始化时根据类型选择一个比较函数，之后每次比较不再判断类型。
+ * 组合索引的属性由多个字段的值依次拼接而成，按照字段的顺序逐个比较，因此拼接后的键值与字段值的字典序一致。
  */
 class AttrComparator
 {
 public:
-  void init(AttrType type, int length)
+  using CompareFunc = int (*)(const char *v1, const char *v2, int attr_length);
+
+  void init(AttrType type, int length) { init(&type, &length, 1); }
+
+  void init(const AttrType *types, const int *lengths, int field_num)
   {
-    attr_type_   = type;
-    attr_length_ = length;
+    ASSERT(field_num > 0 && field_num <= MAX_INDEX_FIELD_NUM, "invalid field num %d", field_num);
+    field_num_   = field_num;
+    attr_length_ = 0;
+    for (int i = 0; i < field_num; i++) {
+      fields_[i].type         = types[i];
+      fields_[i].offset       = attr_length_;
+      fields_[i].length       = lengths[i];
+      fields_[i].compare_func = compare_func_of(types[i]);
+      attr_length_ += lengths[i];
+    }
   }
 
-  int attr_length() const { return attr_length_; }
+  /// 第一个字段的类型。单字段索引就是索引字段的类型
+  AttrType attr_type() const { return fields_[0].type; }
+  int      attr_length() const { return attr_length_; }
+  int      field_num() const { return field_num_; }
 
   int operator()(const char *v1, const char *v2) const
   {
-    // TODO: optimized the comparison
-    Value left;
-    left.set_type(attr_type_);
-    left.set_data(v1, attr_length_);
-    Value right;
-    right.set_type(attr_type_);
-    right.set_data(v2, attr_length_);
-    return DataType::type_instance(attr_type_)->compare(left, right);
+    if (field_num_ == 1) {
+      return fields_[0].compare_func(v1, v2, attr_length_);
+    }
+
+    for (int i = 0; i < field_num_; i++) {
+      const FieldInfo &field  = fields_[i];
+      const int        result = field.compare_func(v1 + field.offset, v2 + field.offset, field.length);
+      if (result != 0) {
+        return result;
+      }
+    }
+    return 0;
+  }
+
+private:
+  static CompareFunc compare_func_of(AttrType type)
+  {
+    switch (type) {
+      case AttrType::INTS: return &TypedAttrCompare<AttrType::INTS>::compare;
+      case AttrType::FLOATS: return &TypedAttrCompare<AttrType::FLOATS>::compare;
+      case AttrType::CHARS: return &TypedAttrCompare<AttrType::CHARS>::compare;
+      case AttrType::VECTORS: return &TypedAttrCompare<AttrType::VECTORS>::compare;
+      case AttrType::BOOLEANS: return &TypedAttrCompare<AttrType::BOOLEANS>::compare;
+      default: return nullptr;
+    }
+  }
+
+private:
+  struct FieldInfo
+  {
+    AttrType    type         = AttrType::UNDEFINED;
+    int         offset       = 0;  ///< 字段在键值中的偏移
+    int         length       = 0;
+    CompareFunc compare_func = nullptr;
+  };
+
+  FieldInfo fields_[MAX_INDEX_FIELD_NUM];
+  int       field_num_   = 0;
+  int       attr_length_ = 0;
+};
+
+/**
+ * @brief 按照类型特化的键值比较，比较函数可以内联到二分查找中
+ * @ingroup BPlusTree
+ */
+template <AttrType TYPE>
+class TypedKeyComparator
+{
+public:
+  TypedKeyComparator(int attr_length, bool unique) : attr_length_(attr_length), unique_(unique) {}
+
+  int operator()(const char *v1, const char *v2) const
+  {
+    int result = TypedAttrCompare<TYPE>::compare(v1, v2, attr_length_);
+    if (result != 0 || unique_) {
+      return result;
+    }
+
+    const RID *rid1 = (const RID *)(v1 + attr_length_);
+    const RID *rid2 = (const RID *)(v2 + attr_length_);
+    return RID::compare(rid1, rid2);
   }
 
 private:
-  AttrType attr_type_;
-  int      attr_length_;
+  int  attr_length_;
+  bool unique_;
 };
 
 /**
  * @brief 键值比较(BplusTree)
  * @details BplusTree的键值除了字段属性，还有RID，是为了避免属性值重复而增加的。
+ * 唯一索引的属性值本身不会重复，键值中没有RID。
+ * 大量比较的地方(比如节点内的二分查找)可以使用 visit，得到按照类型特化的比较器。
  * @ingroup BPlusTree
  */
 class KeyComparator
 {
 public:
   void init(AttrType type, int length) { attr_comparator_.init(type, length); }
+  void init(const AttrType *types, const int *lengths, int field_num, bool unique = false)
+  {
+    attr_comparator_.init(types, lengths, field_num);
+    unique_ = unique;
+  }
 
   const AttrComparator &attr_comparator() const { return attr_comparator_; }
+  bool                  unique() const { return unique_; }
 
   int operator()(const char *v1, const char *v2) const
   {
     int result = attr_comparator_(v1, v2);
-    if (result != 0) {
+    if (result != 0 || unique_) {
       return result;
     }
 
@@ -105,8 +257,28 @@ public:
     return RID::compare(rid1, rid2);
   }
 
+  /**
+   * @brief 使用按照类型特化的比较器调用 func，没有特化的类型和组合索引使用当前比较器
+   */
+  template <typename Func>
+  auto visit(Func &&func) const
+  {
+    if (attr_comparator_.field_num() != 1) {
+      return func(*this);
+    }
+
+    const int attr_length = attr_comparator_.attr_length();
+    switch (attr_comparator_.attr_type()) {
+      case AttrType::INTS: return func(TypedKeyComparator<AttrType::INTS>(attr_length, unique_));
+      case AttrType::FLOATS: return func(TypedKeyComparator<AttrType::FLOATS>(attr_length, unique_));
+      case AttrType::CHARS: return func(TypedKeyComparator<AttrType::CHARS>(attr_length, unique_));
+      default: return func(*this);
+    }
+  }
+
 private:
   AttrComparator attr_comparator_;
+  bool           unique_ = false;
 };
 
 /**
@@ -116,23 +288,45 @@ private:
 class AttrPrinter
 {
 public:
-  void init(AttrType type, int length)
+  void init(AttrType type, int length) { init(&type, &length, 1); }
+
+  void init(const AttrType *types, const int *lengths, int field_num)
   {
-    attr_type_   = type;
-    attr_length_ = length;
+    field_num_   = field_num;
+    attr_length_ = 0;
+    for (int i = 0; i < field_num; i++) {
+      attr_types_[i]   = types[i];
+      attr_lengths_[i] = lengths[i];
+      attr_length_ += lengths[i];
+    }
   }
 
   int attr_length() const { return attr_length_; }
 
   string operator()(const char *v) const
   {
-    Value value(attr_type_, const_cast<char *>(v), attr_length_);
-    return value.to_string();
+    if (field_num_ == 1) {
+      Value value(attr_types_[0], const_cast<char *>(v), attr_length_);
+      return value.to_string();
+    }
+
+    string result = "(";
+    for (int i = 0, offset = 0; i < field_num_; offset += attr_lengths_[i], i++) {
+      Value value(attr_types_[i], const_cast<char *>(v + offset), attr_lengths_[i]);
+      if (i > 0) {
+        result += ",";
+      }
+      result += value.to_string();
+    }
+    result += ")";
+    return result;
   }
 
 private:
-  AttrType attr_type_;
-  int      attr_length_;
+  AttrType attr_types_[MAX_INDEX_FIELD_NUM];
+  int      attr_lengths_[MAX_INDEX_FIELD_NUM];
+  int      field_num_   = 0;
+  int      attr_length_ = 0;
 };
 
 /**
@@ -143,28 +337,40 @@ class KeyPrinter
 {
 public:
   void init(AttrType type, int length) { attr_printer_.init(type, length); }
+  void init(const AttrType *types, const int *lengths, int field_num, bool unique = false)
+  {
+    attr_printer_.init(types, lengths, field_num);
+    unique_ = unique;
+  }
 
   const AttrPrinter &attr_printer() const { return attr_printer_; }
 
   string operator()(const char *v) const
   {
     stringstream ss;
-    ss << "{key:" << attr_printer_(v) << ",";
+    ss << "{key:" << attr_printer_(v);
+    if (unique_) {
+      ss << "}";
+      return ss.str();
+    }
 
     const RID *rid = (const RID *)(v + attr_printer_.attr_length());
-    ss << "rid:{" << rid->to_string() << "}}";
+    ss << ",rid:{" << rid->to_string() << "}}";
     return ss.str();
   }
 
 private:
   AttrPrinter attr_printer_;
+  bool        unique_ = false;
 };
 
 /**
  * @brief the meta information of bplus tree
  * @ingroup BPlusTree
  * @details this is the first page of bplus tree.
- * only one field can be supported, can you extend it to multi-fields?
+ * 组合索引的键值是各个字段的值按照顺序拼接起来的，attr_length 是所有字段长度之和，attr_type 是第一个字段的类型。
+ * 旧版本的索引文件 field_num 是 0，表示只有一个字段(attr_type, attr_length)。
+ * 唯一索引的键值就是属性值，key_length 等于 attr_length。
  */
 struct IndexFileHeader
 {
@@ -177,8 +383,12 @@ struct IndexFileHeader
   int32_t  internal_max_size;  ///< 内部节点最大的键值对数
   int32_t  leaf_max_size;      ///< 叶子节点最大的键值对数
   int32_t  attr_length;        ///< 键值的长度
-  int32_t  key_length;         ///< attr length + sizeof(RID)
+  int32_t  key_length;         ///< attr length + sizeof(RID)，唯一索引是 attr length
   AttrType attr_type;          ///< 键值的类型
+  int32_t  field_num;          ///< 键值包含的字段个数
+  AttrType field_types[MAX_INDEX_FIELD_NUM];    ///< 每个字段的类型
+  int32_t  field_lengths[MAX_INDEX_FIELD_NUM];  ///< 每个字段的长度
+  int32_t  unique;                              ///< 是否是唯一索引
 
   const string to_string() const
   {
@@ -187,6 +397,8 @@ struct IndexFileHeader
     ss << "attr_length:" << attr_length << ","
        << "key_length:" << key_length << ","
        << "attr_type:" << attr_type_to_string(attr_type) << ","
+       << "field_num:" << field_num << ","
+       << "unique:" << unique << ","
        << "root_page:" << root_page << ","
        << "internal_max_size:" << internal_max_size << ","
        << "leaf_max_size:" << leaf_max_size << ";";
@@ -374,6 +586,8 @@ protected:
   RC preappend(const char *item);
 
 private:
+  friend class BplusTreeBulkLoader;
+
   LeafIndexNode *leaf_node_ = nullptr;
 };
 
@@ -439,6 +653,8 @@ private:
   int item_size() const override;
 
 private:
+  friend class BplusTreeBulkLoader;
+
   InternalIndexNode *internal_node_ = nullptr;
 };
 
@@ -464,6 +680,18 @@ public:
   RC create(LogHandler &log_handler, DiskBufferPool &buffer_pool, AttrType attr_type, int attr_length,
       int internal_max_size = -1, int leaf_max_size = -1);
 
+  /**
+   * @brief 创建一个组合键的B+树
+   * @details 键值是各个字段的值按照顺序拼接起来的，比较时按照字段顺序逐个比较
+   * @param attr_types 每个字段的类型
+   * @param attr_lengths 每个字段的长度
+   * @param unique 是否是唯一索引。唯一索引的键值中不包含RID，插入重复的键值会返回 RECORD_DUPLICATE_KEY
+   */
+  RC create(LogHandler &log_handler, BufferPoolManager &bpm, const char *file_name, const vector<AttrType> &attr_types,
+      const vector<int> &attr_lengths, int internal_max_size = -1, int leaf_max_size = -1, bool unique = false);
+  RC create(LogHandler &log_handler, DiskBufferPool &buffer_pool, const vector<AttrType> &attr_types,
+      const vector<int> &attr_lengths, int internal_max_size = -1, int leaf_max_size = -1, bool unique = false);
+
   /**
    * @brief 打开一个B+树
    * @param log_handler 记录日志
@@ -497,6 +725,7 @@ public:
 
   /**
    * @brief 获取指定值的record
+   * @details 组合索引可以只给出前面若干个字段的值，返回前缀相同的所有记录
    * @param key_len user_key的长度
    * @param rid  返回值，记录记录所在的页面号和slot
    */
@@ -576,8 +805,9 @@ protected:
 
   /**
    * @brief 从叶子节点中删除指定的键值对
+   * @details 唯一索引的键值中没有RID，需要确认叶子节点中记录的RID与 rid 相同才能删除
    */
-  RC delete_entry_internal(BplusTreeMiniTransaction &mtr, Frame *leaf_frame, const char *key);
+  RC delete_entry_internal(BplusTreeMiniTransaction &mtr, Frame *leaf_frame, const char *key, const RID &rid);
 
   /**
    * @brief 拆分节点
@@ -635,6 +865,12 @@ protected:
 private:
   common::MemPoolItem::item_unique_ptr make_key(const char *user_key, const RID &rid);
 
+  /**
+   * @brief 根据文件头初始化键值比较器和打印器
+   * @details 旧版本的索引文件没有记录字段信息，这里补上
+   */
+  void init_key_comparator();
+
 protected:
   LogHandler     *log_handler_      = nullptr;  /// 日志处理器
   DiskBufferPool *disk_buffer_pool_ = nullptr;  /// 磁盘缓冲池
@@ -652,6 +888,7 @@ protected:
 
 private:
   friend class BplusTreeScanner;
+  friend class BplusTreeBulkLoader;
   friend class BplusTreeTester;
 };
 
@@ -667,8 +904,8 @@ public:
 
   /**
    * @brief 扫描指定范围的数据
-   * @param left_user_key 扫描范围的左边界，如果是null，则没有左边界
-   * @param left_len left_user_key 的内存大小(只有在变长字段中才会关注)
+   * @param left_user_key 扫描范围的左边界，如果是null，则没有左边界。组合索引可以只给出前面若干个字段的值
+   * @param left_len left_user_key 的内存大小(变长字段和组合索引的前缀才会关注)
    * @param left_inclusive 左边界的值是否包含在内
    * @param right_user_key 扫描范围的右边界。如果是null，则没有右边界
    * @param right_len right_user_key 的内存大小(只有在变长字段中才会关注)
@@ -701,6 +938,13 @@ private:
    */
   RC fix_user_key(const char *user_key, int key_len, bool want_greater, char **fixed_key, bool *should_inclusive);
 
+  /**
+   * @brief 组合索引的前缀键值，使用最小值或最大值补齐剩下的字段
+   * @details key_len 必须是前面若干个字段长度之和
+   * @param fill_max 使用最大值补齐还是最小值补齐
+   */
+  RC fix_prefix_key(const char *user_key, int key_len, bool fill_max, char **fixed_key);
+
   void fetch_item(RID &rid);
 
   /**
@@ -718,6 +962,8 @@ private:
   Frame *current_frame_ = nullptr;
 
   common::MemPoolItem::item_unique_ptr right_key_;
-  int                                  iter_index_    = -1;
-  bool                                 first_emitted_ = false;
+  bool                                 right_inclusive_ = false;  ///< 唯一索引的右边界键值中没有RID，需要单独记录
+  int                                  iter_index_      = -1;
+  bool                                 first_emitted_   = false;
+  bool                                 point_lookup_    = false;  ///< 唯一索引的等值查询，最多只有一条数据
 };
@@ -0,0 +1,381 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "storage/index/bplus_tree_bulk_loader.h"
+#include "common/lang/algorithm.h"
+#include "common/lang/filesystem.h"
+#include "common/lang/fstream.h"
+#include "common/lang/ios.h"
+#include "common/lang/limits.h"
+#include "common/lang/memory.h"
+#include "common/lang/queue.h"
+#include "common/lang/system_error.h"
+#include "common/log/log.h"
+
+BplusTreeBulkLoader::BplusTreeBulkLoader(
+    BplusTreeHandler &tree_handler, const string &tmp_file_prefix, int64_t sort_buffer_size, int fill_percent)
+    : tree_handler_(tree_handler), tmp_file_prefix_(tmp_file_prefix), fill_percent_(fill_percent)
+{
+  const IndexFileHeader &header = tree_handler_.file_header();
+  entry_comparator_.init(header.field_types, header.field_lengths, header.field_num, false /*unique*/);
+  entry_size_ = header.attr_length + static_cast<int>(sizeof(RID));
+
+  // 每条数据除了本身的内存，排序时还需要一个指针
+  const int64_t max_entries = sort_buffer_size / (entry_size_ + static_cast<int64_t>(sizeof(const char *)));
+  max_entries_              = static_cast<int>(std::clamp<int64_t>(max_entries, 2, numeric_limits<int>::max()));
+
+  init_level(leaf_level_, true /*leaf*/);
+}
+
+BplusTreeBulkLoader::~BplusTreeBulkLoader() { remove_run_files(); }
+
+void BplusTreeBulkLoader::init_level(Level &level, bool leaf) const
+{
+  const IndexFileHeader &header = tree_handler_.file_header();
+
+  level.leaf      = leaf;
+  level.item_size = header.key_length + (leaf ? static_cast<int>(sizeof(RID)) : static_cast<int>(sizeof(PageNum)));
+  level.max_size  = leaf ? header.leaf_max_size : header.internal_max_size;
+
+  // 与 IndexNodeHandler::min_size 一致，除了最右边的节点，每个节点都不能少于最小元素个数
+  const int min_size = level.max_size - level.max_size / 2;
+  level.target       = std::clamp(level.max_size * fill_percent_ / 100, min_size, level.max_size);
+}
+
+RC BplusTreeBulkLoader::add(const char *user_key, const RID &rid)
+{
+  if (static_cast<int>(sorted_entries_.size()) >= max_entries_) {
+    RC rc = spill();
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+  }
+
+  const int    attr_length = tree_handler_.file_header().attr_length;
+  const size_t offset      = entries_.size();
+  if (offset + entry_size_ > entries_.capacity()) {
+    // 按需扩大缓冲区，最多容纳 max_entries_ 条数据。重新分配内存之后，前面记录的指针需要跟着调整
+    const char  *old_data    = entries_.data();
+    const size_t entry_num   = max<size_t>(sorted_entries_.size() * 2, INITIAL_ENTRY_NUM);
+    const size_t reserve_num = min<size_t>(entry_num, max_entries_);
+    entries_.reserve(reserve_num * entry_size_);
+    for (const char *&entry : sorted_entries_) {
+      entry = entries_.data() + (entry - old_data);
+    }
+  }
+
+  entries_.resize(offset + entry_size_);
+  memcpy(entries_.data() + offset, user_key, attr_length);
+  memcpy(entries_.data() + offset + attr_length, &rid, sizeof(rid));
+  sorted_entries_.push_back(entries_.data() + offset);
+  return RC::SUCCESS;
+}
+
+void BplusTreeBulkLoader::sort_entries()
+{
+  entry_comparator_.visit([this](const auto &comparator) {
+    sort(sorted_entries_.begin(), sorted_entries_.end(), [&comparator](const char *left, const char *right) {
+      return comparator(left, right) < 0;
+    });
+    return 0;
+  });
+}
+
+string BplusTreeBulkLoader::run_file_name(int index) const { return tmp_file_prefix_ + "." + std::to_string(index); }
+
+RC BplusTreeBulkLoader::spill()
+{
+  sort_entries();
+
+  const string file_name = run_file_name(run_num_);
+  ofstream     out(file_name, ios_base::out | ios_base::binary | ios_base::trunc);
+  if (!out.is_open()) {
+    LOG_WARN("failed to open sort file. file=%s, errmsg=%s", file_name.c_str(), strerror(errno));
+    return RC::IOERR_OPEN;
+  }
+  run_num_++;
+
+  for (const char *entry : sorted_entries_) {
+    out.write(entry, entry_size_);
+  }
+  out.close();
+  if (out.fail()) {
+    LOG_WARN("failed to write sort file. file=%s, errmsg=%s", file_name.c_str(), strerror(errno));
+    return RC::IOERR_WRITE;
+  }
+
+  LOG_INFO("spilled sorted entries to file. file=%s, entry num=%d", file_name.c_str(), static_cast<int>(sorted_entries_.size()));
+  entries_.clear();
+  sorted_entries_.clear();
+  return RC::SUCCESS;
+}
+
+RC BplusTreeBulkLoader::merge_runs(const function<RC(const char *)> &consumer)
+{
+  struct Run
+  {
+    ifstream     in;
+    vector<char> entry;
+  };
+
+  vector<unique_ptr<Run>> runs;
+  for (int i = 0; i < run_num_; i++) {
+    auto run = make_unique<Run>();
+    run->in.open(run_file_name(i), ios_base::in | ios_base::binary);
+    if (!run->in.is_open()) {
+      LOG_WARN("failed to open sort file. file=%s, errmsg=%s", run_file_name(i).c_str(), strerror(errno));
+      return RC::IOERR_OPEN;
+    }
+    run->entry.resize(entry_size_);
+    runs.push_back(std::move(run));
+  }
+
+  // 小顶堆，每次取出所有临时文件中最小的一条数据
+  auto greater = [this, &runs](int left, int right) {
+    return entry_comparator_(runs[left]->entry.data(), runs[right]->entry.data()) > 0;
+  };
+  priority_queue<int, vector<int>, decltype(greater)> heap(greater);
+
+  for (int i = 0; i < run_num_; i++) {
+    if (runs[i]->in.read(runs[i]->entry.data(), entry_size_)) {
+      heap.push(i);
+    }
+  }
+
+  RC rc = RC::SUCCESS;
+  while (!heap.empty()) {
+    const int index = heap.top();
+    heap.pop();
+
+    Run &run = *runs[index];
+    rc       = consumer(run.entry.data());
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+
+    if (run.in.read(run.entry.data(), entry_size_)) {
+      heap.push(index);
+    } else if (!run.in.eof()) {
+      LOG_WARN("failed to read sort file. file=%s", run_file_name(index).c_str());
+      return RC::IOERR_READ;
+    }
+  }
+  return rc;
+}
+
+void BplusTreeBulkLoader::remove_run_files()
+{
+  for (int i = 0; i < run_num_; i++) {
+    error_code ec;
+    filesystem::remove(run_file_name(i), ec);
+  }
+  run_num_ = 0;
+}
+
+RC BplusTreeBulkLoader::add_sorted_entry(const char *entry)
+{
+  const IndexFileHeader &header = tree_handler_.file_header();
+  if (header.unique) {
+    if (!last_entry_.empty() && entry_comparator_.attr_comparator()(last_entry_.data(), entry) == 0) {
+      LOG_TRACE("duplicate key found while bulk loading unique index");
+      return RC::RECORD_DUPLICATE_KEY;
+    }
+    last_entry_.assign(entry, entry + entry_size_);
+    // 唯一索引的键值就是属性值，数据正好是键值加上RID
+    return append_item(leaf_level_, entry);
+  }
+
+  // 普通索引的键值是属性值加上RID，后面还要再存放一个RID
+  item_buffer_.resize(leaf_level_.item_size);
+  memcpy(item_buffer_.data(), entry, entry_size_);
+  memcpy(item_buffer_.data() + entry_size_, entry + header.attr_length, sizeof(RID));
+  return append_item(leaf_level_, item_buffer_.data());
+}
+
+RC BplusTreeBulkLoader::append_item(Level &level, const char *item)
+{
+  level.pending.insert(level.pending.end(), item, item + level.item_size);
+
+  const int pending_num = static_cast<int>(level.pending.size()) / level.item_size;
+  if (pending_num < level.target * 2) {
+    return RC::SUCCESS;
+  }
+
+  RC rc = write_node(level, level.pending.data(), level.target);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+  level.pending.erase(level.pending.begin(), level.pending.begin() + static_cast<size_t>(level.target) * level.item_size);
+  return RC::SUCCESS;
+}
+
+RC BplusTreeBulkLoader::finish_level(Level &level)
+{
+  const int pending_num = static_cast<int>(level.pending.size()) / level.item_size;
+  if (pending_num == 0) {
+    return RC::SUCCESS;
+  }
+
+  // 剩下的数据放不到一个节点中，就平分成两个节点，两个节点都不会少于最小元素个数
+  RC rc = RC::SUCCESS;
+  if (pending_num <= level.max_size) {
+    rc = write_node(level, level.pending.data(), pending_num);
+  } else {
+    const int left_num = pending_num / 2;
+    rc                 = write_node(level, level.pending.data(), left_num);
+    if (OB_SUCC(rc)) {
+      rc = write_node(level,
+          level.pending.data() + static_cast<size_t>(left_num) * level.item_size,
+          pending_num - left_num);
+    }
+  }
+  level.pending.clear();
+  return rc;
+}
+
+RC BplusTreeBulkLoader::write_node(Level &level, const char *items, int num)
+{
+  const IndexFileHeader &header = tree_handler_.file_header();
+
+  RC rc = RC::SUCCESS;
+
+  BplusTreeMiniTransaction mtr(tree_handler_, &rc);
+  LatchMemo               &latch_memo = mtr.latch_memo();
+
+  Frame *frame = nullptr;
+  rc           = latch_memo.allocate_page(frame);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to allocate page while bulk loading. rc=%s", strrc(rc));
+    return rc;
+  }
+  latch_memo.xlatch(frame);
+
+  if (level.leaf) {
+    LeafIndexNodeHandler node(mtr, header, frame);
+    rc = node.init_empty();
+    if (OB_SUCC(rc)) {
+      rc = node.append(items, num);
+    }
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to init leaf node while bulk loading. rc=%s", strrc(rc));
+      return rc;
+    }
+
+    if (level.last_page != BP_INVALID_PAGE_NUM) {
+      Frame *prev_frame = nullptr;
+      rc                = latch_memo.get_page(level.last_page, prev_frame);
+      if (OB_FAIL(rc)) {
+        LOG_WARN("failed to get previous leaf page. page num=%d, rc=%s", level.last_page, strrc(rc));
+        return rc;
+      }
+      latch_memo.xlatch(prev_frame);
+
+      LeafIndexNodeHandler prev_node(mtr, header, prev_frame);
+      rc = prev_node.set_next_page(frame->page_num());
+      if (OB_FAIL(rc)) {
+        return rc;
+      }
+      prev_frame->mark_dirty();
+    }
+    level.last_page = frame->page_num();
+  } else {
+    // append 会把所有子节点的父节点设置为当前节点
+    InternalIndexNodeHandler node(mtr, header, frame);
+    rc = node.init_empty();
+    if (OB_SUCC(rc)) {
+      rc = node.append(items, num);
+    }
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to init internal node while bulk loading. rc=%s", strrc(rc));
+      return rc;
+    }
+  }
+  frame->mark_dirty();
+
+  // 上一层使用当前节点的第一个键值作为分隔键
+  const PageNum page_num = frame->page_num();
+  level.parent_items.insert(level.parent_items.end(), items, items + header.key_length);
+  level.parent_items.insert(
+      level.parent_items.end(), (const char *)&page_num, (const char *)&page_num + sizeof(page_num));
+  return rc;
+}
+
+RC BplusTreeBulkLoader::finish()
+{
+  if (!tree_handler_.is_empty()) {
+    LOG_WARN("cannot bulk load a non-empty bplus tree");
+    return RC::INTERNAL;
+  }
+
+  RC   rc       = RC::SUCCESS;
+  auto consumer = [this](const char *entry) { return add_sorted_entry(entry); };
+  if (run_num_ == 0) {
+    sort_entries();
+    for (const char *entry : sorted_entries_) {
+      rc = consumer(entry);
+      if (OB_FAIL(rc)) {
+        return rc;
+      }
+    }
+  } else {
+    if (!sorted_entries_.empty()) {
+      rc = spill();
+      if (OB_FAIL(rc)) {
+        return rc;
+      }
+    }
+    rc = merge_runs(consumer);
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+    remove_run_files();
+  }
+  entries_.clear();
+  sorted_entries_.clear();
+
+  rc = finish_level(leaf_level_);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  // 自底向上构建内部节点，直到某一层只有一个节点
+  const int    internal_item_size = tree_handler_.file_header().key_length + static_cast<int>(sizeof(PageNum));
+  vector<char> items              = std::move(leaf_level_.parent_items);
+  int          level_num          = 1;
+  while (static_cast<int>(items.size()) > internal_item_size) {
+    Level level;
+    init_level(level, false /*leaf*/);
+    for (size_t offset = 0; offset < items.size(); offset += internal_item_size) {
+      rc = append_item(level, items.data() + offset);
+      if (OB_FAIL(rc)) {
+        return rc;
+      }
+    }
+    rc = finish_level(level);
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+    items = std::move(level.parent_items);
+    level_num++;
+  }
+
+  if (items.empty()) {
+    LOG_INFO("no data to bulk load");
+    return RC::SUCCESS;
+  }
+
+  PageNum root_page = BP_INVALID_PAGE_NUM;
+  memcpy(&root_page, items.data() + tree_handler_.file_header().key_length, sizeof(root_page));
+
+  BplusTreeMiniTransaction mtr(tree_handler_, &rc);
+  tree_handler_.update_root_page_num_locked(mtr, root_page);
+  LOG_INFO("bulk load bplus tree done. root page=%d, level num=%d", root_page, level_num);
+  return rc;
+}
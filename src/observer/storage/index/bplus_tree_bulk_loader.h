@@ -0,0 +1,103 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include "common/lang/functional.h"
+#include "common/lang/string.h"
+#include "common/lang/vector.h"
+#include "common/sys/rc.h"
+#include "storage/index/bplus_tree.h"
+
+/**
+ * @brief 批量构建B+树
+ * @ingroup BPlusTree
+ * @details 给已有数据的表创建索引时，逐条插入的话每条数据都要从根节点查找叶子节点、加锁并记录日志。
+ * 批量构建先把所有的 (键值, RID) 排序，内存放不下时分批排序后写到临时文件中，最后做多路归并。
+ * 排好序的数据从左到右依次写入叶子节点，每个节点按照填充比例写满后再写下一个，然后自底向上构建内部节点。
+ * 每个页面使用一个 mini transaction，页面上所有的数据记录在一条日志中。
+ * 只能在空的B+树上使用，构建期间不能有其它线程访问这棵树。
+ */
+class BplusTreeBulkLoader
+{
+public:
+  /**
+   * @param tree_handler 需要构建的B+树，必须是空的
+   * @param tmp_file_prefix 排序时临时文件的前缀，临时文件在构建结束后删除
+   * @param sort_buffer_size 排序使用的内存大小(字节)，超过这个大小就写到临时文件中
+   * @param fill_percent 页面的填充比例。留一些空间可以减少后面插入数据时的页面分裂，不会低于节点的最小元素个数
+   */
+  BplusTreeBulkLoader(
+      BplusTreeHandler &tree_handler, const string &tmp_file_prefix, int64_t sort_buffer_size, int fill_percent);
+  ~BplusTreeBulkLoader();
+
+  /**
+   * @brief 添加一条数据，不要求有序
+   * @note 这里假设user_key的内存大小与attr_length 一致
+   */
+  RC add(const char *user_key, const RID &rid);
+
+  /**
+   * @brief 排序并构建B+树
+   * @return 唯一索引有重复的键值时返回 RECORD_DUPLICATE_KEY
+   */
+  RC finish();
+
+private:
+  /**
+   * @brief B+树某一层上正在构建的节点
+   * @details 总是多缓存一个节点的数据，这样最后剩下的数据不足一个节点时，可以和前一个节点平分
+   */
+  struct Level
+  {
+    bool         leaf      = true;
+    int          item_size = 0;
+    int          target    = 0;  ///< 每个节点写入的元素个数
+    int          max_size  = 0;
+    vector<char> pending;                          ///< 还没有写到页面上的元素
+    vector<char> parent_items;                     ///< 上一层的元素，每个节点的第一个键值和页面编号
+    PageNum      last_page = BP_INVALID_PAGE_NUM;  ///< 上一个叶子节点，用来设置兄弟节点
+  };
+
+  void init_level(Level &level, bool leaf) const;
+  RC   append_item(Level &level, const char *item);
+  RC   finish_level(Level &level);
+  RC   write_node(Level &level, const char *items, int num);
+
+  /// @brief 按照顺序处理一条排好序的数据，放到叶子节点中
+  RC add_sorted_entry(const char *entry);
+
+  void sort_entries();
+  RC   spill();
+  RC   merge_runs(const function<RC(const char *)> &consumer);
+
+  string run_file_name(int index) const;
+  void   remove_run_files();
+
+private:
+  static constexpr size_t INITIAL_ENTRY_NUM = 1024;  ///< 第一次分配缓冲区时容纳的数据条数
+
+  BplusTreeHandler &tree_handler_;
+  string            tmp_file_prefix_;
+  int               fill_percent_ = 100;
+
+  /// 排序时比较 (键值, RID)。唯一索引的比较器不比较RID，这里单独初始化一个
+  KeyComparator entry_comparator_;
+  int           entry_size_  = 0;  ///< attr_length + sizeof(RID)
+  int           max_entries_ = 0;  ///< 内存中最多缓存多少条数据
+  int           run_num_     = 0;  ///< 临时文件的个数
+
+  vector<char>         entries_;
+  vector<const char *> sorted_entries_;
+
+  Level        leaf_level_;
+  vector<char> item_buffer_;
+  vector<char> last_entry_;  ///< 上一条写入叶子节点的数据，用来检查唯一索引的重复键值
+};
@@ -14,12 +14,15 @@ See the Mulan PSL v2 for more details. */
 
 #include "storage/index/bplus_tree_index.h"
 #include "common/log/log.h"
+#include "storage/index/bplus_tree_bulk_loader.h"
+#include "storage/record/record_scanner.h"
 #include "storage/table/table.h"
 #include "storage/db/db.h"
 
 BplusTreeIndex::~BplusTreeIndex() noexcept { close(); }
 
-RC BplusTreeIndex::create(Table *table, const char *file_name, const IndexMeta &index_meta, const FieldMeta &field_meta)
+RC BplusTreeIndex::create(
+    Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas)
 {
   if (inited_) {
     LOG_WARN("Failed to create index due to the index has been created before. file_name:%s, index:%s, field:%s",
@@ -27,10 +30,24 @@ RC BplusTreeIndex::create(Table *table, const char *file_name, const IndexMeta &
     return RC::RECORD_OPENNED;
   }
 
-  Index::init(index_meta, field_meta);
+  Index::init(index_meta, field_metas);
 
   BufferPoolManager &bpm = table->db()->buffer_pool_manager();
-  RC rc = index_handler_.create(table->db()->log_handler(), bpm, file_name, field_meta.type(), field_meta.len());
+  vector<AttrType> attr_types;
+  vector<int>      attr_lengths;
+  for (const FieldMeta &field_meta : field_metas) {
+    attr_types.push_back(field_meta.type());
+    attr_lengths.push_back(field_meta.len());
+  }
+
+  RC rc = index_handler_.create(table->db()->log_handler(),
+      bpm,
+      file_name,
+      attr_types,
+      attr_lengths,
+      -1 /*internal_max_size*/,
+      -1 /*leaf_max_size*/,
+      index_meta.unique());
   if (RC::SUCCESS != rc) {
     LOG_WARN("Failed to create index_handler, file_name:%s, index:%s, field:%s, rc:%s",
         file_name, index_meta.name(), index_meta.field(), strrc(rc));
@@ -44,7 +61,8 @@ RC BplusTreeIndex::create(Table *table, const char *file_name, const IndexMeta &
   return RC::SUCCESS;
 }
 
-RC BplusTreeIndex::open(Table *table, const char *file_name, const IndexMeta &index_meta, const FieldMeta &field_meta)
+RC BplusTreeIndex::open(
+    Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas)
 {
   if (inited_) {
     LOG_WARN("Failed to open index due to the index has been initedd before. file_name:%s, index:%s, field:%s",
@@ -52,7 +70,7 @@ RC BplusTreeIndex::open(Table *table, const char *file_name, const IndexMeta &in
     return RC::RECORD_OPENNED;
   }
 
-  Index::init(index_meta, field_meta);
+  Index::init(index_meta, field_metas);
 
   BufferPoolManager &bpm = table->db()->buffer_pool_manager();
   RC rc = index_handler_.open(table->db()->log_handler(), bpm, file_name);
@@ -80,14 +98,34 @@ RC BplusTreeIndex::close()
   return RC::SUCCESS;
 }
 
+const char *BplusTreeIndex::make_user_key(const char *record, vector<char> &buffer) const
+{
+  bool contiguous = true;
+  for (size_t i = 1; i < field_metas_.size() && contiguous; i++) {
+    const FieldMeta &prev = field_metas_[i - 1];
+    contiguous            = (prev.offset() + prev.len() == field_metas_[i].offset());
+  }
+  if (contiguous) {
+    return record + field_metas_[0].offset();
+  }
+
+  buffer.clear();
+  for (const FieldMeta &field_meta : field_metas_) {
+    buffer.insert(buffer.end(), record + field_meta.offset(), record + field_meta.offset() + field_meta.len());
+  }
+  return buffer.data();
+}
+
 RC BplusTreeIndex::insert_entry(const char *record, const RID *rid)
 {
-  return index_handler_.insert_entry(record + field_meta_.offset(), rid);
+  vector<char> buffer;
+  return index_handler_.insert_entry(make_user_key(record, buffer), rid);
 }
 
 RC BplusTreeIndex::delete_entry(const char *record, const RID *rid)
 {
-  return index_handler_.delete_entry(record + field_meta_.offset(), rid);
+  vector<char> buffer;
+  return index_handler_.delete_entry(make_user_key(record, buffer), rid);
 }
 
 IndexScanner *BplusTreeIndex::create_scanner(
@@ -103,6 +141,34 @@ IndexScanner *BplusTreeIndex::create_scanner(
   return index_scanner;
 }
 
+RC BplusTreeIndex::bulk_load(
+    RecordScanner &scanner, const char *tmp_file_prefix, int64_t sort_buffer_size, int fill_percent)
+{
+  BplusTreeBulkLoader loader(index_handler_, tmp_file_prefix, sort_buffer_size, fill_percent);
+
+  RC           rc = RC::SUCCESS;
+  Record       record;
+  vector<char> key_buffer;
+  while (OB_SUCC(rc = scanner.next(record))) {
+    rc = loader.add(make_user_key(record.data(), key_buffer), record.rid());
+    if (OB_FAIL(rc)) {
+      LOG_WARN("failed to add record into bulk loader. index=%s, rc=%s", index_meta_.name(), strrc(rc));
+      return rc;
+    }
+  }
+
+  if (rc != RC::RECORD_EOF) {
+    LOG_WARN("failed to scan records while bulk loading index. index=%s, rc=%s", index_meta_.name(), strrc(rc));
+    return rc;
+  }
+
+  rc = loader.finish();
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to bulk load index. index=%s, rc=%s", index_meta_.name(), strrc(rc));
+  }
+  return rc;
+}
+
 RC BplusTreeIndex::sync() { return index_handler_.sync(); }
 
 ////////////////////////////////////////////////////////////////////////////////
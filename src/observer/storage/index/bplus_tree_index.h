@@ -17,6 +17,8 @@ See the Mulan PSL v2 for more details. */
 #include "storage/index/bplus_tree.h"
 #include "storage/index/index.h"
 
+class RecordScanner;
+
 /**
  * @brief B+树索引
  * @ingroup Index
@@ -27,13 +29,24 @@ public:
   BplusTreeIndex() = default;
   virtual ~BplusTreeIndex() noexcept;
 
-  RC create(Table *table, const char *file_name, const IndexMeta &index_meta, const FieldMeta &field_meta) override;
-  RC open(Table *table, const char *file_name, const IndexMeta &index_meta, const FieldMeta &field_meta) override;
+  RC create(
+      Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas) override;
+  RC open(Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas) override;
   RC close();
 
   RC insert_entry(const char *record, const RID *rid) override;
   RC delete_entry(const char *record, const RID *rid) override;
 
+  /**
+   * @brief 使用表中已有的数据批量构建索引
+   * @details 只能在刚创建的空索引上调用，参考 BplusTreeBulkLoader
+   * @param scanner 表的记录扫描器
+   * @param tmp_file_prefix 排序时临时文件的前缀
+   * @param sort_buffer_size 排序使用的内存大小
+   * @param fill_percent 页面的填充比例
+   */
+  RC bulk_load(RecordScanner &scanner, const char *tmp_file_prefix, int64_t sort_buffer_size, int fill_percent);
+
   /**
    * 扫描指定范围的数据
    */
@@ -42,6 +55,13 @@ public:
 
   RC sync() override;
 
+private:
+  /**
+   * @brief 从记录中取出索引的键值
+   * @details 单字段索引或者字段在记录中连续存放时，直接使用记录中的数据，否则将各个字段拼接到 buffer 中
+   */
+  const char *make_user_key(const char *record, vector<char> &buffer) const;
+
 private:
   bool             inited_ = false;
   Table           *table_  = nullptr;
@@ -40,18 +40,23 @@ public:
   Index()          = default;
   virtual ~Index() = default;
 
-  virtual RC create(Table *table, const char *file_name, const IndexMeta &index_meta, const FieldMeta &field_meta)
+  /**
+   * @param field_metas 索引包含的字段，多个字段就是组合索引
+   */
+  virtual RC create(
+      Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas)
   {
     return RC::UNSUPPORTED;
   }
-  virtual RC open(Table *table, const char *file_name, const IndexMeta &index_meta, const FieldMeta &field_meta)
+  virtual RC open(Table *table, const char *file_name, const IndexMeta &index_meta, const vector<FieldMeta> &field_metas)
   {
     return RC::UNSUPPORTED;
   }
 
   virtual bool is_vector_index() { return false; }
 
-  const IndexMeta &index_meta() const { return index_meta_; }
+  const IndexMeta         &index_meta() const { return index_meta_; }
+  const vector<FieldMeta> &field_metas() const { return field_metas_; }
 
   /**
    * @brief 插入一条数据
@@ -72,6 +77,7 @@ public:
   /**
    * @brief 创建一个索引数据的扫描器
    *
+   * @details 组合索引的键值是各个字段的值按照顺序拼接起来的，边界可以只包含前面若干个字段
    * @param left_key 要扫描的左边界
    * @param left_len 左边界的长度
    * @param left_inclusive 是否包含左边界
@@ -89,11 +95,11 @@ public:
   virtual RC sync() = 0;
 
 protected:
-  RC init(const IndexMeta &index_meta, const FieldMeta &field_meta);
+  RC init(const IndexMeta &index_meta, const vector<FieldMeta> &field_metas);
 
 protected:
-  IndexMeta index_meta_;  ///< 索引的元数据
-  FieldMeta field_meta_;  ///< 当前实现仅考虑一个字段的索引
+  IndexMeta         index_meta_;   ///< 索引的元数据
+  vector<FieldMeta> field_metas_;  ///< 索引包含的字段，按照键值中的顺序
 };
 
 /**
@@ -21,23 +21,47 @@ See the Mulan PSL v2 for more details. */
 
 const static Json::StaticString FIELD_NAME("name");
 const static Json::StaticString FIELD_FIELD_NAME("field_name");
+const static Json::StaticString FIELD_FIELD_NAMES("field_names");
+const static Json::StaticString FIELD_UNIQUE("unique");
 
-RC IndexMeta::init(const char *name, const FieldMeta &field)
+RC IndexMeta::init(const char *name, const FieldMeta &field) { return init(name, vector<const FieldMeta *>{&field}); }
+
+RC IndexMeta::init(const char *name, const vector<const FieldMeta *> &fields, bool unique)
 {
   if (common::is_blank(name)) {
     LOG_ERROR("Failed to init index, name is empty.");
     return RC::INVALID_ARGUMENT;
   }
 
-  name_  = name;
-  field_ = field.name();
+  if (fields.empty()) {
+    LOG_ERROR("Failed to init index, no fields. name=%s", name);
+    return RC::INVALID_ARGUMENT;
+  }
+
+  name_   = name;
+  unique_ = unique;
+  fields_.clear();
+  for (const FieldMeta *field : fields) {
+    fields_.push_back(field->name());
+  }
   return RC::SUCCESS;
 }
 
 void IndexMeta::to_json(Json::Value &json_value) const
 {
   json_value[FIELD_NAME]       = name_;
-  json_value[FIELD_FIELD_NAME] = field_;
+  json_value[FIELD_FIELD_NAME] = fields_[0];
+  // 单字段索引只写 field_name，与旧版本的格式保持一致
+  if (fields_.size() > 1) {
+    Json::Value field_names(Json::arrayValue);
+    for (const string &field : fields_) {
+      field_names.append(field);
+    }
+    json_value[FIELD_FIELD_NAMES] = std::move(field_names);
+  }
+  if (unique_) {
+    json_value[FIELD_UNIQUE] = true;
+  }
 }
 
 RC IndexMeta::from_json(const TableMeta &table, const Json::Value &json_value, IndexMeta &index)
@@ -55,17 +79,59 @@ RC IndexMeta::from_json(const TableMeta &table, const Json::Value &json_value, I
     return RC::INTERNAL;
   }
 
-  const FieldMeta *field = table.field(field_value.asCString());
-  if (nullptr == field) {
-    LOG_ERROR("Deserialize index [%s]: no such field: %s", name_value.asCString(), field_value.asCString());
-    return RC::SCHEMA_FIELD_MISSING;
+  vector<const char *> field_names;
+  const Json::Value   &field_names_value = json_value[FIELD_FIELD_NAMES];
+  if (field_names_value.isNull()) {
+    field_names.push_back(field_value.asCString());
+  } else if (field_names_value.isArray()) {
+    for (const Json::Value &name : field_names_value) {
+      if (!name.isString()) {
+        LOG_ERROR("Field name of index [%s] is not a string. json value=%s",
+            name_value.asCString(), name.toStyledString().c_str());
+        return RC::INTERNAL;
+      }
+      field_names.push_back(name.asCString());
+    }
+  } else {
+    LOG_ERROR("Field names of index [%s] is not an array. json value=%s",
+        name_value.asCString(), field_names_value.toStyledString().c_str());
+    return RC::INTERNAL;
+  }
+
+  vector<const FieldMeta *> fields;
+  for (const char *field_name : field_names) {
+    const FieldMeta *field = table.field(field_name);
+    if (nullptr == field) {
+      LOG_ERROR("Deserialize index [%s]: no such field: %s", name_value.asCString(), field_name);
+      return RC::SCHEMA_FIELD_MISSING;
+    }
+    fields.push_back(field);
+  }
+
+  const Json::Value &unique_value = json_value[FIELD_UNIQUE];
+  if (!unique_value.isNull() && !unique_value.isBool()) {
+    LOG_ERROR("Unique flag of index [%s] is not a boolean. json value=%s",
+        name_value.asCString(), unique_value.toStyledString().c_str());
+    return RC::INTERNAL;
   }
 
-  return index.init(name_value.asCString(), *field);
+  return index.init(name_value.asCString(), fields, unique_value.isBool() && unique_value.asBool());
 }
 
 const char *IndexMeta::name() const { return name_.c_str(); }
 
-const char *IndexMeta::field() const { return field_.c_str(); }
+const char *IndexMeta::field() const { return fields_.empty() ? "" : fields_[0].c_str(); }
 
-void IndexMeta::desc(ostream &os) const { os << "index name=" << name_ << ", field=" << field_; }
\ No newline at end of file
+void IndexMeta::desc(ostream &os) const
+{
+  os << "index name=" << name_ << ", field=";
+  for (size_t i = 0; i < fields_.size(); i++) {
+    if (i > 0) {
+      os << ",";
+    }
+    os << fields_[i];
+  }
+  if (unique_) {
+    os << ", unique";
+  }
+}
\ No newline at end of file
@@ -23,10 +23,15 @@ RC HeapRecordScanner::open_scan()
     LOG_WARN("failed to init bp iterator. rc=%d:%s", rc, strrc(rc));
     return rc;
   }
-  if (table_ == nullptr || table_->table_meta().storage_format() == StorageFormat::ROW_FORMAT) {
+  if (table_ == nullptr) {
     record_page_handler_ = new RowRecordPageHandler();
   } else {
-    record_page_handler_ = new PaxRecordPageHandler();
+    record_page_handler_ = RecordPageHandler::create(table_->table_meta().storage_format());
+  }
+
+  if (BufferRing::need_ring(*disk_buffer_pool_)) {
+    buffer_ring_ = make_unique<BufferRing>();
+    record_page_handler_->set_buffer_ring(buffer_ring_.get());
   }
 
   return rc;
@@ -132,6 +137,7 @@ RC HeapRecordScanner::close_scan()
     record_page_handler_ = nullptr;
   }
 
+  buffer_ring_.reset();
   return RC::SUCCESS;
 }
 
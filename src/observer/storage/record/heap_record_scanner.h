@@ -70,9 +70,10 @@ private:
   LogHandler     *log_handler_      = nullptr;
   ReadWriteMode   rw_mode_ = ReadWriteMode::READ_WRITE;  ///< 遍历出来的数据，是否可能对它做修改
 
-  BufferPoolIterator bp_iterator_;                    ///< 遍历buffer pool的所有页面
-  ConditionFilter   *condition_filter_    = nullptr;  ///< 过滤record
-  RecordPageHandler *record_page_handler_ = nullptr;  ///< 处理文件某页面的记录
-  RecordPageIterator record_page_iterator_;           ///< 遍历某个页面上的所有record
-  Record             next_record_;                    ///< 获取的记录放在这里缓存起来
+  BufferPoolIterator     bp_iterator_;                    ///< 遍历buffer pool的所有页面
+  unique_ptr<BufferRing> buffer_ring_;                    ///< 扫描大表时使用，避免污染缓冲池
+  ConditionFilter       *condition_filter_    = nullptr;  ///< 过滤record
+  RecordPageHandler     *record_page_handler_ = nullptr;  ///< 处理文件某页面的记录
+  RecordPageIterator     record_page_iterator_;           ///< 遍历某个页面上的所有record
+  Record                 next_record_;                    ///< 获取的记录放在这里缓存起来
 };
\ No newline at end of file
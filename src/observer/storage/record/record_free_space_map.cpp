@@ -0,0 +1,310 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "storage/record/record_free_space_map.h"
+#include "common/io/io.h"
+#include "common/lang/algorithm.h"
+#include "common/log/log.h"
+
+using namespace common;
+
+RecordFreeSpaceMap::~RecordFreeSpaceMap() { (void)close(); }
+
+int RecordFreeSpaceMap::free_class(int free_record_num, int record_capacity)
+{
+  if (free_record_num <= 0 || record_capacity <= 0) {
+    return FULL_CLASS;
+  }
+  free_record_num = min(free_record_num, record_capacity);
+  return 1 + free_record_num * (CLASS_NUM - 2) / record_capacity;
+}
+
+RC RecordFreeSpaceMap::open(const char *file_name, PageNum file_page_num, bool &loaded)
+{
+  loaded = false;
+  if (fd_ >= 0) {
+    LOG_WARN("free space map has been opened. file=%s", file_name_.c_str());
+    return RC::RECORD_OPENNED;
+  }
+
+  int fd = ::open(file_name, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+  if (fd < 0) {
+    LOG_WARN("failed to open free space map file. file=%s, error=%s", file_name, strerror(errno));
+    return RC::IOERR_OPEN;
+  }
+  fd_        = fd;
+  file_name_ = file_name;
+
+  FileHeader header;
+  memset(&header, 0, sizeof(header));
+  int ret = readn(fd_, &header, sizeof(header));
+  if (ret == 0 && header.magic == FileHeader::MAGIC && header.clean == 1 && header.page_num >= 0) {
+    RC rc = load(header.page_num, file_page_num);
+    if (OB_SUCC(rc)) {
+      loaded = true;
+    } else {
+      clear();
+      LOG_WARN("failed to load free space map, rebuild it. file=%s, rc=%s", file_name, strrc(rc));
+    }
+  }
+
+  // 后面的修改都只在内存中，正常关闭之前文件中的内容都不可信
+  RC rc = write_header(false /*clean*/);
+  if (OB_FAIL(rc)) {
+    ::close(fd_);
+    fd_ = -1;
+    return rc;
+  }
+
+  LOG_INFO("free space map opened. file=%s, loaded=%d, free page num=%d", file_name, loaded, free_page_num());
+  return RC::SUCCESS;
+}
+
+RC RecordFreeSpaceMap::load(int32_t page_num, PageNum file_page_num)
+{
+  vector<uint8_t> classes(page_num);
+  if (page_num > 0 && readn(fd_, classes.data(), page_num) != 0) {
+    return RC::IOERR_READ;
+  }
+
+  // 数据文件被删除重建时可能留下旧的空闲空间表，记录了数据文件中不存在的页面
+  for (PageNum i = file_page_num; i < page_num; i++) {
+    if (classes[i] != FULL_CLASS) {
+      LOG_WARN("free space map does not match data file. file=%s, page num=%d, file page num=%d",
+               file_name_.c_str(), i, file_page_num);
+      return RC::INVALID_ARGUMENT;
+    }
+  }
+
+  for (PageNum i = 0; i < page_num; i++) {
+    if (classes[i] != FULL_CLASS) {
+      update(i, classes[i]);
+    }
+  }
+  return RC::SUCCESS;
+}
+
+RC RecordFreeSpaceMap::write_header(bool clean)
+{
+  FileHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic    = FileHeader::MAGIC;
+  header.clean    = clean ? 1 : 0;
+  header.page_num = static_cast<int32_t>(segments_.size() * SEGMENT_PAGE_NUM);
+
+  if (lseek(fd_, 0, SEEK_SET) == -1 || writen(fd_, &header, sizeof(header)) != 0 || fdatasync(fd_) != 0) {
+    LOG_WARN("failed to write free space map header. file=%s, error=%s", file_name_.c_str(), strerror(errno));
+    return RC::IOERR_WRITE;
+  }
+  return RC::SUCCESS;
+}
+
+RC RecordFreeSpaceMap::close()
+{
+  RC rc = RC::SUCCESS;
+  if (fd_ >= 0) {
+    rc = persist();
+    ::close(fd_);
+    fd_ = -1;
+    LOG_INFO("free space map closed. file=%s, rc=%s", file_name_.c_str(), strrc(rc));
+  }
+
+  clear();
+  return rc;
+}
+
+void RecordFreeSpaceMap::clear()
+{
+  lock_guard<SharedMutex> guard(lock_);
+  segments_.clear();
+  free_page_num_.store(0);
+  search_hint_.store(0);
+}
+
+RC RecordFreeSpaceMap::persist()
+{
+  // 先写内容再写文件头，中间出现异常时文件头仍然是没有正常关闭的状态
+  {
+    lock_guard<SharedMutex> guard(lock_);
+    vector<uint8_t> classes(SEGMENT_PAGE_NUM);
+    for (size_t i = 0; i < segments_.size(); i++) {
+      for (int j = 0; j < SEGMENT_PAGE_NUM; j++) {
+        classes[j] = segments_[i]->classes[j].load(std::memory_order_relaxed);
+      }
+
+      const off_t offset = sizeof(FileHeader) + static_cast<off_t>(i) * SEGMENT_PAGE_NUM;
+      if (lseek(fd_, offset, SEEK_SET) == -1 || writen(fd_, classes.data(), SEGMENT_PAGE_NUM) != 0) {
+        LOG_WARN("failed to write free space map. file=%s, error=%s", file_name_.c_str(), strerror(errno));
+        return RC::IOERR_WRITE;
+      }
+    }
+  }
+
+  if (fdatasync(fd_) != 0) {
+    LOG_WARN("failed to sync free space map. file=%s, error=%s", file_name_.c_str(), strerror(errno));
+    return RC::IOERR_SYNC;
+  }
+  return write_header(true /*clean*/);
+}
+
+void RecordFreeSpaceMap::update(PageNum page_num, int free_class)
+{
+  if (page_num < 0) {
+    return;
+  }
+
+  free_class = max(FULL_CLASS, min(free_class, CLASS_NUM - 1));
+
+  const size_t segment_index = page_num / SEGMENT_PAGE_NUM;
+  {
+    std::shared_lock<SharedMutex> guard(lock_);
+    if (segment_index < segments_.size()) {
+      update_segment(*segments_[segment_index], page_num % SEGMENT_PAGE_NUM, free_class);
+      return;
+    }
+  }
+
+  if (free_class == FULL_CLASS) {
+    // 没有记录的页面本来就当作满的
+    return;
+  }
+
+  lock_guard<SharedMutex> guard(lock_);
+  update_segment(ensure_segment(segment_index), page_num % SEGMENT_PAGE_NUM, free_class);
+}
+
+RecordFreeSpaceMap::Segment &RecordFreeSpaceMap::ensure_segment(size_t segment_index)
+{
+  while (segments_.size() <= segment_index) {
+    segments_.push_back(make_unique<Segment>());
+  }
+  return *segments_[segment_index];
+}
+
+void RecordFreeSpaceMap::update_segment(Segment &segment, int index, int free_class)
+{
+  const int old_class = segment.classes[index].exchange(static_cast<uint8_t>(free_class));
+  if ((old_class == FULL_CLASS) == (free_class == FULL_CLASS)) {
+    return;
+  }
+
+  const uint64_t bit = 1UL << (index % WORD_BITS);
+  if (free_class == FULL_CLASS) {
+    segment.free_bits[index / WORD_BITS].fetch_and(~bit);
+    segment.free_num.fetch_sub(1);
+    free_page_num_.fetch_sub(1);
+  } else {
+    segment.free_bits[index / WORD_BITS].fetch_or(bit);
+    segment.free_num.fetch_add(1);
+    free_page_num_.fetch_add(1);
+  }
+}
+
+PageNum RecordFreeSpaceMap::claim_free_page()
+{
+  if (free_page_num() <= 0) {
+    return BP_INVALID_PAGE_NUM;
+  }
+
+  std::shared_lock<SharedMutex> guard(lock_);
+  const int segment_num = static_cast<int>(segments_.size());
+  if (segment_num == 0) {
+    return BP_INVALID_PAGE_NUM;
+  }
+
+  // 从上次找到的页面开始查找，绕一圈回到起点
+  const PageNum hint          = search_hint_.load(std::memory_order_relaxed);
+  const int     start_segment = min(hint / SEGMENT_PAGE_NUM, segment_num - 1);
+  for (int n = 0; n <= segment_num; n++) {
+    const int segment_index = (start_segment + n) % segment_num;
+    Segment  &segment       = *segments_[segment_index];
+    if (segment.free_num.load(std::memory_order_relaxed) <= 0) {
+      continue;
+    }
+
+    // 第一个段从 hint 所在的字开始，最后再回到这个段时从头开始
+    const int start_word = (n == 0) ? (hint % SEGMENT_PAGE_NUM) / WORD_BITS : 0;
+    for (int w = start_word; w < SEGMENT_PAGE_NUM / WORD_BITS; w++) {
+      uint64_t bits = segment.free_bits[w].load(std::memory_order_relaxed) &
+                      ~segment.claimed_bits[w].load(std::memory_order_relaxed);
+      while (bits != 0) {
+        const int      bit   = __builtin_ctzll(bits);
+        const int      index = w * WORD_BITS + bit;
+        const uint64_t mask  = 1UL << bit;
+        bits &= bits - 1;
+
+        if (segment.classes[index].load(std::memory_order_relaxed) == FULL_CLASS) {
+          continue;
+        }
+        // 其它线程可能同时找到这个页面，只有一个线程能占用成功
+        if ((segment.claimed_bits[w].fetch_or(mask) & mask) != 0) {
+          continue;
+        }
+
+        const PageNum page_num = static_cast<PageNum>(segment_index) * SEGMENT_PAGE_NUM + index;
+        search_hint_.store(page_num, std::memory_order_relaxed);
+        return page_num;
+      }
+    }
+  }
+  return BP_INVALID_PAGE_NUM;
+}
+
+bool RecordFreeSpaceMap::claim(PageNum page_num)
+{
+  if (page_num < 0) {
+    return false;
+  }
+
+  const size_t   segment_index = page_num / SEGMENT_PAGE_NUM;
+  const int      index         = page_num % SEGMENT_PAGE_NUM;
+  const uint64_t mask          = 1UL << (index % WORD_BITS);
+  {
+    std::shared_lock<SharedMutex> guard(lock_);
+    if (segment_index < segments_.size()) {
+      return (segments_[segment_index]->claimed_bits[index / WORD_BITS].fetch_or(mask) & mask) == 0;
+    }
+  }
+
+  lock_guard<SharedMutex> guard(lock_);
+  return (ensure_segment(segment_index).claimed_bits[index / WORD_BITS].fetch_or(mask) & mask) == 0;
+}
+
+void RecordFreeSpaceMap::release(PageNum page_num)
+{
+  if (page_num < 0) {
+    return;
+  }
+
+  std::shared_lock<SharedMutex> guard(lock_);
+  const size_t segment_index = page_num / SEGMENT_PAGE_NUM;
+  if (segment_index < segments_.size()) {
+    const int index = page_num % SEGMENT_PAGE_NUM;
+    segments_[segment_index]->claimed_bits[index / WORD_BITS].fetch_and(~(1UL << (index % WORD_BITS)));
+  }
+}
+
+int RecordFreeSpaceMap::page_class(PageNum page_num) const
+{
+  if (page_num < 0) {
+    return FULL_CLASS;
+  }
+
+  std::shared_lock<SharedMutex> guard(lock_);
+  const size_t segment_index = page_num / SEGMENT_PAGE_NUM;
+  if (segment_index >= segments_.size()) {
+    return FULL_CLASS;
+  }
+  return segments_[segment_index]->classes[page_num % SEGMENT_PAGE_NUM].load(std::memory_order_relaxed);
+}
@@ -0,0 +1,144 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#pragma once
+
+#include "common/lang/atomic.h"
+#include "common/lang/memory.h"
+#include "common/lang/mutex.h"
+#include "common/lang/string.h"
+#include "common/lang/vector.h"
+#include "common/sys/rc.h"
+#include "storage/buffer/page.h"
+
+/**
+ * @brief 数据文件的空闲空间表(Free Space Map)
+ * @ingroup RecordManager
+ * @details 记录数据文件中每个页面的空闲程度(fill class)，插入记录时可以直接找到一个有空闲位置的页面，
+ * 不需要逐个加载页面检查。空闲程度使用一个字节表示，0 表示页面已满，数值越大空闲空间越多，参考 free_class。
+ *
+ * 空闲空间表保存在数据文件旁边的一个单独文件中(数据文件名加上 .fsm 后缀)，打开时读取，关闭时写回。
+ * 文件头中有一个标记，打开之后就清除，正常关闭时再设置，如果打开时发现没有这个标记，说明上次没有正常关闭，
+ * 文件中的内容不可信，需要调用方扫描数据文件重新构建。
+ *
+ * 空闲空间表只是一个提示，不记录日志。修改页面之后，需要在持有页面写锁的时候调用 update，
+ * 这样同一个页面的更新是按顺序的。即使记录的值与页面的实际情况不同，也只是让插入时多检查一个页面，
+ * 或者暂时用不到某个页面的空闲空间，不会影响正确性。
+ *
+ * 内存中按照段(segment)组织，每个段管理 SEGMENT_PAGE_NUM 个页面，段中还有一个位图记录哪些页面不满，
+ * 查找空闲页面时只需要检查位图。更新和查找只需要加读锁，只有增加新的段时才需要加写锁。
+ *
+ * 插入记录的线程会占用(claim)一个页面作为自己的插入目标，被占用的页面不会再被其它线程找到，
+ * 释放(release)之后才能被重新使用。占用状态只保存在内存中。
+ */
+class RecordFreeSpaceMap
+{
+public:
+  static constexpr int FULL_CLASS = 0;   ///< 页面已满
+  static constexpr int CLASS_NUM  = 16;  ///< 空闲程度的个数，最大的值表示页面是空的
+
+  RecordFreeSpaceMap() = default;
+  ~RecordFreeSpaceMap();
+
+  /**
+   * @brief 根据页面的空闲记录个数计算空闲程度
+   * @details 只要有一个空闲位置，空闲程度就不会是 FULL_CLASS
+   */
+  static int free_class(int free_record_num, int record_capacity);
+
+  /**
+   * @brief 打开空闲空间表文件，文件不存在时创建
+   * @param file_page_num 数据文件的页面个数，空闲空间表中记录了超出范围的页面时认为内容不可信
+   * @param[out] loaded 是否从文件中加载到了可信的内容，否则需要调用方重新构建
+   */
+  RC open(const char *file_name, PageNum file_page_num, bool &loaded);
+
+  /**
+   * @brief 把空闲空间表写回文件，并标记为正常关闭
+   */
+  RC close();
+
+  /**
+   * @brief 清空内存中所有页面的空闲程度，重新构建之前调用
+   */
+  void clear();
+
+  /**
+   * @brief 设置页面的空闲程度。需要在持有页面写锁时调用
+   */
+  void update(PageNum page_num, int free_class);
+
+  /**
+   * @brief 查找一个没有满并且没有被占用的页面，并占用它
+   * @details 从上次找到的页面开始查找，找到之后需要加载页面再确认，不再使用时调用 release
+   * @return BP_INVALID_PAGE_NUM 表示没有找到
+   */
+  PageNum claim_free_page();
+
+  /**
+   * @brief 占用指定的页面，比如新分配的页面
+   * @return 页面之前没有被占用时返回 true
+   */
+  bool claim(PageNum page_num);
+
+  /**
+   * @brief 释放占用的页面，如果页面没有满，其它线程可以再找到它
+   */
+  void release(PageNum page_num);
+
+  int page_class(PageNum page_num) const;
+
+  /// 没有满的页面个数
+  int free_page_num() const { return free_page_num_.load(std::memory_order_relaxed); }
+
+private:
+  static constexpr int SEGMENT_PAGE_NUM = 4096;
+  static constexpr int WORD_BITS        = 64;
+
+  struct Segment
+  {
+    atomic<uint8_t>  classes[SEGMENT_PAGE_NUM];
+    atomic<uint64_t> free_bits[SEGMENT_PAGE_NUM / WORD_BITS];     ///< 1 表示对应的页面没有满
+    atomic<uint64_t> claimed_bits[SEGMENT_PAGE_NUM / WORD_BITS];  ///< 1 表示对应的页面被某个线程占用
+    atomic<int32_t>  free_num{0};                              ///< 段中没有满的页面个数
+  };
+
+  /**
+   * @brief 文件头，后面紧跟着每个页面的空闲程度，每个页面一个字节
+   */
+  struct FileHeader
+  {
+    static constexpr int32_t MAGIC = 0x4d5346;  // "FSM"
+
+    int32_t magic;
+    int32_t clean;     ///< 1 表示正常关闭，内容可信
+    int32_t page_num;  ///< 后面记录了多少个页面
+    int32_t reserved;
+  };
+
+  /// 在持有读锁的情况下更新，段已经存在
+  void update_segment(Segment &segment, int index, int free_class);
+
+  /// 确保页面所在的段存在，需要持有写锁
+  Segment &ensure_segment(size_t segment_index);
+
+  RC load(int32_t page_num, PageNum file_page_num);
+  RC persist();
+  RC write_header(bool clean);
+
+private:
+  int    fd_ = -1;
+  string file_name_;
+
+  mutable common::SharedMutex lock_;      ///< 保护 segments_ 本身，增加段时加写锁
+  vector<unique_ptr<Segment>> segments_;
+  atomic<int32_t>             free_page_num_{0};
+  atomic<PageNum>             search_hint_{0};  ///< 上次找到的空闲页面，下次从这里开始查找
+};
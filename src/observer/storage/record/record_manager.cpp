@@ -24,6 +24,8 @@ RecordPageHandler   *RecordPageHandler::create(StorageFormat format)
 {
   if (format == StorageFormat::ROW_FORMAT) {
     return new RowRecordPageHandler();
+  } else if (format == StorageFormat::VAR_ROW_FORMAT) {
+    return new VarRowRecordPageHandler();
   } else {
     return new PaxRecordPageHandler();
   }
@@ -109,7 +111,7 @@ RC RecordPageHandler::init(DiskBufferPool &buffer_pool, LogHandler &log_handler,
   lob_handler_ = lob_handler;
 
   RC ret = RC::SUCCESS;
-  if ((ret = buffer_pool.get_this_page(page_num, &frame_)) != RC::SUCCESS) {
+  if ((ret = buffer_pool.get_this_page(page_num, &frame_, buffer_ring_)) != RC::SUCCESS) {
     LOG_ERROR("Failed to get page handle from disk buffer pool. ret=%d:%s", ret, strrc(ret));
     return ret;
   }
@@ -182,13 +184,13 @@ RC RecordPageHandler::init_empty_page(DiskBufferPool &buffer_pool, LogHandler &l
   page_header_->record_real_size = record_size;
   page_header_->record_size      = align8(record_size);
   page_header_->record_capacity  = page_record_capacity(
-      BP_PAGE_DATA_SIZE, page_header_->record_size, column_num * sizeof(int) /* other fixed size*/);
+      frame_->page_data_size(), page_header_->record_size, column_num * sizeof(int) /* other fixed size*/);
   page_header_->col_idx_offset = align8(PAGE_HEADER_SIZE + page_bitmap_size(page_header_->record_capacity));
   page_header_->data_offset    = align8(PAGE_HEADER_SIZE + page_bitmap_size(page_header_->record_capacity)) +
                               column_num * sizeof(int) /* column index*/;
   this->fix_record_capacity();
   ASSERT(page_header_->data_offset + page_header_->record_capacity * page_header_->record_size 
-              <= BP_PAGE_DATA_SIZE, 
+              <= frame_->page_data_size(), 
          "Record overflow the page size");
 
   bitmap_ = frame_->data() + PAGE_HEADER_SIZE;
@@ -233,13 +235,13 @@ RC RecordPageHandler::init_empty_page(DiskBufferPool &buffer_pool, LogHandler &l
   page_header_->record_real_size = record_size;
   page_header_->record_size      = align8(record_size);
   page_header_->record_capacity =
-      page_record_capacity(BP_PAGE_DATA_SIZE, page_header_->record_size, page_header_->column_num * sizeof(int));
+      page_record_capacity(frame_->page_data_size(), page_header_->record_size, page_header_->column_num * sizeof(int));
   page_header_->col_idx_offset = align8(PAGE_HEADER_SIZE + page_bitmap_size(page_header_->record_capacity));
   page_header_->data_offset    = align8(PAGE_HEADER_SIZE + page_bitmap_size(page_header_->record_capacity)) +
                               column_num * sizeof(int) /* column index*/;
   this->fix_record_capacity();
   ASSERT(page_header_->data_offset + page_header_->record_capacity * page_header_->record_size 
-              <= BP_PAGE_DATA_SIZE, 
+              <= frame_->page_data_size(), 
          "Record overflow the page size");
 
   bitmap_ = frame_->data() + PAGE_HEADER_SIZE;
@@ -421,6 +423,13 @@ PageNum RecordPageHandler::get_page_num() const
 
 bool RecordPageHandler::is_full() const { return page_header_->record_num >= page_header_->record_capacity; }
 
+int RecordPageHandler::free_record_num() const { return page_header_->record_capacity - page_header_->record_num; }
+
+int RecordPageHandler::free_class() const
+{
+  return RecordFreeSpaceMap::free_class(free_record_num(), page_header_->record_capacity);
+}
+
 RC PaxRecordPageHandler::insert_record(const char *data, RID *rid)
 {
   // your code here
@@ -471,14 +480,71 @@ RC PaxRecordPageHandler::get_record(const RID &rid, Record &record)
   return RC::UNIMPLEMENTED;
 }
 
-// TODO: specify the column_ids that chunk needed. currenly we get all columns
-RC PaxRecordPageHandler::get_chunk(Chunk &chunk)
+RC PaxRecordPageHandler::get_chunk(Chunk &chunk, SlotNum &start_slot)
 {
-  // your code here
-  // Todo:
-  // 参照PaxRecordPageHandler::get_record
-  // 一次性获得一个page的所有record
-  return RC::UNIMPLEMENTED;
+  const int record_capacity = page_header_->record_capacity;
+  if (start_slot < 0 || start_slot >= record_capacity) {
+    start_slot = -1;
+    return RC::SUCCESS;
+  }
+
+  // 大页面中的记录可能比列的容量多，一次最多读取列中剩余空间个数的记录
+  int room = record_capacity;
+  for (int i = 0; i < chunk.column_num(); i++) {
+    Column   &column = chunk.column(i);
+    const int col_id = chunk.column_ids(i);
+    if (col_id < 0 || col_id >= page_header_->column_num) {
+      LOG_WARN("invalid column id. col_id=%d, column num=%d", col_id, page_header_->column_num);
+      return RC::INVALID_ARGUMENT;
+    }
+
+    const int field_len = get_field_len(col_id);
+    if (column.attr_len() != field_len) {
+      LOG_WARN("column length mismatch. col_id=%d, column len=%d, field len=%d", col_id, column.attr_len(), field_len);
+      return RC::INVALID_ARGUMENT;
+    }
+    room = min(room, column.capacity() - column.count());
+  }
+
+  // 只读取 chunk 中需要的列，每一列在页面中是连续存放的，连续的有效记录一次复制
+  Bitmap                 bitmap(bitmap_, record_capacity);
+  vector<pair<int, int>> ranges;  // 起始槽位和记录个数
+  SlotNum                slot = bitmap.next_setted_bit(start_slot);
+  if (slot != -1 && room <= 0) {
+    LOG_WARN("chunk has no space for page. start slot=%d, record num=%d", start_slot, page_header_->record_num);
+    return RC::INTERNAL;
+  }
+
+  while (slot != -1 && room > 0) {
+    int end = bitmap.next_unsetted_bit(slot);
+    if (end == -1) {
+      end = record_capacity;
+    }
+
+    const int num = min(end - slot, room);
+    ranges.emplace_back(slot, num);
+    room -= num;
+    slot += num;
+    if (slot >= record_capacity) {
+      slot = -1;
+    } else if (slot == end) {
+      slot = bitmap.next_setted_bit(end);
+    }
+  }
+  start_slot = slot;
+
+  for (int i = 0; i < chunk.column_num(); i++) {
+    Column   &column = chunk.column(i);
+    const int col_id = chunk.column_ids(i);
+    for (const auto &[range_start, range_num] : ranges) {
+      RC rc = column.append(get_field_data(range_start, col_id), range_num);
+      if (OB_FAIL(rc)) {
+        LOG_WARN("failed to append column data. col_id=%d, rc=%s", col_id, strrc(rc));
+        return rc;
+      }
+    }
+  }
+  return RC::SUCCESS;
 }
 
 char *PaxRecordPageHandler::get_field_data(SlotNum slot_num, int col_id)
@@ -503,6 +569,459 @@ int PaxRecordPageHandler::get_field_len(int col_id)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+/**
+ * @brief 去掉末尾的0之后的长度
+ */
+static int trimmed_length(const char *data, int len)
+{
+  while (len > 0 && data[len - 1] == 0) {
+    len--;
+  }
+  return len;
+}
+
+RC VarRowRecordPageHandler::init_empty_page(DiskBufferPool &buffer_pool, LogHandler &log_handler, PageNum page_num,
+    int record_size, TableMeta *table_meta, LobFileHandler *lob_handler)
+{
+  // 字符串字段是变长的，其它字段都按照定长保存
+  vector<int> column_desc;
+  if (table_meta != nullptr) {
+    for (int i = 0; i < table_meta->field_num(); i++) {
+      const FieldMeta *field = table_meta->field(i);
+      column_desc.push_back(field->type() == AttrType::CHARS ? -field->len() : field->len());
+    }
+  }
+
+  RC rc = init(buffer_pool, log_handler, page_num, ReadWriteMode::READ_WRITE);
+  if (OB_FAIL(rc)) {
+    LOG_ERROR("Failed to init empty page page_num:record_size %d:%d. rc=%s", page_num, record_size, strrc(rc));
+    return rc;
+  }
+  lob_handler_ = lob_handler;
+
+  (void)log_handler_.init(log_handler, buffer_pool.id(), record_size, storage_format_);
+
+  rc = init_page_layout(record_size, static_cast<int>(column_desc.size()), column_desc.data());
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+
+  rc = log_handler_.init_new_page(
+      frame_, page_num, span((const char *)column_desc.data(), column_desc.size() * sizeof(int)));
+  if (OB_FAIL(rc)) {
+    LOG_ERROR("Failed to init empty page: write log failed. page_num:record_size %d:%d. rc=%s",
+              page_num, record_size, strrc(rc));
+    return rc;
+  }
+  return RC::SUCCESS;
+}
+
+RC VarRowRecordPageHandler::init_empty_page(DiskBufferPool &buffer_pool, LogHandler &log_handler, PageNum page_num,
+    int record_size, int column_num, const char *col_idx_data, LobFileHandler *lob_handler)
+{
+  RC rc = init(buffer_pool, log_handler, page_num, ReadWriteMode::READ_WRITE);
+  if (OB_FAIL(rc)) {
+    LOG_ERROR("Failed to init empty page page_num:record_size %d:%d. rc=%s", page_num, record_size, strrc(rc));
+    return rc;
+  }
+  lob_handler_ = lob_handler;
+
+  (void)log_handler_.init(log_handler, buffer_pool.id(), record_size, storage_format_);
+
+  vector<int> column_desc(column_num);
+  if (column_num > 0) {
+    memcpy(column_desc.data(), col_idx_data, column_num * sizeof(int));
+  }
+  return init_page_layout(record_size, column_num, column_desc.data());
+}
+
+RC VarRowRecordPageHandler::init_page_layout(int record_size, int column_num, const int *column_desc)
+{
+  // 最短和最长的记录编码之后的长度
+  int min_size   = VAR_LENGTH_SIZE;
+  int max_size   = VAR_LENGTH_SIZE + record_size;
+  int total_size = record_size;
+  if (column_num > 0) {
+    min_size   = 0;
+    max_size   = 0;
+    total_size = 0;
+    for (int i = 0; i < column_num; i++) {
+      const int len = abs(column_desc[i]);
+      min_size += (column_desc[i] > 0) ? len : VAR_LENGTH_SIZE;
+      max_size += (column_desc[i] > 0) ? len : VAR_LENGTH_SIZE + len;
+      total_size += len;
+    }
+  }
+  if (total_size != record_size) {
+    LOG_ERROR("column desc does not match record size. column size=%d, record size=%d", total_size, record_size);
+    return RC::INVALID_ARGUMENT;
+  }
+
+  const int page_data_size       = frame_->page_data_size();
+  page_header_->record_num       = 0;
+  page_header_->column_num       = column_num;
+  page_header_->record_real_size = record_size;
+  page_header_->record_size      = max_size;
+  page_header_->record_capacity  = page_record_capacity(page_data_size,
+      min_size + static_cast<int>(sizeof(Slot)),
+      column_num * sizeof(int) + sizeof(SlotDirectory) /* other fixed size*/);
+  page_header_->col_idx_offset = align8(PAGE_HEADER_SIZE + page_bitmap_size(page_header_->record_capacity));
+  page_header_->data_offset    = align8(page_header_->col_idx_offset + column_num * sizeof(int));
+  if (page_header_->record_capacity <= 0 ||
+      page_header_->data_offset + static_cast<int>(sizeof(SlotDirectory) + sizeof(Slot)) + max_size > page_data_size) {
+    LOG_ERROR("record is too large for page. record size=%d, page data size=%d", record_size, page_data_size);
+    return RC::INVALID_ARGUMENT;
+  }
+
+  bitmap_ = frame_->data() + PAGE_HEADER_SIZE;
+  memset(bitmap_, 0, page_bitmap_size(page_header_->record_capacity));
+  if (column_num > 0) {
+    memcpy(frame_->data() + page_header_->col_idx_offset, column_desc, column_num * sizeof(int));
+  }
+
+  SlotDirectory *dir = directory();
+  dir->slot_num      = 0;
+  dir->heap_offset   = page_data_size;
+  frame_->mark_dirty();
+  return RC::SUCCESS;
+}
+
+VarRowRecordPageHandler::SlotDirectory *VarRowRecordPageHandler::directory() const
+{
+  return reinterpret_cast<SlotDirectory *>(frame_->data() + page_header_->data_offset);
+}
+
+VarRowRecordPageHandler::Slot *VarRowRecordPageHandler::slots() const
+{
+  return reinterpret_cast<Slot *>(frame_->data() + page_header_->data_offset + sizeof(SlotDirectory));
+}
+
+const int *VarRowRecordPageHandler::column_desc() const
+{
+  return reinterpret_cast<const int *>(frame_->data() + page_header_->col_idx_offset);
+}
+
+int VarRowRecordPageHandler::free_space() const
+{
+  const SlotDirectory *dir       = directory();
+  const int            slots_end = page_header_->data_offset + sizeof(SlotDirectory) + dir->slot_num * sizeof(Slot);
+  return dir->heap_offset - slots_end;
+}
+
+int VarRowRecordPageHandler::max_encoded_size() const { return page_header_->record_size; }
+
+int VarRowRecordPageHandler::encoded_size(const char *data) const
+{
+  if (page_header_->column_num == 0) {
+    return VAR_LENGTH_SIZE + trimmed_length(data, page_header_->record_real_size);
+  }
+
+  const int *desc   = column_desc();
+  int        size   = 0;
+  int        offset = 0;
+  for (int i = 0; i < page_header_->column_num; i++) {
+    const int len = abs(desc[i]);
+    size += (desc[i] > 0) ? len : VAR_LENGTH_SIZE + trimmed_length(data + offset, len);
+    offset += len;
+  }
+  return size;
+}
+
+void VarRowRecordPageHandler::encode(const char *data, char *dest) const
+{
+  auto encode_var = [&dest](const char *field, int len) {
+    const uint16_t trimmed = static_cast<uint16_t>(trimmed_length(field, len));
+    memcpy(dest, &trimmed, VAR_LENGTH_SIZE);
+    memcpy(dest + VAR_LENGTH_SIZE, field, trimmed);
+    dest += VAR_LENGTH_SIZE + trimmed;
+  };
+
+  if (page_header_->column_num == 0) {
+    encode_var(data, page_header_->record_real_size);
+    return;
+  }
+
+  const int *desc = column_desc();
+  for (int i = 0; i < page_header_->column_num; i++) {
+    const int len = abs(desc[i]);
+    if (desc[i] > 0) {
+      memcpy(dest, data, len);
+      dest += len;
+    } else {
+      encode_var(data, len);
+    }
+    data += len;
+  }
+}
+
+void VarRowRecordPageHandler::decode(const char *src, char *data) const
+{
+  auto decode_var = [&src](char *field, int len) {
+    uint16_t trimmed = 0;
+    memcpy(&trimmed, src, VAR_LENGTH_SIZE);
+    memcpy(field, src + VAR_LENGTH_SIZE, trimmed);
+    memset(field + trimmed, 0, len - trimmed);
+    src += VAR_LENGTH_SIZE + trimmed;
+  };
+
+  if (page_header_->column_num == 0) {
+    decode_var(data, page_header_->record_real_size);
+    return;
+  }
+
+  const int *desc = column_desc();
+  for (int i = 0; i < page_header_->column_num; i++) {
+    const int len = abs(desc[i]);
+    if (desc[i] > 0) {
+      memcpy(data, src, len);
+      src += len;
+    } else {
+      decode_var(data, len);
+    }
+    data += len;
+  }
+}
+
+RC VarRowRecordPageHandler::place_record(SlotNum slot_num, const char *data)
+{
+  SlotDirectory *dir         = directory();
+  const int      size        = encoded_size(data);
+  const int      new_slots   = (slot_num >= dir->slot_num) ? slot_num + 1 - dir->slot_num : 0;
+  if (free_space() < size + new_slots * static_cast<int>(sizeof(Slot))) {
+    return RC::RECORD_NOMEM;
+  }
+
+  if (new_slots > 0) {
+    memset(slots() + dir->slot_num, 0, new_slots * sizeof(Slot));
+    dir->slot_num = slot_num + 1;
+  }
+
+  dir->heap_offset -= size;
+  encode(data, frame_->data() + dir->heap_offset);
+
+  Slot &slot  = slots()[slot_num];
+  slot.offset = static_cast<uint16_t>(dir->heap_offset);
+  slot.length = static_cast<uint16_t>(size);
+  return RC::SUCCESS;
+}
+
+void VarRowRecordPageHandler::remove_record_data(SlotNum slot_num)
+{
+  SlotDirectory *dir    = directory();
+  Slot          *all    = slots();
+  const int      offset = all[slot_num].offset;
+  const int      length = all[slot_num].length;
+
+  // 记录区中在这条记录前面的数据整体往后挪，空闲空间保持连续
+  char *page = frame_->data();
+  memmove(page + dir->heap_offset + length, page + dir->heap_offset, offset - dir->heap_offset);
+  for (int i = 0; i < dir->slot_num; i++) {
+    if (all[i].length > 0 && all[i].offset < offset) {
+      all[i].offset += length;
+    }
+  }
+  dir->heap_offset += length;
+
+  all[slot_num].offset = 0;
+  all[slot_num].length = 0;
+}
+
+void VarRowRecordPageHandler::shrink_directory()
+{
+  SlotDirectory *dir = directory();
+  Slot          *all = slots();
+  while (dir->slot_num > 0 && all[dir->slot_num - 1].length == 0) {
+    dir->slot_num--;
+  }
+}
+
+RC VarRowRecordPageHandler::insert_record(const char *data, RID *rid)
+{
+  ASSERT(rw_mode_ != ReadWriteMode::READ_ONLY, 
+         "cannot insert record into page while the page is readonly");
+
+  if (page_header_->record_num >= page_header_->record_capacity) {
+    LOG_WARN("Page is full, page_num %d:%d.", disk_buffer_pool_->file_desc(), frame_->page_num());
+    return RC::RECORD_NOMEM;
+  }
+
+  // 找到空闲位置
+  Bitmap bitmap(bitmap_, page_header_->record_capacity);
+  int    index = bitmap.next_unsetted_bit(0);
+  RC     rc    = place_record(index, data);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("Page has no space for record, page_num %d:%d. free space=%d",
+             disk_buffer_pool_->file_desc(), frame_->page_num(), free_space());
+    return rc;
+  }
+  bitmap.set_bit(index);
+  page_header_->record_num++;
+
+  // 记录日志，与数据库恢复相关
+  rc = log_handler_.insert_record(frame_, RID(get_page_num(), index), data);
+  if (OB_FAIL(rc)) {
+    LOG_ERROR("Failed to insert record. page_num %d:%d. rc=%s", disk_buffer_pool_->file_desc(), frame_->page_num(), strrc(rc));
+    // return rc; // ignore errors
+  }
+
+  frame_->mark_dirty();
+
+  if (rid) {
+    rid->page_num = get_page_num();
+    rid->slot_num = index;
+  }
+  return RC::SUCCESS;
+}
+
+RC VarRowRecordPageHandler::recover_insert_record(const char *data, const RID &rid)
+{
+  if (rid.slot_num >= page_header_->record_capacity) {
+    LOG_WARN("slot_num illegal, slot_num(%d) > record_capacity(%d).", rid.slot_num, page_header_->record_capacity);
+    return RC::RECORD_INVALID_RID;
+  }
+
+  Bitmap bitmap(bitmap_, page_header_->record_capacity);
+  if (bitmap.get_bit(rid.slot_num)) {
+    remove_record_data(rid.slot_num);
+  } else {
+    bitmap.set_bit(rid.slot_num);
+    page_header_->record_num++;
+  }
+
+  RC rc = place_record(rid.slot_num, data);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("Page has no space for record, page_num %d:%d. free space=%d",
+             disk_buffer_pool_->file_desc(), frame_->page_num(), free_space());
+    return rc;
+  }
+
+  frame_->mark_dirty();
+  return RC::SUCCESS;
+}
+
+RC VarRowRecordPageHandler::delete_record(const RID *rid)
+{
+  ASSERT(rw_mode_ != ReadWriteMode::READ_ONLY, 
+         "cannot delete record from page while the page is readonly");
+
+  if (rid->slot_num >= page_header_->record_capacity) {
+    LOG_ERROR("Invalid slot_num %d, exceed page's record capacity, frame=%s, page_header=%s",
+              rid->slot_num, frame_->to_string().c_str(), page_header_->to_string().c_str());
+    return RC::RECORD_INVALID_RID;
+  }
+
+  Bitmap bitmap(bitmap_, page_header_->record_capacity);
+  if (!bitmap.get_bit(rid->slot_num)) {
+    LOG_DEBUG("Invalid slot_num %d, slot is empty, page_num %d.", rid->slot_num, frame_->page_num());
+    return RC::RECORD_NOT_EXIST;
+  }
+
+  bitmap.clear_bit(rid->slot_num);
+  page_header_->record_num--;
+  remove_record_data(rid->slot_num);
+  shrink_directory();
+  frame_->mark_dirty();
+
+  RC rc = log_handler_.delete_record(frame_, *rid);
+  if (OB_FAIL(rc)) {
+    LOG_ERROR("Failed to delete record. page_num %d:%d. rc=%s", disk_buffer_pool_->file_desc(), frame_->page_num(), strrc(rc));
+    // return rc; // ignore errors
+  }
+  return RC::SUCCESS;
+}
+
+RC VarRowRecordPageHandler::update_record(const RID &rid, const char *data)
+{
+  ASSERT(rw_mode_ != ReadWriteMode::READ_ONLY, "cannot update record in page while the page is readonly");
+
+  if (rid.slot_num >= page_header_->record_capacity) {
+    LOG_ERROR("Invalid slot_num %d, exceed page's record capacity, frame=%s, page_header=%s",
+              rid.slot_num, frame_->to_string().c_str(), page_header_->to_string().c_str());
+    return RC::INVALID_ARGUMENT;
+  }
+
+  Bitmap bitmap(bitmap_, page_header_->record_capacity);
+  if (!bitmap.get_bit(rid.slot_num)) {
+    LOG_DEBUG("Invalid slot_num %d, slot is empty, page_num %d.", rid.slot_num, frame_->page_num());
+    return RC::RECORD_NOT_EXIST;
+  }
+
+  Slot     &slot = slots()[rid.slot_num];
+  const int size = encoded_size(data);
+  if (size == slot.length) {
+    encode(data, frame_->data() + slot.offset);
+  } else {
+    // 长度变化时先移走原来的数据，再放到记录区的最前面
+    if (free_space() + slot.length < size) {
+      LOG_WARN("Page has no space for updated record, page_num %d:%d. free space=%d, size=%d",
+               disk_buffer_pool_->file_desc(), frame_->page_num(), free_space(), size);
+      return RC::RECORD_NOMEM;
+    }
+    remove_record_data(rid.slot_num);
+    RC rc = place_record(rid.slot_num, data);
+    ASSERT(OB_SUCC(rc), "failed to place updated record. rc=%s", strrc(rc));
+  }
+  frame_->mark_dirty();
+
+  RC rc = log_handler_.update_record(frame_, rid, data);
+  if (OB_FAIL(rc)) {
+    LOG_ERROR("Failed to update record. page_num %d:%d. rc=%s", 
+              disk_buffer_pool_->file_desc(), frame_->page_num(), strrc(rc));
+    // return rc; // ignore errors
+  }
+  return RC::SUCCESS;
+}
+
+RC VarRowRecordPageHandler::get_record(const RID &rid, Record &record)
+{
+  if (rid.slot_num >= page_header_->record_capacity) {
+    LOG_ERROR("Invalid slot_num %d, exceed page's record capacity, frame=%s, page_header=%s",
+              rid.slot_num, frame_->to_string().c_str(), page_header_->to_string().c_str());
+    return RC::RECORD_INVALID_RID;
+  }
+
+  Bitmap bitmap(bitmap_, page_header_->record_capacity);
+  if (!bitmap.get_bit(rid.slot_num)) {
+    LOG_ERROR("Invalid slot_num:%d, slot is empty, page_num %d.", rid.slot_num, frame_->page_num());
+    return RC::RECORD_NOT_EXIST;
+  }
+
+  RC rc = record.new_record(page_header_->record_real_size);
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+  decode(frame_->data() + slots()[rid.slot_num].offset, record.data());
+  record.set_rid(rid);
+  return RC::SUCCESS;
+}
+
+bool VarRowRecordPageHandler::is_full() const
+{
+  return page_header_->record_num >= page_header_->record_capacity ||
+         free_space() < max_encoded_size() + static_cast<int>(sizeof(Slot));
+}
+
+int VarRowRecordPageHandler::free_record_num() const
+{
+  if (is_full()) {
+    return 0;
+  }
+  // 按照最长的记录估算，至少还能插入一条
+  const int free_num = free_space() / (max_encoded_size() + static_cast<int>(sizeof(Slot)));
+  return min(free_num, page_header_->record_capacity - page_header_->record_num);
+}
+
+int VarRowRecordPageHandler::free_class() const
+{
+  // 记录长度不同，按照空闲空间的比例计算
+  if (is_full()) {
+    return RecordFreeSpaceMap::FULL_CLASS;
+  }
+  return RecordFreeSpaceMap::free_class(free_space(), frame_->page_data_size() - page_header_->data_offset);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 RecordFileHandler::~RecordFileHandler() { this->close(); }
 
 RC RecordFileHandler::init(
@@ -527,7 +1046,10 @@ RC RecordFileHandler::init(
 void RecordFileHandler::close()
 {
   if (disk_buffer_pool_ != nullptr) {
-    free_pages_.clear();
+    for (InsertTarget &target : insert_targets_) {
+      target.page_num.store(BP_INVALID_PAGE_NUM);
+    }
+    (void)free_space_map_.close();
     disk_buffer_pool_ = nullptr;
     log_handler_      = nullptr;
     table_meta_       = nullptr;
@@ -536,9 +1058,29 @@ void RecordFileHandler::close()
 
 RC RecordFileHandler::init_free_pages()
 {
-  // 遍历当前文件上所有页面，找到没有满的页面
-  // 这个效率很低，会降低启动速度
-  // NOTE: 由于是初始化时的动作，所以不需要加锁控制并发
+  // 空闲空间表是一个提示，打开失败时仍然可以只在内存中使用
+  const string fsm_file = string(disk_buffer_pool_->filename()) + ".fsm";
+  bool         loaded   = false;
+  RC           rc       = free_space_map_.open(fsm_file.c_str(), disk_buffer_pool_->page_count(), loaded);
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to open free space map, use it in memory only. file=%s, rc=%s", fsm_file.c_str(), strrc(rc));
+  }
+  if (loaded) {
+    return RC::SUCCESS;
+  }
+
+  // 上次没有正常关闭，遍历当前文件上所有页面，重新构建空闲空间表
+  return rebuild_free_pages();
+}
+
+RC RecordFileHandler::rebuild_free_pages()
+{
+  // NOTE: 只在初始化和恢复时调用，所以不需要加锁控制并发
+  // 插入目标页面的占用标识也会被清空，一起丢弃
+  for (InsertTarget &target : insert_targets_) {
+    target.page_num.store(BP_INVALID_PAGE_NUM);
+  }
+  free_space_map_.clear();
 
   RC rc = RC::SUCCESS;
 
@@ -556,45 +1098,82 @@ RC RecordFileHandler::init_free_pages()
       return rc;
     }
 
-    if (!record_page_handler->is_full()) {
-      free_pages_.insert(current_page_num);
-    }
+    free_space_map_.update(current_page_num, record_page_handler->free_class());
     record_page_handler->cleanup();
   }
-  LOG_INFO("record file handler init free pages done. free page num=%d, rc=%s", free_pages_.size(), strrc(rc));
+  LOG_INFO("record file handler rebuild free pages done. free page num=%d, rc=%s",
+           free_space_map_.free_page_num(), strrc(rc));
   return rc;
 }
 
+atomic<PageNum> &RecordFileHandler::insert_target()
+{
+  static atomic<int>     next_thread_index{0};
+  static thread_local int thread_index = next_thread_index.fetch_add(1);
+  return insert_targets_[thread_index % INSERT_TARGET_NUM].page_num;
+}
+
+void RecordFileHandler::set_insert_target(atomic<PageNum> &target, PageNum page_num)
+{
+  PageNum old_page_num = target.exchange(page_num);
+  if (old_page_num != BP_INVALID_PAGE_NUM && old_page_num != page_num) {
+    free_space_map_.release(old_page_num);
+  }
+}
+
+void RecordFileHandler::retire_insert_target(atomic<PageNum> &target, PageNum page_num)
+{
+  // 共用槽位的线程可能已经换了目标页面
+  if (target.compare_exchange_strong(page_num, BP_INVALID_PAGE_NUM)) {
+    free_space_map_.release(page_num);
+  }
+}
+
 RC RecordFileHandler::insert_record(const char *data, int record_size, RID *rid)
 {
   RC ret = RC::SUCCESS;
 
   unique_ptr<RecordPageHandler> record_page_handler(RecordPageHandler::create(storage_format_));
+  atomic<PageNum>              &target           = insert_target();
   bool                          page_found       = false;
-  PageNum                       current_page_num = 0;
+  PageNum                       current_page_num = target.load();
 
-  // 当前要访问free_pages对象，所以需要加锁。在非并发编译模式下，不需要考虑这个锁
-  lock_.lock();
+  // 先使用当前线程的目标页面
+  if (current_page_num != BP_INVALID_PAGE_NUM) {
+    ret = record_page_handler->init(*disk_buffer_pool_, *log_handler_, current_page_num, ReadWriteMode::READ_WRITE);
+    if (OB_FAIL(ret)) {
+      LOG_WARN("failed to init record page handler. page num=%d, rc=%d:%s", current_page_num, ret, strrc(ret));
+      return ret;
+    }
 
-  // 找到没有填满的页面
-  while (!free_pages_.empty()) {
-    current_page_num = *free_pages_.begin();
+    if (!record_page_handler->is_full()) {
+      page_found = true;
+    } else {
+      free_space_map_.update(current_page_num, RecordFreeSpaceMap::FULL_CLASS);
+      record_page_handler->cleanup();
+      retire_insert_target(target, current_page_num);
+    }
+  }
 
+  // 目标页面满了，从空闲空间表中找一个删除记录之后空出来的页面。
+  // 空闲空间表只是提示，拿到页面写锁之后需要再检查一次
+  while (!page_found && (current_page_num = free_space_map_.claim_free_page()) != BP_INVALID_PAGE_NUM) {
     ret = record_page_handler->init(*disk_buffer_pool_, *log_handler_, current_page_num, ReadWriteMode::READ_WRITE);
     if (OB_FAIL(ret)) {
-      lock_.unlock();
+      free_space_map_.release(current_page_num);
       LOG_WARN("failed to init record page handler. page num=%d, rc=%d:%s", current_page_num, ret, strrc(ret));
       return ret;
     }
 
     if (!record_page_handler->is_full()) {
       page_found = true;
+      set_insert_target(target, current_page_num);
       break;
     }
+    free_space_map_.update(current_page_num, RecordFreeSpaceMap::FULL_CLASS);
     record_page_handler->cleanup();
-    free_pages_.erase(free_pages_.begin());
+    free_space_map_.release(current_page_num);
   }
-  lock_.unlock();  // 如果找到了一个有效的页面，那么此时已经拿到了页面的写锁
 
   // 找不到就分配一个新的页面
   if (!page_found) {
@@ -618,17 +1197,14 @@ RC RecordFileHandler::insert_record(const char *data, int record_size, RID *rid)
     // frame 在allocate_page的时候，是有一个pin的，在init_empty_page时又会增加一个，所以这里手动释放一个
     frame->unpin();
 
-    // 这里的加锁顺序看起来与上面是相反的，但是不会出现死锁
-    // 上面的逻辑是先加lock锁，然后加页面写锁，这里是先加上
-    // 了页面写锁，然后加lock的锁，但是不会引起死锁。
-    // 为什么？
-    lock_.lock();
-    free_pages_.insert(current_page_num);
-    lock_.unlock();
+    (void)free_space_map_.claim(current_page_num);
+    set_insert_target(target, current_page_num);
   }
 
-  // 找到空闲位置
-  return record_page_handler->insert_record(data, rid);
+  // 找到空闲位置。仍然持有页面写锁，同一个页面的空闲程度按顺序更新
+  ret = record_page_handler->insert_record(data, rid);
+  free_space_map_.update(current_page_num, record_page_handler->free_class());
+  return ret;
 }
 
 RC RecordFileHandler::insert_chunk(const Chunk &chunk, int record_size)
@@ -665,18 +1241,12 @@ RC RecordFileHandler::delete_record(const RID *rid)
   }
 
   rc = record_page_handler->delete_record(rid);
-  // 📢 这里注意要清理掉资源，否则会与insert_record中的加锁顺序冲突而可能出现死锁
-  // delete record的加锁逻辑是拿到页面锁，删除指定记录，然后加上和释放record manager锁
-  // insert record是加上 record manager锁，然后拿到指定页面锁再释放record manager锁
-  record_page_handler->cleanup();
   if (OB_SUCC(rc)) {
-    // 因为这里已经释放了页面锁，并发时，其它线程可能又把该页面填满了，那就不应该再放入 free_pages_
-    // 中。但是这里可以不关心，因为在查找空闲页面时，会自动过滤掉已经满的页面
-    lock_.lock();
-    free_pages_.insert(rid->page_num);
-    LOG_TRACE("add free page %d to free page list", rid->page_num);
-    lock_.unlock();
+    // 持有页面写锁的时候更新空闲空间表，与插入记录时的更新不会乱序
+    free_space_map_.update(rid->page_num, record_page_handler->free_class());
+    LOG_TRACE("update free space of page %d", rid->page_num);
   }
+  record_page_handler->cleanup();
   return rc;
 }
 
@@ -746,6 +1316,8 @@ RC ChunkFileScanner::close_scan()
     record_page_handler_ = nullptr;
   }
 
+  buffer_ring_.reset();
+  next_slot_ = -1;
   return RC::SUCCESS;
 }
 
@@ -754,6 +1326,13 @@ RC ChunkFileScanner::open_scan_chunk(
 {
   close_scan();
 
+  const StorageFormat format = (table == nullptr) ? StorageFormat::ROW_FORMAT : table->table_meta().storage_format();
+  if (format == StorageFormat::VAR_ROW_FORMAT) {
+    // 变长记录的页面是按照槽位存放的，不能按列读取
+    LOG_WARN("chunk scan does not support var row format. table=%s", table->name());
+    return RC::UNSUPPORTED;
+  }
+
   table_            = table;
   disk_buffer_pool_ = &buffer_pool;
   log_handler_      = &log_handler;
@@ -764,10 +1343,11 @@ RC ChunkFileScanner::open_scan_chunk(
     LOG_WARN("failed to init bp iterator. rc=%d:%s", rc, strrc(rc));
     return rc;
   }
-  if (table == nullptr || table->table_meta().storage_format() == StorageFormat::ROW_FORMAT) {
-    record_page_handler_ = new RowRecordPageHandler();
-  } else {
-    record_page_handler_ = new PaxRecordPageHandler();
+  record_page_handler_ = RecordPageHandler::create(format);
+
+  if (BufferRing::need_ring(buffer_pool)) {
+    buffer_ring_ = make_unique<BufferRing>();
+    record_page_handler_->set_buffer_ring(buffer_ring_.get());
   }
 
   return rc;
@@ -777,25 +1357,39 @@ RC ChunkFileScanner::next_chunk(Chunk &chunk)
 {
   RC rc = RC::SUCCESS;
 
-  while (bp_iterator_.has_next()) {
-    PageNum page_num = bp_iterator_.next();
-    record_page_handler_->cleanup();
-    rc = record_page_handler_->init(*disk_buffer_pool_, *log_handler_, page_num, rw_mode_, table_->lob_handler());
-    if (OB_FAIL(rc)) {
-      LOG_WARN("failed to init record page handler. page_num=%d, rc=%s", page_num, strrc(rc));
-      return rc;
+  while (true) {
+    // 上一个页面读完了才读取下一个页面
+    if (next_slot_ < 0) {
+      if (!bp_iterator_.has_next()) {
+        break;
+      }
+
+      PageNum page_num = bp_iterator_.next();
+      record_page_handler_->cleanup();
+      rc = record_page_handler_->init(*disk_buffer_pool_, *log_handler_, page_num, rw_mode_, table_->lob_handler());
+      if (OB_FAIL(rc)) {
+        LOG_WARN("failed to init record page handler. page_num=%d, rc=%s", page_num, strrc(rc));
+        return rc;
+      }
+      next_slot_ = 0;
     }
-    rc = record_page_handler_->get_chunk(chunk);
+
+    rc = record_page_handler_->get_chunk(chunk, next_slot_);
     if (rc == RC::SUCCESS) {
+      // 页面中的记录都删除了，继续读下一个页面
+      if (chunk.rows() == 0) {
+        continue;
+      }
       return rc;
     } else if (rc == RC::RECORD_EOF) {
       break;
     } else {
-      LOG_WARN("failed to get chunk from page. page_num=%d, rc=%s", page_num, strrc(rc));
+      LOG_WARN("failed to get chunk from page. page_num=%d, rc=%s", record_page_handler_->get_page_num(), strrc(rc));
       return rc;
     }
   }
 
   record_page_handler_->cleanup();
+  next_slot_ = -1;
   return RC::RECORD_EOF;
 }
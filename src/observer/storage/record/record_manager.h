@@ -16,9 +16,11 @@ See the Mulan PSL v2 for more details. */
 
 #include "common/lang/bitmap.h"
 #include "common/lang/sstream.h"
+#include "common/lang/unordered_set.h"
 #include "storage/buffer/disk_buffer_pool.h"
 #include "storage/common/chunk.h"
 #include "storage/record/record.h"
+#include "storage/record/record_free_space_map.h"
 #include "storage/record/record_log.h"
 #include "storage/record/lob_handler.h"
 #include "common/types.h"
@@ -148,6 +150,11 @@ public:
    */
   RC recover_init(DiskBufferPool &buffer_pool, PageNum page_num);
 
+  /**
+   * @brief 设置顺序扫描时使用的页帧环，之后 init 加载页面时都会通过这个环，参考 BufferRing
+   */
+  void set_buffer_ring(BufferRing *buffer_ring) { buffer_ring_ = buffer_ring; }
+
   /**
    * @brief 对一个新的页面做初始化，初始化关于该页面记录信息的页头PageHeader
    *
@@ -156,7 +163,7 @@ public:
    * @param record_size 每个记录的大小
    * @param table_meta  表的元数据
    */
-  RC init_empty_page(DiskBufferPool &buffer_pool, LogHandler &log_handler, PageNum page_num, int record_size,
+  virtual RC init_empty_page(DiskBufferPool &buffer_pool, LogHandler &log_handler, PageNum page_num, int record_size,
       TableMeta *table_meta, LobFileHandler *lob_handler = nullptr);
 
   /**
@@ -167,7 +174,7 @@ public:
    * @param col_num  表中包含的列数
    * @param col_idx_data 列索引数据
    */
-  RC init_empty_page(DiskBufferPool &buffer_pool, LogHandler &log_handler, PageNum page_num, int record_size,
+  virtual RC init_empty_page(DiskBufferPool &buffer_pool, LogHandler &log_handler, PageNum page_num, int record_size,
       int col_num, const char *col_idx_data, LobFileHandler *lob_handler = nullptr);
 
   /**
@@ -215,12 +222,14 @@ public:
   virtual RC get_record(const RID &rid, Record &record) { return RC::UNIMPLEMENTED; }
 
   /**
-   * @brief 获取整个页面中指定列的所有记录。
+   * @brief 获取页面中指定列的记录。
    *
    * @param chunk 由 chunk.column(i).col_id() 指定列。
+   * @param[in,out] start_slot 从这个槽位开始读取，直到页面读完或 chunk 放满。
+   * 返回时指向下一次读取的位置，页面读完时为 -1。
    * 只需由 PaxRecordPageHandler 实现。
    */
-  virtual RC get_chunk(Chunk &chunk) { return RC::UNIMPLEMENTED; }
+  virtual RC get_chunk(Chunk &chunk, SlotNum &start_slot) { return RC::UNIMPLEMENTED; }
 
   /**
    * @brief 返回该记录页的页号
@@ -230,7 +239,17 @@ public:
   /**
    * @brief 当前页面是否已经没有空闲位置插入新的记录
    */
-  bool is_full() const;
+  virtual bool is_full() const;
+
+  /**
+   * @brief 页面中还可以插入多少条记录
+   */
+  virtual int free_record_num() const;
+
+  /**
+   * @brief 页面的空闲程度，参考 RecordFreeSpaceMap::free_class
+   */
+  virtual int free_class() const;
 
 protected:
   /**
@@ -242,7 +261,7 @@ protected:
   void fix_record_capacity()
   {
     int32_t last_record_offset = page_header_->data_offset + page_header_->record_capacity * page_header_->record_size;
-    while (last_record_offset > BP_PAGE_DATA_SIZE) {
+    while (last_record_offset > frame_->page_data_size()) {
       page_header_->record_capacity -= 1;
       last_record_offset -= page_header_->record_size;
     }
@@ -267,6 +286,7 @@ protected:
   char           *bitmap_      = nullptr;  ///< 当前页面上record分配状态信息bitmap内存起始位置
   StorageFormat   storage_format_;
   LobFileHandler *lob_handler_ = nullptr;
+  BufferRing     *buffer_ring_ = nullptr;  ///< 顺序扫描时使用的页帧环
 
 protected:
   friend class RecordPageIterator;
@@ -344,11 +364,12 @@ public:
   virtual RC get_record(const RID &rid, Record &record) override;
 
   /**
-   * @brief 以 Chunk 格式获取整个页面中指定列的所有记录。
+   * @brief 以 Chunk 格式获取页面中指定列的记录。
    *
    * @param chunk 由 chunk.column(i).col_id() 指定列。
+   * @param[in,out] start_slot 大页面中的记录可能超过列的容量，分多次读取
    */
-  virtual RC get_chunk(Chunk &chunk) override;
+  virtual RC get_chunk(Chunk &chunk, SlotNum &start_slot) override;
 
 private:
   // get the field data by `slot_num` and `column id`
@@ -357,6 +378,107 @@ private:
   // get the field length by `column id`, all columns are fixed length.
   int get_field_len(int col_id);
 };
+
+/**
+ * @brief 负责处理变长行存页面中各种操作
+ * @ingroup RecordManager
+ * @details 使用槽位目录(slotted page)组织页面，每条记录按照实际的长度保存：
+ * @code
+ * | PageHeader | record allocate bitmap | column desc | slot directory ...->      |
+ * |-----------------------------------------------------------------------------|
+ * |      free space      | <-... recordN | ..... | record2 | record1              |
+ * @endcode
+ * 槽位目录从前往后增长，记录从页面末尾往前存放，中间是连续的空闲空间。每个槽位记录了记录在页面中的偏移和长度，
+ * RID 中的 slot num 仍然是槽位的编号，记录在页面内移动时 RID 不变。删除记录或者记录长度变化时，
+ * 立即把后面的记录挪过来(compaction)，空闲空间始终是连续的。
+ *
+ * 列描述(column desc)记录了每个字段的长度，正数表示定长字段，原样保存；负数表示字符串字段，
+ * 保存时去掉末尾填充的0，前面加上两个字节的长度，读取时再补齐。没有列描述时(比如没有表元数据的测试)，
+ * 整条记录当作一个字符串字段。
+ *
+ * 对外仍然使用定长的记录格式，日志中也是完整的记录，所以读取记录时需要复制出来。
+ * 为了保证一定能再插入一条记录，剩余空间不足一条最长的记录时就认为页面已满。
+ */
+class VarRowRecordPageHandler : public RecordPageHandler
+{
+public:
+  VarRowRecordPageHandler() : RecordPageHandler(StorageFormat::VAR_ROW_FORMAT) {}
+
+  virtual RC init_empty_page(DiskBufferPool &buffer_pool, LogHandler &log_handler, PageNum page_num, int record_size,
+      TableMeta *table_meta, LobFileHandler *lob_handler = nullptr) override;
+
+  virtual RC init_empty_page(DiskBufferPool &buffer_pool, LogHandler &log_handler, PageNum page_num, int record_size,
+      int col_num, const char *col_idx_data, LobFileHandler *lob_handler = nullptr) override;
+
+  virtual RC insert_record(const char *data, RID *rid) override;
+
+  virtual RC recover_insert_record(const char *data, const RID &rid) override;
+
+  virtual RC delete_record(const RID *rid) override;
+
+  /**
+   * @brief 更新记录，记录变长时如果页面剩余空间不够，返回 RECORD_NOMEM
+   */
+  virtual RC update_record(const RID &rid, const char *data) override;
+
+  /**
+   * @brief 获取指定位置的记录数据
+   *
+   * @param rid 指定的位置
+   * @param record 返回指定的数据。记录需要解码，所以会复制出来
+   */
+  virtual RC get_record(const RID &rid, Record &record) override;
+
+  virtual bool is_full() const override;
+  virtual int  free_record_num() const override;
+  virtual int  free_class() const override;
+
+  /**
+   * @brief 页面中连续的空闲空间大小
+   */
+  int free_space() const;
+
+private:
+  /**
+   * @brief 槽位目录头，位于 data_offset，后面紧跟着 slot_num 个 Slot
+   */
+  struct SlotDirectory
+  {
+    int32_t slot_num;     ///< 槽位目录中的槽位个数，最后一个槽位总是在使用中
+    int32_t heap_offset;  ///< 记录区的起始偏移，记录区一直到页面末尾
+  };
+
+  struct Slot
+  {
+    uint16_t offset;  ///< 记录在页面中的偏移
+    uint16_t length;  ///< 记录编码之后的长度
+  };
+
+  static constexpr int VAR_LENGTH_SIZE = sizeof(uint16_t);
+
+  /// 根据列描述初始化页头和槽位目录
+  RC init_page_layout(int record_size, int column_num, const int *column_desc);
+
+  SlotDirectory *directory() const;
+  Slot          *slots() const;
+  const int     *column_desc() const;
+
+  /// 编码之后的长度
+  int encoded_size(const char *data) const;
+  /// 编码之后最长的长度
+  int max_encoded_size() const;
+  void encode(const char *data, char *dest) const;
+  void decode(const char *src, char *data) const;
+
+  /**
+   * @brief 在指定的槽位放入记录，槽位当前必须是空闲的
+   */
+  RC   place_record(SlotNum slot_num, const char *data);
+  /// 移除槽位指向的记录数据，把前面的记录挪过来。不修改 bitmap
+  void remove_record_data(SlotNum slot_num);
+  /// 去掉槽位目录末尾不再使用的槽位
+  void shrink_directory();
+};
 /**
  * @brief 管理整个文件中记录的增删改查
  * @ingroup RecordManager
@@ -411,20 +533,58 @@ public:
 
   RC visit_record(const RID &rid, function<bool(Record &)> updater);
 
+  /**
+   * @brief 空闲空间表，测试时使用
+   */
+  RecordFreeSpaceMap &free_space_map() { return free_space_map_; }
+
+  /**
+   * @brief 扫描所有页面重新构建空闲空间表
+   * @details 重做日志直接修改页面，不会更新空闲空间表，恢复之后需要重新构建
+   */
+  RC rebuild_free_pages();
+
 private:
   /**
-   * @brief 初始化当前没有填满记录的页面，初始化free_pages_成员
+   * @brief 打开空闲空间表，上次没有正常关闭时，扫描所有页面重新构建
    */
   RC init_free_pages();
 
+  /**
+   * @brief 当前线程插入记录的目标页面
+   */
+  atomic<PageNum> &insert_target();
+
+  /**
+   * @brief 设置插入的目标页面，原来的目标页面不再被占用
+   */
+  void set_insert_target(atomic<PageNum> &target, PageNum page_num);
+
+  /**
+   * @brief 目标页面满了之后，不再使用它
+   */
+  void retire_insert_target(atomic<PageNum> &target, PageNum page_num);
+
 private:
-  DiskBufferPool        *disk_buffer_pool_ = nullptr;
-  LogHandler            *log_handler_      = nullptr;  ///< 记录日志的处理器
-  unordered_set<PageNum> free_pages_;                  ///< 没有填充满的页面集合
-  common::Mutex          lock_;  ///< 当编译时增加-DCONCURRENCY=ON 选项时，才会真正的支持并发
-  StorageFormat          storage_format_;
-  TableMeta             *table_meta_;
-  LobFileHandler        *lob_handler_ = nullptr;
+  /**
+   * @brief 插入记录的目标页面
+   * @details 每个线程第一次插入记录时分配一个编号，映射到一个槽位，之后一直往槽位中的页面插入，
+   * 页面满了再换一个，不同线程之间不会竞争同一个页面的写锁。线程数超过槽位数时多个线程共用一个槽位。
+   * 目标页面在空闲空间表中是占用状态，其它线程查找空闲页面时不会找到它。
+   */
+  struct alignas(64) InsertTarget
+  {
+    atomic<PageNum> page_num{BP_INVALID_PAGE_NUM};
+  };
+  static constexpr int INSERT_TARGET_NUM = 64;
+
+  DiskBufferPool    *disk_buffer_pool_ = nullptr;
+  LogHandler        *log_handler_      = nullptr;  ///< 记录日志的处理器
+  RecordFreeSpaceMap free_space_map_;              ///< 每个页面的空闲程度
+  InsertTarget       insert_targets_[INSERT_TARGET_NUM];
+  StorageFormat      storage_format_;
+  TableMeta         *table_meta_;
+  LobFileHandler    *lob_handler_ = nullptr;
 };
 
 /**
@@ -458,6 +618,8 @@ private:
   LogHandler     *log_handler_      = nullptr;
   ReadWriteMode   rw_mode_ = ReadWriteMode::READ_WRITE;  ///< 遍历出来的数据，是否可能对它做修改
 
-  BufferPoolIterator bp_iterator_;                    ///< 遍历buffer pool的所有页面
-  RecordPageHandler *record_page_handler_ = nullptr;  ///< 处理文件某页面的记录
+  BufferPoolIterator     bp_iterator_;                    ///< 遍历buffer pool的所有页面
+  unique_ptr<BufferRing> buffer_ring_;                    ///< 扫描大表时使用，避免污染缓冲池
+  RecordPageHandler     *record_page_handler_ = nullptr;  ///< 处理文件某页面的记录
+  SlotNum                next_slot_           = -1;       ///< 当前页面下次读取的槽位，-1 表示读取下一个页面
 };
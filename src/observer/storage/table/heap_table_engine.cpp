@@ -10,6 +10,8 @@ See the Mulan PSL v2 for more details. */
 
 #include "storage/table/heap_table_engine.h"
 #include "storage/record/heap_record_scanner.h"
+#include "common/lang/filesystem.h"
+#include "common/lang/system_error.h"
 #include "common/log/log.h"
 #include "storage/index/bplus_tree_index.h"
 #include "storage/common/meta_util.h"
@@ -122,34 +124,40 @@ RC HeapTableEngine::get_chunk_scanner(ChunkFileScanner &scanner, Trx *trx, ReadW
   return rc;
 }
 
-RC HeapTableEngine::create_index(Trx *trx, const FieldMeta *field_meta, const char *index_name)
+RC HeapTableEngine::create_index(
+    Trx *trx, const vector<const FieldMeta *> &field_metas, const char *index_name, bool unique)
 {
-  if (common::is_blank(index_name) || nullptr == field_meta) {
+  if (common::is_blank(index_name) || field_metas.empty()) {
     LOG_INFO("Invalid input arguments, table name is %s, index_name is blank or attribute_name is blank", table_meta_->name());
     return RC::INVALID_ARGUMENT;
   }
 
   IndexMeta new_index_meta;
 
-  RC rc = new_index_meta.init(index_name, *field_meta);
+  RC rc = new_index_meta.init(index_name, field_metas, unique);
   if (rc != RC::SUCCESS) {
     LOG_INFO("Failed to init IndexMeta in table:%s, index_name:%s, field_name:%s", 
-             table_meta_->name(), index_name, field_meta->name());
+             table_meta_->name(), index_name, field_metas[0]->name());
     return rc;
   }
 
+  vector<FieldMeta> index_fields;
+  for (const FieldMeta *field_meta : field_metas) {
+    index_fields.push_back(*field_meta);
+  }
+
   // 创建索引相关数据
   BplusTreeIndex *index      = new BplusTreeIndex();
   string          index_file = table_index_file(db_->path().c_str(), table_meta_->name(), index_name);
 
-  rc = index->create(table_, index_file.c_str(), new_index_meta, *field_meta);
+  rc = index->create(table_, index_file.c_str(), new_index_meta, index_fields);
   if (rc != RC::SUCCESS) {
     delete index;
     LOG_ERROR("Failed to create bplus tree index. file name=%s, rc=%d:%s", index_file.c_str(), rc, strrc(rc));
     return rc;
   }
 
-  // 遍历当前的所有数据，插入这个索引
+  // 遍历当前的所有数据，排序后批量构建索引
   RecordScanner *scanner = nullptr;
   rc = get_record_scanner(scanner, trx, ReadWriteMode::READ_ONLY);
   if (rc != RC::SUCCESS) {
@@ -158,24 +166,21 @@ RC HeapTableEngine::create_index(Trx *trx, const FieldMeta *field_meta, const ch
     return rc;
   }
 
-  Record record;
-  while (OB_SUCC(rc = scanner->next(record))) {
-    rc = index->insert_entry(record.data(), &record.rid());
-    if (rc != RC::SUCCESS) {
-      LOG_WARN("failed to insert record into index while creating index. table=%s, index=%s, rc=%s",
-               table_meta_->name(), index_name, strrc(rc));
-      return rc;
-    }
-  }
-  if (RC::RECORD_EOF == rc) {
-    rc = RC::SUCCESS;
-  } else {
-    LOG_WARN("failed to insert record into index while creating index. table=%s, index=%s, rc=%s",
+  const string sort_file_prefix = index_file + ".sort";
+  rc = index->bulk_load(
+      *scanner, sort_file_prefix.c_str(), db_->index_build_sort_buffer_size(), db_->index_build_fill_percent());
+  scanner->close_scan();
+  delete scanner;
+
+  if (OB_FAIL(rc)) {
+    // 比如唯一索引遇到了重复的键值，需要把创建了一半的索引文件删掉
+    LOG_WARN("failed to insert records into index while creating index. table=%s, index=%s, rc=%s",
              table_meta_->name(), index_name, strrc(rc));
+    delete index;
+    error_code ec;
+    filesystem::remove(index_file, ec);
     return rc;
   }
-  scanner->close_scan();
-  delete scanner;
   LOG_INFO("inserted all records into new index. table=%s, index=%s", table_meta_->name(), index_name);
 
   indexes_.push_back(index);
@@ -267,6 +272,16 @@ RC HeapTableEngine::sync()
   return rc;
 }
 
+RC HeapTableEngine::on_recovered()
+{
+  // 重做日志直接修改数据页面，空闲空间表中的内容已经过时了
+  RC rc = record_handler_->rebuild_free_pages();
+  if (OB_FAIL(rc)) {
+    LOG_WARN("failed to rebuild free pages after recovery. table=%s, rc=%s", table_meta_->name(), strrc(rc));
+  }
+  return rc;
+}
+
 Index *HeapTableEngine::find_index(const char *index_name) const
 {
   for (Index *index : indexes_) {
@@ -315,20 +330,24 @@ RC HeapTableEngine::open()
   init();
   const int index_num = table_meta_->index_num();
   for (int i = 0; i < index_num; i++) {
-    const IndexMeta *index_meta = table_meta_->index(i);
-    const FieldMeta *field_meta = table_meta_->field(index_meta->field());
-    if (field_meta == nullptr) {
-      LOG_ERROR("Found invalid index meta info which has a non-exists field. table=%s, index=%s, field=%s",
-                table_meta_->name(), index_meta->name(), index_meta->field());
-      // skip cleanup
-      //  do all cleanup action in destructive Table function
-      return RC::INTERNAL;
+    const IndexMeta  *index_meta = table_meta_->index(i);
+    vector<FieldMeta> index_fields;
+    for (const string &field_name : index_meta->fields()) {
+      const FieldMeta *field_meta = table_meta_->field(field_name.c_str());
+      if (field_meta == nullptr) {
+        LOG_ERROR("Found invalid index meta info which has a non-exists field. table=%s, index=%s, field=%s",
+                  table_meta_->name(), index_meta->name(), field_name.c_str());
+        // skip cleanup
+        //  do all cleanup action in destructive Table function
+        return RC::INTERNAL;
+      }
+      index_fields.push_back(*field_meta);
     }
 
     BplusTreeIndex *index      = new BplusTreeIndex();
     string          index_file = table_index_file(db_->path().c_str(), table_meta_->name(), index_meta->name());
 
-    rc = index->open(table_, index_file.c_str(), *index_meta, *field_meta);
+    rc = index->open(table_, index_file.c_str(), *index_meta, index_fields);
     if (rc != RC::SUCCESS) {
       delete index;
       LOG_ERROR("Failed to open index. table=%s, index=%s, file=%s, rc=%s",
@@ -37,11 +37,13 @@ public:
   }
   RC get_record(const RID &rid, Record &record) override;
 
-  RC create_index(Trx *trx, const FieldMeta *field_meta, const char *index_name) override;
+  RC create_index(
+      Trx *trx, const vector<const FieldMeta *> &field_metas, const char *index_name, bool unique) override;
   RC get_record_scanner(RecordScanner *&scanner, Trx *trx, ReadWriteMode mode) override;
   RC get_chunk_scanner(ChunkFileScanner &scanner, Trx *trx, ReadWriteMode mode) override;
   RC visit_record(const RID &rid, function<bool(Record &)> visitor) override;
   RC sync() override;
+  RC on_recovered() override;
 
   Index *find_index(const char *index_name) const override;
   Index *find_index_by_field(const char *field_name) const override;
@@ -39,12 +39,17 @@ public:
   }
   RC get_record(const RID &rid, Record &record) override { return RC::UNIMPLEMENTED; }
 
-  RC create_index(Trx *trx, const FieldMeta *field_meta, const char *index_name) override { return RC::UNIMPLEMENTED; }
+  RC create_index(
+      Trx *trx, const vector<const FieldMeta *> &field_metas, const char *index_name, bool unique) override
+  {
+    return RC::UNIMPLEMENTED;
+  }
   RC get_record_scanner(RecordScanner *&scanner, Trx *trx, ReadWriteMode mode) override;
   RC get_chunk_scanner(ChunkFileScanner &scanner, Trx *trx, ReadWriteMode mode) override { return RC::UNIMPLEMENTED; }
   RC visit_record(const RID &rid, function<bool(Record &)> visitor) override { return RC::UNIMPLEMENTED; }
   // TODO:
   RC     sync() override { return RC::SUCCESS; }
+  RC     on_recovered() override { return RC::SUCCESS; }
   Index *find_index(const char *index_name) const override { return nullptr; }
   Index *find_index_by_field(const char *field_name) const override { return nullptr; }
   RC     open() override;
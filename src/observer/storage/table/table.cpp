@@ -98,9 +98,12 @@ RC Table::create(Db *db, int32_t table_id, const char *path, const char *name, c
 
   db_       = db;
 
+  // PAX 格式的表按列存放数据，使用更大的页面可以让每个列块存放更多的数据
+  const int page_size = (storage_format == StorageFormat::PAX_FORMAT) ? db->pax_page_size() : BP_PAGE_SIZE;
+
   string             data_file = table_data_file(base_dir, name);
   BufferPoolManager &bpm       = db->buffer_pool_manager();
-  rc                           = bpm.create_file(data_file.c_str());
+  rc                           = bpm.create_file(data_file.c_str(), page_size);
   if (rc != RC::SUCCESS) {
     LOG_ERROR("Failed to create disk buffer pool of data file. file name=%s", data_file.c_str());
     return rc;
@@ -274,9 +277,9 @@ RC Table::get_chunk_scanner(ChunkFileScanner &scanner, Trx *trx, ReadWriteMode m
   return engine_->get_chunk_scanner(scanner, trx, mode);
 }
 
-RC Table::create_index(Trx *trx, const FieldMeta *field_meta, const char *index_name)
+RC Table::create_index(Trx *trx, const vector<const FieldMeta *> &field_metas, const char *index_name, bool unique)
 {
-  return engine_->create_index(trx, field_meta, index_name);
+  return engine_->create_index(trx, field_metas, index_name, unique);
 }
 
 RC Table::delete_record(const Record &record)
@@ -297,3 +300,8 @@ RC Table::sync()
 {
   return engine_->sync();
 }
+
+RC Table::on_recovered()
+{
+  return engine_->on_recovered();
+}
@@ -94,7 +94,7 @@ public:
   RC get_record(const RID &rid, Record &record);
 
   // TODO refactor
-  RC create_index(Trx *trx, const FieldMeta *field_meta, const char *index_name);
+  RC create_index(Trx *trx, const vector<const FieldMeta *> &field_metas, const char *index_name, bool unique = false);
 
   RC get_record_scanner(RecordScanner *&scanner, Trx *trx, ReadWriteMode mode);
 
@@ -121,6 +121,11 @@ public:
 
   RC sync();
 
+  /**
+   * @brief 重做日志回放之后调用，刷新只在内存中维护的页面信息
+   */
+  RC on_recovered();
+
 private:
   RC set_value_to_record(char *record_data, const Value &value, const FieldMeta *field);
 
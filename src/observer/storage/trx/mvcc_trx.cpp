@@ -44,6 +44,13 @@ const vector<FieldMeta> *MvccTrxKit::trx_fields() const { return &fields_; }
 
 int32_t MvccTrxKit::next_trx_id() { return ++current_trx_id_; }
 
+void MvccTrxKit::update_trx_id(int32_t trx_id)
+{
+  int32_t current = current_trx_id_.load();
+  while (current < trx_id && !current_trx_id_.compare_exchange_weak(current, trx_id)) {
+  }
+}
+
 int32_t MvccTrxKit::max_trx_id() const { return numeric_limits<int32_t>::max(); }
 
 Trx *MvccTrxKit::create_trx(LogHandler &log_handler)
@@ -63,10 +70,8 @@ Trx *MvccTrxKit::create_trx(LogHandler &log_handler, int32_t trx_id)
   if (trx != nullptr) {
     lock_.lock();
     trxes_.push_back(trx);
-    if (current_trx_id_ < trx_id) {
-      current_trx_id_ = trx_id;
-    }
     lock_.unlock();
+    update_trx_id(trx_id);
   }
   return trx;
 }
@@ -97,6 +102,17 @@ LogReplayer *MvccTrxKit::create_log_replayer(Db &db, LogHandler &log_handler)
   return new MvccTrxLogReplayer(db, *this, log_handler);
 }
 
+LSN MvccTrxKit::min_active_trx_lsn()
+{
+  LSN min_lsn = numeric_limits<LSN>::max();
+  lock_.lock();
+  for (Trx *trx : trxes_) {
+    min_lsn = min(min_lsn, static_cast<MvccTrx *>(trx)->start_lsn());
+  }
+  lock_.unlock();
+  return min_lsn;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 MvccTrx::MvccTrx(MvccTrxKit &kit, LogHandler &log_handler) : Trx(TrxKit::Type::MVCC), trx_kit_(kit), log_handler_(log_handler)
@@ -253,6 +269,7 @@ RC MvccTrx::start_if_need()
     trx_id_ = trx_kit_.next_trx_id();
     LOG_DEBUG("current thread change to new trx with %d", trx_id_);
     started_ = true;
+    start_lsn_.store(log_handler_.current_lsn() + 1);
   }
   return RC::SUCCESS;
 }
@@ -326,6 +343,8 @@ RC MvccTrx::commit_with_trx_id(int32_t commit_xid)
   }
 
   operations_.clear();
+  // 提交日志写入之后，检查点才可以越过这个事务的日志
+  start_lsn_.store(numeric_limits<LSN>::max());
 
   LOG_TRACE("append trx commit log. trx id=%d, commit_xid=%d, rc=%s", trx_id_, commit_xid, strrc(rc));
   return rc;
@@ -405,6 +424,7 @@ RC MvccTrx::rollback()
   if (!recovering_) {
     rc = log_handler_.rollback(trx_id_);
   }
+  start_lsn_.store(numeric_limits<LSN>::max());
   LOG_TRACE("append trx rollback log. trx id=%d, rc=%s", trx_id_, strrc(rc));
   return rc;
 }
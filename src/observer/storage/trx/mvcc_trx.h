@@ -39,9 +39,17 @@ public:
 
   LogReplayer *create_log_replayer(Db &db, LogHandler &log_handler) override;
 
+  LSN min_active_trx_lsn() override;
+
 public:
   int32_t next_trx_id();
 
+  /**
+   * @brief 恢复时使用，保证之后分配的事务ID都比日志中出现过的ID大
+   * @details 包括提交事务时分配的ID，否则新的事务可能看不到已经提交的数据
+   */
+  void update_trx_id(int32_t trx_id);
+
 public:
   int32_t max_trx_id() const;
 
@@ -95,6 +103,12 @@ public:
 
   int32_t id() const override { return trx_id_; }
 
+  /**
+   * @brief 事务开始时的LSN
+   * @details 事务写入的日志都不会小于这个值。事务没有开始时是LSN的最大值
+   */
+  LSN start_lsn() const { return start_lsn_.load(); }
+
 private:
   RC   commit_with_trx_id(int32_t commit_id);
   void trx_fields(Table *table, Field &begin_xid_field, Field &end_xid_field) const;
@@ -111,5 +125,6 @@ private:
   int32_t           trx_id_     = -1;
   bool              started_    = false;
   bool              recovering_ = false;
+  atomic<LSN>       start_lsn_{numeric_limits<LSN>::max()};
   OperationSet      operations_;
 };
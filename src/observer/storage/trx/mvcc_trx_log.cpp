@@ -132,6 +132,8 @@ RC MvccTrxLogHandler::rollback(int32_t trx_id)
       lsn, LogModule::Id::TRANSACTION, span<const char>(reinterpret_cast<const char *>(&log_entry), sizeof(log_entry)));
 }
 
+LSN MvccTrxLogHandler::current_lsn() const { return log_handler_.current_lsn(); }
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 MvccTrxLogReplayer::MvccTrxLogReplayer(Db &db, MvccTrxKit &trx_kit, LogHandler &log_handler)
   : db_(db), trx_kit_(trx_kit), log_handler_(log_handler)
@@ -163,6 +165,13 @@ RC MvccTrxLogReplayer::replay(const LogEntry &entry)
   /// 直接调用事务代码自己的重放函数
   rc = trx->redo(&db_, entry);
 
+  // 提交时分配的事务ID也要恢复，否则新事务的ID可能比已经提交的数据小，看不到这些数据
+  if (MvccTrxLogOperation(header->operation_type).type() == MvccTrxLogOperation::Type::COMMIT &&
+      entry.payload_size() >= MvccTrxCommitLogEntry::SIZE) {
+    auto *commit_entry = reinterpret_cast<const MvccTrxCommitLogEntry *>(entry.data());
+    trx_kit_.update_trx_id(commit_entry->commit_trx_id);
+  }
+
   /// 如果事务结束了，需要从内存中把它删除
   if (MvccTrxLogOperation(header->operation_type).type() == MvccTrxLogOperation::Type::ROLLBACK ||
       MvccTrxLogOperation(header->operation_type).type() == MvccTrxLogOperation::Type::COMMIT) {
@@ -18,6 +18,7 @@ See the Mulan PSL v2 for more details. */
 #include <utility>
 
 #include "common/sys/rc.h"
+#include "common/lang/limits.h"
 #include "common/lang/mutex.h"
 #include "sql/parser/parse.h"
 #include "storage/field/field_meta.h"
@@ -129,6 +130,13 @@ public:
 
   virtual LogReplayer *create_log_replayer(Db &db, LogHandler &log_handler) = 0;
 
+  /**
+   * @brief 活跃事务可能写入的最小的LSN
+   * @details 重启时需要活跃事务的日志才能把它们回滚掉，所以检查点不能超过这个位置。
+   * 没有活跃事务时返回LSN的最大值。
+   */
+  virtual LSN min_active_trx_lsn() { return numeric_limits<LSN>::max(); }
+
 public:
   static TrxKit *create(const char *name, Db *db);
 };
@@ -0,0 +1,59 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <string.h>
+#include <string>
+
+#include "common/math/crc.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+
+TEST(Crc32c, known_values)
+{
+  // RFC 3720 B.4 中的例子
+  char zeros[32];
+  memset(zeros, 0, sizeof(zeros));
+  ASSERT_EQ(0x8A9136AAU, crc32c(0, zeros, sizeof(zeros)));
+
+  char ones[32];
+  memset(ones, 0xff, sizeof(ones));
+  ASSERT_EQ(0x62A8AB43U, crc32c(0, ones, sizeof(ones)));
+
+  char increasing[32];
+  for (int i = 0; i < 32; i++) {
+    increasing[i] = static_cast<char>(i);
+  }
+  ASSERT_EQ(0x46DD794EU, crc32c(0, increasing, sizeof(increasing)));
+
+  ASSERT_EQ(0xE3069283U, crc32c(0, "123456789", 9));
+  ASSERT_EQ(0U, crc32c(0, "", 0));
+}
+
+TEST(Crc32c, incremental)
+{
+  string data;
+  for (int i = 0; i < 1000; i++) {
+    data += to_string(i);
+  }
+
+  const uint32_t expected = crc32c(0, data.data(), data.size());
+  for (size_t split : {size_t(0), size_t(1), size_t(7), size_t(8), size_t(100), data.size()}) {
+    uint32_t value = crc32c(0, data.data(), split);
+    value          = crc32c(value, data.data() + split, data.size() - split);
+    ASSERT_EQ(expected, value);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,101 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/compress/lz4.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace common;
+
+static void check_round_trip(const string &data)
+{
+  vector<char> compressed(Lz4::compress_bound(static_cast<int>(data.size())));
+  int compressed_size =
+      Lz4::compress(data.data(), static_cast<int>(data.size()), compressed.data(), static_cast<int>(compressed.size()));
+  ASSERT_GT(compressed_size, 0);
+
+  vector<char> decompressed(data.size());
+  ASSERT_EQ(static_cast<int>(data.size()),
+      Lz4::decompress(compressed.data(), compressed_size, decompressed.data(), static_cast<int>(decompressed.size())));
+  ASSERT_EQ(0, memcmp(data.data(), decompressed.data(), data.size()));
+}
+
+TEST(Lz4, round_trip)
+{
+  check_round_trip("");
+  check_round_trip("a");
+  check_round_trip("abcdefghijklmnopqrstuvwxyz");
+  check_round_trip(string(100000, 'a'));
+
+  string repeated;
+  for (int i = 0; i < 10000; i++) {
+    repeated += "key_" + to_string(i % 100) + "_value;";
+  }
+  check_round_trip(repeated);
+
+  mt19937 generator(1);
+  string  random_data(100000, 0);
+  for (char &c : random_data) {
+    c = static_cast<char>(generator());
+  }
+  check_round_trip(random_data);
+}
+
+TEST(Lz4, compression_ratio)
+{
+  string data;
+  for (int i = 0; i < 1000; i++) {
+    data += "record " + to_string(i) + " with some padding ..................";
+  }
+  vector<char> compressed(Lz4::compress_bound(static_cast<int>(data.size())));
+  int compressed_size =
+      Lz4::compress(data.data(), static_cast<int>(data.size()), compressed.data(), static_cast<int>(compressed.size()));
+  ASSERT_GT(compressed_size, 0);
+  ASSERT_LT(compressed_size, static_cast<int>(data.size()) / 4);
+
+  // 目标空间不够时返回0
+  ASSERT_EQ(0, Lz4::compress(data.data(), static_cast<int>(data.size()), compressed.data(), 10));
+}
+
+TEST(Lz4, invalid_input)
+{
+  string       data(1000, 'x');
+  vector<char> compressed(Lz4::compress_bound(static_cast<int>(data.size())));
+  int compressed_size =
+      Lz4::compress(data.data(), static_cast<int>(data.size()), compressed.data(), static_cast<int>(compressed.size()));
+  ASSERT_GT(compressed_size, 0);
+
+  // 输出空间不够
+  vector<char> decompressed(data.size());
+  ASSERT_EQ(-1, Lz4::decompress(compressed.data(), compressed_size, decompressed.data(), 100));
+
+  // 数据被截断
+  ASSERT_EQ(-1, Lz4::decompress(compressed.data(), compressed_size / 2, decompressed.data(), 1000));
+
+  // 随机数据不能越界访问
+  mt19937 generator(1);
+  for (int i = 0; i < 1000; i++) {
+    vector<char> garbage(64);
+    for (char &c : garbage) {
+      c = static_cast<char>(generator());
+    }
+    (void)Lz4::decompress(garbage.data(), static_cast<int>(garbage.size()), decompressed.data(), 1000);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
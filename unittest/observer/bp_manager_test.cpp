@@ -125,6 +125,61 @@ TEST(test_frame_manager, test_frame_manager_simple_lru)
   frame_manager.cleanup();
 }
 
+TEST(test_frame_manager, test_frame_manager_sharded)
+{
+  BPFrameManager frame_manager("Test");
+  ASSERT_EQ(frame_manager.init(2, 2 /*shard_num*/), RC::SUCCESS);
+  ASSERT_EQ(frame_manager.shard_num(), 2);
+
+  const int buffer_pool_id = 0;
+  const int frame_num      = static_cast<int>(frame_manager.total_frame_num());
+
+  // 页面按照 hash 分配到不同的分片，连续的页面号会均匀地分布在两个分片中
+  vector<Frame *> frames;
+  for (PageNum page_num = 0; page_num < frame_num; page_num++) {
+    Frame *frame = frame_manager.alloc(buffer_pool_id, page_num);
+    ASSERT_NE(frame, nullptr);
+    frames.push_back(frame);
+  }
+  ASSERT_EQ(frame_manager.frame_num(), static_cast<size_t>(frame_num));
+  ASSERT_EQ(frame_manager.alloc(buffer_pool_id, frame_num), nullptr);
+  ASSERT_EQ(frame_manager.alloc(buffer_pool_id, frame_num + 1), nullptr);
+
+  // 页帧内存由所有分片共用，一个分片释放的页帧可以分配给另一个分片中的页面
+  Frame *frame = frames[0];
+  ASSERT_EQ(frame_manager.free(buffer_pool_id, 0, frame), RC::SUCCESS);
+  frames[0] = frame_manager.alloc(buffer_pool_id, frame_num + 1);
+  ASSERT_NE(frames[0], nullptr);
+  ASSERT_EQ(frame_manager.alloc(buffer_pool_id, frame_num), nullptr);
+
+  // 优先在指定页面所属的分片中淘汰页面
+  frames[1]->unpin();
+  frames[2]->unpin();
+  int purged = frame_manager.purge_frames(FrameId(buffer_pool_id, 1), 2, [](Frame *) { return RC::SUCCESS; });
+  ASSERT_EQ(purged, 1);
+  ASSERT_NE(frame_manager.get(buffer_pool_id, 2), nullptr);
+  ASSERT_EQ(frame_manager.get(buffer_pool_id, 1), nullptr);
+  frames[1] = nullptr;
+
+  // 所属的分片中所有的页帧都被pin住时，从其它分片淘汰
+  int purged_other = frame_manager.purge_frames(FrameId(buffer_pool_id, 1), 1, [](Frame *) { return RC::SUCCESS; });
+  ASSERT_EQ(purged_other, 0);
+  frames[2]->unpin();
+  purged_other = frame_manager.purge_frames(FrameId(buffer_pool_id, 1), 1, [](Frame *) { return RC::SUCCESS; });
+  ASSERT_EQ(purged_other, 1);
+  ASSERT_EQ(frame_manager.get(buffer_pool_id, 2), nullptr);
+  frames[2] = frame_manager.alloc(buffer_pool_id, 1);
+  ASSERT_NE(frames[2], nullptr);
+
+  for (Frame *frame : frames) {
+    if (frame != nullptr) {
+      ASSERT_EQ(frame_manager.free(buffer_pool_id, frame->page_num(), frame), RC::SUCCESS);
+    }
+  }
+  ASSERT_EQ(frame_manager.frame_num(), 0UL);
+  ASSERT_EQ(frame_manager.cleanup(), RC::SUCCESS);
+}
+
 int main(int argc, char **argv)
 {
 
@@ -22,6 +22,7 @@ See the Mulan PSL v2 for more details. */
 #include "sql/parser/parse_defs.h"
 #include "storage/buffer/disk_buffer_pool.h"
 #include "storage/index/bplus_tree.h"
+#include "storage/index/bplus_tree_bulk_loader.h"
 #include "storage/clog/vacuous_log_handler.h"
 #include "storage/buffer/double_write_buffer.h"
 #include "gtest/gtest.h"
@@ -518,6 +519,72 @@ TEST(test_bplus_tree, test_internal_index_node_handle)
   }
 }
 
+TEST(test_bplus_tree, test_key_comparator)
+{
+  // 特化的比较结果与 DataType::compare 相同
+  auto value_compare = [](AttrType type, const char *v1, const char *v2, int length) {
+    Value left;
+    left.set_type(type);
+    left.set_data(v1, length);
+    Value right;
+    right.set_type(type);
+    right.set_data(v2, length);
+    return DataType::type_instance(type)->compare(left, right);
+  };
+
+  AttrComparator int_comparator;
+  int_comparator.init(AttrType::INTS, sizeof(int));
+  const int ints[] = {-100, -1, 0, 1, 100, INT32_MIN, INT32_MAX};
+  for (int left : ints) {
+    for (int right : ints) {
+      const char *v1 = reinterpret_cast<const char *>(&left);
+      const char *v2 = reinterpret_cast<const char *>(&right);
+      ASSERT_EQ(int_comparator(v1, v2), value_compare(AttrType::INTS, v1, v2, sizeof(int)));
+    }
+  }
+
+  AttrComparator float_comparator;
+  float_comparator.init(AttrType::FLOATS, sizeof(float));
+  const float floats[] = {-1.5f, 0.0f, 1e-7f, 1.0f, 1.0000001f, 2.5f};
+  for (float left : floats) {
+    for (float right : floats) {
+      const char *v1 = reinterpret_cast<const char *>(&left);
+      const char *v2 = reinterpret_cast<const char *>(&right);
+      ASSERT_EQ(float_comparator(v1, v2), value_compare(AttrType::FLOATS, v1, v2, sizeof(float)));
+    }
+  }
+
+  const int      char_length = 8;
+  AttrComparator char_comparator;
+  char_comparator.init(AttrType::CHARS, char_length);
+  const char *strings[] = {"", "a", "ab", "abc", "abd", "b", "abcdefgh", "abcdefgz"};
+  for (const char *left : strings) {
+    for (const char *right : strings) {
+      char v1[char_length] = {0};
+      char v2[char_length] = {0};
+      memcpy(v1, left, min(strlen(left), size_t(char_length)));
+      memcpy(v2, right, min(strlen(right), size_t(char_length)));
+      ASSERT_EQ(char_comparator(v1, v2), value_compare(AttrType::CHARS, v1, v2, char_length)) << left << " " << right;
+    }
+  }
+
+  // 键值相同时比较 RID
+  KeyComparator key_comparator;
+  key_comparator.init(AttrType::INTS, sizeof(int));
+  char key1[sizeof(int) + sizeof(RID)];
+  char key2[sizeof(int) + sizeof(RID)];
+  int  value = 10;
+  RID  rid1(1, 1);
+  RID  rid2(1, 2);
+  memcpy(key1, &value, sizeof(value));
+  memcpy(key1 + sizeof(int), &rid1, sizeof(RID));
+  memcpy(key2, &value, sizeof(value));
+  memcpy(key2 + sizeof(int), &rid2, sizeof(RID));
+  ASSERT_LT(key_comparator(key1, key2), 0);
+  ASSERT_LT(key_comparator.visit([&](const auto &comparator) { return comparator(key1, key2); }), 0);
+  ASSERT_EQ(key_comparator.visit([&](const auto &comparator) { return comparator(key2, key2); }), 0);
+}
+
 TEST(test_bplus_tree, test_chars)
 {
   LoggerFactory::init_default("test_chars.log");
@@ -793,6 +860,463 @@ TEST(test_bplus_tree, test_scanner)
   handler.close();
 }
 
+TEST(test_bplus_tree, test_composite_key)
+{
+  LoggerFactory::init_default("test.log");
+
+  filesystem::path test_directory("bplus_tree");
+  filesystem::path buffer_pool_file = test_directory / "composite.btree";
+  filesystem::remove_all(test_directory);
+  filesystem::create_directory(test_directory);
+
+  VacuousLogHandler log_handler;
+
+  BufferPoolManager bpm;
+  ASSERT_EQ(RC::SUCCESS, bpm.init(make_unique<VacuousDoubleWriteBuffer>()));
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(buffer_pool_file.c_str()));
+
+  DiskBufferPool *buffer_pool = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(log_handler, buffer_pool_file.c_str(), buffer_pool));
+  ASSERT_NE(nullptr, buffer_pool);
+
+  // 键值是 (int, char(4))
+  BplusTreeHandler handler;
+  ASSERT_EQ(RC::SUCCESS,
+      handler.create(
+          log_handler, *buffer_pool, vector<AttrType>{AttrType::INTS, AttrType::CHARS}, vector<int>{4, 4}, ORDER, ORDER));
+  ASSERT_EQ(2, handler.file_header().field_num);
+  ASSERT_EQ(8, handler.file_header().attr_length);
+
+  auto make_key = [](int a, const char *b) {
+    string key(8, '\0');
+    memcpy(key.data(), &a, sizeof(a));
+    memcpy(key.data() + sizeof(a), b, strlen(b));
+    return key;
+  };
+
+  const char *strs[] = {"cc", "aa", "bb"};
+  RID         rid;
+  for (int a = 9; a >= -10; a--) {
+    for (int j = 0; j < 3; j++) {
+      string key   = make_key(a, strs[j]);
+      rid.page_num = a + 100;
+      rid.slot_num = j;
+      ASSERT_EQ(RC::SUCCESS, handler.insert_entry(key.data(), &rid));
+    }
+  }
+  ASSERT_TRUE(handler.validate_tree());
+
+  auto scan = [&handler](const char *left, int left_len, bool left_inclusive, const char *right, int right_len,
+                  bool right_inclusive, vector<RID> &rids) {
+    rids.clear();
+    BplusTreeScanner scanner(handler);
+    RC               rc = scanner.open(left, left_len, left_inclusive, right, right_len, right_inclusive);
+    if (OB_FAIL(rc)) {
+      return rc;
+    }
+    RID rid;
+    while (OB_SUCC(rc = scanner.next_entry(rid))) {
+      rids.push_back(rid);
+    }
+    scanner.close();
+    return rc == RC::RECORD_EOF ? RC::SUCCESS : rc;
+  };
+
+  vector<RID> rids;
+
+  // a = 5，只给出第一个字段的值，按照第二个字段有序
+  int a = 5;
+  ASSERT_EQ(RC::SUCCESS, scan((const char *)&a, 4, true, (const char *)&a, 4, true, rids));
+  ASSERT_EQ(3, static_cast<int>(rids.size()));
+  ASSERT_EQ(105, rids[0].page_num);
+  ASSERT_EQ(1, rids[0].slot_num);  // aa
+  ASSERT_EQ(2, rids[1].slot_num);  // bb
+  ASSERT_EQ(0, rids[2].slot_num);  // cc
+
+  // a = -3 and b = 'bb'
+  string key = make_key(-3, "bb");
+  ASSERT_EQ(RC::SUCCESS, scan(key.data(), 8, true, key.data(), 8, true, rids));
+  ASSERT_EQ(1, static_cast<int>(rids.size()));
+  ASSERT_EQ(97, rids[0].page_num);
+  ASSERT_EQ(2, rids[0].slot_num);
+
+  // a = -3 and b > 'aa'
+  key = make_key(-3, "aa");
+  a   = -3;
+  ASSERT_EQ(RC::SUCCESS, scan(key.data(), 8, false, (const char *)&a, 4, true, rids));
+  ASSERT_EQ(2, static_cast<int>(rids.size()));
+
+  // a > -1 and a <= 1
+  int begin = -1;
+  int end   = 1;
+  ASSERT_EQ(RC::SUCCESS, scan((const char *)&begin, 4, false, (const char *)&end, 4, true, rids));
+  ASSERT_EQ(6, static_cast<int>(rids.size()));
+  ASSERT_EQ(100, rids.front().page_num);
+  ASSERT_EQ(101, rids.back().page_num);
+
+  // a >= -10 and a < -8
+  begin = -10;
+  end   = -8;
+  ASSERT_EQ(RC::SUCCESS, scan((const char *)&begin, 4, true, (const char *)&end, 4, false, rids));
+  ASSERT_EQ(6, static_cast<int>(rids.size()));
+
+  // a >= 8
+  begin = 8;
+  ASSERT_EQ(RC::SUCCESS, scan((const char *)&begin, 4, true, nullptr, 0, false, rids));
+  ASSERT_EQ(6, static_cast<int>(rids.size()));
+
+  // a < -9
+  end = -9;
+  ASSERT_EQ(RC::SUCCESS, scan(nullptr, 0, false, (const char *)&end, 4, false, rids));
+  ASSERT_EQ(3, static_cast<int>(rids.size()));
+
+  // 空范围
+  begin = 3;
+  end   = 2;
+  ASSERT_EQ(RC::SUCCESS, scan((const char *)&begin, 4, true, (const char *)&end, 4, true, rids));
+  ASSERT_EQ(0, static_cast<int>(rids.size()));
+
+  // 键值长度不是字段长度的前缀
+  ASSERT_EQ(RC::INVALID_ARGUMENT, scan((const char *)&begin, 2, true, nullptr, 0, false, rids));
+
+  list<RID> entries;
+  a = 0;
+  ASSERT_EQ(RC::SUCCESS, handler.get_entry((const char *)&a, 4, entries));
+  ASSERT_EQ(3, static_cast<int>(entries.size()));
+
+  key = make_key(0, "aa");
+  rid.page_num = 100;
+  rid.slot_num = 1;
+  ASSERT_EQ(RC::SUCCESS, handler.delete_entry(key.data(), &rid));
+  entries.clear();
+  ASSERT_EQ(RC::SUCCESS, handler.get_entry((const char *)&a, 4, entries));
+  ASSERT_EQ(2, static_cast<int>(entries.size()));
+
+  // 组合索引的字段必须可以构造前缀扫描的边界
+  BplusTreeHandler unsupported_handler;
+  ASSERT_EQ(RC::UNSUPPORTED,
+      unsupported_handler.create(log_handler,
+          *buffer_pool,
+          vector<AttrType>{AttrType::INTS, AttrType::VECTORS},
+          vector<int>{4, 16},
+          ORDER,
+          ORDER));
+}
+
+TEST(test_bplus_tree, test_unique_key)
+{
+  LoggerFactory::init_default("test.log");
+
+  filesystem::path test_directory("bplus_tree");
+  filesystem::path buffer_pool_file = test_directory / "unique.btree";
+  filesystem::remove_all(test_directory);
+  filesystem::create_directory(test_directory);
+
+  VacuousLogHandler log_handler;
+
+  BufferPoolManager bpm;
+  ASSERT_EQ(RC::SUCCESS, bpm.init(make_unique<VacuousDoubleWriteBuffer>()));
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(buffer_pool_file.c_str()));
+
+  DiskBufferPool *buffer_pool = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(log_handler, buffer_pool_file.c_str(), buffer_pool));
+  ASSERT_NE(nullptr, buffer_pool);
+
+  BplusTreeHandler handler;
+  ASSERT_EQ(RC::SUCCESS,
+      handler.create(
+          log_handler, *buffer_pool, vector<AttrType>{AttrType::INTS}, vector<int>{4}, ORDER, ORDER, true /*unique*/));
+  // 唯一索引的键值中没有RID
+  ASSERT_EQ(4, handler.file_header().key_length);
+
+  auto scan = [&handler](int left, bool left_inclusive, int right, bool right_inclusive) {
+    BplusTreeScanner scanner(handler);
+    RC rc = scanner.open((const char *)&left, 4, left_inclusive, (const char *)&right, 4, right_inclusive);
+    EXPECT_EQ(RC::SUCCESS, rc);
+    int count = 0;
+    RID rid;
+    while (OB_SUCC(scanner.next_entry(rid))) {
+      count++;
+    }
+    return count;
+  };
+
+  // 乱序插入偶数
+  RID rid;
+  for (int i = 0; i < 100; i++) {
+    int key      = (i * 37 % 100) * 2;
+    rid.page_num = key;
+    rid.slot_num = 0;
+    ASSERT_EQ(RC::SUCCESS, handler.insert_entry((const char *)&key, &rid));
+  }
+  ASSERT_TRUE(handler.validate_tree());
+
+  // 相同的键值即使RID不同也不能插入
+  int key      = 10;
+  rid.page_num = 1000;
+  ASSERT_EQ(RC::RECORD_DUPLICATE_KEY, handler.insert_entry((const char *)&key, &rid));
+  ASSERT_TRUE(handler.validate_tree());
+
+  ASSERT_EQ(6, scan(10, true, 20, true));
+  ASSERT_EQ(4, scan(10, false, 20, false));
+  ASSERT_EQ(5, scan(10, false, 20, true));
+  ASSERT_EQ(5, scan(10, true, 20, false));
+  ASSERT_EQ(5, scan(9, false, 19, false));
+  ASSERT_EQ(100, scan(0, true, 198, true));
+  ASSERT_EQ(98, scan(0, false, 198, false));
+
+  list<RID> entries;
+  ASSERT_EQ(RC::SUCCESS, handler.get_entry((const char *)&key, 4, entries));
+  ASSERT_EQ(1, static_cast<int>(entries.size()));
+  ASSERT_EQ(10, entries.front().page_num);
+
+  key = 11;
+  entries.clear();
+  ASSERT_EQ(RC::SUCCESS, handler.get_entry((const char *)&key, 4, entries));
+  ASSERT_EQ(0, static_cast<int>(entries.size()));
+
+  // 删除时需要匹配RID
+  key          = 10;
+  rid.page_num = 1000;
+  ASSERT_EQ(RC::RECORD_NOT_EXIST, handler.delete_entry((const char *)&key, &rid));
+  rid.page_num = 10;
+  ASSERT_EQ(RC::SUCCESS, handler.delete_entry((const char *)&key, &rid));
+  rid.page_num = 1000;
+  ASSERT_EQ(RC::SUCCESS, handler.insert_entry((const char *)&key, &rid));
+  entries.clear();
+  ASSERT_EQ(RC::SUCCESS, handler.get_entry((const char *)&key, 4, entries));
+  ASSERT_EQ(1, static_cast<int>(entries.size()));
+  ASSERT_EQ(1000, entries.front().page_num);
+
+  for (int i = 0; i < 100; i++) {
+    key          = i * 2;
+    rid.page_num = (key == 10) ? 1000 : key;
+    ASSERT_EQ(RC::SUCCESS, handler.delete_entry((const char *)&key, &rid));
+  }
+  ASSERT_TRUE(handler.is_empty());
+
+  // 唯一组合索引按照前缀扫描
+  filesystem::path composite_file = test_directory / "unique_composite.btree";
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(composite_file.c_str()));
+  DiskBufferPool *composite_pool = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(log_handler, composite_file.c_str(), composite_pool));
+
+  BplusTreeHandler composite_handler;
+  ASSERT_EQ(RC::SUCCESS,
+      composite_handler.create(log_handler,
+          *composite_pool,
+          vector<AttrType>{AttrType::INTS, AttrType::INTS},
+          vector<int>{4, 4},
+          ORDER,
+          ORDER,
+          true /*unique*/));
+
+  int pair[2];
+  for (int a = 0; a < 10; a++) {
+    for (int b = 0; b < 3; b++) {
+      pair[0]      = a;
+      pair[1]      = b;
+      rid.page_num = a;
+      rid.slot_num = b;
+      ASSERT_EQ(RC::SUCCESS, composite_handler.insert_entry((const char *)pair, &rid));
+    }
+  }
+  pair[0] = 1;
+  pair[1] = 1;
+  ASSERT_EQ(RC::RECORD_DUPLICATE_KEY, composite_handler.insert_entry((const char *)pair, &rid));
+
+  auto prefix_scan = [&composite_handler](const int *left, bool left_inclusive, const int *right, bool right_inclusive) {
+    BplusTreeScanner scanner(composite_handler);
+    RC               rc = scanner.open(
+        (const char *)left, left ? 4 : 0, left_inclusive, (const char *)right, right ? 4 : 0, right_inclusive);
+    EXPECT_EQ(RC::SUCCESS, rc);
+    int count = 0;
+    RID rid;
+    while (OB_SUCC(scanner.next_entry(rid))) {
+      count++;
+    }
+    return count;
+  };
+
+  int a = 5;
+  ASSERT_EQ(3, prefix_scan(&a, true, &a, true));
+  ASSERT_EQ(12, prefix_scan(&a, false, nullptr, false));
+  ASSERT_EQ(15, prefix_scan(nullptr, false, &a, false));
+  ASSERT_EQ(18, prefix_scan(nullptr, false, &a, true));
+}
+
+TEST(test_bplus_tree, test_bulk_load)
+{
+  LoggerFactory::init_default("test.log");
+
+  filesystem::path test_directory("bplus_tree");
+  filesystem::remove_all(test_directory);
+  filesystem::create_directory(test_directory);
+
+  VacuousLogHandler log_handler;
+
+  BufferPoolManager bpm;
+  ASSERT_EQ(RC::SUCCESS, bpm.init(make_unique<VacuousDoubleWriteBuffer>()));
+
+  auto count_all = [](BplusTreeHandler &handler) {
+    BplusTreeScanner scanner(handler);
+    EXPECT_EQ(RC::SUCCESS, scanner.open(nullptr, 0, false, nullptr, 0, false));
+    int count = 0;
+    RID rid;
+    while (OB_SUCC(scanner.next_entry(rid))) {
+      count++;
+    }
+    return count;
+  };
+
+  // 不同的数据量和填充比例，覆盖最后一个节点需要平分的情况。排序内存只能放10条数据，会写临时文件
+  const int entry_size = 4 + sizeof(RID) + sizeof(const char *);
+  int       file_index = 0;
+  for (int fill_percent : {50, 100}) {
+    for (int num : {0, 1, 4, 5, 7, 8, 9, 17, 100, 1000}) {
+      filesystem::path file_name = test_directory / ("bulk_load_" + std::to_string(file_index++) + ".btree");
+      ASSERT_EQ(RC::SUCCESS, bpm.create_file(file_name.c_str()));
+      DiskBufferPool *buffer_pool = nullptr;
+      ASSERT_EQ(RC::SUCCESS, bpm.open_file(log_handler, file_name.c_str(), buffer_pool));
+
+      BplusTreeHandler handler;
+      ASSERT_EQ(RC::SUCCESS, handler.create(log_handler, *buffer_pool, AttrType::INTS, 4, ORDER, ORDER));
+
+      string sort_file_prefix = file_name.string() + ".sort";
+      {
+        BplusTreeBulkLoader loader(handler, sort_file_prefix, 10 * entry_size, fill_percent);
+        RID rid;
+        for (int i = 0; i < num; i++) {
+          int key      = (i * 37 % num) / 3;  // 乱序，并且有重复的键值
+          rid.page_num = i;
+          rid.slot_num = key;
+          ASSERT_EQ(RC::SUCCESS, loader.add((const char *)&key, rid));
+        }
+        ASSERT_EQ(RC::SUCCESS, loader.finish());
+      }
+      ASSERT_FALSE(filesystem::exists(sort_file_prefix + ".0"));
+
+      ASSERT_EQ(num == 0, handler.is_empty());
+      ASSERT_TRUE(handler.validate_tree()) << "num=" << num << ", fill percent=" << fill_percent;
+      ASSERT_EQ(num, count_all(handler));
+
+      if (num > 0) {
+        list<RID> rids;
+        int       key = (num - 1) / 3;
+        ASSERT_EQ(RC::SUCCESS, handler.get_entry((const char *)&key, 4, rids));
+        ASSERT_EQ(num - key * 3, static_cast<int>(rids.size()));
+      }
+
+      // 批量构建后的树可以正常插入和删除
+      RID rid;
+      for (int i = 0; i < num; i++) {
+        int key      = i;
+        rid.page_num = num + i;
+        rid.slot_num = 0;
+        ASSERT_EQ(RC::SUCCESS, handler.insert_entry((const char *)&key, &rid));
+      }
+      ASSERT_TRUE(handler.validate_tree());
+      ASSERT_EQ(num * 2, count_all(handler));
+
+      for (int i = 0; i < num; i++) {
+        int key      = (i * 37 % num) / 3;
+        rid.page_num = i;
+        rid.slot_num = key;
+        ASSERT_EQ(RC::SUCCESS, handler.delete_entry((const char *)&key, &rid));
+      }
+      ASSERT_TRUE(handler.validate_tree());
+      ASSERT_EQ(num, count_all(handler));
+    }
+  }
+
+  // 唯一索引
+  filesystem::path unique_file = test_directory / "bulk_load_unique.btree";
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(unique_file.c_str()));
+  DiskBufferPool *unique_pool = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(log_handler, unique_file.c_str(), unique_pool));
+
+  BplusTreeHandler unique_handler;
+  ASSERT_EQ(RC::SUCCESS,
+      unique_handler.create(
+          log_handler, *unique_pool, vector<AttrType>{AttrType::INTS}, vector<int>{4}, ORDER, ORDER, true /*unique*/));
+  {
+    BplusTreeBulkLoader loader(unique_handler, unique_file.string() + ".sort", 10 * entry_size, 100);
+    RID rid;
+    for (int i = 0; i < 100; i++) {
+      int key      = i * 37 % 100;
+      rid.page_num = key;
+      ASSERT_EQ(RC::SUCCESS, loader.add((const char *)&key, rid));
+    }
+    ASSERT_EQ(RC::SUCCESS, loader.finish());
+  }
+  ASSERT_TRUE(unique_handler.validate_tree());
+  ASSERT_EQ(100, count_all(unique_handler));
+
+  int       key = 42;
+  list<RID> rids;
+  ASSERT_EQ(RC::SUCCESS, unique_handler.get_entry((const char *)&key, 4, rids));
+  ASSERT_EQ(1, static_cast<int>(rids.size()));
+  ASSERT_EQ(42, rids.front().page_num);
+  RID rid;
+  rid.page_num = 1000;
+  ASSERT_EQ(RC::RECORD_DUPLICATE_KEY, unique_handler.insert_entry((const char *)&key, &rid));
+
+  // 唯一索引有重复的键值
+  filesystem::path duplicate_file = test_directory / "bulk_load_duplicate.btree";
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(duplicate_file.c_str()));
+  DiskBufferPool *duplicate_pool = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(log_handler, duplicate_file.c_str(), duplicate_pool));
+
+  BplusTreeHandler duplicate_handler;
+  ASSERT_EQ(RC::SUCCESS,
+      duplicate_handler.create(
+          log_handler, *duplicate_pool, vector<AttrType>{AttrType::INTS}, vector<int>{4}, ORDER, ORDER, true /*unique*/));
+  {
+    BplusTreeBulkLoader loader(duplicate_handler, duplicate_file.string() + ".sort", 10 * entry_size, 100);
+    for (int i = 0; i < 50; i++) {
+      key          = i % 49;
+      rid.page_num = i;
+      ASSERT_EQ(RC::SUCCESS, loader.add((const char *)&key, rid));
+    }
+    ASSERT_EQ(RC::RECORD_DUPLICATE_KEY, loader.finish());
+  }
+  ASSERT_FALSE(filesystem::exists(duplicate_file.string() + ".sort.0"));
+
+  // 排序内存足够时不写临时文件，缓冲区按需扩大，扩大之后已经加入的数据仍然有效
+  {
+    filesystem::path file_name = test_directory / "bulk_load_in_memory.btree";
+    ASSERT_EQ(RC::SUCCESS, bpm.create_file(file_name.c_str()));
+    DiskBufferPool *buffer_pool = nullptr;
+    ASSERT_EQ(RC::SUCCESS, bpm.open_file(log_handler, file_name.c_str(), buffer_pool));
+
+    BplusTreeHandler handler;
+    ASSERT_EQ(RC::SUCCESS, handler.create(log_handler, *buffer_pool, AttrType::INTS, 4, ORDER, ORDER));
+
+    const int num              = 1500;
+    string    sort_file_prefix = file_name.string() + ".sort";
+    {
+      BplusTreeBulkLoader loader(handler, sort_file_prefix, 100000 * entry_size, 100);
+      RID rid;
+      for (int i = 0; i < num; i++) {
+        int key      = i * 37 % num;
+        rid.page_num = i;
+        rid.slot_num = key;
+        ASSERT_EQ(RC::SUCCESS, loader.add((const char *)&key, rid));
+      }
+      ASSERT_EQ(RC::SUCCESS, loader.finish());
+    }
+    ASSERT_FALSE(filesystem::exists(sort_file_prefix + ".0"));
+    ASSERT_TRUE(handler.validate_tree());
+    ASSERT_EQ(num, count_all(handler));
+
+    list<RID> rids;
+    int       key = num - 1;
+    ASSERT_EQ(RC::SUCCESS, handler.get_entry((const char *)&key, 4, rids));
+    ASSERT_EQ(1, static_cast<int>(rids.size()));
+    ASSERT_EQ(key, rids.front().slot_num);
+  }
+}
+
 TEST(test_bplus_tree, test_bplus_tree_insert)
 {
   LoggerFactory::init_default("test.log");
@@ -13,6 +13,7 @@ See the Mulan PSL v2 for more details. */
 //
 
 #include <filesystem>
+#include <thread>
 
 #include "gtest/gtest.h"
 #include "common/log/log.h"
@@ -105,6 +106,398 @@ TEST(DiskBufferPool, allocate_dispose)
   ASSERT_EQ(buffer_pool_manager.close_file(buffer_pool_filename.c_str()), RC::SUCCESS);
 }
 
+TEST(DiskBufferPool, buffer_ring)
+{
+  filesystem::path directory("buffer_pool");
+  filesystem::remove_all(directory);
+  filesystem::create_directories(directory);
+
+  filesystem::path buffer_pool_filename = directory / "buffer_ring.bp";
+
+  // 缓冲池只有一个内存池，放不下所有的页面
+  BufferPoolManager buffer_pool_manager(DEFAULT_ITEM_NUM_PER_POOL * BP_PAGE_SIZE);
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.init(make_unique<VacuousDoubleWriteBuffer>()));
+  BPFrameManager &frame_manager = buffer_pool_manager.get_frame_manager();
+
+  VacuousLogHandler log_handler;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.create_file(buffer_pool_filename.c_str()));
+  DiskBufferPool *buffer_pool = nullptr;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.open_file(log_handler, buffer_pool_filename.c_str(), buffer_pool));
+
+  const int page_num = 100;
+  for (int i = 0; i < page_num; ++i) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->allocate_page(&frame));
+    ASSERT_EQ(buffer_pool->unpin_page(frame), RC::SUCCESS);
+  }
+
+  // 重新打开文件，缓冲池中只剩下文件头页面
+  ASSERT_EQ(buffer_pool_manager.close_file(buffer_pool_filename.c_str()), RC::SUCCESS);
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.open_file(log_handler, buffer_pool_filename.c_str(), buffer_pool));
+  ASSERT_EQ(frame_manager.frame_num(), 1UL);
+  ASSERT_TRUE(BufferRing::need_ring(*buffer_pool));
+
+  // 通过页帧环扫描，最多占用环大小个页帧
+  BufferRing ring(8);
+  for (PageNum i = 1; i <= page_num; i++) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->get_this_page(i, &frame, &ring));
+    ASSERT_EQ(frame->page_num(), i);
+    ASSERT_EQ(buffer_pool->unpin_page(frame), RC::SUCCESS);
+    ASSERT_LE(frame_manager.frame_num(), static_cast<size_t>(1 + ring.capacity()));
+  }
+
+  // 不使用页帧环，所有页面都会留在缓冲池中
+  for (PageNum i = 1; i <= page_num; i++) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->get_this_page(i, &frame));
+    ASSERT_EQ(buffer_pool->unpin_page(frame), RC::SUCCESS);
+  }
+  ASSERT_EQ(frame_manager.frame_num(), static_cast<size_t>(1 + page_num));
+
+  ASSERT_EQ(buffer_pool_manager.close_file(buffer_pool_filename.c_str()), RC::SUCCESS);
+}
+
+TEST(DiskBufferPool, read_ahead_detector)
+{
+  ReadAheadDetector detector(8);
+  PageNum           start = BP_INVALID_PAGE_NUM;
+  int               count = 0;
+
+  // 随机访问不会触发预读
+  ASSERT_FALSE(detector.on_access(10, start, count));
+  ASSERT_FALSE(detector.on_access(3, start, count));
+  ASSERT_FALSE(detector.on_access(20, start, count));
+
+  // 连续访问之后预读一个窗口
+  ASSERT_FALSE(detector.on_access(21, start, count));
+  ASSERT_TRUE(detector.on_access(22, start, count));
+  ASSERT_EQ(start, 23);
+  ASSERT_EQ(count, 8);
+
+  // 访问到预读区域的一半之后，才继续预读后面的页面
+  for (PageNum page_num = 23; page_num < 26; page_num++) {
+    ASSERT_FALSE(detector.on_access(page_num, start, count));
+  }
+  ASSERT_TRUE(detector.on_access(27, start, count));  // 允许有小的空洞
+  ASSERT_EQ(start, 31);
+  ASSERT_EQ(count, 5);
+
+  ReadAheadDetector disabled(0);
+  for (PageNum page_num = 1; page_num < 10; page_num++) {
+    ASSERT_FALSE(disabled.on_access(page_num, start, count));
+  }
+}
+
+TEST(DiskBufferPool, read_ahead)
+{
+  filesystem::path directory("buffer_pool");
+  filesystem::remove_all(directory);
+  filesystem::create_directories(directory);
+
+  filesystem::path buffer_pool_filename = directory / "read_ahead.bp";
+
+  BufferPoolManager buffer_pool_manager;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.init(make_unique<VacuousDoubleWriteBuffer>(), 8 /*read_ahead_window*/));
+  BPFrameManager &frame_manager = buffer_pool_manager.get_frame_manager();
+
+  VacuousLogHandler log_handler;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.create_file(buffer_pool_filename.c_str()));
+  DiskBufferPool *buffer_pool = nullptr;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.open_file(log_handler, buffer_pool_filename.c_str(), buffer_pool));
+
+  const int page_num = 50;
+  for (int i = 0; i < page_num; ++i) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->allocate_page(&frame));
+    frame->data()[0] = static_cast<char>(i + 1);
+    frame->mark_dirty();
+    ASSERT_EQ(buffer_pool->unpin_page(frame), RC::SUCCESS);
+  }
+
+  ASSERT_EQ(buffer_pool_manager.close_file(buffer_pool_filename.c_str()), RC::SUCCESS);
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.open_file(log_handler, buffer_pool_filename.c_str(), buffer_pool));
+  ASSERT_EQ(frame_manager.frame_num(), 1UL);
+
+  // 显式预读，后台线程把页面加载到缓冲池中
+  const BPFrameManager::Stat stat_before = frame_manager.stat();
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->read_ahead(1, page_num));
+  for (int i = 0; i < 1000 && frame_manager.frame_num() < static_cast<size_t>(1 + page_num); i++) {
+    this_thread::sleep_for(chrono::milliseconds(10));
+  }
+  ASSERT_EQ(frame_manager.frame_num(), static_cast<size_t>(1 + page_num));
+
+  for (PageNum i = 1; i <= page_num; i++) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->get_this_page(i, &frame));
+    ASSERT_EQ(frame->data()[0], static_cast<char>(i));
+    ASSERT_EQ(buffer_pool->unpin_page(frame), RC::SUCCESS);
+  }
+
+  const BPFrameManager::Stat stat_after = frame_manager.stat();
+  ASSERT_EQ(stat_after.read_ahead_count - stat_before.read_ahead_count, page_num);
+  ASSERT_EQ(stat_after.read_ahead_hit - stat_before.read_ahead_hit, page_num);
+  ASSERT_EQ(stat_after.miss_count, stat_before.miss_count);
+
+  // 预读之后没有访问过的页面，淘汰时记为浪费
+  ASSERT_EQ(buffer_pool_manager.close_file(buffer_pool_filename.c_str()), RC::SUCCESS);
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.open_file(log_handler, buffer_pool_filename.c_str(), buffer_pool));
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->read_ahead(1, 4));
+  ASSERT_EQ(buffer_pool_manager.close_file(buffer_pool_filename.c_str()), RC::SUCCESS);
+  ASSERT_EQ(frame_manager.stat().read_ahead_wasted - stat_after.read_ahead_wasted, 4);
+}
+
+TEST(DiskBufferPool, page_cleaner)
+{
+  filesystem::path directory("buffer_pool");
+  filesystem::remove_all(directory);
+  filesystem::create_directories(directory);
+
+  filesystem::path buffer_pool_filename = directory / "page_cleaner.bp";
+
+  BufferPoolManager buffer_pool_manager;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.init(make_unique<VacuousDoubleWriteBuffer>()));
+  BPFrameManager &frame_manager = buffer_pool_manager.get_frame_manager();
+
+  VacuousLogHandler log_handler;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.create_file(buffer_pool_filename.c_str()));
+  DiskBufferPool *buffer_pool = nullptr;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.open_file(log_handler, buffer_pool_filename.c_str(), buffer_pool));
+
+  // 页面号越大，修改得越早
+  const int page_num = 10;
+  for (int i = 0; i < page_num; ++i) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->allocate_page(&frame));
+    frame->set_lsn(1000 - i);
+    frame->set_lsn(2000);
+    frame->mark_dirty();
+    ASSERT_EQ(buffer_pool->unpin_page(frame), RC::SUCCESS);
+  }
+
+  vector<Frame *> dirty_frames = frame_manager.find_dirty_list();
+  ASSERT_GE(dirty_frames.size(), static_cast<size_t>(page_num));
+  for (size_t i = 1; i < dirty_frames.size(); i++) {
+    ASSERT_LE(dirty_frames[i - 1]->recovery_lsn(), dirty_frames[i]->recovery_lsn());
+  }
+  const size_t dirty_num = dirty_frames.size();
+  ASSERT_EQ(dirty_frames.back()->page_num(), 1);
+  ASSERT_EQ(dirty_frames.back()->recovery_lsn(), 1000);
+  ASSERT_EQ(dirty_frames.back()->lsn(), 2000);
+  for (Frame *frame : dirty_frames) {
+    frame->unpin();
+  }
+
+  // 干净页帧不够时，每一轮按照 io_capacity 刷新最老的脏页
+  PageCleaner page_cleaner(buffer_pool_manager, 100 /*clean_percent*/, 40 /*io_capacity*/);
+  ASSERT_EQ(page_cleaner.run_once(), 4);
+  dirty_frames = frame_manager.find_dirty_list();
+  ASSERT_EQ(dirty_frames.size(), dirty_num - 4);
+  for (Frame *frame : dirty_frames) {
+    ASSERT_NE(frame->page_num(), page_num - 1);
+    frame->unpin();
+  }
+
+  Frame *latched_frame = nullptr;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->get_this_page(1, &latched_frame));
+#ifdef CONCURRENCY
+  // 正在被修改的页面会跳过。没有开启 CONCURRENCY 时latch不会真正加锁
+  atomic<int> latch_state{0};
+  thread      writer([&]() {
+    latched_frame->write_latch();
+    latch_state = 1;
+    while (latch_state != 2) {
+      this_thread::yield();
+    }
+    latched_frame->write_unlatch();
+  });
+  while (latch_state != 1) {
+    this_thread::yield();
+  }
+  while (page_cleaner.run_once() > 0) {
+  }
+  latch_state = 2;
+  writer.join();
+  ASSERT_TRUE(latched_frame->dirty());
+  ASSERT_GT(page_cleaner.stat().skipped_pages, 0);
+  ASSERT_EQ(page_cleaner.run_once(), 1);
+#else
+  while (page_cleaner.run_once() > 0) {
+  }
+#endif
+  ASSERT_EQ(buffer_pool->unpin_page(latched_frame), RC::SUCCESS);
+  ASSERT_FALSE(latched_frame->dirty());
+  ASSERT_EQ(latched_frame->recovery_lsn(), 0);
+  ASSERT_TRUE(frame_manager.find_dirty_list().empty());
+  ASSERT_EQ(page_cleaner.stat().flushed_pages, static_cast<int64_t>(dirty_num));
+  ASSERT_EQ(page_cleaner.stat().failed_pages, 0);
+
+  // 后台线程
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.start_page_cleaner(100, 1000));
+  Frame *frame = nullptr;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->get_this_page(2, &frame));
+  frame->set_lsn(3000);
+  frame->mark_dirty();
+  ASSERT_EQ(buffer_pool->unpin_page(frame), RC::SUCCESS);
+  buffer_pool_manager.page_cleaner()->wakeup();
+  for (int i = 0; i < 1000 && frame->dirty(); i++) {
+    this_thread::sleep_for(chrono::milliseconds(10));
+  }
+  ASSERT_FALSE(frame->dirty());
+  ASSERT_EQ(buffer_pool_manager.close_file(buffer_pool_filename.c_str()), RC::SUCCESS);
+}
+
+TEST(DiskBufferPool, direct_io)
+{
+  filesystem::path directory("buffer_pool");
+  filesystem::remove_all(directory);
+  filesystem::create_directories(directory);
+
+  filesystem::path buffer_pool_filename = directory / "direct_io.bp";
+
+  // 页帧比页面少，刷脏页和淘汰时都会经过 double write buffer 写入数据文件
+  BufferPoolManager buffer_pool_manager(DEFAULT_ITEM_NUM_PER_POOL * BP_PAGE_SIZE);
+  auto              dblwr_buffer = make_unique<DiskDoubleWriteBuffer>(buffer_pool_manager);
+  ASSERT_EQ(RC::SUCCESS, dblwr_buffer->open_file((directory / "dblwr.db").c_str()));
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.init(std::move(dblwr_buffer), 0, nullptr, true /*direct_io*/));
+  ASSERT_TRUE(buffer_pool_manager.direct_io());
+
+  VacuousLogHandler log_handler;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.create_file(buffer_pool_filename.c_str()));
+  DiskBufferPool *buffer_pool = nullptr;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.open_file(log_handler, buffer_pool_filename.c_str(), buffer_pool));
+
+  const int page_num = DEFAULT_ITEM_NUM_PER_POOL * 3;
+  for (int i = 0; i < page_num; ++i) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->allocate_page(&frame));
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(&frame->page()) % BP_PAGE_ALIGNMENT, 0UL);
+    memset(frame->data(), i % 128, BP_PAGE_DATA_SIZE);
+    frame->mark_dirty();
+    ASSERT_EQ(buffer_pool->unpin_page(frame), RC::SUCCESS);
+  }
+
+  ASSERT_EQ(buffer_pool_manager.close_file(buffer_pool_filename.c_str()), RC::SUCCESS);
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.open_file(log_handler, buffer_pool_filename.c_str(), buffer_pool));
+  for (PageNum i = 1; i <= page_num; i++) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->get_this_page(i, &frame));
+    ASSERT_EQ(frame->data()[0], static_cast<char>((i - 1) % 128));
+    ASSERT_EQ(frame->data()[BP_PAGE_DATA_SIZE - 1], static_cast<char>((i - 1) % 128));
+    ASSERT_EQ(buffer_pool->unpin_page(frame), RC::SUCCESS);
+  }
+  ASSERT_EQ(buffer_pool_manager.close_file(buffer_pool_filename.c_str()), RC::SUCCESS);
+}
+
+TEST(DiskBufferPool, page_groups)
+{
+  filesystem::path directory("buffer_pool");
+  filesystem::remove_all(directory);
+  filesystem::create_directories(directory);
+
+  filesystem::path buffer_pool_filename = directory / "page_groups.bp";
+
+  BufferPoolManager buffer_pool_manager(DEFAULT_ITEM_NUM_PER_POOL * BP_PAGE_SIZE);
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.init(make_unique<VacuousDoubleWriteBuffer>()));
+
+  VacuousLogHandler log_handler;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.create_file(buffer_pool_filename.c_str()));
+  DiskBufferPool *buffer_pool = nullptr;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.open_file(log_handler, buffer_pool_filename.c_str(), buffer_pool));
+
+  // 分配的页面超过第0组，文件中会多出一个位图页
+  const PageNum bitmap_page_num = BPFileHeader::group_start(1);
+  const int     page_num        = BPFileHeader::FIRST_GROUP_PAGE_NUM + 100;
+  for (int i = 0; i < page_num; ++i) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->allocate_page(&frame));
+    ASSERT_NE(frame->page_num(), bitmap_page_num);
+    ASSERT_EQ(buffer_pool->unpin_page(frame), RC::SUCCESS);
+  }
+  ASSERT_EQ(buffer_pool->page_count(), page_num + 2);
+  ASSERT_EQ(buffer_pool_page_count(buffer_pool), page_num);
+  ASSERT_NE(RC::SUCCESS, buffer_pool->dispose_page(bitmap_page_num));
+
+  // 释放的页面在两个组中，都可以重新分配出来
+  const vector<PageNum> disposed_pages{10, bitmap_page_num + 50};
+  for (PageNum disposed_page : disposed_pages) {
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->dispose_page(disposed_page));
+  }
+  ASSERT_EQ(buffer_pool_page_count(buffer_pool), page_num - 2);
+
+  for (PageNum disposed_page : disposed_pages) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->allocate_page(&frame));
+    ASSERT_EQ(frame->page_num(), disposed_page);
+    ASSERT_EQ(buffer_pool->unpin_page(frame), RC::SUCCESS);
+  }
+  ASSERT_EQ(buffer_pool->page_count(), page_num + 2);
+
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->dispose_page(bitmap_page_num + 60));
+  ASSERT_EQ(buffer_pool_manager.close_file(buffer_pool_filename.c_str()), RC::SUCCESS);
+
+  // 重新打开文件，分配信息都保存在文件头和位图页中
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.open_file(log_handler, buffer_pool_filename.c_str(), buffer_pool));
+  ASSERT_EQ(buffer_pool->page_count(), page_num + 2);
+  ASSERT_EQ(buffer_pool_page_count(buffer_pool), page_num - 1);
+
+  Frame *frame = nullptr;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->allocate_page(&frame));
+  ASSERT_EQ(frame->page_num(), bitmap_page_num + 60);
+  ASSERT_EQ(buffer_pool->unpin_page(frame), RC::SUCCESS);
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->allocate_page(&frame));
+  ASSERT_EQ(frame->page_num(), page_num + 2);
+  ASSERT_EQ(buffer_pool->unpin_page(frame), RC::SUCCESS);
+  ASSERT_EQ(buffer_pool_manager.close_file(buffer_pool_filename.c_str()), RC::SUCCESS);
+  filesystem::remove_all(directory);
+}
+
+TEST(DiskBufferPool, extent)
+{
+  filesystem::path directory("buffer_pool");
+  filesystem::remove_all(directory);
+  filesystem::create_directories(directory);
+
+  filesystem::path buffer_pool_filename = directory / "extent.bp";
+
+  const int         extent_page_num = 16;
+  BufferPoolManager buffer_pool_manager(DEFAULT_ITEM_NUM_PER_POOL * BP_PAGE_SIZE);
+  ASSERT_EQ(RC::SUCCESS,
+      buffer_pool_manager.init(make_unique<VacuousDoubleWriteBuffer>(), 0, nullptr, false, extent_page_num));
+  ASSERT_EQ(buffer_pool_manager.extent_page_num(), extent_page_num);
+
+  VacuousLogHandler log_handler;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.create_file(buffer_pool_filename.c_str()));
+  DiskBufferPool *buffer_pool = nullptr;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.open_file(log_handler, buffer_pool_filename.c_str(), buffer_pool));
+
+  // 文件按照区扩展，每个页面第一次分配时都不需要写文件
+  for (int i = 1; i < extent_page_num * 2; ++i) {
+    Frame *frame = nullptr;
+    ASSERT_EQ(RC::SUCCESS, buffer_pool->allocate_page(&frame));
+    ASSERT_EQ(frame->page_num(), i);
+    ASSERT_EQ(buffer_pool->unpin_page(frame), RC::SUCCESS);
+    const int reserved_page_num = (i / extent_page_num + 1) * extent_page_num;
+    ASSERT_EQ(filesystem::file_size(buffer_pool_filename), static_cast<uintmax_t>(reserved_page_num * BP_PAGE_SIZE));
+  }
+
+  Frame *frame = nullptr;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->allocate_page(&frame));
+  ASSERT_EQ(frame->page_num(), extent_page_num * 2);
+  ASSERT_EQ(buffer_pool->unpin_page(frame), RC::SUCCESS);
+  ASSERT_EQ(filesystem::file_size(buffer_pool_filename), static_cast<uintmax_t>(extent_page_num * 3 * BP_PAGE_SIZE));
+  ASSERT_EQ(buffer_pool_manager.close_file(buffer_pool_filename.c_str()), RC::SUCCESS);
+
+  // 没有写过的页面从文件中读出来是全0
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.open_file(log_handler, buffer_pool_filename.c_str(), buffer_pool));
+  ASSERT_EQ(buffer_pool->page_count(), extent_page_num * 2 + 1);
+  ASSERT_EQ(RC::SUCCESS, buffer_pool->get_this_page(extent_page_num, &frame));
+  ASSERT_EQ(frame->data()[0], 0);
+  ASSERT_EQ(buffer_pool->unpin_page(frame), RC::SUCCESS);
+  ASSERT_EQ(buffer_pool_manager.close_file(buffer_pool_filename.c_str()), RC::SUCCESS);
+  filesystem::remove_all(directory);
+}
+
 TEST(BufferPool, create)
 {
   filesystem::path test_directory("buffer_pool");
@@ -132,6 +525,98 @@ TEST(BufferPool, create)
   ASSERT_EQ(buffer_pool->id(), buffer_pool2->id());
 }
 
+TEST(DiskBufferPool, page_size)
+{
+  filesystem::path directory("buffer_pool");
+  filesystem::remove_all(directory);
+  filesystem::create_directories(directory);
+
+  filesystem::path small_filename = directory / "small_page.bp";
+  filesystem::path large_filename = directory / "large_page.bp";
+  filesystem::path dblwr_filename = directory / "dblwr.db";
+
+  const int large_page_size = BP_MAX_PAGE_SIZE;
+  const int page_num        = DEFAULT_ITEM_NUM_PER_POOL * 3;
+
+  VacuousLogHandler log_handler;
+  {
+    BufferPoolManager buffer_pool_manager(DEFAULT_ITEM_NUM_PER_POOL * BP_PAGE_SIZE);
+    auto              dblwr_buffer = make_unique<DiskDoubleWriteBuffer>(buffer_pool_manager);
+    ASSERT_EQ(RC::SUCCESS, dblwr_buffer->open_file(dblwr_filename.c_str()));
+    ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.init(std::move(dblwr_buffer)));
+
+    ASSERT_NE(RC::SUCCESS, buffer_pool_manager.create_file((directory / "invalid.bp").c_str(), BP_PAGE_SIZE + 1));
+    ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.create_file(small_filename.c_str()));
+    ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.create_file(large_filename.c_str(), large_page_size));
+
+    DiskBufferPool *small_buffer_pool = nullptr;
+    DiskBufferPool *large_buffer_pool = nullptr;
+    ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.open_file(log_handler, small_filename.c_str(), small_buffer_pool));
+    ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.open_file(log_handler, large_filename.c_str(), large_buffer_pool));
+    ASSERT_EQ(small_buffer_pool->page_size(), BP_PAGE_SIZE);
+    ASSERT_EQ(large_buffer_pool->page_size(), large_page_size);
+    ASSERT_EQ(large_buffer_pool->page_data_size(), bp_page_data_size(large_page_size));
+    ASSERT_EQ(buffer_pool_manager.frame_managers().size(), 2UL);
+
+    // 页面个数超过页帧个数，一部分页面会经过 double write buffer 淘汰到磁盘
+    for (int i = 0; i < page_num; ++i) {
+      for (DiskBufferPool *buffer_pool : {small_buffer_pool, large_buffer_pool}) {
+        Frame *frame = nullptr;
+        ASSERT_EQ(RC::SUCCESS, buffer_pool->allocate_page(&frame));
+        ASSERT_EQ(frame->page_size(), buffer_pool->page_size());
+        memset(frame->data(), i % 128, frame->page_data_size());
+        frame->mark_dirty();
+        ASSERT_EQ(buffer_pool->unpin_page(frame), RC::SUCCESS);
+      }
+    }
+  }
+
+  ASSERT_EQ(filesystem::file_size(large_filename) % large_page_size, 0UL);
+
+  BufferPoolManager buffer_pool_manager(DEFAULT_ITEM_NUM_PER_POOL * BP_PAGE_SIZE);
+  auto              dblwr_buffer = make_unique<DiskDoubleWriteBuffer>(buffer_pool_manager);
+  ASSERT_EQ(RC::SUCCESS, dblwr_buffer->open_file(dblwr_filename.c_str()));
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.init(std::move(dblwr_buffer)));
+
+  DiskBufferPool *small_buffer_pool = nullptr;
+  DiskBufferPool *large_buffer_pool = nullptr;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.open_file(log_handler, small_filename.c_str(), small_buffer_pool));
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.open_file(log_handler, large_filename.c_str(), large_buffer_pool));
+  ASSERT_EQ(large_buffer_pool->page_size(), large_page_size);
+  for (DiskBufferPool *buffer_pool : {small_buffer_pool, large_buffer_pool}) {
+    ASSERT_EQ(buffer_pool->page_count(), page_num + 1);
+    for (PageNum i = 1; i <= page_num; i++) {
+      Frame *frame = nullptr;
+      ASSERT_EQ(RC::SUCCESS, buffer_pool->get_this_page(i, &frame));
+      ASSERT_EQ(frame->data()[0], static_cast<char>((i - 1) % 128));
+      ASSERT_EQ(frame->data()[frame->page_data_size() - 1], static_cast<char>((i - 1) % 128));
+      ASSERT_EQ(buffer_pool->unpin_page(frame), RC::SUCCESS);
+    }
+  }
+  ASSERT_EQ(buffer_pool_manager.close_file(small_filename.c_str()), RC::SUCCESS);
+  ASSERT_EQ(buffer_pool_manager.close_file(large_filename.c_str()), RC::SUCCESS);
+  filesystem::remove_all(directory);
+}
+
+TEST(DiskBufferPool, page_size_memory)
+{
+  // 两种页面大小平分内存，总的内存不超过配置的大小
+  const int         memory_size = 2 * DEFAULT_ITEM_NUM_PER_POOL * BP_MAX_PAGE_SIZE;
+  BufferPoolManager buffer_pool_manager(memory_size, 1 /*frame_shard_num*/, nullptr /*frame_replacer*/, 2);
+
+  BPFrameManager &small_frame_manager = buffer_pool_manager.get_frame_manager();
+  BPFrameManager *large_frame_manager = nullptr;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.get_frame_manager(BP_MAX_PAGE_SIZE, large_frame_manager));
+  ASSERT_EQ(small_frame_manager.total_frame_num() * BP_PAGE_SIZE, static_cast<size_t>(memory_size / 2));
+  ASSERT_EQ(large_frame_manager->total_frame_num() * BP_MAX_PAGE_SIZE, static_cast<size_t>(memory_size / 2));
+
+  // 超出预计的页面大小只分配一个内存池
+  BPFrameManager *other_frame_manager = nullptr;
+  ASSERT_EQ(RC::SUCCESS, buffer_pool_manager.get_frame_manager(BP_PAGE_SIZE * 2, other_frame_manager));
+  ASSERT_EQ(other_frame_manager->total_frame_num(), static_cast<size_t>(DEFAULT_ITEM_NUM_PER_POOL));
+  ASSERT_EQ(buffer_pool_manager.frame_managers().size(), 3UL);
+}
+
 int main(int argc, char **argv)
 {
   testing::InitGoogleTest(&argc, argv);
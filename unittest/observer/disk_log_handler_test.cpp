@@ -12,6 +12,8 @@ See the Mulan PSL v2 for more details. */
 // Created by wangyunlai on 2024/01/31
 //
 
+#include <fstream>
+
 #include "gtest/gtest.h"
 
 #define private public
@@ -40,6 +42,49 @@ private:
   int64_t count_ = 0;
 };
 
+/// 使用很小的日志文件写入 times 条日志，返回所有的日志文件
+static void write_log_files(const char *path, int times, vector<string> &files)
+{
+  filesystem::remove_all(path);
+
+  DiskLogHandler  handler;
+  TestLogReplayer replayer;
+  ASSERT_EQ(RC::SUCCESS, handler.init(path, 16 * 1024, 0, "none"));
+  ASSERT_EQ(RC::SUCCESS, handler.replay(replayer, 0));
+  ASSERT_EQ(RC::SUCCESS, handler.start());
+  for (int i = 0; i < times; ++i) {
+    LSN          lsn = 0;
+    vector<char> data(10);
+    ASSERT_EQ(RC::SUCCESS, handler.append(lsn, LogModule::Id::BUFFER_POOL, std::move(data)));
+  }
+  ASSERT_EQ(RC::SUCCESS, handler.stop());
+  ASSERT_EQ(RC::SUCCESS, handler.await_termination());
+
+  ASSERT_EQ(RC::SUCCESS, handler.file_manager_.list_files(files, 0));
+}
+
+/// 修改日志文件中第一条日志的内容，让这一批日志的校验码对不上
+static void corrupt_first_batch(const string &file)
+{
+  fstream fs(file, ios::in | ios::out | ios::binary);
+  fs.seekp(LogBatchHeader::SIZE + LogHeader::SIZE);
+  fs.put('x');
+}
+
+static RC count_log_entries(const char *path, int &count)
+{
+  count = 0;
+  DiskLogHandler handler;
+  RC             rc = handler.init(path, 16 * 1024, 0, "none");
+  if (OB_FAIL(rc)) {
+    return rc;
+  }
+  return handler.iterate([&count](LogEntry &) -> RC {
+    count++;
+    return RC::SUCCESS;
+  }, 0);
+}
+
 TEST(DiskLogHandler, empty)
 {
   // specific an empty directory and test DiskLogHandler start/stop and so on
@@ -180,6 +225,84 @@ TEST(DiskLogHandler, multi_thread)
   ASSERT_EQ(RC::SUCCESS, handler.await_termination());
 }
 
+TEST(DiskLogHandler, group_commit)
+{
+  const char *directory = "test_log_handler_group_commit";
+  filesystem::remove_all(directory);
+
+  DiskLogHandler  handler;
+  TestLogReplayer replayer;
+  ASSERT_EQ(RC::SUCCESS, handler.init(directory));
+  ASSERT_EQ(RC::SUCCESS, handler.replay(replayer, 0));
+  ASSERT_EQ(RC::SUCCESS, handler.start());
+
+  // 每个任务都等待自己的日志刷盘，刷新线程需要及时唤醒它们
+  const int          times = 20000;
+  atomic<int>        failed_count{0};
+  ThreadPoolExecutor executor;
+  ASSERT_EQ(0, executor.init("TestGroupCommit", 8, 8, 60 * 1000));
+
+  for (int i = 0; i < times; ++i) {
+    ASSERT_EQ(0, executor.execute([&handler, &failed_count]() -> void {
+      LSN          lsn = 0;
+      vector<char> data(10);
+      if (OB_FAIL(handler.append(lsn, LogModule::Id::TRANSACTION, std::move(data))) ||
+          OB_FAIL(handler.wait_lsn(lsn)) || handler.current_flushed_lsn() < lsn) {
+        failed_count++;
+      }
+    }));
+  }
+
+  ASSERT_EQ(0, executor.shutdown());
+  ASSERT_EQ(0, executor.await_termination());
+  ASSERT_EQ(0, failed_count.load());
+  ASSERT_EQ(times, handler.current_flushed_lsn());
+
+  ASSERT_EQ(RC::SUCCESS, handler.stop());
+  ASSERT_EQ(RC::SUCCESS, handler.await_termination());
+
+  int count = 0;
+  ASSERT_EQ(RC::SUCCESS, handler.iterate([&count](LogEntry &) -> RC {
+    count++;
+    return RC::SUCCESS;
+  }, 0));
+  ASSERT_EQ(times, count);
+
+  filesystem::remove_all(directory);
+}
+
+TEST(DiskLogHandler, corrupted_files)
+{
+  const char    *path  = "test_log_handler_corrupted";
+  const int      times = 3000;
+  vector<string> files;
+  int            count = 0;
+
+  // 最后一个文件中损坏的日志当作日志的结尾
+  write_log_files(path, times, files);
+  ASSERT_GE(files.size(), 3);
+  ASSERT_EQ(RC::SUCCESS, count_log_entries(path, count));
+  ASSERT_EQ(times, count);
+
+  corrupt_first_batch(files.back());
+  ASSERT_EQ(RC::SUCCESS, count_log_entries(path, count));
+  ASSERT_LT(count, times);
+
+  // 前面的文件中有损坏的日志，恢复失败
+  files.clear();
+  write_log_files(path, times, files);
+  corrupt_first_batch(files[1]);
+  ASSERT_EQ(RC::IOERR_READ, count_log_entries(path, count));
+
+  // 中间少了一个文件，后面文件的LSN接不上，恢复失败
+  files.clear();
+  write_log_files(path, times, files);
+  filesystem::remove(files[1]);
+  ASSERT_EQ(RC::IOERR_READ, count_log_entries(path, count));
+
+  filesystem::remove_all(path);
+}
+
 int main(int argc, char **argv)
 {
   testing::InitGoogleTest(&argc, argv);
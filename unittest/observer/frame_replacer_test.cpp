@@ -0,0 +1,229 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include "storage/buffer/frame.h"
+#include "storage/buffer/frame_replacer.h"
+#include "gtest/gtest.h"
+
+/// 返回第一个淘汰候选
+static Frame *first_victim(FrameReplacer &replacer)
+{
+  Frame *victim = nullptr;
+  replacer.foreach_victim([&victim](Frame *frame) {
+    victim = frame;
+    return false;
+  });
+  return victim;
+}
+
+TEST(frame_replacer, create)
+{
+  unique_ptr<FrameReplacer> replacer;
+  ASSERT_EQ(FrameReplacer::create(nullptr, replacer), RC::SUCCESS);
+  ASSERT_STREQ(replacer->name(), "lru");
+  ASSERT_EQ(FrameReplacer::create("CLOCK", replacer), RC::SUCCESS);
+  ASSERT_STREQ(replacer->name(), "clock");
+  ASSERT_EQ(FrameReplacer::create("2q", replacer), RC::SUCCESS);
+  ASSERT_STREQ(replacer->name(), "2q");
+  ASSERT_EQ(FrameReplacer::create("unknown", replacer), RC::INVALID_ARGUMENT);
+}
+
+TEST(frame_replacer, lru)
+{
+  Frame frames[3];
+
+  LruFrameReplacer replacer;
+  for (Frame &frame : frames) {
+    replacer.on_insert(&frame);
+  }
+  ASSERT_EQ(replacer.size(), 3UL);
+  ASSERT_EQ(first_victim(replacer), &frames[0]);
+
+  replacer.on_access(&frames[0]);
+  ASSERT_EQ(first_victim(replacer), &frames[1]);
+
+  replacer.on_remove(&frames[1]);
+  ASSERT_EQ(first_victim(replacer), &frames[2]);
+  ASSERT_EQ(replacer.size(), 2UL);
+}
+
+TEST(frame_replacer, clock)
+{
+  Frame frames[3];
+
+  ClockFrameReplacer replacer;
+  for (Frame &frame : frames) {
+    replacer.on_insert(&frame);
+  }
+
+  // 第一圈清除所有的访问标识，第二圈从头开始淘汰
+  ASSERT_EQ(first_victim(replacer), &frames[0]);
+
+  // 被访问过的页帧有第二次机会
+  replacer.on_access(&frames[1]);
+  ASSERT_EQ(first_victim(replacer), &frames[2]);
+
+  replacer.on_remove(&frames[2]);
+  replacer.on_remove(&frames[0]);
+  ASSERT_EQ(first_victim(replacer), &frames[1]);
+
+  // 删除后的空位可以复用
+  replacer.on_insert(&frames[0]);
+  ASSERT_EQ(replacer.size(), 2UL);
+
+  int count = 0;
+  replacer.foreach_victim([&count](Frame *) {
+    count++;
+    return true;
+  });
+  ASSERT_GE(count, 2);
+}
+
+/// 页面从A1in淘汰之后再次加载，进入Am
+static void make_hot(TwoQueueFrameReplacer &replacer, Frame &frame)
+{
+  replacer.on_insert(&frame);
+  replacer.on_remove(&frame);
+  replacer.on_insert(&frame);
+}
+
+TEST(frame_replacer, two_queue_scan_resistant)
+{
+  const int hot_num  = 8;
+  const int scan_num = 32;
+  Frame     hot_frames[hot_num];
+  Frame     scan_frames[scan_num];
+  for (int i = 0; i < hot_num; i++) {
+    hot_frames[i].set_buffer_pool_id(0);
+    hot_frames[i].set_page_num(i);
+  }
+
+  TwoQueueFrameReplacer replacer;
+  for (Frame &frame : hot_frames) {
+    make_hot(replacer, frame);
+  }
+
+  // 顺序扫描的页面只访问一次，会先被淘汰
+  for (Frame &frame : scan_frames) {
+    replacer.on_insert(&frame);
+  }
+
+  int index = 0;
+  replacer.foreach_victim([&index, &scan_frames](Frame *frame) {
+    if (index < scan_num) {
+      EXPECT_EQ(frame, &scan_frames[index]);
+    }
+    index++;
+    return true;
+  });
+  ASSERT_EQ(index, hot_num + scan_num);
+
+  // A1 中的页面不多时，优先淘汰 Am 中最久没有访问的页面
+  for (Frame &frame : scan_frames) {
+    replacer.on_remove(&frame);
+  }
+  replacer.on_insert(&scan_frames[0]);
+  ASSERT_EQ(first_victim(replacer), &hot_frames[0]);
+}
+
+TEST(frame_replacer, two_queue_correlated_reference)
+{
+  const int hot_num  = 4;
+  const int scan_num = 16;
+  Frame     hot_frames[hot_num];
+  Frame     scan_frames[scan_num];
+  for (int i = 0; i < hot_num; i++) {
+    hot_frames[i].set_buffer_pool_id(0);
+    hot_frames[i].set_page_num(i);
+  }
+
+  TwoQueueFrameReplacer replacer;
+  for (Frame &frame : hot_frames) {
+    make_hot(replacer, frame);
+  }
+
+  // 扫描时同一个页面被连续访问多次，仍然留在A1in中
+  for (Frame &frame : scan_frames) {
+    replacer.on_insert(&frame);
+    replacer.on_access(&frame);
+    replacer.on_access(&frame);
+  }
+
+  // A1in 超过配额时一直淘汰扫描的页面，Am中的热点页面都不会被淘汰
+  for (int i = 0; i < scan_num - 1; i++) {
+    Frame *victim = first_victim(replacer);
+    ASSERT_EQ(victim, &scan_frames[i]);
+    replacer.on_remove(victim);
+  }
+  ASSERT_EQ(replacer.size(), static_cast<size_t>(hot_num + 1));
+
+  int index = 0;
+  replacer.foreach_victim([&index, &hot_frames, &scan_frames](Frame *frame) {
+    EXPECT_EQ(frame, index < hot_num ? &hot_frames[index] : &scan_frames[scan_num - 1]);
+    index++;
+    return true;
+  });
+  ASSERT_EQ(index, hot_num + 1);
+}
+
+TEST(frame_replacer, two_queue_ghost)
+{
+  const int frame_num = 8;
+  Frame     frames[frame_num];
+  for (int i = 0; i < frame_num; i++) {
+    frames[i].set_buffer_pool_id(0);
+    frames[i].set_page_num(i);
+  }
+
+  TwoQueueFrameReplacer replacer(25, 50);
+  for (Frame &frame : frames) {
+    replacer.on_insert(&frame);
+  }
+
+  // 从A1in淘汰的页面只记录在A1out中，再次加载时直接进入Am
+  replacer.on_remove(&frames[0]);
+  ASSERT_EQ(replacer.ghost_size(), 1UL);
+  replacer.on_insert(&frames[0]);
+  ASSERT_EQ(replacer.ghost_size(), 0UL);
+  int index = 0;
+  replacer.foreach_victim([&index, &frames](Frame *frame) {
+    if (index == frame_num - 1) {
+      EXPECT_EQ(frame, &frames[0]);
+    } else {
+      EXPECT_NE(frame, &frames[0]);
+    }
+    index++;
+    return true;
+  });
+  ASSERT_EQ(index, frame_num);
+
+  // Am 中淘汰的页面不会记录到A1out
+  replacer.on_remove(&frames[0]);
+  ASSERT_EQ(replacer.ghost_size(), 0UL);
+
+  // A1out 的长度不超过最多页帧个数的 a1out_percent
+  for (int i = 1; i < frame_num; i++) {
+    replacer.on_remove(&frames[i]);
+  }
+  ASSERT_EQ(replacer.size(), 0UL);
+  ASSERT_EQ(replacer.ghost_size(), static_cast<size_t>(frame_num / 2));
+
+  // 最早淘汰的页面已经不在A1out中了
+  replacer.on_insert(&frames[1]);
+  ASSERT_EQ(replacer.ghost_size(), static_cast<size_t>(frame_num / 2));
+  replacer.on_insert(&frames[frame_num - 1]);
+  ASSERT_EQ(replacer.ghost_size(), static_cast<size_t>(frame_num / 2 - 1));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
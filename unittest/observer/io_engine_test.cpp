@@ -0,0 +1,100 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <fcntl.h>
+#include <filesystem>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+#include "storage/buffer/io_engine.h"
+#include "storage/buffer/page.h"
+
+using namespace std;
+
+/// 批量写入一些页面，再批量读出来比较
+static void test_io_engine(IoEngine &engine)
+{
+  filesystem::path file_path = filesystem::path("io_engine_test_dir") / engine.name();
+  filesystem::remove_all(file_path.parent_path());
+  filesystem::create_directories(file_path.parent_path());
+
+  int fd = open(file_path.c_str(), O_CREAT | O_RDWR, 0644);
+  ASSERT_GE(fd, 0);
+
+  // 页面个数超过 io_uring 提交队列的长度，需要分多次提交
+  const int    page_num = 100;
+  vector<Page> pages(page_num);
+  vector<IoRequest> requests;
+  for (int i = 0; i < page_num; i++) {
+    memset(&pages[i], i, sizeof(Page));
+    // 倒序写入，在文件中留下空洞也能正确处理
+    const int page_index = page_num - 1 - i;
+    requests.push_back(IoRequest::write(fd, &pages[page_index], sizeof(Page), (int64_t)page_index * sizeof(Page)));
+  }
+  ASSERT_EQ(engine.submit(requests), RC::SUCCESS);
+
+  vector<Page> read_pages(page_num);
+  requests.clear();
+  for (int i = 0; i < page_num; i++) {
+    requests.push_back(IoRequest::read(fd, &read_pages[i], sizeof(Page), (int64_t)i * sizeof(Page)));
+  }
+  ASSERT_EQ(engine.submit(requests), RC::SUCCESS);
+  for (int i = 0; i < page_num; i++) {
+    ASSERT_EQ(requests[i].rc, RC::SUCCESS);
+    ASSERT_EQ(0, memcmp(&pages[i], &read_pages[i], sizeof(Page)));
+  }
+
+  // 读取超过文件尾的数据会失败，但是不影响同一批的其它请求
+  requests.clear();
+  requests.push_back(IoRequest::read(fd, &read_pages[0], sizeof(Page), 0));
+  requests.push_back(IoRequest::read(fd, &read_pages[1], sizeof(Page), (int64_t)page_num * sizeof(Page)));
+  ASSERT_EQ(engine.submit(requests), RC::IOERR_READ);
+  ASSERT_EQ(requests[0].rc, RC::SUCCESS);
+  ASSERT_EQ(requests[1].rc, RC::IOERR_READ);
+
+  Page page;
+  ASSERT_EQ(engine.read(fd, &page, sizeof(page), (int64_t)(page_num - 1) * sizeof(Page)), RC::SUCCESS);
+  ASSERT_EQ(0, memcmp(&page, &pages[page_num - 1], sizeof(Page)));
+
+  close(fd);
+}
+
+TEST(io_engine, create)
+{
+  unique_ptr<IoEngine> engine;
+  ASSERT_EQ(IoEngine::create(nullptr, engine), RC::SUCCESS);
+  ASSERT_STREQ(engine->name(), "sync");
+  ASSERT_EQ(IoEngine::create("SYNC", engine), RC::SUCCESS);
+  ASSERT_STREQ(engine->name(), "sync");
+  // 系统不支持 io_uring 时会使用 sync
+  ASSERT_EQ(IoEngine::create("io_uring", engine), RC::SUCCESS);
+  ASSERT_EQ(IoEngine::create("unknown", engine), RC::INVALID_ARGUMENT);
+}
+
+TEST(io_engine, sync)
+{
+  SyncIoEngine engine;
+  test_io_engine(engine);
+}
+
+TEST(io_engine, io_uring)
+{
+  IoUringIoEngine engine(16);
+  if (OB_FAIL(engine.init())) {
+    GTEST_SKIP() << "io_uring is not supported";
+  }
+  test_io_engine(engine);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
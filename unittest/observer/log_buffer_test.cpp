@@ -12,6 +12,8 @@ See the Mulan PSL v2 for more details. */
 // Created by wangyunlai on 2024/01/31
 //
 
+#include <thread>
+
 #include "gtest/gtest.h"
 
 #define private public
@@ -40,8 +42,11 @@ TEST(LogEntryBuffer, test_append)
   ASSERT_GT(buffer.bytes(), 0);
   ASSERT_GT(buffer.entry_number(), 0);
 
+  // 文件正好放下 (start_lsn, end_lsn] 之间的日志，这些日志分两批刷盘，每批有一个批次头
   LogFileWriter writer;
-  ASSERT_EQ(RC::SUCCESS, writer.open("test_log_entry_buffer.log", end_lsn));
+  filesystem::remove("test_log_entry_buffer.log");
+  ASSERT_EQ(RC::SUCCESS,
+      writer.open("test_log_entry_buffer.log", (LogHeader::SIZE + 10) * (end_lsn - start_lsn) + 2 * LogBatchHeader::SIZE));
   int count = 0;
   ASSERT_EQ(RC::SUCCESS, buffer.flush(writer, count));
   ASSERT_EQ(count, 1);
@@ -60,12 +65,72 @@ TEST(LogEntryBuffer, test_append)
 
   ASSERT_EQ(RC::SUCCESS, buffer.append(lsn, LogModule::Id::BUFFER_POOL, vector<char>(10)));
 
-  ASSERT_NE(RC::SUCCESS, buffer.flush(writer, count));
+  ASSERT_EQ(RC::LOG_FILE_FULL, buffer.flush(writer, count));
 
   writer.close();
   filesystem::remove("test_log_entry_buffer.log");
 }
 
+TEST(LogEntryBuffer, test_concurrent_append)
+{
+  // 多个线程同时写日志，一个线程刷新，写入的数据超过缓冲区大小，缓冲区会回绕
+  const char    *filename = "test_log_entry_buffer_concurrent.log";
+  LogEntryBuffer buffer;
+  ASSERT_EQ(RC::SUCCESS, buffer.init(0));
+  filesystem::remove(filename);
+
+  const int thread_num        = 4;
+  const int entry_per_thread  = 5000;
+  const LSN end_lsn           = thread_num * entry_per_thread;
+  LogFileWriter writer;
+  ASSERT_EQ(RC::SUCCESS, writer.open(filename, 32 * 1024 * 1024));
+
+  atomic<int>    done_threads{0};
+  vector<thread> threads;
+  for (int t = 0; t < thread_num; t++) {
+    threads.emplace_back([&buffer, &done_threads, t]() {
+      for (int i = 0; i < entry_per_thread; i++) {
+        // 每条日志的数据都填充同一个字节，读出来时检查数据是否完整
+        vector<char> data(1 + (i * 37 + t * 101) % 2048, static_cast<char>('a' + t));
+        LSN          lsn = 0;
+        ASSERT_EQ(RC::SUCCESS, buffer.append(lsn, LogModule::Id::BUFFER_POOL, std::move(data)));
+      }
+      done_threads++;
+    });
+  }
+
+  int count = 0;
+  while (done_threads.load() < thread_num || buffer.flushed_lsn() < buffer.current_lsn()) {
+    ASSERT_EQ(RC::SUCCESS, buffer.flush(writer, count));
+  }
+  for (thread &t : threads) {
+    t.join();
+  }
+  ASSERT_EQ(end_lsn, buffer.flushed_lsn());
+  ASSERT_EQ(0, buffer.bytes());
+  writer.close();
+
+  LogFileReader reader;
+  ASSERT_EQ(RC::SUCCESS, reader.open(filename));
+  LSN  expect_lsn = 1;
+  auto checker    = [&expect_lsn](LogEntry &entry) -> RC {
+    if (entry.lsn() != expect_lsn++ || entry.payload_size() <= 0) {
+      return RC::INTERNAL;
+    }
+    for (int i = 0; i < entry.payload_size(); i++) {
+      if (entry.data()[i] != entry.data()[0]) {
+        return RC::INTERNAL;
+      }
+    }
+    return RC::SUCCESS;
+  };
+  ASSERT_EQ(RC::SUCCESS, reader.iterate(checker));
+  ASSERT_EQ(end_lsn + 1, expect_lsn);
+  reader.close();
+
+  filesystem::remove(filename);
+}
+
 int main(int argc, char **argv)
 {
   testing::InitGoogleTest(&argc, argv);
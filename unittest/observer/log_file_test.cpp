@@ -20,6 +20,7 @@ See the Mulan PSL v2 for more details. */
 #define protected public
 
 #include "common/log/log.h"
+#include "storage/clog/log_codec.h"
 #include "storage/clog/log_file.h"
 #include "storage/clog/log_entry.h"
 #include "storage/clog/log_module.h"
@@ -31,16 +32,21 @@ TEST(LogFileWriter, basic)
 {
   const char *filename = "test_log_file_writer.log";
 
+  filesystem::remove(filename);
+
+  // 每次写入一条日志，每批占用 LogBatchHeader::SIZE + LogHeader::SIZE + 10 字节，文件正好可以放下 end_lsn 条日志
   // test LogFileWriter open, close, valid
   LogFileWriter writer;
-  LSN           end_lsn = 1000 - 1;
-  ASSERT_EQ(RC::SUCCESS, writer.open(filename, end_lsn));
+  LSN           end_lsn       = 1000 - 1;
+  const int64_t max_file_size = (LogBatchHeader::SIZE + LogHeader::SIZE + 10) * end_lsn;
+  ASSERT_EQ(RC::SUCCESS, writer.open(filename, max_file_size));
   ASSERT_TRUE(writer.valid());
   ASSERT_FALSE(writer.full());
   ASSERT_EQ(RC::SUCCESS, writer.close());
 
   // test LogFileWriter write
-  ASSERT_EQ(RC::SUCCESS, writer.open(filename, end_lsn));
+  ASSERT_EQ(RC::SUCCESS, writer.open(filename, max_file_size));
+  ASSERT_TRUE(writer.empty());
 
   LogEntry entry;
 
@@ -66,12 +72,24 @@ TEST(LogFileWriter, basic)
   ASSERT_EQ(entry.init(end_lsn - 100, LogModule::Id::BUFFER_POOL, std::move(data)), RC::SUCCESS);
   ASSERT_NE(RC::SUCCESS, writer.write(entry));
 
+  // 重新打开文件时，从最后一条有效日志之后继续写
   data.resize(10);
   writer.close();
-  ASSERT_EQ(RC::SUCCESS, writer.open(filename, end_lsn));
+  ASSERT_EQ(RC::SUCCESS, writer.open(filename, max_file_size));
+  ASSERT_EQ(end_lsn, writer.last_lsn());
   ASSERT_EQ(entry.init(end_lsn + 1, LogModule::Id::BUFFER_POOL, std::move(data)), RC::SUCCESS);
-  ASSERT_NE(RC::SUCCESS, writer.write(entry));
+  ASSERT_EQ(RC::LOG_FILE_FULL, writer.write(entry));
   ASSERT_TRUE(writer.full());
+  writer.close();
+
+  // 空文件总是可以写入一条日志，即使它比文件还大
+  filesystem::remove(filename);
+  ASSERT_EQ(RC::SUCCESS, writer.open(filename, 16));
+  data.resize(100);
+  ASSERT_EQ(entry.init(1, LogModule::Id::BUFFER_POOL, std::move(data)), RC::SUCCESS);
+  ASSERT_EQ(RC::SUCCESS, writer.write(entry));
+  ASSERT_TRUE(writer.full());
+  writer.close();
 
   filesystem::remove(filename);
 }
@@ -83,8 +101,9 @@ TEST(LogFileReader, basic)
   filesystem::remove(log_file);
 
   LogFileWriter writer;
-  LSN           end_lsn = 1000 - 1;
-  ASSERT_EQ(RC::SUCCESS, writer.open(log_file, end_lsn));
+  LSN           end_lsn       = 1000 - 1;
+  const int64_t max_file_size = 1024 * 1024;
+  ASSERT_EQ(RC::SUCCESS, writer.open(log_file, max_file_size));
   ASSERT_TRUE(writer.valid());
 
   LogEntry entry;
@@ -131,8 +150,9 @@ TEST(LogFileReadWrite, test_read_write)
   filesystem::remove(log_file);
 
   LogFileWriter writer;
-  LSN           end_lsn = 1000 - 1;
-  ASSERT_EQ(RC::SUCCESS, writer.open(log_file, end_lsn));
+  LSN           end_lsn       = 1000 - 1;
+  const int64_t max_file_size = 1024 * 1024;
+  ASSERT_EQ(RC::SUCCESS, writer.open(log_file, max_file_size));
   ASSERT_TRUE(writer.valid());
 
   LogEntry entry;
@@ -162,7 +182,8 @@ TEST(LogFileReadWrite, test_read_write)
   writer.close();
   reader.close();
 
-  ASSERT_EQ(RC::SUCCESS, writer.open(log_file, end_lsn));
+  ASSERT_EQ(RC::SUCCESS, writer.open(log_file, max_file_size));
+  ASSERT_EQ(one_lsn, writer.last_lsn());
 
   for (LSN i = one_lsn + 1; i <= end_lsn; i++) {
     vector<char> data(10);
@@ -175,7 +196,110 @@ TEST(LogFileReadWrite, test_read_write)
   ASSERT_EQ(RC::SUCCESS, reader.iterate(callback, 0));
   ASSERT_EQ(end_lsn, count);
 
-  // filesystem::remove(log_file);
+  filesystem::remove(log_file);
+}
+
+TEST(LogFileReadWrite, compressed)
+{
+  const char *log_file = "test_log_file_compressed.log";
+  filesystem::remove(log_file);
+
+  const LogCodec *codec = nullptr;
+  ASSERT_EQ(RC::SUCCESS, LogCodec::find("lz4", codec));
+
+  // 每批写入10条日志，日志内容有很多重复，压缩之后会变小
+  const int     batch_num   = 100;
+  const int     batch_size  = 10;
+  const int     entry_size  = 200;
+  LogFileWriter writer;
+  ASSERT_EQ(RC::SUCCESS, writer.open(log_file, 1024 * 1024, codec));
+  LSN lsn = 0;
+  for (int i = 0; i < batch_num; i++) {
+    vector<LogEntry> entries(batch_size);
+    for (LogEntry &entry : entries) {
+      lsn++;
+      string data = "key_" + to_string(lsn) + "_";
+      data.resize(entry_size, 'v');
+      ASSERT_EQ(RC::SUCCESS, entry.init(lsn, LogModule::Id::BPLUS_TREE, vector<char>(data.begin(), data.end())));
+    }
+    int count = 0;
+    ASSERT_EQ(RC::SUCCESS, writer.write(span<LogEntry>(entries), count));
+    ASSERT_EQ(batch_size, count);
+  }
+  ASSERT_LT(writer.offset_, batch_num * batch_size * (LogHeader::SIZE + entry_size) / 2);
+  writer.close();
+
+  LogFileReader reader;
+  ASSERT_EQ(RC::SUCCESS, reader.open(log_file));
+  LSN  expect_lsn = 0;
+  auto checker    = [&expect_lsn](LogEntry &entry) -> RC {
+    string data = "key_" + to_string(expect_lsn) + "_";
+    data.resize(entry_size, 'v');
+    if (entry.lsn() != expect_lsn++ || entry.payload_size() != entry_size ||
+        0 != memcmp(entry.data(), data.data(), entry_size)) {
+      return RC::INTERNAL;
+    }
+    return RC::SUCCESS;
+  };
+
+  expect_lsn = 1;
+  ASSERT_EQ(RC::SUCCESS, reader.iterate(checker));
+  ASSERT_EQ(lsn + 1, expect_lsn);
+
+  // 从一批日志的中间开始读
+  expect_lsn = 555;
+  ASSERT_EQ(RC::SUCCESS, reader.iterate(checker, expect_lsn));
+  ASSERT_EQ(lsn + 1, expect_lsn);
+  reader.close();
+
+  filesystem::remove(log_file);
+}
+
+TEST(LogFileReadWrite, checksum)
+{
+  const char *log_file = "test_log_file_checksum.log";
+  filesystem::remove(log_file);
+
+  // 写三批日志，破坏第二批中的一个字节
+  LogFileWriter writer;
+  ASSERT_EQ(RC::SUCCESS, writer.open(log_file, 64 * 1024));
+  LSN            lsn = 0;
+  vector<int64_t> batch_offsets;
+  for (int i = 0; i < 3; i++) {
+    batch_offsets.push_back(writer.offset_);
+    vector<LogEntry> entries(10);
+    for (LogEntry &entry : entries) {
+      ASSERT_EQ(RC::SUCCESS, entry.init(++lsn, LogModule::Id::BUFFER_POOL, vector<char>(20, 'a')));
+    }
+    int count = 0;
+    ASSERT_EQ(RC::SUCCESS, writer.write(span<LogEntry>(entries), count));
+  }
+  writer.close();
+
+  {
+    fstream fs(log_file, ios::in | ios::out | ios::binary);
+    fs.seekp(batch_offsets[1] + LogBatchHeader::SIZE + LogHeader::SIZE + 5);
+    fs.put('b');
+  }
+
+  // 校验失败的批次和它后面的日志都被当作不存在
+  LogFileReader reader;
+  ASSERT_EQ(RC::SUCCESS, reader.open(log_file));
+  int count = 0;
+  ASSERT_EQ(RC::SUCCESS, reader.iterate([&count](LogEntry &) -> RC {
+    count++;
+    return RC::SUCCESS;
+  }));
+  ASSERT_EQ(10, count);
+  reader.close();
+
+  // 重新打开文件时，从最后一批有效日志之后继续写
+  ASSERT_EQ(RC::SUCCESS, writer.open(log_file, 64 * 1024));
+  ASSERT_EQ(10, writer.last_lsn());
+  ASSERT_EQ(batch_offsets[1], writer.offset_);
+  writer.close();
+
+  filesystem::remove(log_file);
 }
 
 TEST(LogFileManager, get_lsn_from_filename)
@@ -203,10 +327,11 @@ TEST(LogFileManager, get_lsn_from_filename)
 TEST(LogFileManager, init_not_exists)
 {
   const char *directory                 = "not_exists/not_exists2";
-  int         max_entry_number_per_file = 1000;
+  const int64_t max_file_size      = 64 * 1024;
+  const int     max_recycled_files = 1;
 
   LogFileManager manager;
-  ASSERT_EQ(RC::SUCCESS, manager.init(directory, max_entry_number_per_file));
+  ASSERT_EQ(RC::SUCCESS, manager.init(directory, max_file_size, max_recycled_files));
   ASSERT_TRUE(filesystem::is_directory(directory));
 
   vector<string> files;
@@ -219,12 +344,13 @@ TEST(LogFileManager, init_not_exists)
 TEST(LogFileManager, init_empty_directory)
 {
   const char *directory                 = "empty_directory";
-  int         max_entry_number_per_file = 1000;
+  const int64_t max_file_size      = 64 * 1024;
+  const int     max_recycled_files = 1;
 
   ASSERT_TRUE(filesystem::create_directory(directory));
 
   LogFileManager manager;
-  ASSERT_EQ(RC::SUCCESS, manager.init(directory, max_entry_number_per_file));
+  ASSERT_EQ(RC::SUCCESS, manager.init(directory, max_file_size, max_recycled_files));
   ASSERT_TRUE(filesystem::is_directory(directory));
 
   vector<string> files;
@@ -237,7 +363,8 @@ TEST(LogFileManager, init_empty_directory)
 TEST(LogFileManager, init_with_files)
 {
   const char *directory                 = "init_with_files";
-  int         max_entry_number_per_file = 1000;
+  const int64_t max_file_size      = 64 * 1024;
+  const int     max_recycled_files = 1;
 
   filesystem::remove_all(directory);
 
@@ -255,7 +382,7 @@ TEST(LogFileManager, init_with_files)
   }
 
   LogFileManager manager;
-  ASSERT_EQ(RC::SUCCESS, manager.init(directory, max_entry_number_per_file));
+  ASSERT_EQ(RC::SUCCESS, manager.init(directory, max_file_size, max_recycled_files));
   ASSERT_TRUE(filesystem::is_directory(directory));
 
   vector<string> result_files;
@@ -286,11 +413,12 @@ TEST(LogFileManager, init_with_files)
   ASSERT_EQ(RC::SUCCESS, manager.list_files(result_files, 3010));
   ASSERT_EQ(1, result_files.size());
 
+  // 文件大小不固定，最后一个文件中可能包含任意大的LSN
   ASSERT_EQ(RC::SUCCESS, manager.list_files(result_files, 4000));
-  ASSERT_EQ(0, result_files.size());
+  ASSERT_EQ(1, result_files.size());
 
   ASSERT_EQ(RC::SUCCESS, manager.list_files(result_files, 5000));
-  ASSERT_EQ(0, result_files.size());
+  ASSERT_EQ(1, result_files.size());
 
   ASSERT_TRUE(filesystem::remove_all(directory));
 }
@@ -299,12 +427,13 @@ TEST(LogFileManager, last_file)
 {
   // create an empty directory and try to open last file
   const char *directory                 = "last_file";
-  int         max_entry_number_per_file = 1000;
+  const int64_t max_file_size      = 64 * 1024;
+  const int     max_recycled_files = 1;
 
   filesystem::remove_all(directory);
 
   LogFileManager manager;
-  ASSERT_EQ(RC::SUCCESS, manager.init(directory, max_entry_number_per_file));
+  ASSERT_EQ(RC::SUCCESS, manager.init(directory, max_file_size, max_recycled_files));
   ASSERT_TRUE(filesystem::is_directory(directory));
 
   LogFileWriter writer;
@@ -332,7 +461,7 @@ TEST(LogFileManager, last_file)
     ofs.close();
   }
 
-  ASSERT_EQ(RC::SUCCESS, manager.init(directory, max_entry_number_per_file));
+  ASSERT_EQ(RC::SUCCESS, manager.init(directory, max_file_size, max_recycled_files));
   ASSERT_TRUE(filesystem::is_directory(directory));
 
   ASSERT_EQ(RC::SUCCESS, manager.last_file(writer));
@@ -346,16 +475,17 @@ TEST(LogFileManager, next_file)
 {
   // create an empty directory and try to open next file
   const char *directory                 = "next_file";
-  int         max_entry_number_per_file = 1000;
+  const int64_t max_file_size      = 64 * 1024;
+  const int     max_recycled_files = 1;
 
   filesystem::remove_all(directory);
 
   LogFileManager manager;
-  ASSERT_EQ(RC::SUCCESS, manager.init(directory, max_entry_number_per_file));
+  ASSERT_EQ(RC::SUCCESS, manager.init(directory, max_file_size, max_recycled_files));
   ASSERT_TRUE(filesystem::is_directory(directory));
 
   LogFileWriter writer;
-  ASSERT_EQ(RC::SUCCESS, manager.next_file(writer));
+  ASSERT_EQ(RC::SUCCESS, manager.next_file(writer, 0));
   ASSERT_TRUE(writer.valid());
 
   // test the lsn of the filename of the writer
@@ -378,18 +508,171 @@ TEST(LogFileManager, next_file)
     ofs.close();
   }
 
-  ASSERT_EQ(RC::SUCCESS, manager.init(directory, max_entry_number_per_file));
+  ASSERT_EQ(RC::SUCCESS, manager.init(directory, max_file_size, max_recycled_files));
   ASSERT_TRUE(filesystem::is_directory(directory));
 
-  ASSERT_EQ(RC::SUCCESS, manager.next_file(writer));
+  // 新文件的LSN必须比已有的文件大
+  ASSERT_NE(RC::SUCCESS, manager.next_file(writer, 3000));
+  ASSERT_EQ(RC::SUCCESS, manager.next_file(writer, 4000));
   ASSERT_TRUE(writer.valid());
   ASSERT_EQ(RC::SUCCESS, LogFileManager::get_lsn_from_filename(filesystem::path(writer.filename()).filename(), lsn));
   ASSERT_EQ(4000, lsn);
+  ASSERT_EQ(max_file_size, static_cast<int64_t>(filesystem::file_size(writer.filename())));
 
   writer.close();
   filesystem::remove_all(directory);
 }
 
+TEST(LogFileManager, purge_files)
+{
+  const char *directory                 = "purge_files";
+  const int64_t max_file_size      = 64 * 1024;
+  const int     max_recycled_files = 1;
+
+  filesystem::remove_all(directory);
+  ASSERT_TRUE(filesystem::create_directory(directory));
+  LSN lsns[] = {0, 1000, 2000, 3000};
+  for (LSN lsn : lsns) {
+    string   filename = string(LogFileManager::file_prefix_) + to_string(lsn) + LogFileManager::file_suffix_;
+    ofstream ofs(filesystem::path(directory) / filename);
+    ofs.close();
+  }
+
+  LogFileManager manager;
+  ASSERT_EQ(RC::SUCCESS, manager.init(directory, max_file_size, max_recycled_files));
+
+  vector<string> files;
+  // 文件中还有大于等于lsn的日志，不能删除
+  ASSERT_EQ(RC::SUCCESS, manager.purge_files(999));
+  ASSERT_EQ(RC::SUCCESS, manager.list_files(files, 0));
+  ASSERT_EQ(4, files.size());
+
+  // 回收的文件超过 max_recycled_files 个之后直接删除
+  ASSERT_EQ(RC::SUCCESS, manager.purge_files(2500));
+  ASSERT_EQ(RC::SUCCESS, manager.list_files(files, 0));
+  ASSERT_EQ(2, files.size());
+  ASSERT_EQ(1, manager.recycled_file_num());
+  ASSERT_FALSE(filesystem::exists(filesystem::path(directory) / (string(LogFileManager::file_prefix_) + "0" +
+                                                                 LogFileManager::file_suffix_)));
+  ASSERT_FALSE(filesystem::exists(filesystem::path(directory) / (string(LogFileManager::file_prefix_) + "1000" +
+                                                                 LogFileManager::file_suffix_)));
+  ASSERT_TRUE(filesystem::exists(filesystem::path(directory) / (string(LogFileManager::recycled_file_prefix_) + "0" +
+                                                                LogFileManager::file_suffix_)));
+
+  // 最后一个文件总是保留，新的日志还要写到这里
+  ASSERT_EQ(RC::SUCCESS, manager.purge_files(100000));
+  ASSERT_EQ(RC::SUCCESS, manager.list_files(files, 0));
+  ASSERT_EQ(1, files.size());
+
+  // 新的文件复用回收的文件
+  LogFileWriter writer;
+  LSN           lsn = 0;
+  ASSERT_EQ(RC::SUCCESS, manager.next_file(writer, 4000));
+  ASSERT_EQ(RC::SUCCESS, LogFileManager::get_lsn_from_filename(filesystem::path(writer.filename()).filename(), lsn));
+  ASSERT_EQ(4000, lsn);
+  ASSERT_EQ(0, manager.recycled_file_num());
+  ASSERT_FALSE(filesystem::exists(filesystem::path(directory) / (string(LogFileManager::recycled_file_prefix_) + "0" +
+                                                                 LogFileManager::file_suffix_)));
+
+  writer.close();
+  filesystem::remove_all(directory);
+}
+
+TEST(LogFileManager, rotate_and_recycle)
+{
+  const char   *directory          = "rotate_and_recycle";
+  const int64_t max_file_size      = 4096;
+  const int     max_recycled_files = 4;
+  const int     entry_size         = LogBatchHeader::SIZE + LogHeader::SIZE + 100;
+
+  filesystem::remove_all(directory);
+
+  LogFileManager manager;
+  ASSERT_EQ(RC::SUCCESS, manager.init(directory, max_file_size, max_recycled_files));
+
+  // 写满一个文件之后切换到下一个文件
+  auto write_entries = [&manager](LogFileWriter &writer, LSN first_lsn, LSN last_lsn) {
+    for (LSN lsn = first_lsn; lsn <= last_lsn; lsn++) {
+      LogEntry entry;
+      ASSERT_EQ(RC::SUCCESS, entry.init(lsn, LogModule::Id::BUFFER_POOL, vector<char>(100, static_cast<char>(lsn))));
+      RC rc = writer.write(entry);
+      if (rc == RC::LOG_FILE_FULL) {
+        ASSERT_EQ(RC::SUCCESS, manager.next_file(writer, lsn));
+        rc = writer.write(entry);
+      }
+      ASSERT_EQ(RC::SUCCESS, rc);
+    }
+  };
+
+  auto read_entries = [&manager](LSN start_lsn, LSN &first_lsn, LSN &last_lsn) {
+    vector<string> files;
+    ASSERT_EQ(RC::SUCCESS, manager.list_files(files, start_lsn));
+    first_lsn = 0;
+    last_lsn  = 0;
+    for (const string &file : files) {
+      LogFileReader reader;
+      ASSERT_EQ(RC::SUCCESS, reader.open(file.c_str()));
+      ASSERT_EQ(RC::SUCCESS, reader.iterate([&](LogEntry &entry) -> RC {
+        if (first_lsn == 0) {
+          first_lsn = entry.lsn();
+        } else if (entry.lsn() != last_lsn + 1) {
+          return RC::INTERNAL;
+        }
+        last_lsn = entry.lsn();
+        return RC::SUCCESS;
+      }, start_lsn));
+      reader.close();
+    }
+  };
+
+  const LSN     entry_num      = 200;
+  const int     entry_per_file = static_cast<int>(max_file_size / entry_size);
+  LogFileWriter writer;
+  ASSERT_EQ(RC::SUCCESS, manager.last_file(writer));
+  write_entries(writer, 1, entry_num);
+
+  vector<string> files;
+  ASSERT_EQ(RC::SUCCESS, manager.list_files(files, 0));
+  ASSERT_EQ((entry_num + entry_per_file - 1) / entry_per_file, static_cast<LSN>(files.size()));
+  for (const string &file : files) {
+    ASSERT_EQ(max_file_size, static_cast<int64_t>(filesystem::file_size(file)));
+  }
+
+  LSN first_lsn = 0;
+  LSN last_lsn  = 0;
+  read_entries(0, first_lsn, last_lsn);
+  ASSERT_EQ(1, first_lsn);
+  ASSERT_EQ(entry_num, last_lsn);
+
+  read_entries(100, first_lsn, last_lsn);
+  ASSERT_EQ(100, first_lsn);
+  ASSERT_EQ(entry_num, last_lsn);
+
+  // 回收检查点之前的文件，后面的日志写到回收的文件中，旧的日志不会被读出来
+  ASSERT_EQ(RC::SUCCESS, manager.purge_files(150));
+  ASSERT_EQ(max_recycled_files, manager.recycled_file_num());
+  read_entries(0, first_lsn, last_lsn);
+  ASSERT_LE(first_lsn, 150);
+  ASSERT_EQ(entry_num, last_lsn);
+
+  write_entries(writer, entry_num + 1, entry_num + entry_per_file * 2);
+  ASSERT_EQ(max_recycled_files - 2, manager.recycled_file_num());
+  read_entries(0, first_lsn, last_lsn);
+  ASSERT_LE(first_lsn, 150);
+  ASSERT_EQ(entry_num + entry_per_file * 2, last_lsn);
+  writer.close();
+
+  // 重启之后从最后一个文件的有效日志之后继续写
+  LogFileManager manager2;
+  ASSERT_EQ(RC::SUCCESS, manager2.init(directory, max_file_size, max_recycled_files));
+  ASSERT_EQ(max_recycled_files - 2, manager2.recycled_file_num());
+  ASSERT_EQ(RC::SUCCESS, manager2.last_file(writer));
+  ASSERT_EQ(entry_num + entry_per_file * 2, writer.last_lsn());
+  writer.close();
+
+  filesystem::remove_all(directory);
+}
+
 int main(int argc, char **argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -21,7 +21,11 @@ See the Mulan PSL v2 for more details. */
 #define private public
 #include "common/value.h"
 #undef private
+#include "common/conf/ini.h"
+#include "common/ini_setting.h"
 #include "gtest/gtest.h"
+#include "storage/buffer/page_cleaner.h"
+#include "storage/clog/disk_log_handler.h"
 #include "storage/db/db.h"
 #include "storage/table/table.h"
 #include "storage/record/record.h"
@@ -729,6 +733,233 @@ TEST(MvccTrxLog, wal_rollback_abnormal)
   db.reset();
 }
 
+TEST(MvccTrxLog, checkpoint)
+{
+  /*
+  插入一些数据，刷新所有脏页之后做检查点，检查点之前的日志文件会被删除。
+  再插入一些数据，并留下一个没有提交的事务，做检查点时不能越过这个事务的日志。
+  将文件复制到另一个目录，从检查点开始恢复，检查数据是否一致。
+  */
+  filesystem::path test_directory("mvcc_trx_log_test");
+  filesystem::remove_all(test_directory);
+  filesystem::create_directory(test_directory);
+
+  const char      *dbname           = "test_db";
+  const char      *dbname2          = "test_db2";
+  filesystem::path db_path          = test_directory / dbname;
+  filesystem::path db_path2         = test_directory / dbname2;
+  const char      *trx_kit_name     = "mvcc";
+  const char      *log_handler_name = "disk";
+
+  filesystem::create_directories(db_path);
+  filesystem::create_directories(db_path2);
+
+  // 使用比较小的日志文件，保证能生成多个日志文件，同时测试压缩过的日志
+  get_properties()->put(CLOG_FILE_SIZE, "65536", STORAGE);
+  get_properties()->put(CLOG_COMPRESSION, "lz4", STORAGE);
+
+  auto db = make_unique<Db>();
+  ASSERT_EQ(RC::SUCCESS, db->init(dbname, db_path.c_str(), trx_kit_name, log_handler_name));
+
+  const char             *table_name = "table_0";
+  const int               field_num  = 10;
+  vector<AttrInfoSqlNode> attr_infos;
+  for (int i = 0; i < field_num; i++) {
+    AttrInfoSqlNode attr_info;
+    attr_info.name   = string("field_") + to_string(i);
+    attr_info.type   = AttrType::INTS;
+    attr_info.length = 4;
+    attr_infos.push_back(attr_info);
+  }
+  ASSERT_EQ(RC::SUCCESS, db->create_table(table_name, attr_infos, {}));
+  Table *table = db->find_table(table_name);
+  ASSERT_NE(table, nullptr);
+
+  TrxKit &trx_kit     = db->trx_kit();
+  auto    insert_rows = [&](Trx *trx, int num) {
+    for (int i = 0; i < num; i++) {
+      Record        record;
+      vector<Value> values(field_num);
+      for (Value &value : values) {
+        value.set_int(i);
+      }
+      ASSERT_EQ(RC::SUCCESS, table->make_record(values.size(), values.data(), record));
+      ASSERT_EQ(RC::SUCCESS, trx->insert_record(table, record));
+    }
+  };
+
+  const int trx_num    = 3;
+  const int insert_num = 1000;
+  for (int i = 0; i < trx_num; i++) {
+    Trx *trx = trx_kit.create_trx(db->log_handler());
+    trx->start_if_need();
+    insert_rows(trx, insert_num);
+    ASSERT_EQ(RC::SUCCESS, trx->commit());
+    trx_kit.destroy_trx(trx);
+  }
+
+  // 回收的日志文件不算在内
+  auto clog_file_num = [](const filesystem::path &path) {
+    int num = 0;
+    for (const auto &entry : filesystem::directory_iterator(path / "clog")) {
+      if (!entry.path().filename().string().starts_with("clog_recycled_")) {
+        num++;
+      }
+    }
+    return num;
+  };
+  const int clog_files_before = clog_file_num(db_path);
+  ASSERT_GT(clog_files_before, 1);
+
+  // 第一次只记录当前的LSN
+  ASSERT_EQ(RC::SUCCESS, db->checkpoint());
+  PageCleaner page_cleaner(db->buffer_pool_manager(), 100 /*clean_percent*/, 1000000 /*io_capacity*/);
+  while (page_cleaner.run_once() > 0) {
+  }
+  ASSERT_EQ(RC::SUCCESS, db->checkpoint());
+  ASSERT_LT(clog_file_num(db_path), clog_files_before);
+
+  // 提交一批数据，但是不刷新页面
+  for (int i = 0; i < trx_num; i++) {
+    Trx *trx = trx_kit.create_trx(db->log_handler());
+    trx->start_if_need();
+    insert_rows(trx, insert_num);
+    ASSERT_EQ(RC::SUCCESS, trx->commit());
+    trx_kit.destroy_trx(trx);
+  }
+
+  // 没有提交的事务，恢复的时候需要回滚
+  Trx *active_trx = trx_kit.create_trx(db->log_handler());
+  active_trx->start_if_need();
+  insert_rows(active_trx, 10);
+  while (page_cleaner.run_once() > 0) {
+  }
+  ASSERT_EQ(RC::SUCCESS, db->checkpoint());
+  ASSERT_EQ(RC::SUCCESS, db->checkpoint());
+
+  DiskLogHandler &log_handler = static_cast<DiskLogHandler &>(db->log_handler());
+  ASSERT_EQ(RC::SUCCESS, log_handler.wait_lsn(log_handler.current_lsn()));
+
+  filesystem::copy(db_path, db_path2, filesystem::copy_options::recursive);
+
+  auto db2 = make_unique<Db>();
+  ASSERT_EQ(RC::SUCCESS, db2->init(dbname2, db_path2.c_str(), trx_kit_name, log_handler_name));
+  Table *table2 = db2->find_table(table_name);
+  ASSERT_NE(table2, nullptr);
+
+  // 没有提交的事务在恢复时回滚，插入的数据不可见
+  Trx *trx2 = db2->trx_kit().create_trx(db2->log_handler());
+  trx2->start_if_need();
+  RecordScanner *scanner2 = nullptr;
+  ASSERT_EQ(RC::SUCCESS, table2->get_record_scanner(scanner2, nullptr, ReadWriteMode::READ_ONLY));
+  int    visible_count = 0;
+  Record record;
+  while (OB_SUCC(scanner2->next(record))) {
+    if (OB_SUCC(trx2->visit_record(table2, record, ReadWriteMode::READ_ONLY))) {
+      visible_count++;
+    }
+  }
+  delete scanner2;
+  db2->trx_kit().destroy_trx(trx2);
+  ASSERT_EQ(trx_num * insert_num * 2, visible_count);
+
+  db2.reset();
+  ASSERT_EQ(RC::SUCCESS, active_trx->rollback());
+  trx_kit.destroy_trx(active_trx);
+  db.reset();
+
+  get_properties()->put(CLOG_FILE_SIZE, to_string(CLOG_FILE_SIZE_DEFAULT), STORAGE);
+  get_properties()->put(CLOG_COMPRESSION, CLOG_COMPRESSION_DEFAULT, STORAGE);
+}
+
+TEST(MvccTrxLog, checkpoint_durable_lsn)
+{
+  /*
+  提交一批数据并刷新所有页面，再提交一批数据但是不刷新页面，然后多次做检查点。
+  检查点不能越过同步文件时脏页最小的LSN，从这个LSN开始的日志不能被回收。
+  */
+  filesystem::path test_directory("mvcc_trx_log_test_durable_lsn");
+  filesystem::remove_all(test_directory);
+  filesystem::create_directory(test_directory);
+
+  const char      *dbname  = "test_db";
+  filesystem::path db_path = test_directory / dbname;
+  filesystem::create_directories(db_path);
+
+  get_properties()->put(CLOG_FILE_SIZE, "65536", STORAGE);
+
+  auto db = make_unique<Db>();
+  ASSERT_EQ(RC::SUCCESS, db->init(dbname, db_path.c_str(), "mvcc", "disk"));
+
+  const char             *table_name = "table_0";
+  const int               field_num  = 10;
+  vector<AttrInfoSqlNode> attr_infos;
+  for (int i = 0; i < field_num; i++) {
+    AttrInfoSqlNode attr_info;
+    attr_info.name   = string("field_") + to_string(i);
+    attr_info.type   = AttrType::INTS;
+    attr_info.length = 4;
+    attr_infos.push_back(attr_info);
+  }
+  ASSERT_EQ(RC::SUCCESS, db->create_table(table_name, attr_infos, {}));
+  Table *table = db->find_table(table_name);
+  ASSERT_NE(table, nullptr);
+
+  TrxKit &trx_kit     = db->trx_kit();
+  auto    insert_rows = [&](int num) {
+    Trx *trx = trx_kit.create_trx(db->log_handler());
+    trx->start_if_need();
+    for (int i = 0; i < num; i++) {
+      Record        record;
+      vector<Value> values(field_num);
+      for (Value &value : values) {
+        value.set_int(i);
+      }
+      ASSERT_EQ(RC::SUCCESS, table->make_record(values.size(), values.data(), record));
+      ASSERT_EQ(RC::SUCCESS, trx->insert_record(table, record));
+    }
+    ASSERT_EQ(RC::SUCCESS, trx->commit());
+    trx_kit.destroy_trx(trx);
+  };
+
+  const int insert_num = 3000;
+  insert_rows(insert_num);
+  ASSERT_EQ(RC::SUCCESS, db->checkpoint());
+  PageCleaner page_cleaner(db->buffer_pool_manager(), 100 /*clean_percent*/, 1000000 /*io_capacity*/);
+  while (page_cleaner.run_once() > 0) {
+  }
+  insert_rows(insert_num);
+
+  DiskLogHandler &log_handler = static_cast<DiskLogHandler &>(db->log_handler());
+  for (int i = 0; i < 3; i++) {
+    ASSERT_EQ(RC::SUCCESS, db->checkpoint());
+
+    // 还有脏页，同步文件时记录的LSN就是脏页最小的 recovery lsn
+    const LSN durable_lsn = db->buffer_pool_manager().durable_lsn();
+    const LSN current_lsn = log_handler.current_lsn();
+    ASSERT_GT(durable_lsn, 0);
+    ASSERT_LT(durable_lsn, current_lsn);
+    ASSERT_EQ(RC::SUCCESS, log_handler.wait_lsn(current_lsn));
+
+    LSN     first_lsn = 0;
+    int64_t count     = 0;
+    ASSERT_EQ(RC::SUCCESS, log_handler.iterate([&](LogEntry &entry) -> RC {
+      if (first_lsn == 0) {
+        first_lsn = entry.lsn();
+      }
+      count++;
+      return RC::SUCCESS;
+    }, durable_lsn));
+    ASSERT_EQ(durable_lsn, first_lsn);
+    ASSERT_EQ(current_lsn - durable_lsn + 1, count);
+  }
+
+  db.reset();
+  filesystem::remove_all(test_directory);
+
+  get_properties()->put(CLOG_FILE_SIZE, to_string(CLOG_FILE_SIZE_DEFAULT), STORAGE);
+}
+
 int main(int argc, char **argv)
 {
   testing::InitGoogleTest(&argc, argv);
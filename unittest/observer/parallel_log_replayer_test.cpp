@@ -0,0 +1,225 @@
+/* Copyright (c) 2021 OceanBase and/or its affiliates. All rights reserved.
+miniob is licensed under Mulan PSL v2.
+You can use this software according to the terms and conditions of the Mulan PSL v2.
+You may obtain a copy of Mulan PSL v2 at:
+         http://license.coscl.org.cn/MulanPSL2
+THIS SOFTWARE IS PROVIDED ON AN "AS IS" BASIS, WITHOUT WARRANTIES OF ANY KIND,
+EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO NON-INFRINGEMENT,
+MERCHANTABILITY OR FIT FOR A PARTICULAR PURPOSE.
+See the Mulan PSL v2 for more details. */
+
+#include <filesystem>
+#include <algorithm>
+#include <random>
+
+#include "gtest/gtest.h"
+#include "storage/buffer/disk_buffer_pool.h"
+#include "storage/buffer/double_write_buffer.h"
+#include "storage/clog/disk_log_handler.h"
+#include "storage/clog/integrated_log_replayer.h"
+#include "storage/clog/parallel_log_replayer.h"
+#include "storage/index/bplus_tree.h"
+#include "storage/record/record_manager.h"
+
+using namespace std;
+using namespace common;
+
+/**
+ * @brief 记录回放过的事务日志
+ */
+class RecordingLogReplayer : public LogReplayer
+{
+public:
+  RC replay(const LogEntry &entry) override
+  {
+    lsns.push_back(entry.lsn());
+    return RC::SUCCESS;
+  }
+
+  RC on_done() override
+  {
+    done = true;
+    return RC::SUCCESS;
+  }
+
+  vector<LSN> lsns;
+  bool        done = false;
+};
+
+TEST(ParallelLogReplayer, record_and_index)
+{
+  filesystem::path test_directory = "parallel_log_replayer_test_dir";
+  filesystem::path crash_directory = "parallel_log_replayer_test_crash_dir";
+  filesystem::remove_all(test_directory);
+  filesystem::remove_all(crash_directory);
+  filesystem::create_directory(test_directory);
+
+  const filesystem::path record_filename = test_directory / "record.bp";
+  const filesystem::path index_filename  = test_directory / "index.bp";
+  const filesystem::path log_directory   = test_directory / "clog";
+
+  // 1. 创建一个数据文件和一个索引文件，插入数据并删除一部分
+  auto bpm = make_unique<BufferPoolManager>();
+  ASSERT_EQ(RC::SUCCESS, bpm->init(make_unique<VacuousDoubleWriteBuffer>()));
+  auto log_handler = make_unique<DiskLogHandler>();
+  ASSERT_EQ(RC::SUCCESS, log_handler->init(log_directory.c_str()));
+  IntegratedLogReplayer log_replayer(*bpm);
+  ASSERT_EQ(RC::SUCCESS, log_handler->replay(log_replayer, 0));
+  ASSERT_EQ(RC::SUCCESS, log_handler->start());
+
+  DiskBufferPool *record_buffer_pool = nullptr;
+  DiskBufferPool *index_buffer_pool  = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm->create_file(record_filename.c_str()));
+  ASSERT_EQ(RC::SUCCESS, bpm->open_file(*log_handler, record_filename.c_str(), record_buffer_pool));
+  ASSERT_EQ(RC::SUCCESS, bpm->create_file(index_filename.c_str()));
+  ASSERT_EQ(RC::SUCCESS, bpm->open_file(*log_handler, index_filename.c_str(), index_buffer_pool));
+
+  auto record_handler = make_unique<RecordFileHandler>(StorageFormat::ROW_FORMAT);
+  ASSERT_EQ(RC::SUCCESS, record_handler->init(*record_buffer_pool, *log_handler, nullptr, nullptr));
+  auto tree_handler = make_unique<BplusTreeHandler>();
+  ASSERT_EQ(RC::SUCCESS, tree_handler->create(*log_handler, *index_buffer_pool, AttrType::INTS, sizeof(int)));
+
+  const int   insert_num = 10000;
+  vector<int> keys(insert_num);
+  for (int i = 0; i < insert_num; i++) {
+    keys[i] = i;
+  }
+  mt19937 generator(random_device{}());
+  shuffle(keys.begin(), keys.end(), generator);
+
+  char        record_data[64] = {0};
+  vector<RID> rids(insert_num);
+  for (int key : keys) {
+    memcpy(record_data, &key, sizeof(key));
+    ASSERT_EQ(RC::SUCCESS, record_handler->insert_record(record_data, sizeof(record_data), &rids[key]));
+    ASSERT_EQ(RC::SUCCESS, tree_handler->insert_entry(reinterpret_cast<const char *>(&key), &rids[key]));
+  }
+
+  for (int key = 0; key < insert_num; key += 3) {
+    ASSERT_EQ(RC::SUCCESS, record_handler->delete_record(&rids[key]));
+    ASSERT_EQ(RC::SUCCESS, tree_handler->delete_entry(reinterpret_cast<const char *>(&key), &rids[key]));
+  }
+
+  // 2. 日志都写入磁盘之后，直接复制文件，相当于进程崩溃，大部分修改还在内存中
+  ASSERT_EQ(RC::SUCCESS, log_handler->stop());
+  ASSERT_EQ(RC::SUCCESS, log_handler->await_termination());
+  filesystem::copy(test_directory, crash_directory, filesystem::copy_options::recursive);
+
+  tree_handler.reset();
+  record_handler.reset();
+  bpm.reset();
+  log_handler.reset();
+
+  // 3. 使用多个线程回放日志
+  auto bpm2 = make_unique<BufferPoolManager>();
+  ASSERT_EQ(RC::SUCCESS, bpm2->init(make_unique<VacuousDoubleWriteBuffer>()));
+  auto            log_handler2        = make_unique<DiskLogHandler>();
+  DiskBufferPool *record_buffer_pool2 = nullptr;
+  DiskBufferPool *index_buffer_pool2  = nullptr;
+  ASSERT_EQ(RC::SUCCESS,
+      bpm2->open_file(*log_handler2, (crash_directory / "record.bp").c_str(), record_buffer_pool2));
+  ASSERT_EQ(RC::SUCCESS,
+      bpm2->open_file(*log_handler2, (crash_directory / "index.bp").c_str(), index_buffer_pool2));
+  ASSERT_EQ(RC::SUCCESS, log_handler2->init((crash_directory / "clog").c_str()));
+
+  auto trx_log_replayer = make_unique<RecordingLogReplayer>();
+  ParallelLogReplayer parallel_replayer(*bpm2, std::move(trx_log_replayer), 4);
+  ASSERT_EQ(RC::SUCCESS, parallel_replayer.start());
+  ASSERT_EQ(RC::SUCCESS, log_handler2->replay(parallel_replayer, 0));
+  ASSERT_EQ(RC::SUCCESS, parallel_replayer.on_done());
+  ASSERT_EQ(RC::SUCCESS, log_handler2->start());
+
+  // 4. 检查数据和索引
+  auto record_handler2 = make_unique<RecordFileHandler>(StorageFormat::ROW_FORMAT);
+  ASSERT_EQ(RC::SUCCESS, record_handler2->init(*record_buffer_pool2, *log_handler2, nullptr, nullptr));
+  for (int key = 0; key < insert_num; key++) {
+    Record record;
+    RC     rc = record_handler2->get_record(rids[key], record);
+    if (key % 3 == 0) {
+      ASSERT_NE(RC::SUCCESS, rc);
+    } else {
+      ASSERT_EQ(RC::SUCCESS, rc);
+      ASSERT_EQ(0, memcmp(record.data(), &key, sizeof(key)));
+    }
+  }
+
+  auto tree_handler2 = make_unique<BplusTreeHandler>();
+  ASSERT_EQ(RC::SUCCESS, tree_handler2->open(*log_handler2, *index_buffer_pool2));
+  auto scanner = make_unique<BplusTreeScanner>(*tree_handler2);
+  ASSERT_EQ(RC::SUCCESS, scanner->open(nullptr, 0, true, nullptr, 0, true));
+  RC  rc  = RC::SUCCESS;
+  int key = 1;
+  RID rid;
+  while (OB_SUCC(rc = scanner->next_entry(rid))) {
+    ASSERT_EQ(rids[key], rid);
+    key += (key % 3 == 1) ? 1 : 2;
+  }
+  ASSERT_EQ(RC::RECORD_EOF, rc);
+  ASSERT_GE(key, insert_num);
+  ASSERT_EQ(RC::SUCCESS, scanner->close());
+
+  scanner.reset();
+  tree_handler2.reset();
+  record_handler2.reset();
+  ASSERT_EQ(RC::SUCCESS, log_handler2->stop());
+  ASSERT_EQ(RC::SUCCESS, log_handler2->await_termination());
+  bpm2.reset();
+  log_handler2.reset();
+}
+
+TEST(ParallelLogReplayer, trx_entries_in_order)
+{
+  BufferPoolManager bpm;
+  ASSERT_EQ(RC::SUCCESS, bpm.init(make_unique<VacuousDoubleWriteBuffer>()));
+
+  auto                 trx_log_replayer = make_unique<RecordingLogReplayer>();
+  RecordingLogReplayer *recorder        = trx_log_replayer.get();
+  ParallelLogReplayer  parallel_replayer(bpm, std::move(trx_log_replayer), 4);
+  ASSERT_EQ(RC::SUCCESS, parallel_replayer.start());
+
+  const int entry_num = 1000;
+  for (int i = 1; i <= entry_num; i++) {
+    LogEntry entry;
+    ASSERT_EQ(RC::SUCCESS, entry.init(i, LogModule::Id::TRANSACTION, vector<char>(16, 'a')));
+    ASSERT_EQ(RC::SUCCESS, parallel_replayer.replay(entry));
+  }
+
+  // 事务日志等到 on_done 时才回放
+  ASSERT_TRUE(recorder->lsns.empty());
+  ASSERT_EQ(RC::SUCCESS, parallel_replayer.on_done());
+  ASSERT_TRUE(recorder->done);
+  ASSERT_EQ(entry_num, static_cast<int>(recorder->lsns.size()));
+  for (int i = 0; i < entry_num; i++) {
+    ASSERT_EQ(i + 1, recorder->lsns[i]);
+  }
+}
+
+TEST(ParallelLogReplayer, failed_entry)
+{
+  BufferPoolManager bpm;
+  ASSERT_EQ(RC::SUCCESS, bpm.init(make_unique<VacuousDoubleWriteBuffer>()));
+
+  // 没有打开任何 buffer pool，回放页面日志会失败
+  ParallelLogReplayer parallel_replayer(bpm, nullptr, 2);
+  ASSERT_EQ(RC::SUCCESS, parallel_replayer.start());
+
+  BufferPoolLogEntry log;
+  log.buffer_pool_id = 100;
+  log.operation_type = BufferPoolOperation(BufferPoolOperation::Type::ALLOCATE).type_id();
+  log.page_num       = 1;
+  LogEntry entry;
+  ASSERT_EQ(RC::SUCCESS,
+      entry.init(1,
+          LogModule::Id::BUFFER_POOL,
+          vector<char>(reinterpret_cast<const char *>(&log), reinterpret_cast<const char *>(&log) + sizeof(log))));
+  ASSERT_EQ(RC::SUCCESS, parallel_replayer.replay(entry));
+  ASSERT_NE(RC::SUCCESS, parallel_replayer.on_done());
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  filesystem::path log_filename = filesystem::path(argv[0]).filename();
+  LoggerFactory::init_default(log_filename.string() + ".log", LOG_LEVEL_INFO);
+  return RUN_ALL_TESTS();
+}
@@ -278,8 +278,10 @@ TEST_P(PaxPageHandlerTestWithParam, DISABLED_PaxPageHandler)
   chunk1.add_column(std::move(col_3), 2);
   auto col_4 = std::make_unique<Column>(fm4, 2048);
   chunk1.add_column(std::move(col_4), 3);
-  rc = record_page_handle->get_chunk(chunk1);
+  SlotNum start_slot = 0;
+  rc = record_page_handle->get_chunk(chunk1, start_slot);
   ASSERT_EQ(rc, RC::SUCCESS);
+  ASSERT_EQ(start_slot, -1);
   ASSERT_EQ(chunk1.rows(), record_num);
   for (int i = 0; i < record_num; i++) {
     int   int_val   = i + int_base;
@@ -295,7 +297,8 @@ TEST_P(PaxPageHandlerTestWithParam, DISABLED_PaxPageHandler)
   fm2_1.init("col2", AttrType::FLOATS, 4, 4, true, 1);
   auto col_2_1 = std::make_unique<Column>(fm2_1, 2048);
   chunk2.add_column(std::move(col_2_1), 1);
-  rc = record_page_handle->get_chunk(chunk2);
+  start_slot = 0;
+  rc = record_page_handle->get_chunk(chunk2, start_slot);
   ASSERT_EQ(rc, RC::SUCCESS);
   ASSERT_EQ(chunk2.rows(), record_num);
   for (int i = 0; i < record_num; i++) {
@@ -322,7 +325,8 @@ TEST_P(PaxPageHandlerTestWithParam, DISABLED_PaxPageHandler)
 
   // get chunk
   chunk1.reset_data();
-  record_page_handle->get_chunk(chunk1);
+  start_slot = 0;
+  record_page_handle->get_chunk(chunk1, start_slot);
   ASSERT_EQ(chunk1.rows(), record_num - delete_num);
 
   int col1_expected = (int_base + 0 + int_base + record_num - 1) * record_num /2;
@@ -347,6 +351,208 @@ TEST_P(PaxPageHandlerTestWithParam, DISABLED_PaxPageHandler)
   delete bpm;
 }
 
+TEST(PaxPageHandler, get_chunk)
+{
+  VacuousLogHandler log_handler;
+
+  const char *record_manager_file = "pax_get_chunk.bp";
+  ::remove(record_manager_file);
+
+  BufferPoolManager bpm;
+  ASSERT_EQ(RC::SUCCESS, bpm.init(make_unique<VacuousDoubleWriteBuffer>()));
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(record_manager_file));
+  DiskBufferPool *bp = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(log_handler, record_manager_file, bp));
+
+  Frame *frame = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bp->allocate_page(&frame));
+
+  TableMeta table_meta;
+  table_meta.fields_.resize(2);
+  table_meta.fields_[0].attr_type_ = AttrType::INTS;
+  table_meta.fields_[0].attr_len_  = 4;
+  table_meta.fields_[0].field_id_  = 0;
+  table_meta.fields_[1].attr_type_ = AttrType::CHARS;
+  table_meta.fields_[1].attr_len_  = 8;
+  table_meta.fields_[1].field_id_  = 1;
+
+  PaxRecordPageHandler page_handler;
+  ASSERT_EQ(RC::SUCCESS, page_handler.init_empty_page(*bp, log_handler, frame->page_num(), 12, &table_meta));
+
+  // 直接按照 PAX 格式填充页面，跳过第 3 条和第 7 条记录
+  const int   record_num = 10;
+  PageHeader *header     = reinterpret_cast<PageHeader *>(frame->data());
+  int        *col_idx    = reinterpret_cast<int *>(frame->data() + header->col_idx_offset);
+  char       *col0       = frame->data() + header->data_offset;
+  char       *col1       = frame->data() + header->data_offset + col_idx[0];
+  Bitmap      bitmap(frame->data() + sizeof(PageHeader), header->record_capacity);
+  for (int i = 0; i < record_num; i++) {
+    if (i == 3 || i == 7) {
+      continue;
+    }
+    memcpy(col0 + i * 4, &i, sizeof(i));
+    snprintf(col1 + i * 8, 8, "str%d", i);
+    bitmap.set_bit(i);
+    header->record_num++;
+  }
+
+  // 只读取第二列
+  Chunk     chunk;
+  FieldMeta field;
+  field.init("col1", AttrType::CHARS, 4, 8, true, 1);
+  chunk.add_column(make_unique<Column>(field, 64), 1);
+  SlotNum start_slot = 0;
+  ASSERT_EQ(RC::SUCCESS, page_handler.get_chunk(chunk, start_slot));
+  ASSERT_EQ(start_slot, -1);
+  ASSERT_EQ(chunk.rows(), record_num - 2);
+
+  int row = 0;
+  for (int i = 0; i < record_num; i++) {
+    if (i == 3 || i == 7) {
+      continue;
+    }
+    ASSERT_EQ(chunk.get_value(0, row).get_string(), "str" + to_string(i));
+    row++;
+  }
+
+  // 两列都读取，追加到已有的数据后面
+  FieldMeta int_field;
+  int_field.init("col0", AttrType::INTS, 0, 4, true, 0);
+  Chunk chunk2;
+  chunk2.add_column(make_unique<Column>(int_field, 64), 0);
+  chunk2.add_column(make_unique<Column>(field, 64), 1);
+  start_slot = 0;
+  ASSERT_EQ(RC::SUCCESS, page_handler.get_chunk(chunk2, start_slot));
+  start_slot = 0;
+  ASSERT_EQ(RC::SUCCESS, page_handler.get_chunk(chunk2, start_slot));
+  ASSERT_EQ(chunk2.rows(), 2 * (record_num - 2));
+  ASSERT_EQ(chunk2.get_value(0, 3).get_int(), 4);
+  ASSERT_EQ(chunk2.get_value(1, 3).get_string(), "str4");
+
+  // 列的长度与页面中的不一致
+  Chunk chunk3;
+  chunk3.add_column(make_unique<Column>(int_field, 64), 1);
+  start_slot = 0;
+  ASSERT_EQ(RC::INVALID_ARGUMENT, page_handler.get_chunk(chunk3, start_slot));
+
+  // 列的容量不够时分多次读取，跳过的记录不会占用空间
+  Chunk chunk4;
+  chunk4.add_column(make_unique<Column>(int_field, 3), 0);
+  vector<int> values;
+  start_slot = 0;
+  while (start_slot != -1) {
+    chunk4.reset_data();
+    ASSERT_EQ(RC::SUCCESS, page_handler.get_chunk(chunk4, start_slot));
+    ASSERT_LE(chunk4.rows(), 3);
+    for (int i = 0; i < chunk4.rows(); i++) {
+      values.push_back(chunk4.get_value(0, i).get_int());
+    }
+  }
+  ASSERT_EQ(values, vector<int>({0, 1, 2, 4, 5, 6, 8, 9}));
+
+  page_handler.cleanup();
+  frame->unpin();
+  ASSERT_EQ(RC::SUCCESS, bpm.close_file(record_manager_file));
+}
+
+TEST(PaxPageHandler, large_page_chunk)
+{
+  VacuousLogHandler log_handler;
+
+  const char *record_manager_file = "pax_large_page_chunk.bp";
+  ::remove(record_manager_file);
+
+  // 64KB 的页面中只有一个 4 字节的列，页面中的记录比列的容量多
+  BufferPoolManager bpm;
+  ASSERT_EQ(RC::SUCCESS, bpm.init(make_unique<VacuousDoubleWriteBuffer>()));
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(record_manager_file, 65536));
+  DiskBufferPool *bp = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(log_handler, record_manager_file, bp));
+
+  Frame *frame = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bp->allocate_page(&frame));
+
+  TableMeta table_meta;
+  table_meta.storage_format_ = StorageFormat::PAX_FORMAT;
+  table_meta.fields_.resize(1);
+  table_meta.fields_[0].attr_type_ = AttrType::INTS;
+  table_meta.fields_[0].attr_len_  = 4;
+  table_meta.fields_[0].field_id_  = 0;
+
+  PaxRecordPageHandler page_handler;
+  ASSERT_EQ(RC::SUCCESS, page_handler.init_empty_page(*bp, log_handler, frame->page_num(), 4, &table_meta));
+
+  PageHeader *header          = reinterpret_cast<PageHeader *>(frame->data());
+  const int   record_num      = header->record_capacity;
+  const int   column_capacity = 3000;
+  ASSERT_GT(record_num, 2 * column_capacity);
+
+  char  *col0 = frame->data() + header->data_offset;
+  Bitmap bitmap(frame->data() + sizeof(PageHeader), header->record_capacity);
+  for (int i = 0; i < record_num; i++) {
+    memcpy(col0 + i * 4, &i, sizeof(i));
+    bitmap.set_bit(i);
+  }
+  header->record_num = record_num;
+  frame->mark_dirty();
+  page_handler.cleanup();
+  frame->unpin();
+
+  Table table;
+  table.table_meta_.storage_format_ = StorageFormat::PAX_FORMAT;
+
+  ChunkFileScanner chunk_scanner;
+  ASSERT_EQ(RC::SUCCESS, chunk_scanner.open_scan_chunk(&table, *bp, log_handler, ReadWriteMode::READ_ONLY));
+
+  FieldMeta field;
+  field.init("col0", AttrType::INTS, 0, 4, true, 0);
+  Chunk chunk;
+  chunk.add_column(make_unique<Column>(field, column_capacity), 0);
+
+  RC  rc        = RC::SUCCESS;
+  int count     = 0;
+  int chunk_num = 0;
+  while (OB_SUCC(rc = chunk_scanner.next_chunk(chunk))) {
+    ASSERT_LE(chunk.rows(), column_capacity);
+    for (int i = 0; i < chunk.rows(); i++) {
+      ASSERT_EQ(chunk.get_value(0, i).get_int(), count + i);
+    }
+    count += chunk.rows();
+    chunk_num++;
+    chunk.reset_data();
+  }
+  ASSERT_EQ(rc, RC::RECORD_EOF);
+  ASSERT_EQ(count, record_num);
+  ASSERT_EQ(chunk_num, (record_num + column_capacity - 1) / column_capacity);
+
+  chunk_scanner.close_scan();
+  ASSERT_EQ(RC::SUCCESS, bpm.close_file(record_manager_file));
+  ::remove(record_manager_file);
+}
+
+TEST(ChunkFileScanner, var_row_format)
+{
+  VacuousLogHandler log_handler;
+
+  const char *record_manager_file = "chunk_scanner_var_row.bp";
+  ::remove(record_manager_file);
+
+  BufferPoolManager bpm;
+  ASSERT_EQ(RC::SUCCESS, bpm.init(make_unique<VacuousDoubleWriteBuffer>()));
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(record_manager_file));
+  DiskBufferPool *bp = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(log_handler, record_manager_file, bp));
+
+  // 变长记录的页面不能按列读取
+  Table table;
+  table.table_meta_.storage_format_ = StorageFormat::VAR_ROW_FORMAT;
+  ChunkFileScanner chunk_scanner;
+  ASSERT_EQ(RC::UNSUPPORTED, chunk_scanner.open_scan_chunk(&table, *bp, log_handler, ReadWriteMode::READ_ONLY));
+
+  ASSERT_EQ(RC::SUCCESS, bpm.close_file(record_manager_file));
+  ::remove(record_manager_file);
+}
+
 INSTANTIATE_TEST_SUITE_P(PaxFileScannerTests, PaxRecordFileScannerWithParam, testing::Values(1, 10, 100, 1000, 2000, 10000));
 
 INSTANTIATE_TEST_SUITE_P(PaxPageTests, PaxPageHandlerTestWithParam, testing::Values(1, 10, 100, 337));
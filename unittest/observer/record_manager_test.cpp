@@ -15,6 +15,8 @@ See the Mulan PSL v2 for more details. */
 #include <string.h>
 #include <sstream>
 #include <filesystem>
+#include <set>
+#include <thread>
 #include <utility>
 
 #include "storage/buffer/disk_buffer_pool.h"
@@ -123,6 +125,100 @@ TEST(RecordPageHandler, test_record_page_handler)
   delete record_page_handle;
 }
 
+TEST(RecordPageHandler, var_row_record_page_handler)
+{
+  VacuousLogHandler log_handler;
+
+  const char *record_manager_file = "var_row_record_manager.bp";
+  ::remove(record_manager_file);
+
+  BufferPoolManager bpm;
+  ASSERT_EQ(RC::SUCCESS, bpm.init(make_unique<VacuousDoubleWriteBuffer>()));
+  ASSERT_EQ(RC::SUCCESS, bpm.create_file(record_manager_file));
+  DiskBufferPool *bp = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bpm.open_file(log_handler, record_manager_file, bp));
+
+  Frame *frame = nullptr;
+  ASSERT_EQ(RC::SUCCESS, bp->allocate_page(&frame));
+  const PageNum page_num = frame->page_num();
+  frame->unpin();
+
+  // 两个定长字段和一个字符串字段
+  const int record_size   = 4 + 200 + 4;
+  const int column_desc[] = {4, -200, 4};
+  auto      make_record   = [](int i, int str_len, char *buf) {
+    memset(buf, 0, record_size);
+    memcpy(buf, &i, sizeof(i));
+    memset(buf + 4, 'a' + i % 26, str_len);
+    memcpy(buf + 204, &i, sizeof(i));
+  };
+
+  VarRowRecordPageHandler page_handler;
+  ASSERT_EQ(RC::SUCCESS,
+      page_handler.init_empty_page(
+          *bp, log_handler, page_num, record_size, 3, reinterpret_cast<const char *>(column_desc)));
+
+  // 短字符串只占用实际的长度，一个页面可以放下的记录比定长格式多
+  char        buf[record_size];
+  vector<RID> rids;
+  for (int i = 0; !page_handler.is_full(); i++) {
+    make_record(i, i % 10, buf);
+    RID rid;
+    ASSERT_EQ(RC::SUCCESS, page_handler.insert_record(buf, &rid));
+    ASSERT_EQ(rid.slot_num, i);
+    rids.push_back(rid);
+  }
+  const int fixed_capacity = (BP_PAGE_DATA_SIZE - (int)sizeof(PageHeader)) / (record_size + 4);
+  ASSERT_GT(static_cast<int>(rids.size()), fixed_capacity * 5);
+
+  Record record;
+  for (int i = 0; i < static_cast<int>(rids.size()); i++) {
+    make_record(i, i % 10, buf);
+    ASSERT_EQ(RC::SUCCESS, page_handler.get_record(rids[i], record));
+    ASSERT_EQ(record.len(), record_size);
+    ASSERT_EQ(0, memcmp(record.data(), buf, record_size));
+  }
+
+  // 删除记录之后空闲空间立即合并，RID 不变
+  const int free_space = page_handler.free_space();
+  for (int i = 0; i < static_cast<int>(rids.size()); i += 2) {
+    ASSERT_EQ(RC::SUCCESS, page_handler.delete_record(&rids[i]));
+  }
+  ASSERT_GT(page_handler.free_space(), free_space);
+  ASSERT_FALSE(page_handler.is_full());
+
+  // 变长和变短的更新
+  make_record(1, 200, buf);
+  ASSERT_EQ(RC::SUCCESS, page_handler.update_record(rids[1], buf));
+  make_record(3, 0, buf);
+  ASSERT_EQ(RC::SUCCESS, page_handler.update_record(rids[3], buf));
+
+  RecordPageIterator iterator;
+  iterator.init(&page_handler);
+  int count = 0;
+  while (iterator.has_next()) {
+    ASSERT_EQ(RC::SUCCESS, iterator.next(record));
+    const int i       = record.rid().slot_num;
+    const int str_len = (i == 1) ? 200 : (i == 3 ? 0 : i % 10);
+    ASSERT_EQ(1, i % 2);
+    make_record(i, str_len, buf);
+    ASSERT_EQ(0, memcmp(record.data(), buf, record_size));
+    count++;
+  }
+  ASSERT_EQ(count, static_cast<int>(rids.size()) / 2);
+
+  // 删除的槽位可以重新使用
+  make_record(0, 5, buf);
+  RID rid;
+  ASSERT_EQ(RC::SUCCESS, page_handler.insert_record(buf, &rid));
+  ASSERT_EQ(rid.slot_num, 0);
+  ASSERT_EQ(RC::SUCCESS, page_handler.get_record(rid, record));
+  ASSERT_EQ(0, memcmp(record.data(), buf, record_size));
+
+  page_handler.cleanup();
+  ASSERT_EQ(RC::SUCCESS, bpm.close_file(record_manager_file));
+}
+
 TEST(RecordScanner, test_record_file_iterator)
 {
   VacuousLogHandler log_handler;
@@ -363,6 +459,151 @@ TEST(RecordManager, durability)
   bpm2.close_file(record_manager_file.c_str());
 }
 
+TEST(RecordManager, free_space_map)
+{
+  filesystem::path directory("record_manager_free_space_map");
+  filesystem::remove_all(directory);
+  ASSERT_TRUE(filesystem::create_directories(directory));
+
+  filesystem::path record_manager_file = directory / "record_manager.bp";
+  filesystem::path fsm_file            = directory / "record_manager.bp.fsm";
+  filesystem::path fsm_file_copy       = directory / "record_manager.bp.fsm.copy";
+
+  BufferPoolManager bpm;
+  ASSERT_EQ(bpm.init(make_unique<VacuousDoubleWriteBuffer>()), RC::SUCCESS);
+  VacuousLogHandler log_handler;
+
+  DiskBufferPool *buffer_pool = nullptr;
+  ASSERT_EQ(bpm.create_file(record_manager_file.c_str()), RC::SUCCESS);
+  ASSERT_EQ(bpm.open_file(log_handler, record_manager_file.c_str(), buffer_pool), RC::SUCCESS);
+
+  const int  record_size              = 100;
+  const char record_data[record_size] = "hello, world!";
+  const int  insert_record_num        = 1000;
+
+  vector<RID> rids;
+  {
+    RecordFileHandler record_file_handler(StorageFormat::ROW_FORMAT);
+    ASSERT_EQ(record_file_handler.init(*buffer_pool, log_handler, nullptr, nullptr), RC::SUCCESS);
+    for (int i = 0; i < insert_record_num; i++) {
+      RID rid;
+      ASSERT_EQ(record_file_handler.insert_record(record_data, record_size, &rid), RC::SUCCESS);
+      rids.push_back(rid);
+    }
+
+    // 只有最后一个页面没有满
+    RecordFreeSpaceMap &free_space_map = record_file_handler.free_space_map();
+    ASSERT_EQ(free_space_map.free_page_num(), 1);
+    ASSERT_EQ(free_space_map.page_class(rids.front().page_num), RecordFreeSpaceMap::FULL_CLASS);
+    ASSERT_NE(free_space_map.page_class(rids.back().page_num), RecordFreeSpaceMap::FULL_CLASS);
+
+    ASSERT_EQ(record_file_handler.delete_record(&rids.front()), RC::SUCCESS);
+    ASSERT_EQ(free_space_map.free_page_num(), 2);
+    ASSERT_NE(free_space_map.page_class(rids.front().page_num), RecordFreeSpaceMap::FULL_CLASS);
+
+    // 打开期间文件中的内容是不可信的
+    filesystem::copy_file(fsm_file, fsm_file_copy);
+    record_file_handler.close();
+  }
+
+  // 正常关闭之后，直接从文件中加载
+  {
+    RecordFileHandler record_file_handler(StorageFormat::ROW_FORMAT);
+    ASSERT_EQ(record_file_handler.init(*buffer_pool, log_handler, nullptr, nullptr), RC::SUCCESS);
+    RecordFreeSpaceMap &free_space_map = record_file_handler.free_space_map();
+    ASSERT_EQ(free_space_map.free_page_num(), 2);
+    ASSERT_NE(free_space_map.page_class(rids.front().page_num), RecordFreeSpaceMap::FULL_CLASS);
+    ASSERT_EQ(free_space_map.page_class(rids[insert_record_num / 2].page_num), RecordFreeSpaceMap::FULL_CLASS);
+  }
+
+  // 没有正常关闭时，扫描文件重新构建
+  filesystem::copy_file(fsm_file_copy, fsm_file, filesystem::copy_options::overwrite_existing);
+  {
+    RecordFileHandler record_file_handler(StorageFormat::ROW_FORMAT);
+    ASSERT_EQ(record_file_handler.init(*buffer_pool, log_handler, nullptr, nullptr), RC::SUCCESS);
+    RecordFreeSpaceMap &free_space_map = record_file_handler.free_space_map();
+    ASSERT_EQ(free_space_map.free_page_num(), 2);
+
+    // 删除记录空出来的位置会被重新使用
+    RID rid;
+    ASSERT_EQ(record_file_handler.insert_record(record_data, record_size, &rid), RC::SUCCESS);
+    ASSERT_EQ(rid.page_num, rids.front().page_num);
+    ASSERT_EQ(free_space_map.page_class(rid.page_num), RecordFreeSpaceMap::FULL_CLASS);
+    ASSERT_EQ(free_space_map.free_page_num(), 1);
+
+    // 回放日志时直接修改页面，空闲空间表过时之后可以按照页面重新构建
+    free_space_map.update(rids[insert_record_num / 2].page_num, RecordFreeSpaceMap::CLASS_NUM - 1);
+    ASSERT_EQ(free_space_map.free_page_num(), 2);
+    ASSERT_EQ(record_file_handler.rebuild_free_pages(), RC::SUCCESS);
+    ASSERT_EQ(free_space_map.free_page_num(), 1);
+    ASSERT_EQ(free_space_map.page_class(rids[insert_record_num / 2].page_num), RecordFreeSpaceMap::FULL_CLASS);
+    ASSERT_NE(free_space_map.page_class(rids.back().page_num), RecordFreeSpaceMap::FULL_CLASS);
+  }
+
+  bpm.close_file(record_manager_file.c_str());
+  filesystem::remove_all(directory);
+}
+
+TEST(RecordManager, insert_target)
+{
+  filesystem::path directory("record_manager_insert_target");
+  filesystem::remove_all(directory);
+  ASSERT_TRUE(filesystem::create_directories(directory));
+
+  filesystem::path record_manager_file = directory / "record_manager.bp";
+
+  BufferPoolManager bpm;
+  ASSERT_EQ(bpm.init(make_unique<VacuousDoubleWriteBuffer>()), RC::SUCCESS);
+  VacuousLogHandler log_handler;
+
+  DiskBufferPool *buffer_pool = nullptr;
+  ASSERT_EQ(bpm.create_file(record_manager_file.c_str()), RC::SUCCESS);
+  ASSERT_EQ(bpm.open_file(log_handler, record_manager_file.c_str(), buffer_pool), RC::SUCCESS);
+
+  RecordFileHandler record_file_handler(StorageFormat::ROW_FORMAT);
+  ASSERT_EQ(record_file_handler.init(*buffer_pool, log_handler, nullptr, nullptr), RC::SUCCESS);
+
+  const int  record_size              = 100;
+  const char record_data[record_size] = "hello, world!";
+  const int  thread_num               = 4;
+  const int  insert_record_num        = 10;  // 一个页面可以放下
+
+  // 每个线程都往自己的目标页面中插入记录
+  vector<vector<RID>> thread_rids(thread_num);
+  vector<thread>      threads;
+  for (int t = 0; t < thread_num; t++) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < insert_record_num; i++) {
+        RID rid;
+        ASSERT_EQ(record_file_handler.insert_record(record_data, record_size, &rid), RC::SUCCESS);
+        thread_rids[t].push_back(rid);
+      }
+    });
+  }
+  for (thread &t : threads) {
+    t.join();
+  }
+
+  set<PageNum> pages;
+  for (const vector<RID> &rids : thread_rids) {
+    ASSERT_EQ(static_cast<int>(rids.size()), insert_record_num);
+    for (const RID &rid : rids) {
+      ASSERT_EQ(rid.page_num, rids.front().page_num);
+    }
+    pages.insert(rids.front().page_num);
+  }
+  ASSERT_EQ(static_cast<int>(pages.size()), thread_num);
+
+  // 其它线程的目标页面不会被找到，删除记录空出来的页面可以被找到
+  RecordFreeSpaceMap &free_space_map = record_file_handler.free_space_map();
+  ASSERT_EQ(free_space_map.free_page_num(), thread_num);
+  ASSERT_EQ(free_space_map.claim_free_page(), BP_INVALID_PAGE_NUM);
+
+  record_file_handler.close();
+  bpm.close_file(record_manager_file.c_str());
+  filesystem::remove_all(directory);
+}
+
 int main(int argc, char **argv)
 {
   testing::InitGoogleTest(&argc, argv);